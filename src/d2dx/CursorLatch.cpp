@@ -0,0 +1,78 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CursorLatch.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+CursorLatch::CursorLatch(
+	const std::shared_ptr<IClock>& clock) :
+	_clock{ clock }
+{
+}
+
+_Use_decl_annotations_
+void CursorLatch::OnGameMousePos(
+	Offset pos)
+{
+	_gamePos = pos;
+	_gamePosTimeUs = _clock->GetTimeUs();
+}
+
+void CursorLatch::OnCursorDrawn()
+{
+	/* The cursor may consist of several batches, all drawn at the same position. */
+	if (!_isCursorDrawn)
+	{
+		_drawnPos = _gamePos;
+		_drawnPosTimeUs = _gamePosTimeUs;
+		_isCursorDrawn = true;
+	}
+}
+
+_Use_decl_annotations_
+Offset CursorLatch::Latch(
+	const Offset* newestPos)
+{
+	if (!_isCursorDrawn || _drawnPosTimeUs < 0)
+	{
+		_presentedPosTimeUs = -1;
+		return { 0, 0 };
+	}
+
+	if (!newestPos)
+	{
+		_presentedPosTimeUs = _drawnPosTimeUs;
+		return { 0, 0 };
+	}
+
+	_presentedPosTimeUs = _clock->GetTimeUs();
+	return { newestPos->x - _drawnPos.x, newestPos->y - _drawnPos.y };
+}
+
+int64_t CursorLatch::EndFrame()
+{
+	const int64_t ageUs = _isCursorDrawn && _presentedPosTimeUs >= 0 ? _clock->GetTimeUs() - _presentedPosTimeUs : -1;
+
+	_isCursorDrawn = false;
+	_presentedPosTimeUs = -1;
+
+	return ageUs;
+}
@@ -0,0 +1,68 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "IClock.h"
+#include "Types.h"
+
+namespace d2dx
+{
+	/*
+		Moves the mouse cursor to the newest mouse position right before a frame is presented, rather than
+		leaving it where the game drew it, which may be most of a frame earlier.
+
+		The game draws the cursor at the position of the last mouse message it was given. The cursor is
+		moved by the difference between that position and the newest one, read just before presenting.
+		The age of the position that the cursor is presented at is measured either way.
+	*/
+	class CursorLatch final
+	{
+	public:
+		CursorLatch(
+			_In_ const std::shared_ptr<IClock>& clock);
+
+		CursorLatch(const CursorLatch&) = delete;
+		CursorLatch& operator=(const CursorLatch&) = delete;
+
+		/* A mouse message is delivered to the game. The position is in game coordinates. */
+		void OnGameMousePos(
+			_In_ Offset pos);
+
+		/* The game has drawn the cursor, at the position it was last given. */
+		void OnCursorDrawn();
+
+		/* Before presenting: returns how far to move the cursor to show it at the newest mouse position (in
+		   game coordinates). If that isn't known, or the cursor wasn't drawn, the cursor stays put. */
+		Offset Latch(
+			_In_opt_ const Offset* newestPos);
+
+		/* After presenting: returns the age of the presented cursor position in microseconds, or -1 if no
+		   cursor was presented. */
+		int64_t EndFrame();
+
+	private:
+		std::shared_ptr<IClock> _clock;
+		Offset _gamePos{ 0, 0 };
+		int64_t _gamePosTimeUs = -1;
+		Offset _drawnPos{ 0, 0 };
+		int64_t _drawnPosTimeUs = -1;
+		int64_t _presentedPosTimeUs = -1;
+		bool _isCursorDrawn = false;
+	};
+}
@@ -26,6 +26,7 @@
 #include "Metrics.h"
 #include "Utils.h"
 #include "Vertex.h"
+#include "Win32Sleeper.h"
 #include "dx256_bmp.h"
 
 using namespace d2dx;
@@ -39,6 +40,34 @@ extern uint32_t* currentlyDrawingWeatherParticleIndexPtr;
 #define D2DX_GLIDE_ALPHA_BLEND(rgb_sf, rgb_df, alpha_sf, alpha_df) \
 		(uint16_t)(((rgb_sf & 0xF) << 12) | ((rgb_df & 0xF) << 8) | ((alpha_sf & 0xF) << 4) | (alpha_df & 0xF))
 
+/* Replaces the bright white color code (0xFF 'c' '/') with white (0xFF 'c' '0') and returns the string length. */
+static uint32_t RemapColorCodes114d(
+	_Inout_z_ wchar_t* str)
+{
+	uint32_t i = 0;
+
+	for (; str[i]; ++i)
+	{
+		if (str[i] == 0xFF && str[i + 1] == L'c' && str[i + 2] == L'/')
+		{
+			str[i + 2] = L'0';
+		}
+	}
+
+	return i;
+}
+
+/* Returns the refresh rate of the primary display, or 60 Hz if it is unknown. */
+static uint32_t GetDisplayRefreshRate()
+{
+	DEVMODEA displayMode = { };
+	displayMode.dmSize = sizeof(displayMode);
+
+	/* Frequencies of 0 and 1 mean the hardware default. */
+	return EnumDisplaySettingsA(nullptr, ENUM_CURRENT_SETTINGS, &displayMode) && displayMode.dmDisplayFrequency > 1 ?
+		displayMode.dmDisplayFrequency : 60;
+}
+
 static Options GetCommandLineOptions()
 {
 	Options options;
@@ -52,29 +81,78 @@ _Use_decl_annotations_
 D2DXContext::D2DXContext(
 	const std::shared_ptr<IGameHelper>& gameHelper,
 	const std::shared_ptr<ISimd>& simd,
-	const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler) :
+	const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler,
+	const std::shared_ptr<IClock>& clock) :
 	_gameHelper{ gameHelper },
 	_simd{ simd },
 	_compatibilityModeDisabler{ compatibilityModeDisabler },
+	_clock{ clock },
 	_frame(0),
 	_majorGameState(MajorGameState::Unknown),
 	_paletteKeys(D2DX_MAX_PALETTES, true),
-	_batchCount(0),
-	_batches(D2DX_MAX_BATCHES_PER_FRAME),
-	_vertexCount(0),
-	_vertices(D2DX_MAX_VERTICES_PER_FRAME),
+	_batches(D2DX_BATCH_ARENA_CHUNK_SIZE, D2DX_MAX_BATCHES_PER_FRAME / D2DX_BATCH_ARENA_CHUNK_SIZE),
+	_vertices(D2DX_VERTEX_ARENA_CHUNK_SIZE, D2DX_MAX_VERTICES_PER_FRAME / D2DX_VERTEX_ARENA_CHUNK_SIZE),
+	_memoryBudget{ (uint32_t)MemoryConsumer::Count, _options.GetMemoryBudget() },
 	_customGameSize{ 0,0 },
 	_suggestedGameSize{ 0, 0 },
 	_options{ GetCommandLineOptions() },
 	_lastScreenOpenMode{ 0 },
-	_surfaceIdTracker{ gameHelper },
-	_textMotionPredictor{ gameHelper },
-	_unitMotionPredictor{ gameHelper },
-	_weatherMotionPredictor{ gameHelper },
+	_gameStateTracker{ gameHelper },
+	_unitMotionPredictor{ gameHelper, _options.GetMotionPredictionSettings() },
+	_lfbChangeDetector{ simd, 640, 480 },
+	_frameTimeTracker{ clock },
+	_cursorLatch{ clock },
+	_sleepPolicy{ clock },
+	_displayFrameIntervalUs{ 1000000 / GetDisplayRefreshRate() },
 	_featureFlags{ 0 }
 {
 	_threadId = GetCurrentThreadId();
 
+	if (_memoryBudget.GetBudget() > 0)
+	{
+		D2DX_LOG("Memory budget is %llu MB.", _memoryBudget.GetBudget() / (1024 * 1024));
+	}
+
+	_gameStateTracker.AddObserver(&_surfaceIdTracker);
+	_gameStateTracker.AddObserver(&_textMotionPredictor);
+	_gameStateTracker.AddObserver(&_unitMotionPredictor);
+	_gameStateTracker.AddObserver(&_weatherMotionPredictor);
+
+	if (_options.GetFlag(OptionsFlag::DbgMetrics))
+	{
+		_metrics = std::make_unique<MetricsRegistry>(4096);
+	}
+
+	if (_options.GetFlag(OptionsFlag::DbgMetrics) || _options.GetFlag(OptionsFlag::DbgCostOverlay))
+	{
+		_drawCosts = std::make_unique<DrawCostAttribution>(4096);
+	}
+
+	if (_options.GetTargetFps() > 0)
+	{
+		_framePacer = std::make_unique<FramePacer>(clock, std::make_shared<Win32Sleeper>(), _options.GetTargetFps());
+		D2DX_LOG("Pacing frames at %i fps.", _options.GetTargetFps());
+
+		/* Options rejects the render thread together with frame pacing. */
+		assert(!_options.GetFlag(OptionsFlag::RenderThread));
+	}
+
+	if (_options.GetFlag(OptionsFlag::DbgDumpTextures))
+	{
+		_textureDumper = std::make_unique<TextureDumper>(64, std::make_shared<PngTextureDumpSink>());
+	}
+
+#ifdef D2DX_TRACE
+	const FrameRange traceFrames = _options.GetTraceFrames();
+
+	if (traceFrames.first >= 0)
+	{
+		_tracer = std::make_unique<Tracer>(clock, 1024 * 1024);
+		_tracer->SetFrameRange(traceFrames.first, traceFrames.last);
+		Tracer::SetInstance(_tracer.get());
+	}
+#endif
+
 	if (!_options.GetFlag(OptionsFlag::NoCompatModeFix))
 	{
 		_compatibilityModeDisabler->DisableCompatibilityMode();
@@ -111,7 +189,37 @@ D2DXContext::D2DXContext(
 
 D2DXContext::~D2DXContext() noexcept
 {
+	if (_renderThread.joinable())
+	{
+		_stopRenderThread = true;
+		UnlockRenderContext();
+		_renderThread.join();
+	}
+
 	DetachLateDetours();
+	ExportMetrics();
+	_frameTimeTracker.LogSummary();
+
+	if (_framePacer)
+	{
+		_framePacer->LogSummary();
+	}
+
+	_sleepPolicy.LogSummary();
+
+	D2DX_LOG("Most batches/vertices in a frame: %u/%u.", _batches.GetHighWaterMark(), _vertices.GetHighWaterMark());
+
+	if (_renderContext)
+	{
+		D2DX_LOG("Texture caches committed %u kB.", _renderContext->GetTextureCacheStats().committedBytes / 1024);
+	}
+
+	if (_textureDumper)
+	{
+		_textureDumper->Flush();
+		D2DX_LOG("Dumped %llu textures (%llu dropped because the queue was full).",
+			_textureDumper->GetWrittenCount(), _textureDumper->GetDroppedCount());
+	}
 }
 
 _Use_decl_annotations_
@@ -222,12 +330,27 @@ void D2DXContext::OnSstWinOpen(
 			windowSize.width = width;
 			windowSize.height = height;
 		}
+		LockRenderContext();
 		_renderContext->SetSizes(gameSize, windowSize * _options.GetWindowScale());
 	}
 
-	_batchCount = 0;
-	_vertexCount = 0;
+	_batches.Reset();
+	_vertices.Reset();
 	_scratchBatch = Batch();
+
+	if (_renderLoop)
+	{
+		/* The last frame was drawn for the old size. */
+		_renderLoop->DropFrame();
+	}
+
+	UpdateMemoryBudget();
+	UnlockRenderContext();
+
+	if (_options.GetFlag(OptionsFlag::RenderThread) && !_renderThread.joinable())
+	{
+		StartRenderThread();
+	}
 }
 
 _Use_decl_annotations_
@@ -262,14 +385,16 @@ void D2DXContext::OnTexDownload(
 		return;
 	}
 
-	_textureHasher.Invalidate(startAddress);
+	const uint32_t memRequired = (uint32_t)(width * height);
 
-	uint32_t memRequired = (uint32_t)(width * height);
+	assert(memRequired <= (_glideState.tmuMemory.GetSize() - startAddress));
+	if (memRequired > (_glideState.tmuMemory.GetSize() - startAddress))
+	{
+		return;
+	}
 
-	auto pStart = _glideState.tmuMemory.items + startAddress;
-	auto pEnd = _glideState.tmuMemory.items + startAddress + memRequired;
-	assert(pEnd <= (_glideState.tmuMemory.items + _glideState.tmuMemory.capacity));
-	memcpy_s(pStart, _glideState.tmuMemory.capacity - startAddress, sourceAddress, memRequired);
+	_textureHasher.Invalidate(_glideState.tmuMemory, startAddress, memRequired);
+	_glideState.tmuMemory.Write(startAddress, sourceAddress, memRequired);
 }
 
 _Use_decl_annotations_
@@ -287,21 +412,22 @@ void D2DXContext::OnTexSource(
 
 	_readVertexState.isDirty = true;
 
-	uint8_t* pixels = _glideState.tmuMemory.items + startAddress;
 	const uint32_t pixelsSize = width * height;
+	const uint8_t* pixels = _glideState.tmuMemory.GetReadable(startAddress, pixelsSize);
 
 	int32_t stShift = 0;
 	_BitScanReverse((DWORD*)&stShift, max(width, height));
 	_glideState.stShift = 8 - stShift;
 
-	uint32_t hash = _textureHasher.GetHash(startAddress, pixels, pixelsSize);
+	uint32_t hash = _textureHasher.GetHash(_glideState.tmuMemory, startAddress, pixels, pixelsSize);
 
 	/* Patch the '5' to not look like '6'. */
 	if (hash == 0x8a12f6bb)
 	{
-		pixels[1 + 10 * 16] = 181;
-		pixels[2 + 10 * 16] = 181;
-		pixels[1 + 11 * 16] = 29;
+		uint8_t* patchedPixels = _glideState.tmuMemory.GetWritable(startAddress, pixelsSize);
+		patchedPixels[1 + 10 * 16] = 181;
+		patchedPixels[2 + 10 * 16] = 181;
+		patchedPixels[1 + 11 * 16] = 29;
 	}
 
 	_scratchBatch.SetTextureStartAddress(startAddress);
@@ -313,15 +439,15 @@ void D2DXContext::OnTexSource(
 		_scratchBatch.SetTextureCategory(_gameHelper->GetTextureCategoryFromHash(hash));
 	}
 
-	if (_options.GetFlag(OptionsFlag::DbgDumpTextures))
+	if (_textureDumper)
 	{
-		DumpTexture(hash, width, height, pixels, pixelsSize, (uint32_t)_scratchBatch.GetTextureCategory(), _glideState.palettes.items + _scratchBatch.GetPaletteIndex() * 256);
+		_textureDumper->TryDump(hash, width, height, pixels, (uint32_t)_scratchBatch.GetTextureCategory(), _glideState.palettes.items + _scratchBatch.GetPaletteIndex() * 256);
 	}
 }
 
 void D2DXContext::CheckMajorGameState()
 {
-	const int32_t batchCount = (int32_t)_batchCount;
+	const int32_t batchCount = (int32_t)_batches.GetCount();
 
 	if (_majorGameState == MajorGameState::Unknown && batchCount == 0)
 	{
@@ -330,7 +456,7 @@ void D2DXContext::CheckMajorGameState()
 
 	_majorGameState = MajorGameState::Menus;
 
-	if (_gameHelper->IsInGame())
+	if (_gameStateTracker.GetSnapshot().isInGame)
 	{
 		_majorGameState = MajorGameState::InGame;
 		AttachLateDetours(_gameHelper.get(), this);
@@ -339,8 +465,8 @@ void D2DXContext::CheckMajorGameState()
 	{
 		for (int32_t i = 0; i < batchCount; ++i)
 		{
-			const Batch& batch = _batches.items[i];
-			const int32_t y0 = _vertices.items[batch.GetStartVertex()].GetY();
+			const Batch& batch = _batches[i];
+			const int32_t y0 = _vertices[batch.GetStartVertex()].GetY();
 
 			if (batch.GetHash() == 0x4bea7b80 && y0 >= 550)
 			{
@@ -351,18 +477,18 @@ void D2DXContext::CheckMajorGameState()
 	}
 }
 
-_Use_decl_annotations_
-void D2DXContext::DrawBatches(
-	uint32_t startVertexLocation)
+void D2DXContext::DrawBatches()
 {
-	const int32_t batchCount = (int32_t)_batchCount;
+	const int32_t batchCount = (int32_t)_batches.GetCount();
 
 	Batch mergedBatch;
 	int32_t drawCalls = 0;
+	uint32_t chunkIndex = 0xFFFFFFFF;
+	uint32_t startVertexLocation = 0;
 
 	for (int32_t i = 0; i < batchCount; ++i)
 	{
-		const Batch& batch = _batches.items[i];
+		const Batch& batch = _batches[i];
 
 		if (!batch.IsValid())
 		{
@@ -370,6 +496,8 @@ void D2DXContext::DrawBatches(
 			continue;
 		}
 
+		const uint32_t batchChunkIndex = _vertices.GetChunkIndex(batch.GetStartVertex());
+
 		if (!mergedBatch.IsValid())
 		{
 			mergedBatch = batch;
@@ -379,10 +507,17 @@ void D2DXContext::DrawBatches(
 			if (_renderContext->GetTextureCache(batch) != _renderContext->GetTextureCache(mergedBatch) ||
 				batch.GetTextureAtlas() != mergedBatch.GetTextureAtlas() ||
 				batch.GetAlphaBlend() != mergedBatch.GetAlphaBlend() ||
+				batchChunkIndex != chunkIndex ||
 				((mergedBatch.GetVertexCount() + batch.GetVertexCount()) > 65535))
 			{
 				_renderContext->Draw(mergedBatch, startVertexLocation);
 				++drawCalls;
+
+				if (_drawCosts)
+				{
+					_drawCosts->AddDrawCall(mergedBatch.GetGameAddress(), mergedBatch.GetTextureCategory());
+				}
+
 				mergedBatch = batch;
 			}
 			else
@@ -390,12 +525,33 @@ void D2DXContext::DrawBatches(
 				mergedBatch.SetVertexCount(mergedBatch.GetVertexCount() + batch.GetVertexCount());
 			}
 		}
+
+		/* Each chunk of vertices is uploaded right before its batches are drawn. If the vertex buffer wraps
+		   around, the draws using the previous contents have then already been issued. */
+		if (batchChunkIndex != chunkIndex)
+		{
+			chunkIndex = batchChunkIndex;
+			startVertexLocation = _renderContext->BulkWriteVertices(_vertices.GetChunk(chunkIndex), _vertices.GetChunkUsedCount(chunkIndex));
+
+			/* The start vertex of a batch includes the chunk's offset; subtract it (modulo 2^32). */
+			startVertexLocation -= chunkIndex * _vertices.GetChunkSize();
+		}
 	}
 
 	if (mergedBatch.IsValid())
 	{
 		_renderContext->Draw(mergedBatch, startVertexLocation);
 		++drawCalls;
+
+		if (_drawCosts)
+		{
+			_drawCosts->AddDrawCall(mergedBatch.GetGameAddress(), mergedBatch.GetTextureCategory());
+		}
+	}
+
+	if (_metrics)
+	{
+		_metrics->Add(Metric::DrawCalls, drawCalls);
 	}
 
 	if (!(_frame & 255))
@@ -404,47 +560,544 @@ void D2DXContext::DrawBatches(
 	}
 }
 
+void D2DXContext::RecordFrameMetrics()
+{
+	const TextureCacheStats textureCacheStats = _renderContext->GetTextureCacheStats();
+	const StateChangeStats stateChangeStats = _renderContext->GetStateChangeStats();
+
+	_metrics->Add(Metric::Batches, _batches.GetCount());
+	_metrics->Add(Metric::Vertices, _vertices.GetCount());
+	_metrics->AddFromTotal(Metric::TextureFinds, textureCacheStats.finds);
+	_metrics->AddFromTotal(Metric::TextureMisses, textureCacheStats.misses);
+	_metrics->AddFromTotal(Metric::TextureUploadBytes, textureCacheStats.uploadBytes);
+	_metrics->AddFromTotal(Metric::HashCacheHits, _textureHasher.GetCacheHits());
+	_metrics->AddFromTotal(Metric::HashCacheMisses, _textureHasher.GetCacheMisses());
+	_metrics->AddFromTotal(Metric::StateChangesIssued, stateChangeStats.issued);
+	_metrics->AddFromTotal(Metric::StateChangesFiltered, stateChangeStats.filtered);
+
+	if (_textureDumper)
+	{
+		_metrics->AddFromTotal(Metric::TextureDumpDrops, _textureDumper->GetDroppedCount());
+	}
+
+	_metrics->Set(Metric::PredictedUnits, _unitMotionPredictor.GetTrackedCount());
+	_metrics->Set(Metric::PredictedTexts, _textMotionPredictor.GetTrackedCount());
+	_metrics->Set(Metric::PredictedWeatherParticles, _weatherMotionPredictor.GetTrackedCount());
+	_metrics->Set(Metric::TmuCommittedBytes, (int64_t)(_glideState.tmuMemory.GetCommittedBytes() + _glideState.sideTmuMemory.GetCommittedBytes()));
+	_metrics->Set(Metric::TextureCacheCommittedBytes, (int64_t)textureCacheStats.committedBytes);
+	_metrics->Set(Metric::MemoryUsedBytes, (int64_t)_memoryBudget.GetTotalUsage());
+	_metrics->Set(Metric::FrameTimeUs, (int64_t)(_renderContext->GetFrameTime() * 1000000.0f));
 
-void D2DXContext::OnBufferSwap()
+	/* Let the frame time tracker see this frame's counters, in case it was a hitch. */
+	_frameTimeTracker.EndFrame(_metrics.get());
+
+	_metrics->EndFrame();
+}
+
+void D2DXContext::UpdateMemoryBudget()
 {
-	CheckMajorGameState();
-	InsertLogoOnTitleScreen();
+	const uint64_t batchChunkBytes = (uint64_t)D2DX_BATCH_ARENA_CHUNK_SIZE * sizeof(Batch);
+	const uint64_t vertexChunkBytes = (uint64_t)D2DX_VERTEX_ARENA_CHUNK_SIZE * sizeof(Vertex);
+
+	/* These can't be resized, so they are only accounted for. */
+	const uint64_t vertexBufferBytes = _renderContext->GetVertexBufferSize();
+	const uint64_t tmuMemoryBytes = _glideState.tmuMemory.GetCommittedBytes() + _glideState.sideTmuMemory.GetCommittedBytes();
+	const uint64_t textureDumpQueueBytes = _textureDumper ? _textureDumper->GetMemoryFootprint() : 0;
+
+	_memoryBudget.SetLimits((uint32_t)MemoryConsumer::VertexBuffer, vertexBufferBytes, vertexBufferBytes);
+	_memoryBudget.SetLimits((uint32_t)MemoryConsumer::TmuMemory, tmuMemoryBytes, tmuMemoryBytes);
+	_memoryBudget.SetLimits((uint32_t)MemoryConsumer::TextureDumpQueue, textureDumpQueueBytes, textureDumpQueueBytes);
+
+	_memoryBudget.SetLimits((uint32_t)MemoryConsumer::BatchArena, batchChunkBytes, (uint64_t)D2DX_MAX_BATCHES_PER_FRAME * sizeof(Batch));
+	_memoryBudget.SetLimits((uint32_t)MemoryConsumer::VertexArena, vertexChunkBytes, (uint64_t)D2DX_MAX_VERTICES_PER_FRAME * sizeof(Vertex));
 
-	if (IsFeatureEnabled(Feature::UnitMotionPrediction) &&
-		_majorGameState == MajorGameState::InGame)
+	for (uint32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
 	{
-		const Offset offset = _unitMotionPredictor.GetOffset(_gameHelper->GetPlayerUnit());
+		const ITextureCache* textureCache = _renderContext->GetTextureCacheByIndex(i);
+		const uint32_t consumer = (uint32_t)MemoryConsumer::TextureCaches + i;
 
-		for (uint32_t i = 0; i < _batchCount; ++i)
+		_memoryBudget.SetLimits(consumer, textureCache->GetAtlasMemoryFootprint(), textureCache->GetMemoryFootprint());
+		_memoryBudget.ReportDemand(consumer, textureCache->GetMemoryDemand());
+	}
+
+	if (_memoryBudget.Rebalance())
+	{
+		_batches.SetMaxChunkCount((uint32_t)(_memoryBudget.GetAllowance((uint32_t)MemoryConsumer::BatchArena) / batchChunkBytes));
+		_vertices.SetMaxChunkCount((uint32_t)(_memoryBudget.GetAllowance((uint32_t)MemoryConsumer::VertexArena) / vertexChunkBytes));
+
+		for (uint32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
 		{
-			const auto& batch = _batches.items[i];
-			auto surfaceId = _vertices.items[batch.GetStartVertex()].GetSurfaceId();
+			_renderContext->GetTextureCacheByIndex(i)->SetMemoryLimit(
+				(uint32_t)_memoryBudget.GetAllowance((uint32_t)MemoryConsumer::TextureCaches + i));
+		}
 
-			if (surfaceId != D2DX_SURFACE_ID_USER_INTERFACE &&
+		/* Atlases used by the last frame may have been released. */
+		if (_renderLoop)
+		{
+			_renderLoop->DropFrame();
+		}
+	}
+
+	for (uint32_t i = 0; i < D2DX_TEXTURE_CACHE_COUNT; ++i)
+	{
+		_memoryBudget.ReportUsage((uint32_t)MemoryConsumer::TextureCaches + i, _renderContext->GetTextureCacheByIndex(i)->GetCommittedMemoryFootprint());
+	}
+
+	_memoryBudget.ReportUsage((uint32_t)MemoryConsumer::BatchArena, (uint64_t)_batches.GetCapacity() * sizeof(Batch));
+	_memoryBudget.ReportUsage((uint32_t)MemoryConsumer::VertexArena, (uint64_t)_vertices.GetCapacity() * sizeof(Vertex));
+	_memoryBudget.ReportUsage((uint32_t)MemoryConsumer::VertexBuffer, vertexBufferBytes);
+	_memoryBudget.ReportUsage((uint32_t)MemoryConsumer::TmuMemory, tmuMemoryBytes);
+	_memoryBudget.ReportUsage((uint32_t)MemoryConsumer::TextureDumpQueue, textureDumpQueueBytes);
+}
+
+void D2DXContext::StartRenderThread()
+{
+	const uint32_t refreshRate = GetDisplayRefreshRate();
+
+	const uint32_t maxVertexCount = _renderContext->GetVertexBufferSize() / sizeof(Vertex);
+
+	_renderLoop = std::make_unique<RenderLoop>(_clock, 1000000 / refreshRate, 40000, maxVertexCount);
+	_repeatVertices = Buffer<Vertex>{ maxVertexCount };
+	_renderContextLock = std::unique_lock<std::recursive_mutex>{ _renderContext->GetMutex(), std::defer_lock };
+	_renderThread = std::thread{ &D2DXContext::RunRenderThread, this };
+
+	D2DX_LOG("Started render thread, repeating frames at up to %u Hz.", refreshRate);
+}
+
+void D2DXContext::RunRenderThread()
+{
+	while (!_stopRenderThread)
+	{
+		const int64_t timeUntilRepeatUs = _renderLoop->GetTimeUntilRepeatUs();
+
+		/* Wake up early, since sleeps may overshoot by a millisecond or more. */
+		if (timeUntilRepeatUs > 2000)
+		{
+			Sleep((DWORD)min(timeUntilRepeatUs / 1000 - 1, (int64_t)4));
+			continue;
+		}
+		else if (timeUntilRepeatUs > 0)
+		{
+			Sleep(0);
+			continue;
+		}
+
+		Offset worldOffset{ 0, 0 };
+		bool wasRepeated = false;
+
+		{
+			/* Blocks while the game thread is drawing a frame. Presenting the repeat may release the lock. */
+			std::unique_lock<std::recursive_mutex> lock{ _renderContext->GetMutex() };
+
+			const RenderLoopFrame* frame = _renderLoop->BeginRepeat(&worldOffset);
+
+			if (frame)
+			{
+				DrawRepeatedFrame(*frame, worldOffset, lock);
+				wasRepeated = true;
+			}
+		}
+
+		if (!wasRepeated)
+		{
+			/* There is no frame that can be repeated, e.g. during a video. */
+			Sleep(1);
+		}
+	}
+}
+
+_Use_decl_annotations_
+void D2DXContext::DrawRepeatedFrame(
+	const RenderLoopFrame& frame,
+	Offset worldOffset,
+	std::unique_lock<std::recursive_mutex>& lock)
+{
+	memcpy(_repeatVertices.items, frame.vertices.items, sizeof(Vertex) * frame.vertexCount);
+
+	if (worldOffset.x != 0 || worldOffset.y != 0)
+	{
+		/* As in ApplyPlayerMotionOffset, the player and the UI stay in place. Weather particles only move
+		   with the camera: their own motion from WeatherMotionPredictor isn't extrapolated, since the frame
+		   doesn't record which vertices belong to which particle, so rain and snow stand still in repeats. */
+		for (uint32_t i = 0; i < frame.batchCount; ++i)
+		{
+			const Batch& batch = frame.batches.items[i];
+			Vertex* pVertices = &_repeatVertices.items[batch.GetStartVertex()];
+
+			if (pVertices->GetSurfaceId() != D2DX_SURFACE_ID_USER_INTERFACE &&
 				batch.GetTextureCategory() != TextureCategory::Player)
 			{
 				const auto batchVertexCount = batch.GetVertexCount();
-				auto vertexIndex = batch.GetStartVertex();
 				for (uint32_t j = 0; j < batchVertexCount; ++j)
 				{
-					_vertices.items[vertexIndex++].AddOffset(
-						-offset.x,
-						-offset.y);
+					pVertices[j].AddOffset(
+						worldOffset.x,
+						worldOffset.y);
 				}
 			}
 		}
 	}
 
-	auto startVertexLocation = _renderContext->BulkWriteVertices(_vertices.items, _vertexCount);
+	const uint32_t startVertexLocation = _renderContext->BulkWriteVertices(_repeatVertices.items, frame.vertexCount);
+
+	Batch mergedBatch;
 
-	DrawBatches(startVertexLocation);
+	for (uint32_t i = 0; i < frame.batchCount; ++i)
+	{
+		const Batch& batch = frame.batches.items[i];
 
-	_skipCountingSleep = true;
-	_renderContext->Present();
-	_skipCountingSleep = false;
+		if (!mergedBatch.IsValid())
+		{
+			mergedBatch = batch;
+		}
+		else if (_renderContext->GetTextureCache(batch) != _renderContext->GetTextureCache(mergedBatch) ||
+			batch.GetTextureAtlas() != mergedBatch.GetTextureAtlas() ||
+			batch.GetAlphaBlend() != mergedBatch.GetAlphaBlend() ||
+			((mergedBatch.GetVertexCount() + batch.GetVertexCount()) > 65535))
+		{
+			_renderContext->Draw(mergedBatch, startVertexLocation);
+			mergedBatch = batch;
+		}
+		else
+		{
+			mergedBatch.SetVertexCount(mergedBatch.GetVertexCount() + batch.GetVertexCount());
+		}
+	}
+
+	if (mergedBatch.IsValid())
+	{
+		_renderContext->Draw(mergedBatch, startVertexLocation);
+	}
+
+	_renderContext->PresentRepeat(lock);
+}
+
+void D2DXContext::LockRenderContext()
+{
+	/* Held until the end of the frame, so that the render thread only sees the render context between
+	   the game's frames. */
+	if (_renderThread.joinable() && !_renderContextLock.owns_lock())
+	{
+		_renderContextLock.lock();
+	}
+}
+
+void D2DXContext::UnlockRenderContext()
+{
+	if (_renderContextLock.owns_lock())
+	{
+		_renderContextLock.unlock();
+	}
+}
+
+void D2DXContext::AttributeBatchCosts()
+{
+	for (uint32_t i = 0; i < _batches.GetCount(); ++i)
+	{
+		const Batch& batch = _batches[i];
+		_drawCosts->AddBatch(batch.GetGameAddress(), batch.GetTextureCategory(), batch.GetVertexCount());
+	}
+}
+
+void D2DXContext::ApplyPlayerMotionOffset()
+{
+	if (!IsFeatureEnabled(Feature::UnitMotionPrediction) ||
+		_majorGameState != MajorGameState::InGame)
+	{
+		return;
+	}
+
+	D2DX_TRACE_SCOPE("ApplyPlayerMotionOffset");
+
+	const Offset offset = _unitMotionPredictor.GetOffset(_gameStateTracker.GetSnapshot().playerUnit);
+
+	for (uint32_t i = 0; i < _batches.GetCount(); ++i)
+	{
+		const auto& batch = _batches[i];
+		Vertex* pVertices = &_vertices[batch.GetStartVertex()];
+
+		if (pVertices->GetSurfaceId() != D2DX_SURFACE_ID_USER_INTERFACE &&
+			batch.GetTextureCategory() != TextureCategory::Player)
+		{
+			const auto batchVertexCount = batch.GetVertexCount();
+			for (uint32_t j = 0; j < batchVertexCount; ++j)
+			{
+				pVertices[j].AddOffset(
+					-offset.x,
+					-offset.y);
+			}
+		}
+	}
+}
+
+void D2DXContext::ApplyCursorLatch()
+{
+	Offset newestPos{ 0, 0 };
+	const bool hasNewestPos = !_options.GetFlag(OptionsFlag::NoLateCursor) && GetGameMousePos(&newestPos);
+
+	const Offset offset = _cursorLatch.Latch(hasNewestPos ? &newestPos : nullptr);
+
+	if (offset.x == 0 && offset.y == 0)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < _batches.GetCount(); ++i)
+	{
+		const auto& batch = _batches[i];
+
+		if (batch.GetTextureCategory() == TextureCategory::MousePointer)
+		{
+			Vertex* pVertices = &_vertices[batch.GetStartVertex()];
+
+			const auto batchVertexCount = batch.GetVertexCount();
+			for (uint32_t j = 0; j < batchVertexCount; ++j)
+			{
+				pVertices[j].AddOffset(
+					offset.x,
+					offset.y);
+			}
+		}
+	}
+}
+
+_Use_decl_annotations_
+bool D2DXContext::GetGameMousePos(
+	Offset* pos) const
+{
+	*pos = { 0, 0 };
+
+	POINT mousePos;
+	if (!GetCursorPos(&mousePos) || !ScreenToClient(_renderContext->GetHWnd(), &mousePos))
+	{
+		return false;
+	}
+
+	/* The inverse of the scaling in OnSetCursorPos, as applied to the window's mouse messages. */
+	Size gameSize;
+	Rect renderRect;
+	Size desktopSize;
+	_renderContext->GetCurrentMetrics(&gameSize, &renderRect, &desktopSize);
+
+	const bool isFullscreen = _renderContext->GetScreenMode() == ScreenMode::FullscreenDefault;
+	const float scale = (float)renderRect.size.height / gameSize.height;
+	const uint32_t scaledWidth = (uint32_t)(scale * gameSize.width);
+	const float mouseOffsetX = isFullscreen ? (float)(desktopSize.width / 2 - scaledWidth / 2) : 0.0f;
+
+	pos->x = max(0, min(gameSize.width - 1, (int32_t)(max(0.0f, mousePos.x - mouseOffsetX) / scale)));
+	pos->y = max(0, min(gameSize.height - 1, (int32_t)(mousePos.y / scale)));
+	return true;
+}
+
+void D2DXContext::FlushBatches()
+{
+	D2DX_TRACE_SCOPE("FlushBatches");
+	D2DX_DEBUG_LOG("Frame arena is full, drawing %u batches mid-frame.", _batches.GetCount());
+
+	LockRenderContext();
+
+	if (_drawCosts && !_skipAttributingBatchCosts)
+	{
+		AttributeBatchCosts();
+	}
+
+	ApplyPlayerMotionOffset();
+	DrawBatches();
+
+	if (_metrics)
+	{
+		_metrics->Add(Metric::Batches, _batches.GetCount());
+		_metrics->Add(Metric::Vertices, _vertices.GetCount());
+		_metrics->Add(Metric::MidFrameFlushes, 1);
+	}
+
+	_flushedBatchCount += _batches.GetCount();
+	_flushedVertexCount += _vertices.GetCount();
+
+	_batches.Reset();
+	_vertices.Reset();
+
+	/* Part of this frame is already drawn, so it mustn't be mistaken for a repeat of the previous one. */
+	_frameChangeDetector.Reset();
+}
+
+_Use_decl_annotations_
+Vertex* D2DXContext::AllocateVertices(
+	uint32_t count,
+	uint32_t* startVertex)
+{
+	/* Also make sure that there is room for the batch that will use the vertices. */
+	Vertex* pVertices = _batches.GetCount() < _batches.GetMaxCount() ? _vertices.Allocate(count, startVertex) : nullptr;
+
+	if (!pVertices)
+	{
+		FlushBatches();
+		pVertices = _vertices.Allocate(count, startVertex);
+	}
+
+	return pVertices;
+}
+
+_Use_decl_annotations_
+void D2DXContext::AddBatch(
+	const Batch& batch)
+{
+	uint32_t index;
+	Batch* pBatch = _batches.Allocate(1, &index);
+	assert(pBatch);
+
+	if (pBatch)
+	{
+		*pBatch = batch;
+	}
+}
+
+
+void D2DXContext::OnBufferSwap()
+{
+	LockRenderContext();
+
+	_gameStateTracker.Capture();
+
+	/* The screen no longer shows the last video frame. */
+	_lfbChangeDetector.Reset();
+
+	CheckMajorGameState();
+	InsertLogoOnTitleScreen();
+
+	if (_drawCosts)
+	{
+		AttributeBatchCosts();
+
+		/* Inserted after attributing the game's batches, so that the overlay's own vertices aren't counted.
+		   Making room for the overlay can flush the batches, which have then already been attributed. */
+		_skipAttributingBatchCosts = true;
+		InsertCostOverlay();
+		_skipAttributingBatchCosts = false;
+	}
+
+	if (_framePacer)
+	{
+		D2DX_TRACE_SCOPE("WaitForNextFrame");
+		_skipCountingSleep = true;
+		_framePacer->Wait();
+		_skipCountingSleep = false;
+	}
+
+	ApplyPlayerMotionOffset();
+	ApplyCursorLatch();
+
+	int64_t presentStartUs = _clock->GetTimeUs();
+	bool wasPresentedAgain = false;
+
+	/* A repeat from the render thread has replaced the game's last frame on screen. */
+	if (_renderLoop && _renderLoop->HasRepeatedSincePresent())
+	{
+		_frameChangeDetector.Reset();
+	}
+
+	/* Menus, and the game while it waits or is paused, often submit the same frame over and over. There's
+	   no need to draw and post-process those again. */
+	if (!_frameChangeDetector.Update(
+		_batches,
+		_vertices,
+		_paletteKeys.items, _paletteKeys.capacity,
+		_glideState.gammaTable.items, _glideState.gammaTable.capacity))
+	{
+		D2DX_TRACE_SCOPE("PresentAgain");
+		_skipCountingSleep = true;
+		wasPresentedAgain = _renderContext->PresentAgain();
+		_skipCountingSleep = false;
+	}
+
+	if (!wasPresentedAgain)
+	{
+		{
+			D2DX_TRACE_SCOPE("DrawBatches");
+			DrawBatches();
+		}
+
+		presentStartUs = _clock->GetTimeUs();
+
+		{
+			D2DX_TRACE_SCOPE("Present");
+			_skipCountingSleep = true;
+			_renderContext->Present();
+			_skipCountingSleep = false;
+		}
+	}
+
+	const int64_t cursorAgeUs = _cursorLatch.EndFrame();
+
+	if (_framePacer)
+	{
+		_framePacer->OnPresented();
+	}
+
+	_sleepPolicy.OnPresented();
+
+	if (_renderLoop)
+	{
+		if (_flushedBatchCount > 0)
+		{
+			/* Part of the frame was drawn mid-frame and is no longer in the arenas. */
+			_renderLoop->DropFrame();
+			_renderLoop->OnPresented();
+		}
+		else
+		{
+			const D2::UnitAny* playerUnit = _gameStateTracker.GetSnapshot().playerUnit;
+			const OffsetF cameraVelocity =
+				IsFeatureEnabled(Feature::UnitMotionPrediction) && _majorGameState == MajorGameState::InGame && playerUnit ?
+				_unitMotionPredictor.GetScreenVelocity(playerUnit) :
+				OffsetF{ 0.0f, 0.0f };
+
+			_renderLoop->SubmitFrame(_batches, _vertices, cameraVelocity);
+		}
+	}
+
+	if (_drawCosts)
+	{
+		_drawCosts->EndFrame();
+	}
+
+	if (_metrics)
+	{
+		_metrics->Add(Metric::RepeatedFrames, wasPresentedAgain ? 1 : 0);
+
+		if (_renderLoop)
+		{
+			_metrics->AddFromTotal(Metric::RenderThreadFrames, _renderLoop->GetRepeatCount());
+		}
+
+		_metrics->Set(Metric::PresentTimeUs, _clock->GetTimeUs() - presentStartUs);
+
+		if (cursorAgeUs >= 0)
+		{
+			_metrics->Set(Metric::CursorAgeUs, cursorAgeUs);
+		}
+
+		if (_framePacer)
+		{
+			_metrics->Set(Metric::PacingJitterUs, _framePacer->GetLastJitterUs());
+		}
+
+		RecordFrameMetrics();
+	}
+	else
+	{
+		_frameTimeTracker.EndFrame(nullptr);
+	}
 
 	++_frame;
 
+#ifdef D2DX_TRACE
+	if (_tracer && _tracer->OnNewFrame(_frame))
+	{
+		_tracer->Export("d2dx_trace.json");
+	}
+#endif
+
 	if (!(_frame & 255))
 	{
 		_textureHasher.PrintStats();
@@ -453,10 +1106,28 @@ void D2DXContext::OnBufferSwap()
 		_sleeps = 0;
 	}
 
-	_batchCount = 0;
-	_vertexCount = 0;
+	/* The arenas are sized by what the whole frame needed, including any mid-frame flushes. */
+	const uint32_t batchCount = _flushedBatchCount + _batches.GetCount();
+	const uint32_t vertexCount = _flushedVertexCount + _vertices.GetCount();
+
+	_memoryBudget.ReportDemand((uint32_t)MemoryConsumer::BatchArena,
+		(uint64_t)((batchCount + D2DX_BATCH_ARENA_CHUNK_SIZE - 1) / D2DX_BATCH_ARENA_CHUNK_SIZE) * D2DX_BATCH_ARENA_CHUNK_SIZE * sizeof(Batch));
+	_memoryBudget.ReportDemand((uint32_t)MemoryConsumer::VertexArena,
+		(uint64_t)((vertexCount + D2DX_VERTEX_ARENA_CHUNK_SIZE - 1) / D2DX_VERTEX_ARENA_CHUNK_SIZE) * D2DX_VERTEX_ARENA_CHUNK_SIZE * sizeof(Vertex));
 
-	_lastScreenOpenMode = _gameHelper->ScreenOpenMode();
+	_flushedBatchCount = 0;
+	_flushedVertexCount = 0;
+
+	_batches.Reset();
+	_vertices.Reset();
+
+	/* Caches are resized between frames, when nothing refers to their contents. */
+	if (!(_frame & 63))
+	{
+		UpdateMemoryBudget();
+	}
+
+	_lastScreenOpenMode = _gameStateTracker.GetSnapshot().screenOpenMode;
 
 	_surfaceIdTracker.OnNewFrame();
 
@@ -465,6 +1136,9 @@ void D2DXContext::OnBufferSwap()
 	_avgDir = { 0.0f, 0.0f };
 
 	_readVertexState.isDirty = true;
+
+	/* Let the render thread repeat this frame until the game delivers the next one. */
+	UnlockRenderContext();
 }
 
 _Use_decl_annotations_
@@ -561,7 +1235,6 @@ void D2DXContext::OnDrawPoint(
 {
 	Batch batch = _scratchBatch;
 	batch.SetGameAddress(GameAddress::Unknown);
-	batch.SetStartVertex(_vertexCount);
 
 	EnsureReadVertexStateUpdated(batch);
 
@@ -584,17 +1257,24 @@ void D2DXContext::OnDrawPoint(
 	vertex1.AddOffset(1, 0);
 	vertex2.AddOffset(1, 1);
 
-	assert((_vertexCount + 3) < _vertices.capacity);
-	_vertices.items[_vertexCount++] = vertex0;
-	_vertices.items[_vertexCount++] = vertex1;
-	_vertices.items[_vertexCount++] = vertex2;
+	uint32_t startVertex;
+	Vertex* pVertices = AllocateVertices(3, &startVertex);
+
+	if (!pVertices)
+	{
+		return;
+	}
+
+	pVertices[0] = vertex0;
+	pVertices[1] = vertex1;
+	pVertices[2] = vertex2;
 
+	batch.SetStartVertex(startVertex);
 	batch.SetVertexCount(3);
 
-	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
+	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, pVertices, batch.GetVertexCount());
 
-	assert(_batchCount < _batches.capacity);
-	_batches.items[_batchCount++] = batch;
+	AddBatch(batch);
 }
 
 _Use_decl_annotations_
@@ -605,7 +1285,6 @@ void D2DXContext::OnDrawLine(
 {
 	Batch batch = _scratchBatch;
 	batch.SetGameAddress(GameAddress::DrawLine);
-	batch.SetStartVertex(_vertexCount);
 	batch.SetPaletteIndex(D2DX_WHITE_PALETTE_INDEX);
 	batch.SetTextureCategory(TextureCategory::UserInterface);
 
@@ -627,7 +1306,7 @@ void D2DXContext::OnDrawLine(
 		currentlyDrawingWeatherParticles)
 	{
 		uint32_t currentWeatherParticleIndex = *currentlyDrawingWeatherParticleIndexPtr;
-		const int32_t act = _gameHelper->GetCurrentAct();
+		const int32_t act = _gameStateTracker.GetSnapshot().currentAct;
 
 		OffsetF startPos{ d2Vertex0->x, d2Vertex0->y };
 		OffsetF endPos{ d2Vertex1->x, d2Vertex1->y };
@@ -687,24 +1366,31 @@ void D2DXContext::OnDrawLine(
 		vertex3.SetColor(c);
 		vertex4.SetColor(c);
 
-		assert((_vertexCount + 3 * 4) < _vertices.capacity);
+		uint32_t startVertex;
+		Vertex* pVertices = AllocateVertices(3 * 4, &startVertex);
 
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex1;
-		_vertices.items[_vertexCount++] = vertex2;
+		if (!pVertices)
+		{
+			return;
+		}
+
+		pVertices[0] = vertex0;
+		pVertices[1] = vertex1;
+		pVertices[2] = vertex2;
 
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex2;
-		_vertices.items[_vertexCount++] = vertex3;
+		pVertices[3] = vertex0;
+		pVertices[4] = vertex2;
+		pVertices[5] = vertex3;
 
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex3;
-		_vertices.items[_vertexCount++] = vertex4;
+		pVertices[6] = vertex0;
+		pVertices[7] = vertex3;
+		pVertices[8] = vertex4;
 
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex4;
-		_vertices.items[_vertexCount++] = vertex1;
+		pVertices[9] = vertex0;
+		pVertices[10] = vertex4;
+		pVertices[11] = vertex1;
 
+		batch.SetStartVertex(startVertex);
 		batch.SetVertexCount(3 * 4);
 
 		_lastWeatherParticleIndex = currentWeatherParticleIndex;
@@ -736,19 +1422,26 @@ void D2DXContext::OnDrawLine(
 			(int32_t)(d2Vertex1->x + wideningVec.x),
 			(int32_t)(d2Vertex1->y + wideningVec.y));
 
-		assert((_vertexCount + 6) < _vertices.capacity);
-		_vertices.items[_vertexCount++] = vertex0;
-		_vertices.items[_vertexCount++] = vertex1;
-		_vertices.items[_vertexCount++] = vertex2;
-		_vertices.items[_vertexCount++] = vertex1;
-		_vertices.items[_vertexCount++] = vertex2;
-		_vertices.items[_vertexCount++] = vertex3;
+		uint32_t startVertex;
+		Vertex* pVertices = AllocateVertices(6, &startVertex);
+
+		if (!pVertices)
+		{
+			return;
+		}
+
+		pVertices[0] = vertex0;
+		pVertices[1] = vertex1;
+		pVertices[2] = vertex2;
+		pVertices[3] = vertex1;
+		pVertices[4] = vertex2;
+		pVertices[5] = vertex3;
 
+		batch.SetStartVertex(startVertex);
 		batch.SetVertexCount(6);
 	}
 
-	assert(_batchCount < _batches.capacity);
-	_batches.items[_batchCount++] = batch;
+	AddBatch(batch);
 }
 
 _Use_decl_annotations_
@@ -756,11 +1449,17 @@ const Batch D2DXContext::PrepareBatchForSubmit(
 	Batch batch,
 	PrimitiveType primitiveType,
 	uint32_t vertexCount,
-	uint32_t gameContext) const
+	uint32_t gameContext)
 {
+	D2DX_TRACE_SCOPE("PrepareBatchForSubmit");
+
 	auto gameAddress = _gameHelper->IdentifyGameAddress(gameContext);
 
-	auto tcl = _renderContext->UpdateTexture(batch, _glideState.tmuMemory.items, _glideState.tmuMemory.capacity);
+	LockRenderContext();
+
+	const TextureCacheStats statsBefore = _drawCosts ? _renderContext->GetTextureCacheStats() : TextureCacheStats{ };
+
+	auto tcl = _renderContext->UpdateTexture(batch, _glideState.tmuMemory.GetData(), _glideState.tmuMemory.GetSize());
 
 	if (tcl._textureAtlas < 0)
 	{
@@ -771,9 +1470,24 @@ const Batch D2DXContext::PrepareBatchForSubmit(
 	batch.SetTextureIndex(tcl._textureIndex);
 
 	batch.SetGameAddress(gameAddress);
-	batch.SetStartVertex(_vertexCount);
 	batch.SetVertexCount(vertexCount);
 	batch.SetTextureCategory(_gameHelper->RefineTextureCategoryFromGameAddress(batch.GetTextureCategory(), gameAddress));
+
+	if (batch.GetTextureCategory() == TextureCategory::MousePointer)
+	{
+		_cursorLatch.OnCursorDrawn();
+	}
+
+	if (_drawCosts)
+	{
+		const TextureCacheStats statsAfter = _renderContext->GetTextureCacheStats();
+
+		if (statsAfter.misses != statsBefore.misses)
+		{
+			_drawCosts->AddTextureMiss(gameAddress, batch.GetTextureCategory(), (uint32_t)(statsAfter.uploadBytes - statsBefore.uploadBytes));
+		}
+	}
+
 	return batch;
 }
 
@@ -831,7 +1545,15 @@ void D2DXContext::OnDrawVertexArray(
 	const uint32_t iteratedColorMask = _readVertexState.iteratedColorMask;
 	const uint32_t maskedConstantColor = _readVertexState.maskedConstantColor;
 
-	Vertex* pVertices = &_vertices.items[_vertexCount];
+	uint32_t startVertex;
+	Vertex* pVertices = AllocateVertices(batch.GetVertexCount(), &startVertex);
+
+	if (!pVertices)
+	{
+		return;
+	}
+
+	batch.SetStartVertex(startVertex);
 
 	for (int32_t i = 0; i < 3; ++i)
 	{
@@ -871,12 +1593,9 @@ void D2DXContext::OnDrawVertexArray(
 		}
 	}
 
-	_vertexCount += 3 * (count - 2);
-
-	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
+	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices[startVertex], batch.GetVertexCount());
 
-	assert(_batchCount < _batches.capacity);
-	_batches.items[_batchCount++] = batch;
+	AddBatch(batch);
 }
 
 _Use_decl_annotations_
@@ -912,7 +1631,15 @@ void D2DXContext::OnDrawVertexArrayContiguous(
 
 	Vertex v = _readVertexState.templateVertex;
 
-	Vertex* pVertices = &_vertices.items[_vertexCount];
+	uint32_t startVertex;
+	Vertex* pVertices = AllocateVertices(6, &startVertex);
+
+	if (!pVertices)
+	{
+		return;
+	}
+
+	batch.SetStartVertex(startVertex);
 
 	for (int32_t i = 0; i < 4; ++i)
 	{
@@ -925,12 +1652,9 @@ void D2DXContext::OnDrawVertexArrayContiguous(
 	pVertices[4] = pVertices[0];
 	pVertices[5] = pVertices[2];
 
-	_vertexCount += 6;
-
-	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, &_vertices.items[batch.GetStartVertex()], batch.GetVertexCount());
+	_surfaceIdTracker.UpdateBatchSurfaceId(batch, _majorGameState, _gameSize, pVertices, batch.GetVertexCount());
 
-	assert(_batchCount < _batches.capacity);
-	_batches.items[_batchCount++] = batch;
+	AddBatch(batch);
 }
 
 _Use_decl_annotations_
@@ -982,6 +1706,7 @@ void D2DXContext::OnTexDownloadTable(
 				memcpy(_glideState.palettes.items + 256 * i, palette, 1024);
 			}
 
+			LockRenderContext();
 			_renderContext->SetPalette(i, palette);
 			return;
 		}
@@ -1012,6 +1737,7 @@ void D2DXContext::OnLoadGammaTable(
 		_glideState.gammaTable.items[i] = ((blue[i] & 0xFF) << 16) | ((green[i] & 0xFF) << 8) | (red[i] & 0xFF);
 	}
 
+	LockRenderContext();
 	_renderContext->LoadGammaTable(_glideState.gammaTable.items, _glideState.gammaTable.capacity);
 }
 
@@ -1020,7 +1746,24 @@ void D2DXContext::OnLfbUnlock(
 	const uint32_t* lfbPtr,
 	uint32_t strideInBytes)
 {
+	/* Videos often repeat frames. There's no need to upload and present those again. */
+	if (!_lfbChangeDetector.Update(lfbPtr, strideInBytes))
+	{
+		return;
+	}
+
+	LockRenderContext();
+
 	_renderContext->WriteToScreen(lfbPtr, 640, 480);
+
+	if (_renderLoop)
+	{
+		/* The video frame replaces whatever the game drew. */
+		_renderLoop->DropFrame();
+		_renderLoop->OnPresented();
+	}
+
+	UnlockRenderContext();
 }
 
 _Use_decl_annotations_
@@ -1043,7 +1786,11 @@ void D2DXContext::OnGammaCorrectionRGB(
 		gammaTable[i] = (ri << 16) | (gi << 8) | bi;
 	}
 
+	LockRenderContext();
 	_renderContext->LoadGammaTable(gammaTable, ARRAYSIZE(gammaTable));
+
+	/* This table isn't part of the glide state that frames are compared by. */
+	_frameChangeDetector.Reset();
 }
 
 void D2DXContext::PrepareLogoTextureBatch()
@@ -1067,7 +1814,7 @@ void D2DXContext::PrepareLogoTextureBatch()
 
 	uint32_t hash = fnv_32a_buf((void*)srcPixels, sizeof(uint8_t) * 81 * 40, FNV1_32A_INIT);
 
-	uint8_t* data = _glideState.sideTmuMemory.items;
+	uint8_t* data = _glideState.sideTmuMemory.GetWritable(0, 128 * 128);
 
 	_logoTextureBatch.SetTextureStartAddress(0);
 	_logoTextureBatch.SetTextureHash(hash);
@@ -1093,16 +1840,15 @@ void D2DXContext::PrepareLogoTextureBatch()
 
 void D2DXContext::InsertLogoOnTitleScreen()
 {
-	if (_options.GetFlag(OptionsFlag::NoLogo) || _majorGameState != MajorGameState::TitleScreen || _batchCount <= 0)
+	if (_options.GetFlag(OptionsFlag::NoLogo) || _majorGameState != MajorGameState::TitleScreen || _batches.GetCount() == 0)
 		return;
 
 	PrepareLogoTextureBatch();
 
-	auto tcl = _renderContext->UpdateTexture(_logoTextureBatch, _glideState.sideTmuMemory.items, _glideState.sideTmuMemory.capacity);
+	auto tcl = _renderContext->UpdateTexture(_logoTextureBatch, _glideState.sideTmuMemory.GetData(), _glideState.sideTmuMemory.GetSize());
 
 	_logoTextureBatch.SetTextureAtlas(tcl._textureAtlas);
 	_logoTextureBatch.SetTextureIndex(tcl._textureIndex);
-	_logoTextureBatch.SetStartVertex(_vertexCount);
 
 	Size gameSize;
 	_renderContext->GetCurrentMetrics(&gameSize, nullptr, nullptr);
@@ -1116,15 +1862,154 @@ void D2DXContext::InsertLogoOnTitleScreen()
 	Vertex vertex2(x + 80, y + 41, 80, 41, color, true, _logoTextureBatch.GetTextureIndex(), D2DX_LOGO_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
 	Vertex vertex3(x, y + 41, 0, 41, color, true, _logoTextureBatch.GetTextureIndex(), D2DX_LOGO_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
 
-	assert((_vertexCount + 6) < _vertices.capacity);
-	_vertices.items[_vertexCount++] = vertex0;
-	_vertices.items[_vertexCount++] = vertex1;
-	_vertices.items[_vertexCount++] = vertex2;
-	_vertices.items[_vertexCount++] = vertex0;
-	_vertices.items[_vertexCount++] = vertex2;
-	_vertices.items[_vertexCount++] = vertex3;
+	uint32_t startVertex;
+	Vertex* pVertices = AllocateVertices(6, &startVertex);
+
+	if (!pVertices)
+	{
+		return;
+	}
+
+	pVertices[0] = vertex0;
+	pVertices[1] = vertex1;
+	pVertices[2] = vertex2;
+	pVertices[3] = vertex0;
+	pVertices[4] = vertex2;
+	pVertices[5] = vertex3;
 
-	_batches.items[_batchCount++] = _logoTextureBatch;
+	_logoTextureBatch.SetStartVertex(startVertex);
+	AddBatch(_logoTextureBatch);
+}
+
+void D2DXContext::PrepareCostOverlayTextureBatch()
+{
+	if (_costOverlayTextureBatch.IsValid())
+	{
+		return;
+	}
+
+	/* A small blank texture placed after the logo. With the white palette, the bars get the vertex color. */
+	const int32_t startAddress = 128 * 128;
+	uint8_t* data = _glideState.sideTmuMemory.GetWritable(startAddress, 8 * 8);
+	memset(data, 1, 8 * 8);
+
+	_costOverlayTextureBatch.SetTextureStartAddress(startAddress);
+	_costOverlayTextureBatch.SetTextureHash(fnv_32a_buf(data, 8 * 8, FNV1_32A_INIT));
+	_costOverlayTextureBatch.SetTextureSize(8, 8);
+	_costOverlayTextureBatch.SetTextureCategory(TextureCategory::UserInterface);
+	_costOverlayTextureBatch.SetAlphaBlend(AlphaBlend::Opaque);
+	_costOverlayTextureBatch.SetIsChromaKeyEnabled(false);
+	_costOverlayTextureBatch.SetRgbCombine(RgbCombine::ColorMultipliedByTexture);
+	_costOverlayTextureBatch.SetAlphaCombine(AlphaCombine::One);
+	_costOverlayTextureBatch.SetPaletteIndex(D2DX_WHITE_PALETTE_INDEX);
+}
+
+void D2DXContext::InsertCostOverlay()
+{
+	const uint32_t rowCount = (uint32_t)GameAddress::Count + (uint32_t)TextureCategory::Count;
+	const uint32_t maxOverlayVertexCount = rowCount * 3 * 6;
+
+	if (!_options.GetFlag(OptionsFlag::DbgCostOverlay) ||
+		_batches.GetCount() == 0)
+	{
+		return;
+	}
+
+	PrepareCostOverlayTextureBatch();
+
+	auto tcl = _renderContext->UpdateTexture(_costOverlayTextureBatch, _glideState.sideTmuMemory.GetData(), _glideState.sideTmuMemory.GetSize());
+
+	if (tcl._textureAtlas < 0)
+	{
+		return;
+	}
+
+	_costOverlayTextureBatch.SetTextureAtlas(tcl._textureAtlas);
+	_costOverlayTextureBatch.SetTextureIndex(tcl._textureIndex);
+
+	uint32_t startVertex;
+	Vertex* pVertices = AllocateVertices(maxOverlayVertexCount, &startVertex);
+
+	if (!pVertices)
+	{
+		return;
+	}
+
+	Vertex* pOverlayVertices = pVertices;
+
+	/* Every batch and draw call has both a game address and a texture category, so either group gives the frame total. */
+	uint32_t totalVertices = 0;
+	uint32_t totalDrawCalls = 0;
+
+	for (int32_t i = 0; i < (int32_t)GameAddress::Count; ++i)
+	{
+		totalVertices += _drawCosts->GetLastFrame((GameAddress)i, DrawCost::Vertices);
+		totalDrawCalls += _drawCosts->GetLastFrame((GameAddress)i, DrawCost::DrawCalls);
+	}
+
+	const int32_t barWidth = 200;
+
+	for (uint32_t row = 0; row < rowCount; ++row)
+	{
+		const bool isGameAddress = row < (uint32_t)GameAddress::Count;
+
+		const uint32_t vertices = isGameAddress ?
+			_drawCosts->GetLastFrame((GameAddress)row, DrawCost::Vertices) :
+			_drawCosts->GetLastFrame((TextureCategory)(row - (uint32_t)GameAddress::Count), DrawCost::Vertices);
+
+		const uint32_t drawCalls = isGameAddress ?
+			_drawCosts->GetLastFrame((GameAddress)row, DrawCost::DrawCalls) :
+			_drawCosts->GetLastFrame((TextureCategory)(row - (uint32_t)GameAddress::Count), DrawCost::DrawCalls);
+
+		const int32_t x = 16;
+		const int32_t y = 16 + (int32_t)row * 8 + (isGameAddress ? 0 : 4);
+
+		pVertices = AddCostOverlayRect(pVertices, { x, y, barWidth, 1 }, 0xFF404040);
+
+		if (vertices > 0)
+		{
+			pVertices = AddCostOverlayRect(pVertices, { x, y + 1, max(1, (int32_t)((uint64_t)barWidth * vertices / max(1U, totalVertices))), 4 }, isGameAddress ? 0xFF40A0FF : 0xFF40FF80);
+		}
+
+		if (drawCalls > 0)
+		{
+			pVertices = AddCostOverlayRect(pVertices, { x, y + 5, max(1, (int32_t)((uint64_t)barWidth * drawCalls / max(1U, totalDrawCalls))), 2 }, 0xFFFFFFFF);
+		}
+	}
+
+	const uint32_t overlayVertexCount = (uint32_t)(pVertices - pOverlayVertices);
+	_vertices.ShrinkLastAllocation(maxOverlayVertexCount - overlayVertexCount);
+
+	_costOverlayTextureBatch.SetStartVertex(startVertex);
+	_costOverlayTextureBatch.SetVertexCount(overlayVertexCount);
+	AddBatch(_costOverlayTextureBatch);
+}
+
+_Use_decl_annotations_
+Vertex* D2DXContext::AddCostOverlayRect(
+	Vertex* pVertices,
+	const Rect& rect,
+	uint32_t color)
+{
+	const int32_t x0 = rect.offset.x;
+	const int32_t y0 = rect.offset.y;
+	const int32_t x1 = rect.offset.x + rect.size.width;
+	const int32_t y1 = rect.offset.y + rect.size.height;
+	const int32_t textureIndex = _costOverlayTextureBatch.GetTextureIndex();
+
+	Vertex vertex0(x0, y0, 0, 0, color, false, textureIndex, D2DX_WHITE_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
+	Vertex vertex1(x1, y0, 8, 0, color, false, textureIndex, D2DX_WHITE_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
+	Vertex vertex2(x1, y1, 8, 8, color, false, textureIndex, D2DX_WHITE_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
+	Vertex vertex3(x0, y1, 0, 8, color, false, textureIndex, D2DX_WHITE_PALETTE_INDEX, D2DX_SURFACE_ID_USER_INTERFACE);
+
+	pVertices[0] = vertex0;
+	pVertices[1] = vertex1;
+	pVertices[2] = vertex2;
+	pVertices[3] = vertex0;
+	pVertices[4] = vertex2;
+	pVertices[5] = vertex3;
+
+	return pVertices + 6;
 }
 
 GameVersion D2DXContext::GetGameVersion() const
@@ -1192,6 +2077,13 @@ Offset D2DXContext::OnMouseMoveMessage(
 	return pos;
 }
 
+_Use_decl_annotations_
+void D2DXContext::OnGameMouseMove(
+	Offset pos)
+{
+	_cursorLatch.OnGameMousePos(pos);
+}
+
 _Use_decl_annotations_
 int32_t D2DXContext::OnSleep(
 	int32_t ms)
@@ -1203,12 +2095,21 @@ int32_t D2DXContext::OnSleep(
 
 	++_sleeps;
 
-	if (_majorGameState == MajorGameState::InGame)
+	if (_metrics)
+	{
+		_metrics->Add(Metric::Sleeps, 1);
+	}
+
+	if (!_options.GetFlag(OptionsFlag::AdaptiveSleep))
 	{
 		return ms;
 	}
 
-	return ms;
+	return _sleepPolicy.OnSleep(
+		_majorGameState,
+		ms,
+		_framePacer ? _framePacer->GetIntervalUs() : _displayFrameIntervalUs,
+		_framePacer ? _framePacer->GetWakeTimeUs() : -1);
 }
 
 _Use_decl_annotations_
@@ -1262,16 +2163,19 @@ void D2DXContext::OnBufferClear()
 	{
 		if (IsFeatureEnabled(Feature::UnitMotionPrediction))
 		{
+			D2DX_TRACE_SCOPE("UnitMotionPredictor::Update");
 			_unitMotionPredictor.Update(_renderContext.get());
 		}
 
 		if (IsFeatureEnabled(Feature::TextMotionPrediction))
 		{
+			D2DX_TRACE_SCOPE("TextMotionPredictor::Update");
 			_textMotionPredictor.Update(_renderContext.get());
 		}
 
 		if (IsFeatureEnabled(Feature::WeatherMotionPrediction))
 		{
+			D2DX_TRACE_SCOPE("WeatherMotionPredictor::Update");
 			_weatherMotionPredictor.Update(_renderContext.get());
 		}
 	}
@@ -1294,27 +2198,24 @@ Offset D2DXContext::BeginDrawText(
 		return offset;
 	}
 
-	if (d2Function != D2Function::D2Win_DrawText && IsFeatureEnabled(Feature::TextMotionPrediction))
-	{
-		auto hash = fnv_32a_buf((void*)str, wcslen(str), FNV1_32A_INIT);
-
-		const uint64_t textId = 
-			(((uint64_t)(returnAddress & 0xFFFFFF) << 40ULL) |
-			((uint64_t)((uintptr_t)str & 0xFFFFFF) << 16ULL)) ^
-			(uint64_t)hash;
-
-		offset = _textMotionPredictor.GetOffset(textId, pos);
-	}
+	uint32_t length = 0;
 
 	if (_gameHelper->GetVersion() == GameVersion::Lod114d)
 	{
-		// In 1.14d, some color codes are black. Remap them.
+		// In 1.14d, some color codes are black. Remap them (and get the length in the same pass).
+		length = RemapColorCodes114d(str);
+	}
 
-		// Bright white -> white
-		while (wchar_t* subStr = wcsstr(str, L"c/"))
+	if (d2Function != D2Function::D2Win_DrawText && IsFeatureEnabled(Feature::TextMotionPrediction))
+	{
+		if (!length)
 		{
-			subStr[2] = L'0';
+			length = (uint32_t)wcslen(str);
 		}
+
+		const uint64_t textId = _textMotionPredictor.GetTextId(returnAddress, str, length);
+
+		offset = _textMotionPredictor.GetOffset(textId, pos);
 	}
 
 	return offset;
@@ -1344,7 +2245,7 @@ Offset D2DXContext::BeginDrawImage(
 	{
 		_unitMotionPredictor.SetUnitScreenPos(currentlyDrawingUnit, pos.x, pos.y);
 
-		if (currentlyDrawingUnit == _gameHelper->GetPlayerUnit())
+		if (currentlyDrawingUnit == _gameStateTracker.GetSnapshot().playerUnit)
 		{
 			// The player unit itself.
 			_scratchBatch.SetTextureCategory(TextureCategory::Player);
@@ -1438,3 +2339,15 @@ bool D2DXContext::IsFeatureEnabled(
 
 	return (_featureFlags & (uint32_t)feature) != 0;
 }
+
+void D2DXContext::ExportMetrics()
+{
+	if (!_metrics)
+	{
+		return;
+	}
+
+	const MetricsFormat format = _options.GetMetricsFormat();
+	_metrics->Export(format == MetricsFormat::Json ? "d2dx_metrics.json" : "d2dx_metrics.csv", format);
+	_drawCosts->Export(format == MetricsFormat::Json ? "d2dx_drawcosts.json" : "d2dx_drawcosts.csv", format);
+}
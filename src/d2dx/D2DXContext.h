@@ -22,13 +22,29 @@
 #include "Buffer.h"
 #include "IBuiltinResMod.h"
 #include "ID2DXContext.h"
+#include "IClock.h"
 #include "IGameHelper.h"
 #include "IGlide3x.h"
 #include "IRenderContext.h"
 #include "IWin32InterceptionHandler.h"
 #include "CompatibilityModeDisabler.h"
+#include "CursorLatch.h"
+#include "DrawCostAttribution.h"
+#include "FrameArena.h"
+#include "FrameChangeDetector.h"
+#include "FramePacer.h"
+#include "FrameTimeTracker.h"
+#include "GameStateTracker.h"
+#include "LfbChangeDetector.h"
+#include "MemoryBudget.h"
+#include "MetricsRegistry.h"
+#include "RenderLoop.h"
+#include "SleepPolicy.h"
 #include "SurfaceIdTracker.h"
+#include "TextureDumper.h"
 #include "TextureHasher.h"
+#include "TmuMemory.h"
+#include "Tracer.h"
 #include "TextMotionPredictor.h"
 #include "UnitMotionPredictor.h"
 #include "WeatherMotionPredictor.h"
@@ -45,7 +61,8 @@ namespace d2dx
 		D2DXContext(
 			_In_ const std::shared_ptr<IGameHelper>& gameHelper,
 			_In_ const std::shared_ptr<ISimd>& simd,
-			_In_ const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler);
+			_In_ const std::shared_ptr<CompatibilityModeDisabler>& compatibilityModeDisabler,
+			_In_ const std::shared_ptr<IClock>& clock);
 		
 		virtual ~D2DXContext() noexcept;
 
@@ -170,6 +187,8 @@ namespace d2dx
 		virtual bool IsFeatureEnabled(
 			_In_ Feature feature) override;
 
+		virtual void ExportMetrics() override;
+
 #pragma endregion ID2DXContext
 
 #pragma region IWin32InterceptionHandler
@@ -180,6 +199,9 @@ namespace d2dx
 		virtual Offset OnMouseMoveMessage(
 			_In_ Offset pos) override;
 
+		virtual void OnGameMouseMove(
+			_In_ Offset pos) override;
+
 		virtual int32_t OnSleep(
 			_In_ int32_t ms) override;
 
@@ -206,28 +228,82 @@ namespace d2dx
 #pragma endregion ID2InterceptionHandler
 
 	private:		
+		enum class MemoryConsumer
+		{
+			TextureCaches = 0,
+			BatchArena = D2DX_TEXTURE_CACHE_COUNT,
+			VertexArena,
+			VertexBuffer,
+			TmuMemory,
+			TextureDumpQueue,
+			Count
+		};
+
 		void CheckMajorGameState();
 
 		void PrepareLogoTextureBatch();
 
 		void InsertLogoOnTitleScreen();
 
-		void DrawBatches(
-			_In_ uint32_t startVertexLocation);
+		void PrepareCostOverlayTextureBatch();
+
+		void InsertCostOverlay();
+
+		Vertex* AddCostOverlayRect(
+			_Out_writes_(6) Vertex* pVertices,
+			_In_ const Rect& rect,
+			_In_ uint32_t color);
+
+		void DrawBatches();
+
+		void FlushBatches();
+
+		void AttributeBatchCosts();
+
+		void ApplyPlayerMotionOffset();
+
+		void ApplyCursorLatch();
+
+		bool GetGameMousePos(
+			_Out_ Offset* pos) const;
+
+		Vertex* AllocateVertices(
+			_In_ uint32_t count,
+			_Out_ uint32_t* startVertex);
+
+		void AddBatch(
+			_In_ const Batch& batch);
+
+		void RecordFrameMetrics();
+
+		void UpdateMemoryBudget();
+
+		void StartRenderThread();
+
+		void RunRenderThread();
+
+		void DrawRepeatedFrame(
+			_In_ const RenderLoopFrame& frame,
+			_In_ Offset worldOffset,
+			_Inout_ std::unique_lock<std::recursive_mutex>& lock);
+
+		void LockRenderContext();
+
+		void UnlockRenderContext();
 
 		const Batch PrepareBatchForSubmit(
 			_In_ Batch batch,
 			_In_ PrimitiveType primitiveType,
 			_In_ uint32_t vertexCount,
-			_In_ uint32_t gameContext) const;
+			_In_ uint32_t gameContext);
 		
 		void EnsureReadVertexStateUpdated(
 			_In_ const Batch& batch);
 
 		struct GlideState
 		{
-			Buffer<uint8_t> tmuMemory{ D2DX_TMU_MEMORY_SIZE };
-			Buffer<uint8_t> sideTmuMemory{ D2DX_SIDE_TMU_MEMORY_SIZE };
+			TmuMemory tmuMemory{ D2DX_TMU_MEMORY_SIZE };
+			TmuMemory sideTmuMemory{ D2DX_SIDE_TMU_MEMORY_SIZE };
 			Buffer<uint32_t> palettes{ D2DX_MAX_PALETTES * 256 };
 			Buffer<uint32_t> gammaTable{ 256 };
 			uint32_t constantColor{ 0xFFFFFFFF };
@@ -254,24 +330,45 @@ namespace d2dx
 		std::shared_ptr<ISimd> _simd;
 		std::unique_ptr<IBuiltinResMod> _builtinResMod;
 		std::shared_ptr<CompatibilityModeDisabler> _compatibilityModeDisabler;
+		std::shared_ptr<IClock> _clock;
+		Options _options;
 		TextureHasher _textureHasher;
+		GameStateTracker _gameStateTracker;
 		UnitMotionPredictor _unitMotionPredictor;
 		TextMotionPredictor _textMotionPredictor;
 		WeatherMotionPredictor _weatherMotionPredictor;
 		SurfaceIdTracker _surfaceIdTracker;
+		LfbChangeDetector _lfbChangeDetector;
+		FrameChangeDetector _frameChangeDetector;
+		std::unique_ptr<MetricsRegistry> _metrics;
+		std::unique_ptr<DrawCostAttribution> _drawCosts;
+		FrameTimeTracker _frameTimeTracker;
+		CursorLatch _cursorLatch;
+		std::unique_ptr<FramePacer> _framePacer;
+		SleepPolicy _sleepPolicy;
+		int64_t _displayFrameIntervalUs;
+		std::unique_ptr<Tracer> _tracer;
+		std::unique_ptr<TextureDumper> _textureDumper;
 
 		MajorGameState _majorGameState;
 
 		Buffer<uint32_t> _paletteKeys;
 
-		uint32_t _batchCount;
-		Buffer<Batch> _batches;
+		FrameArena<Batch> _batches;
+		FrameArena<Vertex> _vertices;
+		uint32_t _flushedBatchCount = 0;
+		uint32_t _flushedVertexCount = 0;
 
-		uint32_t _vertexCount;
-		Buffer<Vertex> _vertices;
+		MemoryBudget _memoryBudget;
+
+		std::unique_ptr<RenderLoop> _renderLoop;
+		std::thread _renderThread;
+		std::atomic<bool> _stopRenderThread{ false };
+		std::unique_lock<std::recursive_mutex> _renderContextLock;
+		Buffer<Vertex> _repeatVertices;
 
-		Options _options;
 		Batch _logoTextureBatch;
+		Batch _costOverlayTextureBatch;
 		
 		Size _customGameSize;
 		Size _suggestedGameSize;
@@ -291,6 +388,7 @@ namespace d2dx
 		uint32_t _featureFlags;
 
 		bool _skipCountingSleep = false;
+		bool _skipAttributingBatchCosts = false;
 		int32_t _sleeps = 0;
 		uint32_t _threadId = 0;
 	};
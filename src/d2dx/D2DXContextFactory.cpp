@@ -22,6 +22,7 @@
 #include "SimdSse2.h"
 #include "D2DXContext.h"
 #include "CompatibilityModeDisabler.h"
+#include "QpcClock.h"
 
 using namespace d2dx;
 
@@ -38,7 +39,8 @@ ID2DXContext* D2DXContextFactory::GetInstance(
 		auto gameHelper = std::make_shared<GameHelper>();
 		auto simd = std::make_shared<SimdSse2>();
 		auto compatibilityModeDisabler = std::make_shared<CompatibilityModeDisabler>();
-		instance = std::make_shared<D2DXContext>(gameHelper, simd, compatibilityModeDisabler);
+		auto clock = std::make_shared<QpcClock>();
+		instance = std::make_shared<D2DXContext>(gameHelper, simd, compatibilityModeDisabler, clock);
 	}
 
 	return instance.get();
@@ -0,0 +1,195 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+namespace d2dx
+{
+	/*
+		Shadows the pipeline state bound on a device context, and drops binds that wouldn't change it.
+
+		Every Set call is counted as either issued (passed on to the device context) or filtered. The
+		device context type is a template parameter so that the filtering can be tested with a fake that
+		records the calls; it needs the same methods as ID3D11DeviceContext for the state that is shadowed.
+
+		The shadow state assumes that nothing else binds these states. Call Invalidate after anything that
+		may have changed them behind the cache's back, e.g. ClearState.
+	*/
+	template<typename TDeviceContext>
+	class DeviceContextStateCache final
+	{
+	public:
+		DeviceContextStateCache(
+			_In_ TDeviceContext* deviceContext) noexcept :
+			_deviceContext{ deviceContext }
+		{
+			assert(deviceContext);
+
+			/* A new device context has everything unbound, which is all zeroes. */
+			memset(&_state, 0, sizeof(_state));
+		}
+
+		DeviceContextStateCache(const DeviceContextStateCache&) = delete;
+		DeviceContextStateCache& operator=(const DeviceContextStateCache&) = delete;
+
+		/* Forgets the shadowed state, so that the next binds are all issued. */
+		void Invalidate() noexcept
+		{
+			/* No valid state is all ones (the viewport is NaNs), so everything will compare different. */
+			memset(&_state, 0xFF, sizeof(_state));
+		}
+
+		void SetVertexShader(
+			_In_opt_ ID3D11VertexShader* vs) noexcept
+		{
+			if (IsChanged(vs != _state.vs))
+			{
+				_deviceContext->VSSetShader(vs, nullptr, 0);
+				_state.vs = vs;
+			}
+		}
+
+		void SetPixelShader(
+			_In_opt_ ID3D11PixelShader* ps) noexcept
+		{
+			if (IsChanged(ps != _state.ps))
+			{
+				_deviceContext->PSSetShader(ps, nullptr, 0);
+				_state.ps = ps;
+			}
+		}
+
+		void SetPixelShaderResources(
+			_In_opt_ ID3D11ShaderResourceView* srv0,
+			_In_opt_ ID3D11ShaderResourceView* srv1) noexcept
+		{
+			if (IsChanged(srv0 != _state.psSrvs[0] || srv1 != _state.psSrvs[1]))
+			{
+				_state.psSrvs[0] = srv0;
+				_state.psSrvs[1] = srv1;
+				_deviceContext->PSSetShaderResources(0, 2, _state.psSrvs);
+			}
+		}
+
+		void SetBlendState(
+			_In_opt_ ID3D11BlendState* blendState) noexcept
+		{
+			if (IsChanged(blendState != _state.bs))
+			{
+				const float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+				_deviceContext->OMSetBlendState(blendState, blendFactor, 0xffffffff);
+				_state.bs = blendState;
+			}
+		}
+
+		void SetRasterizerState(
+			_In_opt_ ID3D11RasterizerState* rs) noexcept
+		{
+			if (IsChanged(rs != _state.rs))
+			{
+				_deviceContext->RSSetState(rs);
+				_state.rs = rs;
+			}
+		}
+
+		void SetRenderTargets(
+			_In_opt_ ID3D11RenderTargetView* rtv0,
+			_In_opt_ ID3D11RenderTargetView* rtv1) noexcept
+		{
+			if (IsChanged(rtv0 != _state.rtvs[0] || rtv1 != _state.rtvs[1]))
+			{
+				_state.rtvs[0] = rtv0;
+				_state.rtvs[1] = rtv1;
+				_deviceContext->OMSetRenderTargets(2, _state.rtvs, nullptr);
+			}
+		}
+
+		void SetViewport(
+			_In_ const D3D11_VIEWPORT& viewport) noexcept
+		{
+			if (IsChanged(memcmp(&viewport, &_state.viewport, sizeof(D3D11_VIEWPORT)) != 0))
+			{
+				_deviceContext->RSSetViewports(1, &viewport);
+				_state.viewport = viewport;
+			}
+		}
+
+		void SetScissorRect(
+			_In_ const D3D11_RECT& scissorRect) noexcept
+		{
+			if (IsChanged(memcmp(&scissorRect, &_state.scissorRect, sizeof(D3D11_RECT)) != 0))
+			{
+				_deviceContext->RSSetScissorRects(1, &scissorRect);
+				_state.scissorRect = scissorRect;
+			}
+		}
+
+		void SetPrimitiveTopology(
+			_In_ D3D11_PRIMITIVE_TOPOLOGY topology) noexcept
+		{
+			if (IsChanged(topology != _state.topology))
+			{
+				_deviceContext->IASetPrimitiveTopology(topology);
+				_state.topology = topology;
+			}
+		}
+
+		/* Running totals. */
+		uint64_t GetIssuedCount() const noexcept
+		{
+			return _issuedCount;
+		}
+
+		uint64_t GetFilteredCount() const noexcept
+		{
+			return _filteredCount;
+		}
+
+	private:
+		struct State final
+		{
+			ID3D11VertexShader* vs;
+			ID3D11PixelShader* ps;
+			ID3D11ShaderResourceView* psSrvs[2];
+			ID3D11BlendState* bs;
+			ID3D11RasterizerState* rs;
+			ID3D11RenderTargetView* rtvs[2];
+			D3D11_VIEWPORT viewport;
+			D3D11_RECT scissorRect;
+			D3D11_PRIMITIVE_TOPOLOGY topology;
+		};
+
+		inline bool IsChanged(
+			_In_ bool isDifferent) noexcept
+		{
+			if (isDifferent)
+			{
+				++_issuedCount;
+				return true;
+			}
+
+			++_filteredCount;
+			return false;
+		}
+
+		TDeviceContext* _deviceContext;
+		State _state;
+		uint64_t _issuedCount = 0;
+		uint64_t _filteredCount = 0;
+	};
+}
@@ -0,0 +1,306 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "DrawCostAttribution.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+namespace
+{
+	const char* drawCostNames[] =
+	{
+		"vertices",
+		"batches",
+		"draw_calls",
+		"texture_misses",
+		"texture_upload_bytes",
+	};
+
+	const char* gameAddressNames[] =
+	{
+		"unknown",
+		"draw_wall1",
+		"draw_wall2",
+		"draw_floor",
+		"draw_shadow",
+		"draw_dynamic",
+		"draw_something1",
+		"draw_line",
+	};
+
+	const char* textureCategoryNames[] =
+	{
+		"unknown",
+		"mouse_pointer",
+		"player",
+		"loading_screen",
+		"floor",
+		"title_screen",
+		"wall",
+		"user_interface",
+	};
+
+	static_assert(ARRAYSIZE(drawCostNames) == (size_t)DrawCost::Count, "Missing draw cost name.");
+	static_assert(ARRAYSIZE(gameAddressNames) == (size_t)GameAddress::Count, "Missing game address name.");
+	static_assert(ARRAYSIZE(textureCategoryNames) == (size_t)TextureCategory::Count, "Missing texture category name.");
+}
+
+_Use_decl_annotations_
+DrawCostAttribution::DrawCostAttribution(
+	uint32_t historyLength) :
+	_current{ FrameSize, true },
+	_totals{ FrameSize, true },
+	_history{ historyLength * FrameSize, true },
+	_historyLength{ historyLength }
+{
+	assert(historyLength > 0);
+}
+
+_Use_decl_annotations_
+void DrawCostAttribution::AddBatch(
+	GameAddress gameAddress,
+	TextureCategory textureCategory,
+	uint32_t vertexCount) noexcept
+{
+	Add(gameAddress, textureCategory, DrawCost::Batches, 1);
+	Add(gameAddress, textureCategory, DrawCost::Vertices, vertexCount);
+}
+
+_Use_decl_annotations_
+void DrawCostAttribution::AddDrawCall(
+	GameAddress gameAddress,
+	TextureCategory textureCategory) noexcept
+{
+	Add(gameAddress, textureCategory, DrawCost::DrawCalls, 1);
+}
+
+_Use_decl_annotations_
+void DrawCostAttribution::AddTextureMiss(
+	GameAddress gameAddress,
+	TextureCategory textureCategory,
+	uint32_t uploadBytes) noexcept
+{
+	Add(gameAddress, textureCategory, DrawCost::TextureMisses, 1);
+	Add(gameAddress, textureCategory, DrawCost::TextureUploadBytes, uploadBytes);
+}
+
+_Use_decl_annotations_
+void DrawCostAttribution::Add(
+	GameAddress gameAddress,
+	TextureCategory textureCategory,
+	DrawCost cost,
+	uint32_t value) noexcept
+{
+	assert((uint32_t)gameAddress < (uint32_t)GameAddress::Count);
+	assert((uint32_t)textureCategory < (uint32_t)TextureCategory::Count);
+
+	_current.items[GetIndex(gameAddress, cost)] += value;
+	_current.items[GetIndex(textureCategory, cost)] += value;
+}
+
+void DrawCostAttribution::EndFrame() noexcept
+{
+	uint32_t* row = &_history.items[(uint32_t)(_frameCount % _historyLength) * FrameSize];
+
+	/* Keep the totals covering exactly the frames in the history, by removing the frame being replaced. */
+	const bool isReplacingFrame = _frameCount >= _historyLength;
+
+	for (uint32_t i = 0; i < FrameSize; ++i)
+	{
+		if (isReplacingFrame)
+		{
+			_totals.items[i] -= row[i];
+		}
+
+		_totals.items[i] += _current.items[i];
+		row[i] = _current.items[i];
+		_current.items[i] = 0;
+	}
+
+	++_frameCount;
+}
+
+uint32_t DrawCostAttribution::GetHistoryCount() const noexcept
+{
+	return (uint32_t)min(_frameCount, (uint64_t)_historyLength);
+}
+
+_Use_decl_annotations_
+uint32_t DrawCostAttribution::GetLastFrame(
+	GameAddress gameAddress,
+	DrawCost cost) const noexcept
+{
+	return GetLastFrame(GetIndex(gameAddress, cost));
+}
+
+_Use_decl_annotations_
+uint32_t DrawCostAttribution::GetLastFrame(
+	TextureCategory textureCategory,
+	DrawCost cost) const noexcept
+{
+	return GetLastFrame(GetIndex(textureCategory, cost));
+}
+
+_Use_decl_annotations_
+uint32_t DrawCostAttribution::GetLastFrame(
+	uint32_t index) const noexcept
+{
+	if (_frameCount == 0)
+	{
+		return 0;
+	}
+
+	return _history.items[(uint32_t)((_frameCount - 1) % _historyLength) * FrameSize + index];
+}
+
+_Use_decl_annotations_
+uint64_t DrawCostAttribution::GetTotal(
+	GameAddress gameAddress,
+	DrawCost cost) const noexcept
+{
+	return _totals.items[GetIndex(gameAddress, cost)];
+}
+
+_Use_decl_annotations_
+uint64_t DrawCostAttribution::GetTotal(
+	TextureCategory textureCategory,
+	DrawCost cost) const noexcept
+{
+	return _totals.items[GetIndex(textureCategory, cost)];
+}
+
+_Use_decl_annotations_
+void DrawCostAttribution::Write(
+	FILE* file,
+	MetricsFormat format) const
+{
+	if (format == MetricsFormat::Json)
+	{
+		WriteJson(file);
+	}
+	else
+	{
+		WriteCsv(file);
+	}
+}
+
+_Use_decl_annotations_
+bool DrawCostAttribution::Export(
+	const char* path,
+	MetricsFormat format) const
+{
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, path, "w") != 0 || !file)
+	{
+		D2DX_LOG("Failed to open %s for writing draw costs.", path);
+		return false;
+	}
+
+	Write(file, format);
+	fclose(file);
+
+	D2DX_LOG("Wrote draw costs for %u frames to %s.", GetHistoryCount(), path);
+	return true;
+}
+
+_Use_decl_annotations_
+const char* DrawCostAttribution::GetName(
+	DrawCost cost) noexcept
+{
+	return drawCostNames[(int32_t)cost];
+}
+
+_Use_decl_annotations_
+const char* DrawCostAttribution::GetName(
+	GameAddress gameAddress) noexcept
+{
+	return gameAddressNames[(int32_t)gameAddress];
+}
+
+_Use_decl_annotations_
+const char* DrawCostAttribution::GetName(
+	TextureCategory textureCategory) noexcept
+{
+	return textureCategoryNames[(int32_t)textureCategory];
+}
+
+_Use_decl_annotations_
+void DrawCostAttribution::WriteCsv(
+	FILE* file) const
+{
+	fprintf(file, "group,name,frames");
+
+	for (int32_t i = 0; i < (int32_t)DrawCost::Count; ++i)
+	{
+		fprintf(file, ",%s", drawCostNames[i]);
+	}
+
+	fprintf(file, "\n");
+
+	const uint32_t historyCount = GetHistoryCount();
+
+	for (uint32_t row = 0; row < RowCount; ++row)
+	{
+		const bool isGameAddress = row < (uint32_t)GameAddress::Count;
+
+		fprintf(file, "%s,%s,%u",
+			isGameAddress ? "game_address" : "texture_category",
+			isGameAddress ? gameAddressNames[row] : textureCategoryNames[row - (uint32_t)GameAddress::Count],
+			historyCount);
+
+		for (int32_t i = 0; i < (int32_t)DrawCost::Count; ++i)
+		{
+			fprintf(file, ",%llu", (unsigned long long)_totals.items[row * (uint32_t)DrawCost::Count + i]);
+		}
+
+		fprintf(file, "\n");
+	}
+}
+
+_Use_decl_annotations_
+void DrawCostAttribution::WriteJson(
+	FILE* file) const
+{
+	fprintf(file, "{\n\t\"frames\": %u", GetHistoryCount());
+
+	for (uint32_t row = 0; row < RowCount; ++row)
+	{
+		const bool isGameAddress = row < (uint32_t)GameAddress::Count;
+
+		if (row == 0 || row == (uint32_t)GameAddress::Count)
+		{
+			fprintf(file, "%s,\n\t\"%s\": [", row > 0 ? "\n\t]" : "", isGameAddress ? "game_addresses" : "texture_categories");
+		}
+
+		fprintf(file, "%s\n\t\t{ \"name\": \"%s\"",
+			(row == 0 || row == (uint32_t)GameAddress::Count) ? "" : ",",
+			isGameAddress ? gameAddressNames[row] : textureCategoryNames[row - (uint32_t)GameAddress::Count]);
+
+		for (int32_t i = 0; i < (int32_t)DrawCost::Count; ++i)
+		{
+			fprintf(file, ", \"%s\": %llu", drawCostNames[i], (unsigned long long)_totals.items[row * (uint32_t)DrawCost::Count + i]);
+		}
+
+		fprintf(file, " }");
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+}
@@ -0,0 +1,147 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "Options.h"
+#include "Types.h"
+
+namespace d2dx
+{
+	enum class DrawCost
+	{
+		Vertices,
+		Batches,
+		DrawCalls,
+		TextureMisses,
+		TextureUploadBytes,
+		Count
+	};
+
+	/*
+		Breaks down the per-frame rendering costs by the game address that submitted the batches, and by
+		texture category. Keeps a rolling history of the most recent frames, and writes the costs summed
+		over that history as CSV or JSON.
+
+		Merged draw calls are attributed to the first batch of the merge.
+	*/
+	class DrawCostAttribution final
+	{
+	public:
+		DrawCostAttribution(
+			_In_ uint32_t historyLength);
+
+		DrawCostAttribution(const DrawCostAttribution&) = delete;
+		DrawCostAttribution& operator=(const DrawCostAttribution&) = delete;
+
+		void AddBatch(
+			_In_ GameAddress gameAddress,
+			_In_ TextureCategory textureCategory,
+			_In_ uint32_t vertexCount) noexcept;
+
+		void AddDrawCall(
+			_In_ GameAddress gameAddress,
+			_In_ TextureCategory textureCategory) noexcept;
+
+		void AddTextureMiss(
+			_In_ GameAddress gameAddress,
+			_In_ TextureCategory textureCategory,
+			_In_ uint32_t uploadBytes) noexcept;
+
+		/* Moves the current frame into the history, and starts a new frame from zero. */
+		void EndFrame() noexcept;
+
+		uint32_t GetHistoryCount() const noexcept;
+
+		/* Costs of the most recently ended frame. */
+		uint32_t GetLastFrame(
+			_In_ GameAddress gameAddress,
+			_In_ DrawCost cost) const noexcept;
+
+		uint32_t GetLastFrame(
+			_In_ TextureCategory textureCategory,
+			_In_ DrawCost cost) const noexcept;
+
+		/* Costs summed over the frames in the history. */
+		uint64_t GetTotal(
+			_In_ GameAddress gameAddress,
+			_In_ DrawCost cost) const noexcept;
+
+		uint64_t GetTotal(
+			_In_ TextureCategory textureCategory,
+			_In_ DrawCost cost) const noexcept;
+
+		void Write(
+			_In_ FILE* file,
+			_In_ MetricsFormat format) const;
+
+		bool Export(
+			_In_z_ const char* path,
+			_In_ MetricsFormat format) const;
+
+		static _Ret_z_ const char* GetName(
+			_In_ DrawCost cost) noexcept;
+
+		static _Ret_z_ const char* GetName(
+			_In_ GameAddress gameAddress) noexcept;
+
+		static _Ret_z_ const char* GetName(
+			_In_ TextureCategory textureCategory) noexcept;
+
+	private:
+		/* Each frame holds a row of costs per game address, followed by a row per texture category. */
+		static constexpr uint32_t RowCount = (uint32_t)GameAddress::Count + (uint32_t)TextureCategory::Count;
+		static constexpr uint32_t FrameSize = RowCount * (uint32_t)DrawCost::Count;
+
+		static inline uint32_t GetIndex(
+			_In_ GameAddress gameAddress,
+			_In_ DrawCost cost) noexcept
+		{
+			return (uint32_t)gameAddress * (uint32_t)DrawCost::Count + (uint32_t)cost;
+		}
+
+		static inline uint32_t GetIndex(
+			_In_ TextureCategory textureCategory,
+			_In_ DrawCost cost) noexcept
+		{
+			return ((uint32_t)GameAddress::Count + (uint32_t)textureCategory) * (uint32_t)DrawCost::Count + (uint32_t)cost;
+		}
+
+		void Add(
+			_In_ GameAddress gameAddress,
+			_In_ TextureCategory textureCategory,
+			_In_ DrawCost cost,
+			_In_ uint32_t value) noexcept;
+
+		uint32_t GetLastFrame(
+			_In_ uint32_t index) const noexcept;
+
+		void WriteCsv(
+			_In_ FILE* file) const;
+
+		void WriteJson(
+			_In_ FILE* file) const;
+
+		Buffer<uint32_t> _current;
+		Buffer<uint64_t> _totals;
+		Buffer<uint32_t> _history;
+		uint32_t _historyLength = 0;
+		uint64_t _frameCount = 0;
+	};
+}
@@ -0,0 +1,237 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	/*
+		Per-frame storage for batches and vertices, allocated in fixed-size chunks.
+
+		Only the chunks a frame actually needs are allocated, and they are kept for the following frames.
+		Growing never moves existing elements, and resetting for the next frame is O(1). An allocation is
+		always contiguous, so it may skip the end of a chunk; an index is chunkIndex * chunkSize + offset.
+
+		The number of chunks is bounded (indices must fit in a batch), and Allocate returns nullptr when the
+		arena is full. The caller is then expected to flush what it has and Reset. The bound can be lowered
+		between frames to save memory, at the cost of more flushes.
+	*/
+	template<typename T>
+	class FrameArena final
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "FrameArena elements must be trivially copyable.");
+
+	public:
+		FrameArena(
+			_In_ uint32_t chunkSize,
+			_In_ uint32_t maxChunkCount) noexcept :
+			_chunks{ maxChunkCount, true },
+			_chunkUsedCounts{ maxChunkCount, true },
+			_chunkSize{ chunkSize },
+			_chunkShift{ 0 },
+			_maxChunkCount{ maxChunkCount }
+		{
+			assert(chunkSize > 0 && !(chunkSize & (chunkSize - 1)));
+			assert(maxChunkCount > 0);
+
+			while ((1U << _chunkShift) < chunkSize)
+			{
+				++_chunkShift;
+			}
+		}
+
+		~FrameArena() noexcept
+		{
+			for (uint32_t i = 0; i < _allocatedChunkCount; ++i)
+			{
+				_aligned_free(_chunks.items[i]);
+			}
+		}
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		/* Allocates count contiguous elements, and returns them along with the index of the first one. Returns
+		   nullptr if the arena is full. */
+		T* Allocate(
+			_In_ uint32_t count,
+			_Out_ uint32_t* index) noexcept
+		{
+			assert(count <= _chunkSize);
+
+			*index = 0;
+
+			if (count > _chunkSize)
+			{
+				return nullptr;
+			}
+
+			if ((_chunkUsedCounts.items[_chunkIndex] + count) > _chunkSize)
+			{
+				if ((_chunkIndex + 1) >= _maxChunkCount)
+				{
+					return nullptr;
+				}
+
+				++_chunkIndex;
+				_chunkUsedCounts.items[_chunkIndex] = 0;
+			}
+
+			if (_chunkIndex >= _allocatedChunkCount)
+			{
+				_chunks.items[_chunkIndex] = (T*)_aligned_malloc(sizeof(T) * _chunkSize, 256);
+
+				if (!_chunks.items[_chunkIndex])
+				{
+					D2DX_FATAL_ERROR("Out of memory.");
+				}
+
+				++_allocatedChunkCount;
+			}
+
+			const uint32_t offset = _chunkUsedCounts.items[_chunkIndex];
+			_chunkUsedCounts.items[_chunkIndex] += count;
+			_count += count;
+			_highWaterMark = max(_highWaterMark, _count);
+
+			*index = (_chunkIndex << _chunkShift) + offset;
+			return _chunks.items[_chunkIndex] + offset;
+		}
+
+		/* Gives back the unused end of the most recent allocation. */
+		void ShrinkLastAllocation(
+			_In_ uint32_t unusedCount) noexcept
+		{
+			assert(unusedCount <= _chunkUsedCounts.items[_chunkIndex]);
+			_chunkUsedCounts.items[_chunkIndex] -= unusedCount;
+			_count -= unusedCount;
+		}
+
+		/* Makes all chunks available for the next frame. */
+		void Reset() noexcept
+		{
+			_chunkIndex = 0;
+			_chunkUsedCounts.items[0] = 0;
+			_count = 0;
+		}
+
+		/* Limits the number of chunks, and frees the chunks beyond the limit. Must be called right after Reset. */
+		void SetMaxChunkCount(
+			_In_ uint32_t maxChunkCount) noexcept
+		{
+			assert(_count == 0);
+
+			_maxChunkCount = min(_chunks.capacity, max(1U, maxChunkCount));
+
+			while (_allocatedChunkCount > _maxChunkCount)
+			{
+				--_allocatedChunkCount;
+				_aligned_free(_chunks.items[_allocatedChunkCount]);
+				_chunks.items[_allocatedChunkCount] = nullptr;
+			}
+		}
+
+		inline uint32_t GetMaxChunkCount() const noexcept
+		{
+			return _maxChunkCount;
+		}
+
+		/* The most elements the arena can hold with its current chunk limit. */
+		inline uint32_t GetMaxCount() const noexcept
+		{
+			return _maxChunkCount * _chunkSize;
+		}
+
+		inline T& operator[](
+			_In_ uint32_t index) noexcept
+		{
+			assert((index >> _chunkShift) <= _chunkIndex && (index & (_chunkSize - 1)) < _chunkUsedCounts.items[index >> _chunkShift]);
+			return _chunks.items[index >> _chunkShift][index & (_chunkSize - 1)];
+		}
+
+		inline const T& operator[](
+			_In_ uint32_t index) const noexcept
+		{
+			assert((index >> _chunkShift) <= _chunkIndex && (index & (_chunkSize - 1)) < _chunkUsedCounts.items[index >> _chunkShift]);
+			return _chunks.items[index >> _chunkShift][index & (_chunkSize - 1)];
+		}
+
+		/* The number of elements allocated since the last Reset. */
+		inline uint32_t GetCount() const noexcept
+		{
+			return _count;
+		}
+
+		/* The most elements that were ever allocated between two Resets. */
+		inline uint32_t GetHighWaterMark() const noexcept
+		{
+			return _highWaterMark;
+		}
+
+		/* The number of elements the currently allocated chunks can hold. */
+		inline uint32_t GetCapacity() const noexcept
+		{
+			return _allocatedChunkCount * _chunkSize;
+		}
+
+		inline uint32_t GetChunkSize() const noexcept
+		{
+			return _chunkSize;
+		}
+
+		inline uint32_t GetChunkIndex(
+			_In_ uint32_t index) const noexcept
+		{
+			return index >> _chunkShift;
+		}
+
+		/* The number of chunks in use since the last Reset. */
+		inline uint32_t GetChunkCount() const noexcept
+		{
+			return _count > 0 ? _chunkIndex + 1 : 0;
+		}
+
+		inline const T* GetChunk(
+			_In_ uint32_t chunkIndex) const noexcept
+		{
+			assert(chunkIndex <= _chunkIndex);
+			return _chunks.items[chunkIndex];
+		}
+
+		/* The number of elements in use in a chunk. Elements are only ever skipped at the end of a chunk. */
+		inline uint32_t GetChunkUsedCount(
+			_In_ uint32_t chunkIndex) const noexcept
+		{
+			assert(chunkIndex <= _chunkIndex);
+			return _chunkUsedCounts.items[chunkIndex];
+		}
+
+	private:
+		Buffer<T*> _chunks;
+		Buffer<uint32_t> _chunkUsedCounts;
+		uint32_t _chunkSize;
+		uint32_t _chunkShift;
+		uint32_t _maxChunkCount;
+		uint32_t _chunkIndex = 0;
+		uint32_t _allocatedChunkCount = 0;
+		uint32_t _count = 0;
+		uint32_t _highWaterMark = 0;
+	};
+}
@@ -0,0 +1,96 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FrameChangeDetector.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+bool FrameChangeDetector::Update(
+	const FrameArena<Batch>& batches,
+	const FrameArena<Vertex>& vertices,
+	const uint32_t* paletteKeys,
+	uint32_t paletteKeyCount,
+	const uint32_t* gammaTable,
+	uint32_t gammaTableSize) noexcept
+{
+	const uint32_t batchCount = batches.GetCount();
+	const uint32_t vertexCount = vertices.GetCount();
+
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	hash = Hash(hash, batches);
+	hash = Hash(hash, vertices);
+	hash = Hash(hash, paletteKeys, paletteKeyCount * sizeof(uint32_t));
+	hash = Hash(hash, gammaTable, gammaTableSize * sizeof(uint32_t));
+
+	const bool isUnchanged =
+		_hasPreviousFrame &&
+		batchCount == _previousBatchCount &&
+		vertexCount == _previousVertexCount &&
+		hash == _previousHash;
+
+	_previousHash = hash;
+	_previousBatchCount = batchCount;
+	_previousVertexCount = vertexCount;
+	_hasPreviousFrame = true;
+
+	if (isUnchanged)
+	{
+		++_unchangedFrameCount;
+		return false;
+	}
+
+	return true;
+}
+
+void FrameChangeDetector::Reset() noexcept
+{
+	_hasPreviousFrame = false;
+}
+
+uint64_t FrameChangeDetector::GetUnchangedFrameCount() const noexcept
+{
+	return _unchangedFrameCount;
+}
+
+_Use_decl_annotations_
+uint64_t FrameChangeDetector::Hash(
+	uint64_t hash,
+	const void* data,
+	size_t size) noexcept
+{
+	/* This runs over every vertex of every frame, so it consumes whole 64-bit words rather than bytes. */
+	const uint8_t* bytes = (const uint8_t*)data;
+	const size_t wordCount = size / sizeof(uint64_t);
+
+	for (size_t i = 0; i < wordCount; ++i)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+		hash = (hash ^ word) * 0x100000001B3ULL;
+		hash ^= hash >> 29;
+	}
+
+	for (size_t i = wordCount * sizeof(uint64_t); i < size; ++i)
+	{
+		hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+	}
+
+	return hash;
+}
@@ -0,0 +1,82 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Batch.h"
+#include "FrameArena.h"
+#include "Vertex.h"
+
+namespace d2dx
+{
+	/*
+		Recognizes frames that are identical to the previous one (common in menus, and while the game is
+		paused or waiting), so that they can be presented again instead of being drawn and post-processed.
+
+		A frame is summarized by a 64-bit hash of everything that determines its pixels: the batches (which
+		include texture hashes), the vertices, the palettes in use and the gamma table.
+	*/
+	class FrameChangeDetector final
+	{
+	public:
+		FrameChangeDetector() noexcept = default;
+
+		FrameChangeDetector(const FrameChangeDetector&) = delete;
+		FrameChangeDetector& operator=(const FrameChangeDetector&) = delete;
+
+		/* Compares a frame with the previous one, and keeps its hash for the next comparison. Returns false if
+		   nothing changed. */
+		bool Update(
+			_In_ const FrameArena<Batch>& batches,
+			_In_ const FrameArena<Vertex>& vertices,
+			_In_reads_(paletteKeyCount) const uint32_t* paletteKeys,
+			_In_ uint32_t paletteKeyCount,
+			_In_reads_(gammaTableSize) const uint32_t* gammaTable,
+			_In_ uint32_t gammaTableSize) noexcept;
+
+		/* Makes the next frame count as changed, e.g. because something else has been presented since. */
+		void Reset() noexcept;
+
+		uint64_t GetUnchangedFrameCount() const noexcept;
+
+	private:
+		template<typename T>
+		static uint64_t Hash(
+			_In_ uint64_t hash,
+			_In_ const FrameArena<T>& arena) noexcept
+		{
+			for (uint32_t i = 0; i < arena.GetChunkCount(); ++i)
+			{
+				hash = Hash(hash, arena.GetChunk(i), arena.GetChunkUsedCount(i) * sizeof(T));
+			}
+
+			return hash;
+		}
+
+		static uint64_t Hash(
+			_In_ uint64_t hash,
+			_In_reads_bytes_(size) const void* data,
+			_In_ size_t size) noexcept;
+
+		uint64_t _previousHash = 0;
+		uint32_t _previousBatchCount = 0;
+		uint32_t _previousVertexCount = 0;
+		bool _hasPreviousFrame = false;
+		uint64_t _unchangedFrameCount = 0;
+	};
+}
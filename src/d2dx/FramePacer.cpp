@@ -0,0 +1,147 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FramePacer.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+/* Sleeps shorter than this aren't worth the risk of oversleeping; spin instead. */
+#define D2DX_PACER_MIN_SLEEP_US 500
+
+_Use_decl_annotations_
+FramePacer::FramePacer(
+	const std::shared_ptr<IClock>& clock,
+	const std::shared_ptr<ISleeper>& sleeper,
+	int32_t targetFps) :
+	_clock{ clock },
+	_sleeper{ sleeper },
+	_intervalUs{ 1000000 / max(1, targetFps) }
+{
+}
+
+void FramePacer::Wait()
+{
+	int64_t timeUs = _clock->GetTimeUs();
+
+	if (_deadlineUs >= 0)
+	{
+		const int64_t wakeUs = _deadlineUs - _predictedPresentUs;
+
+		for (;;)
+		{
+			const int64_t sleepUs = wakeUs - timeUs - _sleepOvershootUs;
+
+			if (sleepUs < D2DX_PACER_MIN_SLEEP_US)
+			{
+				break;
+			}
+
+			_sleeper->SleepUs(sleepUs);
+
+			const int64_t newTimeUs = _clock->GetTimeUs();
+			CalibrateSleepOvershoot(newTimeUs - timeUs - sleepUs);
+			timeUs = newTimeUs;
+		}
+
+		while (timeUs < wakeUs)
+		{
+			_sleeper->Spin();
+			timeUs = _clock->GetTimeUs();
+		}
+	}
+
+	_waitEndUs = timeUs;
+}
+
+void FramePacer::OnPresented()
+{
+	const int64_t timeUs = _clock->GetTimeUs();
+
+	/* Predict the time to draw and present from the recent frames, but never use up more than half
+	   the interval on it. */
+	const int64_t presentUs = min(timeUs - _waitEndUs, _intervalUs / 2);
+	_predictedPresentUs += (presentUs - _predictedPresentUs) / 8;
+
+	if (_lastPresentUs >= 0)
+	{
+		_lastJitterUs = abs((timeUs - _lastPresentUs) - _intervalUs);
+		_jitter.Record(_lastJitterUs);
+	}
+
+	_lastPresentUs = timeUs;
+
+	_deadlineUs = _deadlineUs < 0 || timeUs - _deadlineUs > _intervalUs ?
+		timeUs + _intervalUs :
+		_deadlineUs + _intervalUs;
+}
+
+_Use_decl_annotations_
+void FramePacer::CalibrateSleepOvershoot(
+	int64_t overshootUs)
+{
+	overshootUs = max((int64_t)0, overshootUs);
+
+	/* Rise quickly, so that a coarser timer is adapted to within a few frames, but decay slowly, so that
+	   an occasional short sleep doesn't cause oversleeping on the next. */
+	if (overshootUs > _sleepOvershootUs)
+	{
+		_sleepOvershootUs += (overshootUs - _sleepOvershootUs + 1) / 2;
+	}
+	else
+	{
+		_sleepOvershootUs -= (_sleepOvershootUs - overshootUs) / 16;
+	}
+}
+
+int64_t FramePacer::GetIntervalUs() const
+{
+	return _intervalUs;
+}
+
+int64_t FramePacer::GetWakeTimeUs() const
+{
+	return _deadlineUs < 0 ? -1 : _deadlineUs - _predictedPresentUs;
+}
+
+int64_t FramePacer::GetSleepOvershootUs() const
+{
+	return _sleepOvershootUs;
+}
+
+int64_t FramePacer::GetLastJitterUs() const
+{
+	return _lastJitterUs;
+}
+
+const FrameTimeHistogram& FramePacer::GetJitterHistogram() const
+{
+	return _jitter;
+}
+
+void FramePacer::LogSummary() const
+{
+	D2DX_LOG("Frame pacing at %.2f fps over %llu frames: jitter p50 %.2f ms, p99 %.2f ms, max %.2f ms, sleep overshoot %.2f ms.",
+		1000000.0f / _intervalUs,
+		_jitter.GetCount(),
+		_jitter.GetPercentile(50.0f) / 1000.0f,
+		_jitter.GetPercentile(99.0f) / 1000.0f,
+		_jitter.GetMax() / 1000.0f,
+		_sleepOvershootUs / 1000.0f);
+}
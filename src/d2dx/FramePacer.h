@@ -0,0 +1,85 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameTimeHistogram.h"
+#include "IClock.h"
+#include "ISleeper.h"
+
+namespace d2dx
+{
+	/*
+		Paces presentation to a target frame rate.
+
+		Each frame has a present deadline, one frame interval after the previous one. Before drawing, Wait
+		sleeps and then spins until the deadline minus the predicted time to draw and present the frame.
+		Sleeps are shortened by an estimate of how much the sleeper oversleeps, which is calibrated from
+		each sleep, so that the spin at the end is short. If a frame is more than a frame interval late,
+		the cadence starts over from it, rather than rushing the following frames.
+
+		The jitter, the difference between each interval between presents and the target interval, is
+		recorded in a histogram.
+	*/
+	class FramePacer final
+	{
+	public:
+		FramePacer(
+			_In_ const std::shared_ptr<IClock>& clock,
+			_In_ const std::shared_ptr<ISleeper>& sleeper,
+			_In_ int32_t targetFps);
+
+		FramePacer(const FramePacer&) = delete;
+		FramePacer& operator=(const FramePacer&) = delete;
+
+		/* Call before drawing the frame. */
+		void Wait();
+
+		/* Call after presenting the frame. */
+		void OnPresented();
+
+		int64_t GetIntervalUs() const;
+
+		/* Returns the time by which Wait would like the game to be done with the frame, or -1 if it
+		   isn't known yet. */
+		int64_t GetWakeTimeUs() const;
+
+		int64_t GetSleepOvershootUs() const;
+
+		int64_t GetLastJitterUs() const;
+
+		const FrameTimeHistogram& GetJitterHistogram() const;
+
+		void LogSummary() const;
+
+	private:
+		void CalibrateSleepOvershoot(
+			_In_ int64_t overshootUs);
+
+		std::shared_ptr<IClock> _clock;
+		std::shared_ptr<ISleeper> _sleeper;
+		int64_t _intervalUs = 0;
+		int64_t _deadlineUs = -1;
+		int64_t _waitEndUs = -1;
+		int64_t _lastPresentUs = -1;
+		int64_t _predictedPresentUs = 0;
+		int64_t _sleepOvershootUs = 1000;
+		int64_t _lastJitterUs = 0;
+		FrameTimeHistogram _jitter;
+	};
+}
@@ -0,0 +1,118 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FrameTimeHistogram.h"
+
+using namespace d2dx;
+
+FrameTimeHistogram::FrameTimeHistogram() :
+	_buckets{ BucketCount, true }
+{
+}
+
+_Use_decl_annotations_
+void FrameTimeHistogram::Record(
+	int64_t valueUs) noexcept
+{
+	valueUs = max((int64_t)0, min(MaxValue, valueUs));
+
+	++_buckets.items[GetBucketIndex(valueUs)];
+	++_count;
+	_max = max(_max, valueUs);
+}
+
+void FrameTimeHistogram::Reset() noexcept
+{
+	memset(_buckets.items, 0, sizeof(uint32_t) * _buckets.capacity);
+	_count = 0;
+	_max = 0;
+}
+
+uint64_t FrameTimeHistogram::GetCount() const noexcept
+{
+	return _count;
+}
+
+int64_t FrameTimeHistogram::GetMax() const noexcept
+{
+	return _max;
+}
+
+_Use_decl_annotations_
+int64_t FrameTimeHistogram::GetPercentile(
+	float percentile) const noexcept
+{
+	if (_count == 0)
+	{
+		return 0;
+	}
+
+	const double fraction = max(0.0, min(100.0, (double)percentile)) / 100.0;
+	const uint64_t target = max((uint64_t)1, (uint64_t)ceil(fraction * _count));
+	uint64_t cumulative = 0;
+
+	for (uint32_t i = 0; i < BucketCount; ++i)
+	{
+		cumulative += _buckets.items[i];
+
+		if (cumulative >= target)
+		{
+			return min(_max, GetBucketMaxValue(i));
+		}
+	}
+
+	return _max;
+}
+
+_Use_decl_annotations_
+uint32_t FrameTimeHistogram::GetBucketIndex(
+	int64_t valueUs) noexcept
+{
+	assert(valueUs >= 0 && valueUs <= MaxValue);
+
+	if (valueUs < 64)
+	{
+		return (uint32_t)valueUs;
+	}
+
+	/* Find the shift that brings the value into [32, 64). */
+	uint32_t shift = 1;
+	while ((valueUs >> shift) >= 64)
+	{
+		++shift;
+	}
+
+	return 64 + (shift - 1) * 32 + (uint32_t)((valueUs >> shift) - 32);
+}
+
+_Use_decl_annotations_
+int64_t FrameTimeHistogram::GetBucketMaxValue(
+	uint32_t bucketIndex) noexcept
+{
+	assert(bucketIndex < BucketCount);
+
+	if (bucketIndex < 64)
+	{
+		return bucketIndex;
+	}
+
+	const uint32_t shift = (bucketIndex - 64) / 32 + 1;
+	const int64_t subBucket = 32 + (bucketIndex - 64) % 32;
+	return ((subBucket + 1) << shift) - 1;
+}
@@ -0,0 +1,63 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	/*
+		Histogram of frame times in microseconds, with log-linear buckets (as in HdrHistogram): values below
+		64 us are exact, and above that each power of two is split into 32 buckets, giving a precision of
+		about 3%. Values are clamped at about 33 seconds, so the memory used is fixed.
+	*/
+	class FrameTimeHistogram final
+	{
+	public:
+		static constexpr int64_t MaxValue = (1 << 25) - 1;
+		static constexpr uint32_t BucketCount = 64 + 19 * 32;
+
+		FrameTimeHistogram();
+
+		void Record(
+			_In_ int64_t valueUs) noexcept;
+
+		void Reset() noexcept;
+
+		uint64_t GetCount() const noexcept;
+
+		int64_t GetMax() const noexcept;
+
+		/* Returns the value that the given percentage (0-100) of the recorded values are at or below. */
+		int64_t GetPercentile(
+			_In_ float percentile) const noexcept;
+
+		static uint32_t GetBucketIndex(
+			_In_ int64_t valueUs) noexcept;
+
+		/* The highest value that falls in the bucket. */
+		static int64_t GetBucketMaxValue(
+			_In_ uint32_t bucketIndex) noexcept;
+
+	private:
+		Buffer<uint32_t> _buckets;
+		uint64_t _count = 0;
+		int64_t _max = 0;
+	};
+}
@@ -0,0 +1,165 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "FrameTimeTracker.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+/* Don't look for hitches until the median is meaningful. */
+static constexpr uint64_t WarmupFrames = 60;
+
+/* The median is refreshed this often, since it is relatively expensive to find. */
+static constexpr uint64_t MedianUpdateInterval = 32;
+
+static constexpr int64_t HitchFactor = 2;
+
+_Use_decl_annotations_
+FrameTimeTracker::FrameTimeTracker(
+	const std::shared_ptr<IClock>& clock) :
+	_clock{ clock },
+	_recentHitches{ MaxRecentHitches }
+{
+}
+
+_Use_decl_annotations_
+bool FrameTimeTracker::EndFrame(
+	const MetricsRegistry* metrics)
+{
+	const int64_t timeUs = _clock->GetTimeUs();
+
+	if (_lastTimeUs < 0)
+	{
+		_lastTimeUs = timeUs;
+		return false;
+	}
+
+	const int64_t frameTimeUs = timeUs - _lastTimeUs;
+	_lastTimeUs = timeUs;
+
+	const uint64_t frame = _frame++;
+	_histogram.Record(frameTimeUs);
+
+	if (frame < WarmupFrames)
+	{
+		return false;
+	}
+
+	if (!_medianUs || !(frame % MedianUpdateInterval))
+	{
+		_medianUs = _histogram.GetPercentile(50.0f);
+	}
+
+	if (frameTimeUs <= HitchFactor * _medianUs)
+	{
+		return false;
+	}
+
+	FrameHitch& hitch = _recentHitches.items[_hitchCount % MaxRecentHitches];
+	++_hitchCount;
+
+	hitch.frame = frame;
+	hitch.frameTimeUs = frameTimeUs;
+	hitch.medianUs = _medianUs;
+	hitch.hasMetrics = metrics != nullptr;
+
+	for (int32_t i = 0; i < (int32_t)Metric::Count; ++i)
+	{
+		hitch.metrics[i] = metrics ? metrics->GetCurrent((Metric)i) : 0;
+	}
+
+	return true;
+}
+
+const FrameTimeHistogram& FrameTimeTracker::GetHistogram() const
+{
+	return _histogram;
+}
+
+uint64_t FrameTimeTracker::GetHitchCount() const
+{
+	return _hitchCount;
+}
+
+uint32_t FrameTimeTracker::GetRecentHitchCount() const
+{
+	return (uint32_t)min(_hitchCount, (uint64_t)MaxRecentHitches);
+}
+
+_Use_decl_annotations_
+const FrameHitch& FrameTimeTracker::GetRecentHitch(
+	uint32_t index) const
+{
+	assert(index < GetRecentHitchCount());
+	return _recentHitches.items[(_hitchCount - GetRecentHitchCount() + index) % MaxRecentHitches];
+}
+
+void FrameTimeTracker::LogSummary() const
+{
+	D2DX_LOG("Frame times over %llu frames: p50 %.2f ms, p90 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms, %llu hitches.",
+		_histogram.GetCount(),
+		_histogram.GetPercentile(50.0f) / 1000.0f,
+		_histogram.GetPercentile(90.0f) / 1000.0f,
+		_histogram.GetPercentile(99.0f) / 1000.0f,
+		_histogram.GetPercentile(99.9f) / 1000.0f,
+		_histogram.GetMax() / 1000.0f,
+		_hitchCount);
+
+	for (uint32_t i = 0; i < GetRecentHitchCount(); ++i)
+	{
+		const FrameHitch& hitch = GetRecentHitch(i);
+
+		D2DX_LOG("Hitch at frame %llu: %.2f ms (median %.2f ms).", hitch.frame, hitch.frameTimeUs / 1000.0f, hitch.medianUs / 1000.0f);
+
+		if (!hitch.hasMetrics)
+		{
+			continue;
+		}
+
+		/* Log the non-zero counters, as many per line as fit. */
+		char line[200];
+		int32_t lineLength = 0;
+
+		for (int32_t m = 0; m < (int32_t)Metric::Count; ++m)
+		{
+			if (!hitch.metrics[m])
+			{
+				continue;
+			}
+
+			char entry[80];
+			_snprintf_s(entry, _TRUNCATE, " %s=%lld", MetricsRegistry::GetName((Metric)m), (long long)hitch.metrics[m]);
+			const int32_t entryLength = (int32_t)strlen(entry);
+
+			if (lineLength + entryLength >= (int32_t)sizeof(line))
+			{
+				D2DX_LOG(" %s", line);
+				lineLength = 0;
+			}
+
+			memcpy(line + lineLength, entry, entryLength + 1);
+			lineLength += entryLength;
+		}
+
+		if (lineLength > 0)
+		{
+			D2DX_LOG(" %s", line);
+		}
+	}
+}
@@ -0,0 +1,76 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameTimeHistogram.h"
+#include "IClock.h"
+#include "MetricsRegistry.h"
+
+namespace d2dx
+{
+	struct FrameHitch final
+	{
+		uint64_t frame = 0;
+		int64_t frameTimeUs = 0;
+		int64_t medianUs = 0;
+
+		/* The metrics counters of the frame, if metrics are enabled. */
+		bool hasMetrics = false;
+		int64_t metrics[(int32_t)Metric::Count] = { };
+	};
+
+	/*
+		Measures the time between frames into a FrameTimeHistogram, and detects hitches: frames that take
+		more than twice the median frame time. The most recent hitches are kept along with the metrics of
+		the frame, so that a stutter can be traced back to e.g. texture uploads or presentation.
+	*/
+	class FrameTimeTracker final
+	{
+	public:
+		static constexpr uint32_t MaxRecentHitches = 32;
+
+		FrameTimeTracker(
+			_In_ const std::shared_ptr<IClock>& clock);
+
+		/* Call once per frame. Returns true if the frame was a hitch. */
+		bool EndFrame(
+			_In_opt_ const MetricsRegistry* metrics);
+
+		const FrameTimeHistogram& GetHistogram() const;
+
+		uint64_t GetHitchCount() const;
+
+		uint32_t GetRecentHitchCount() const;
+
+		/* Index 0 is the oldest of the recent hitches. */
+		const FrameHitch& GetRecentHitch(
+			_In_ uint32_t index) const;
+
+		void LogSummary() const;
+
+	private:
+		std::shared_ptr<IClock> _clock;
+		FrameTimeHistogram _histogram;
+		int64_t _lastTimeUs = -1;
+		int64_t _medianUs = 0;
+		uint64_t _frame = 0;
+		uint64_t _hitchCount = 0;
+		Buffer<FrameHitch> _recentHitches;
+	};
+}
@@ -0,0 +1,122 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Types.h"
+
+namespace d2dx
+{
+	/*
+		Maps return addresses in the game's draw code to GameAddress values, for one game version.
+
+		This is a direct-mapped table: each known address gets its own slot, and the multiplicative hash
+		that picks the slot is searched for at compile time so that no two known addresses collide. A lookup
+		is one multiply, one load and one compare, regardless of the return address.
+
+		Declare instances constexpr and static_assert on IsValid(), so that an unplaceable address list fails
+		the build.
+	*/
+	class GameAddressTable final
+	{
+	public:
+		static constexpr uint32_t Capacity = 64;
+
+		constexpr GameAddressTable() noexcept :
+			_entries{}
+		{
+		}
+
+		/* Takes the return address for each GameAddress, indexed by GameAddress. Zero means not present. */
+		constexpr GameAddressTable(
+			_In_ const uint32_t (&addresses)[(int32_t)GameAddress::Count]) noexcept :
+			_entries{}
+		{
+			for (uint32_t attempt = 0; attempt < 256; ++attempt)
+			{
+				_multiplier = 0x9E3779B1U + attempt * 2;
+
+				if (TryPlace(addresses))
+				{
+					_isValid = true;
+					return;
+				}
+			}
+		}
+
+		constexpr bool IsValid() const noexcept
+		{
+			return _isValid;
+		}
+
+		GameAddress Find(
+			_In_ uint32_t returnAddress) const noexcept
+		{
+			const Entry& entry = _entries[GetSlot(returnAddress)];
+			return entry.returnAddress == returnAddress ? entry.gameAddress : GameAddress::Unknown;
+		}
+
+	private:
+		struct Entry final
+		{
+			uint32_t returnAddress;
+			GameAddress gameAddress;
+		};
+
+		constexpr uint32_t GetSlot(
+			_In_ uint32_t returnAddress) const noexcept
+		{
+			return (returnAddress * _multiplier) >> 26;
+		}
+
+		constexpr bool TryPlace(
+			_In_ const uint32_t (&addresses)[(int32_t)GameAddress::Count]) noexcept
+		{
+			for (uint32_t i = 0; i < Capacity; ++i)
+			{
+				_entries[i] = { 0, GameAddress::Unknown };
+			}
+
+			/* Index 0 is GameAddress::Unknown, which has no address. */
+			for (int32_t i = 1; i < (int32_t)GameAddress::Count; ++i)
+			{
+				if (addresses[i] == 0)
+				{
+					continue;
+				}
+
+				Entry& entry = _entries[GetSlot(addresses[i])];
+
+				if (entry.gameAddress != GameAddress::Unknown)
+				{
+					return false;
+				}
+
+				entry = { addresses[i], (GameAddress)i };
+			}
+
+			return true;
+		}
+
+		static_assert(Capacity == (1U << (32 - 26)), "Capacity must match the slot shift.");
+
+		Entry _entries[Capacity];
+		uint32_t _multiplier = 0x9E3779B1U;
+		bool _isValid = false;
+	};
+}
@@ -19,10 +19,41 @@
 #include "pch.h"
 #include "GameHelper.h"
 #include "Buffer.h"
+#include "TextureCategoryTable.h"
 #include "Utils.h"
 
 using namespace d2dx;
 
+class GameModules final : public IGameModules
+{
+public:
+	GameModules(
+		_In_ HANDLE hGameExe,
+		_In_ HANDLE hD2ClientDll,
+		_In_ HANDLE hD2GfxDll,
+		_In_ HANDLE hD2WinDll) :
+		_hModules{ nullptr, hGameExe, hD2ClientDll, hD2GfxDll, hD2WinDll }
+	{
+	}
+
+	virtual uintptr_t GetBaseAddress(
+		_In_ GameModule module) const override
+	{
+		return (uintptr_t)_hModules[(int32_t)module];
+	}
+
+	virtual void* GetExportByOrdinal(
+		_In_ GameModule module,
+		_In_ int32_t ordinal) const override
+	{
+		HANDLE hModule = _hModules[(int32_t)module];
+		return hModule ? GetProcAddress((HMODULE)hModule, MAKEINTRESOURCEA(ordinal)) : nullptr;
+	}
+
+private:
+	HANDLE _hModules[(int32_t)GameModule::Count];
+};
+
 GameHelper::GameHelper() :
 	_version(GetGameVersion()),
 	_hProcess(GetCurrentProcess()),
@@ -31,9 +62,10 @@ GameHelper::GameHelper() :
 	_hD2CommonDll(LoadLibraryA("D2Common.dll")),
 	_hD2GfxDll(LoadLibraryA("D2Gfx.dll")),
 	_hD2WinDll(LoadLibraryA("D2Win.dll")),
-	_isProjectDiablo2(GetModuleHandleA("PD2_EXT.dll") != nullptr)
+	_isProjectDiablo2(GetModuleHandleA("PD2_EXT.dll") != nullptr),
+	_layout(_version, GameModules{ _hGameExe, _hD2ClientDll, _hD2GfxDll, _hD2WinDll })
 {
-	InitializeTextureHashPrefixTable();
+	_gameAddressTable = SelectGameAddressTable(_version);
 
 	if (_isProjectDiablo2)
 	{
@@ -70,23 +102,8 @@ const char* GameHelper::GetVersionString() const
 
 uint32_t GameHelper::ScreenOpenMode() const
 {
-	switch (_version)
-	{
-	case GameVersion::Lod109d:
-		return *(const uint32_t*)((uint32_t)_hD2ClientDll + 0x115C10);
-	case GameVersion::Lod110f:
-		return *(const uint32_t*)((uint32_t)_hD2ClientDll + 0x10B9C4);
-	case GameVersion::Lod112:
-		return *(const uint32_t*)((uint32_t)_hD2ClientDll + 0x11C1D0);
-	case GameVersion::Lod113c:
-		return *(const uint32_t*)((uint32_t)_hD2ClientDll + 0x11C414);
-	case GameVersion::Lod113d:
-		return *(const uint32_t*)((uint32_t)_hD2ClientDll + 0x11D070);
-	case GameVersion::Lod114d:
-		return *(const uint32_t*)((uint32_t)_hGameExe + 0x3A5210);
-	default:
-		return 0;
-	}
+	const uint32_t* screenOpenMode = (const uint32_t*)_layout.GetData(GameData::ScreenOpenMode);
+	return screenOpenMode ? *screenOpenMode : 0;
 }
 
 Size GameHelper::GetConfiguredGameSize() const
@@ -117,7 +134,7 @@ Size GameHelper::GetConfiguredGameSize() const
 	}
 }
 
-static const uint32_t gameAddresses_109d[] =
+static constexpr uint32_t gameAddresses_109d[(int32_t)GameAddress::Count] =
 {
 	0xFFFFFFFF,
 	0x6f818468, /* DrawWall1 */
@@ -129,7 +146,7 @@ static const uint32_t gameAddresses_109d[] =
 	0, /* DrawSomething2 */
 };
 
-static const uint32_t gameAddresses_110[] =
+static constexpr uint32_t gameAddresses_110[(int32_t)GameAddress::Count] =
 {
 	0xFFFFFFFF,
 	0x6f81840c, /* DrawWall1 */
@@ -141,7 +158,7 @@ static const uint32_t gameAddresses_110[] =
 	0, /* DrawSomething2 */
 };
 
-static const uint32_t gameAddresses_112[] =
+static constexpr uint32_t gameAddresses_112[(int32_t)GameAddress::Count] =
 {
 	0xFFFFFFFF,
 	0x6f85a2f9, /* DrawWall1 */
@@ -153,7 +170,7 @@ static const uint32_t gameAddresses_112[] =
 	0, /* DrawSomething2 */
 };
 
-static const uint32_t gameAddresses_113c[] =
+static constexpr uint32_t gameAddresses_113c[(int32_t)GameAddress::Count] =
 {
 	0xFFFFFFFF,
 	0x6f8567ab, /* DrawWall1 */
@@ -165,7 +182,7 @@ static const uint32_t gameAddresses_113c[] =
 	0x0050c0de, /* DrawSomething2 */
 };
 
-static const uint32_t gameAddresses_113d[] =
+static constexpr uint32_t gameAddresses_113d[(int32_t)GameAddress::Count] =
 {
 	0xFFFFFFFF,
 	0x6f857199, /* DrawWall1 */
@@ -177,7 +194,7 @@ static const uint32_t gameAddresses_113d[] =
 	0x0050c0de, /* DrawSomething2 */
 };
 
-static const uint32_t gameAddresses_114d[] =
+static constexpr uint32_t gameAddresses_114d[(int32_t)GameAddress::Count] =
 {
 	0xFFFFFFFF,
 	0x50d39f, /* DrawWall1 */
@@ -189,53 +206,41 @@ static const uint32_t gameAddresses_114d[] =
 	0x50c0de, /* DrawSomething2 */
 };
 
-_Use_decl_annotations_
-GameAddress GameHelper::IdentifyGameAddress(
-	uint32_t returnAddress) const
+static constexpr GameAddressTable gameAddressTables[] =
 {
-	const uint32_t* gameAddresses = nullptr;
-	uint32_t gameAddressCount = 0;
+	{ },
+	{ gameAddresses_109d },
+	{ gameAddresses_110 },
+	{ gameAddresses_112 },
+	{ gameAddresses_113c },
+	{ gameAddresses_113d },
+	{ gameAddresses_114d },
+};
 
-	switch (_version)
-	{
-	case GameVersion::Lod109d:
-		gameAddresses = gameAddresses_109d;
-		gameAddressCount = ARRAYSIZE(gameAddresses_109d);
-		break;
-	case GameVersion::Lod110f:
-		gameAddresses = gameAddresses_110;
-		gameAddressCount = ARRAYSIZE(gameAddresses_110);
-		break;
-	case GameVersion::Lod112:
-		gameAddresses = gameAddresses_112;
-		gameAddressCount = ARRAYSIZE(gameAddresses_112);
-		break;
-	case GameVersion::Lod113c:
-		gameAddresses = gameAddresses_113c;
-		gameAddressCount = ARRAYSIZE(gameAddresses_113c);
-		break;
-	case GameVersion::Lod113d:
-		gameAddresses = gameAddresses_113d;
-		gameAddressCount = ARRAYSIZE(gameAddresses_113d);
-		break;
-	case GameVersion::Lod114d:
-		gameAddresses = gameAddresses_114d;
-		gameAddressCount = ARRAYSIZE(gameAddresses_114d);
-		break;
-	}
+static_assert(ARRAYSIZE(gameAddressTables) == (int32_t)GameVersion::Lod114d + 1, "Missing game address table.");
+static_assert(gameAddressTables[(int32_t)GameVersion::Lod109d].IsValid(), "Bad game address table for 1.09d.");
+static_assert(gameAddressTables[(int32_t)GameVersion::Lod110f].IsValid(), "Bad game address table for 1.10.");
+static_assert(gameAddressTables[(int32_t)GameVersion::Lod112].IsValid(), "Bad game address table for 1.12.");
+static_assert(gameAddressTables[(int32_t)GameVersion::Lod113c].IsValid(), "Bad game address table for 1.13c.");
+static_assert(gameAddressTables[(int32_t)GameVersion::Lod113d].IsValid(), "Bad game address table for 1.13d.");
+static_assert(gameAddressTables[(int32_t)GameVersion::Lod114d].IsValid(), "Bad game address table for 1.14d.");
 
-	for (uint32_t i = 0; i < gameAddressCount; ++i)
-	{
-		if (gameAddresses[i] == returnAddress)
-		{
-			return (GameAddress)i;
-		}
-	}
+_Use_decl_annotations_
+const GameAddressTable* GameHelper::SelectGameAddressTable(
+	GameVersion version)
+{
+	const int32_t index = (int32_t)version;
+	return &gameAddressTables[index >= 0 && index < (int32_t)ARRAYSIZE(gameAddressTables) ? index : 0];
+}
 
-	return GameAddress::Unknown;
+_Use_decl_annotations_
+GameAddress GameHelper::IdentifyGameAddress(
+	uint32_t returnAddress) const
+{
+	return _gameAddressTable->Find(returnAddress);
 }
 
-static const uint32_t titleScreenHashes[] = {
+static constexpr uint32_t titleScreenHashes[] = {
 	0x0836bff0,	0x0d609152,	0x1df19dd6,	0x2c779942,	0x3a174cb2,	0x3d35f3c5,	0x3d4c8c14,	0x605f521f,	0x6b69636d,
 	0x73059f7c,	0x8766b77a,	0x8af2178a,	0x90bdd994,	0x94e77d2d,	0xa66ac09c,	0xbe1a20c3,	0xc158e602,	0xc2625261,
 	0xccf7cc94,	0xcee4c170,	0xd38a63df,	0xd4579523,	0xda6e064e,	0xe22a8bc4,	0xe2e6b0c7,	0xe9263199, 0xe1e211f9,
@@ -248,19 +253,18 @@ static const uint32_t titleScreenHashes[] = {
 	0xf045cd36, 0xf169106c, 0xc9d4e158
 };
 
-static const uint32_t loadingScreenHashes[] = {
-	0x0aa1834d, 0x1a7964a9, 0x2f5b86a7, 0x70a8cb14, 0x32965ce1, 0x897794ce, 0x3136b0ee, 0x32965ce1, 0xc2cc7e28,
+static constexpr uint32_t loadingScreenHashes[] = {
+	0x0aa1834d, 0x1a7964a9, 0x2f5b86a7, 0x70a8cb14, 0x32965ce1, 0x897794ce, 0x3136b0ee, 0xc2cc7e28,
 	0x2a683b29, 0x01c37ff8
 };
 
-static const uint32_t mousePointerHashes[] = {
-	0xfe34f8b7,	0x5cac0e94,	0x4b661cd1,	3432412206,	2611936918,	2932294163,	1166565234,	77145516, 1264983249,
-	4264884407
+static constexpr uint32_t mousePointerHashes[] = {
+	0xfe34f8b7,	0x5cac0e94,	0x4b661cd1,	3432412206,	2611936918,	2932294163,	1166565234,	77145516
 };
 
-static const uint32_t uiHashes[] = {
-	0x2ff1fd61, 0x54cc8b72,	0xfc253c88, 0xabe12614, 0xa22f5459, 0xa0d8fb2a, 0x20526487, 0x8a3b7d58, 0x2ff1fd61,
-	0x54cc8b72, 0x76aa9aac, 0xef8d8978, 0x45e0af79, 0x9a008b35, 0x2a53bd89, 0x13d2c082, 0xab6ab811, 0xee7d31ba,
+static constexpr uint32_t uiHashes[] = {
+	0x2ff1fd61, 0x54cc8b72,	0xfc253c88, 0xabe12614, 0xa22f5459, 0xa0d8fb2a, 0x20526487, 0x8a3b7d58,
+	0x76aa9aac, 0xef8d8978, 0x45e0af79, 0x9a008b35, 0x2a53bd89, 0x13d2c082, 0xab6ab811, 0xee7d31ba,
 	0x6d1e37cf, 0xa4e86125, 0xa769824b, 0xb4119f58, 0xc2da4379, 0xdfbf045f, 0x88021112, 0x726eeaa0, 0x49e4e24e,
 	0x3b50f3b6, 0x1e623206, 0xae502740, 0xd16d7f9a, 0xf6ec6116, 0x56acd7e4, 0x7656c190, 0xb0d15023, 0xb2c6e5fb,
 	0x27d5991a, 0x21d8d615, 0x2bbf74be, 0x9ab19e53, 0x9ba9eeb2, 0x109348c9, 0x0f37086a, 0x10ac28d0, 0x5c121175,
@@ -273,87 +277,26 @@ static const uint32_t uiHashes[] = {
 	0x45c78147, 0x5ca62551, 0xf8d429fb, 0xfee40e62,
 };
 
-struct Hashes
-{
-	int32_t count;
-	const uint32_t* hashes;
-};
-
-static const Hashes hashesPerCategory[(int)TextureCategory::Count] =
+static constexpr TextureHashList textureHashLists[] =
 {
-	{ 0, nullptr },
-	{ ARRAYSIZE(mousePointerHashes), mousePointerHashes },
-	{ 0, nullptr },
-	{ ARRAYSIZE(loadingScreenHashes), loadingScreenHashes },
-	{ /* Floor: don't bother keeping a list of hashes */ 0, nullptr },
-	{ ARRAYSIZE(titleScreenHashes), titleScreenHashes },
-	{ /* Wall: don't bother keeping a list of hashes */ 0, nullptr },
-	{ ARRAYSIZE(uiHashes), uiHashes },
+	{ TextureCategory::MousePointer, mousePointerHashes, ARRAYSIZE(mousePointerHashes) },
+	{ TextureCategory::LoadingScreen, loadingScreenHashes, ARRAYSIZE(loadingScreenHashes) },
+	/* Floor: don't bother keeping a list of hashes */
+	{ TextureCategory::TitleScreen, titleScreenHashes, ARRAYSIZE(titleScreenHashes) },
+	/* Wall: don't bother keeping a list of hashes */
+	{ TextureCategory::UserInterface, uiHashes, ARRAYSIZE(uiHashes) },
 };
 
-static bool isInitialized = false;
-static Buffer<uint32_t> prefixTable[256];
-static Buffer<uint32_t> prefixCounts(256, true);
+static constexpr TextureCategoryTable<256> textureCategoryTable{ textureHashLists };
 
-void GameHelper::InitializeTextureHashPrefixTable()
-{
-	for (int32_t category = 0; category < ARRAYSIZE(hashesPerCategory); ++category)
-	{
-		const Hashes& hashes = hashesPerCategory[category];
-
-		for (int32_t hashIndex = 0; hashIndex < hashes.count; ++hashIndex)
-		{
-			++prefixCounts.items[(hashes.hashes[hashIndex] >> 24) & 0xFF];
-		}
-	}
-
-	for (int32_t prefix = 0; prefix < 256; ++prefix)
-	{
-		const uint32_t count = prefixCounts.items[prefix];
-
-		if (count > 0)
-		{
-			prefixTable[prefix] = Buffer<uint32_t>(count, true);
-		}
-		else
-		{
-			prefixTable[prefix] = Buffer<uint32_t>();
-		}
-	}
-
-	for (int32_t category = 0; category < ARRAYSIZE(hashesPerCategory); ++category)
-	{
-		const Hashes& hashes = hashesPerCategory[category];
-		for (int32_t j = 0; j < hashes.count; ++j)
-		{
-			const uint32_t hash = hashes.hashes[j];
-			const uint32_t prefix = hash >> 24;
-			const uint32_t position = --prefixCounts.items[prefix];
-			prefixTable[prefix].items[position] = (((uint32_t)category & 0xFF) << 24) | (hash & 0x00FFFFFF);
-		}
-	}
-}
+static_assert(!textureCategoryTable.HasOverflowed(), "Too many texture hashes, increase the table capacity.");
+static_assert(!textureCategoryTable.HasDuplicates(), "Duplicate texture hash in the texture category lists.");
 
 _Use_decl_annotations_
 TextureCategory GameHelper::GetTextureCategoryFromHash(
 	uint32_t textureHash) const
 {
-	Buffer<uint32_t>& table = prefixTable[textureHash >> 24];
-
-	if (table.capacity == 0)
-	{
-		return TextureCategory::Unknown;
-	}
-
-	for (int32_t i = 0; i < (int32_t)table.capacity; ++i)
-	{
-		uint32_t entry = table.items[i];
-
-		if ((entry & 0x00FFFFFF) == (textureHash & 0x00FFFFFF))
-			return (TextureCategory)(entry >> 24);
-	}
-
-	return TextureCategory::Unknown;
+	return textureCategoryTable.Find(textureHash);
 }
 
 _Use_decl_annotations_
@@ -691,27 +634,15 @@ typedef D2::UnitAny* (__stdcall* GetClientPlayerFunc)();
 
 D2::UnitAny* GameHelper::GetPlayerUnit() const
 {
-	GetClientPlayerFunc getClientPlayerFunc;
+	const uint32_t* playerUnit = (const uint32_t*)_layout.GetData(GameData::PlayerUnit);
 
-	switch (_version)
+	if (playerUnit)
 	{
-	case GameVersion::Lod109d:
-		getClientPlayerFunc = (GetClientPlayerFunc)((uintptr_t)_hD2ClientDll + 0x8CFC0);
-		return getClientPlayerFunc();
-	case GameVersion::Lod110f:
-		getClientPlayerFunc = (GetClientPlayerFunc)((uintptr_t)_hD2ClientDll + 0x883D0);
-		return getClientPlayerFunc();
-	case GameVersion::Lod112:
-		return (D2::UnitAny*)*(const uint32_t*)((uint32_t)_hD2ClientDll + 0x11C3D0);
-	case GameVersion::Lod113c:
-		return (D2::UnitAny*)*(const uint32_t*)((uint32_t)_hD2ClientDll + 0x11BBFC);
-	case GameVersion::Lod113d:
-		return (D2::UnitAny*)*(const uint32_t*)((uint32_t)_hD2ClientDll + 0x11D050);
-	case GameVersion::Lod114d:
-		return (D2::UnitAny*)*(const uint32_t*)((uint32_t)_hGameExe + 0x3A6A70);
-	default:
-		return nullptr;
+		return (D2::UnitAny*)*playerUnit;
 	}
+
+	GetClientPlayerFunc getClientPlayerFunc = (GetClientPlayerFunc)_layout.GetFunction(D2Function::D2Client_GetPlayerUnit);
+	return getClientPlayerFunc ? getClientPlayerFunc() : nullptr;
 }
 
 _Use_decl_annotations_
@@ -797,42 +728,6 @@ Offset GameHelper::GetUnitPos(
 
 typedef D2::UnitAny* (__fastcall* FindUnitFunc)(DWORD dwId, DWORD dwType);
 
-static D2::UnitAny* __fastcall FindClientSideUnit109d(DWORD unitId, DWORD unitType)
-{
-	uint32_t** unitPtrTable = (uint32_t**)0x6FBC4BF8;
-	uint32_t* unit = unitPtrTable[unitType * 128 + (unitId & 127)];
-
-	while (unit)
-	{
-		if (unit[0] == unitType && unit[2] == unitId)
-		{
-			return (D2::UnitAny*)unit;
-		}
-
-		unit = (uint32_t*)unit[66];
-	}
-
-	return nullptr;
-}
-
-static D2::UnitAny* __fastcall FindServerSideUnit109d(DWORD unitId, DWORD unitType)
-{
-	uint32_t** unitPtrTable = (uint32_t**)0x6FBC57F8;
-	uint32_t* unit = unitPtrTable[unitType * 128 + (unitId & 127)];
-
-	while (unit)
-	{
-		if (unit[0] == unitType && unit[2] == unitId)
-		{
-			return (D2::UnitAny*)unit;
-		}
-
-		unit = (uint32_t*)unit[66];
-	}
-
-	return nullptr;
-}
-
 _Use_decl_annotations_
 D2::UnitAny* GameHelper::FindUnit(
 	uint32_t unitId,
@@ -858,307 +753,7 @@ _Use_decl_annotations_
 void* GameHelper::GetFunction(
 	D2Function function) const
 {
-	HANDLE hModule = nullptr;
-	int32_t ordinal = 0;
-
-	switch (_version)
-	{
-	case GameVersion::Lod109d:
-		switch (function)
-		{
-		case D2Function::D2Gfx_DrawImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10072;
-			break;
-		case D2Function::D2Gfx_DrawShiftedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10073;
-			break;
-		case D2Function::D2Gfx_DrawVerticalCropImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10074;
-			break;
-		case D2Function::D2Gfx_DrawClippedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10077;
-			break;
-		case D2Function::D2Gfx_DrawImageFast:
-			hModule = _hD2GfxDll;
-			ordinal = 10076;
-			break;
-		case D2Function::D2Gfx_DrawShadow:
-			hModule = _hD2GfxDll;
-			ordinal = 10075;
-			break;
-		case D2Function::D2Win_DrawText:
-			hModule = _hD2WinDll;
-			ordinal = 10117;
-			break;
-		case D2Function::D2Client_DrawUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0xB8350);
-		case D2Function::D2Client_FindClientSideUnit:
-			return (void*)FindClientSideUnit109d;
-		case D2Function::D2Client_DrawWeatherParticles:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x07BC0);
-		case D2Function::D2Client_FindServerSideUnit:
-			return (void*)FindServerSideUnit109d;
-		default:
-			break;
-		}
-		break;
-	case GameVersion::Lod110f:
-		switch (function)
-		{
-		case D2Function::D2Gfx_DrawImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10072;
-			break;
-		case D2Function::D2Gfx_DrawShiftedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10073;
-			break;
-		case D2Function::D2Gfx_DrawVerticalCropImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10074;
-			break;
-		case D2Function::D2Gfx_DrawClippedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10077;
-			break;
-		case D2Function::D2Gfx_DrawImageFast:
-			hModule = _hD2GfxDll;
-			ordinal = 10076;
-			break;
-		case D2Function::D2Gfx_DrawShadow: 
-			hModule = _hD2GfxDll;
-			ordinal = 10075;
-			break; 
-		case D2Function::D2Win_DrawText:
-			hModule = _hD2WinDll;
-			ordinal = 10117;
-			break;
-		case D2Function::D2Client_DrawUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0xBA720);
-		case D2Function::D2Client_FindClientSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x86BE0);
-		case D2Function::D2Client_DrawWeatherParticles:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x08690);
-		case D2Function::D2Client_FindServerSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x86C70);
-		default:
-			break;
-		}
-		break;
-	case GameVersion::Lod112:
-		switch (function)
-		{
-		case D2Function::D2Gfx_DrawImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10024;
-			break;
-		case D2Function::D2Gfx_DrawShiftedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10044;
-			break;
-		case D2Function::D2Gfx_DrawVerticalCropImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10046;
-			break;
-		case D2Function::D2Gfx_DrawClippedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10061;
-			break;
-		case D2Function::D2Gfx_DrawImageFast:
-			hModule = _hD2GfxDll;
-			ordinal = 10012;
-			break;
-		case D2Function::D2Gfx_DrawShadow:
-			hModule = _hD2GfxDll;
-			ordinal = 10030;
-			break;
-		case D2Function::D2Win_DrawText:
-			hModule = _hD2WinDll;
-			ordinal = 10001;
-			break;
-		//case D2Function::D2Win_DrawFramedText:
-		//	hModule = _hD2WinDll;
-		//	ordinal = 10137;
-		//	break;
-		//case D2Function::D2Win_DrawRectangledText:
-		//	hModule = _hD2WinDll;
-		//	ordinal = 10078;
-		//	break;
-		case D2Function::D2Client_DrawUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x94250);
-		case D2Function::D2Client_DrawMissile:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x949C0);
-		case D2Function::D2Client_DrawWeatherParticles:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x14210);
-		case D2Function::D2Client_FindClientSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x1F1A0);
-		case D2Function::D2Client_FindServerSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x1F1C0);
-		default:
-			break;
-		}
-		break;
-	case GameVersion::Lod113c:
-		switch (function)
-		{
-		case D2Function::D2Gfx_DrawImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10041;
-			break;
-		case D2Function::D2Gfx_DrawShiftedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10019;
-			break;
-		case D2Function::D2Gfx_DrawVerticalCropImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10074;
-			break;
-		case D2Function::D2Gfx_DrawClippedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10079;
-			break;
-		case D2Function::D2Gfx_DrawImageFast:
-			hModule = _hD2GfxDll;
-			ordinal = 10046;
-			break;
-		case D2Function::D2Gfx_DrawShadow:
-			hModule = _hD2GfxDll;
-			ordinal = 10011;
-			break;
-		case D2Function::D2Win_DrawText:
-			hModule = _hD2WinDll;
-			ordinal = 10096;
-			break;
-		case D2Function::D2Win_DrawFramedText:
-			hModule = _hD2WinDll; 
-			ordinal = 10085;
-			break;
-		case D2Function::D2Win_DrawRectangledText:
-			hModule = _hD2WinDll;
-			ordinal = 10013;
-			break;
-		case D2Function::D2Client_DrawUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x6C490);
-		case D2Function::D2Client_DrawMissile:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x6CC00);
-		case D2Function::D2Client_DrawWeatherParticles:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x7FE80);
-		case D2Function::D2Client_FindClientSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0xA5B20);
-		case D2Function::D2Client_FindServerSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0xA5B40);
-		default:
-			break;
-		}
-		break;
-	case GameVersion::Lod113d:
-		switch (function)
-		{
-		case D2Function::D2Gfx_DrawImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10042;
-			break;
-		case D2Function::D2Gfx_DrawShiftedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10067;
-			break;
-		case D2Function::D2Gfx_DrawVerticalCropImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10082;
-			break;
-		case D2Function::D2Gfx_DrawClippedImage:
-			hModule = _hD2GfxDll;
-			ordinal = 10015;
-			break;
-		case D2Function::D2Gfx_DrawImageFast:
-			hModule = _hD2GfxDll;
-			ordinal = 10006;
-			break;
-		case D2Function::D2Gfx_DrawShadow:
-			hModule = _hD2GfxDll;
-			ordinal = 10084;
-			break;
-		case D2Function::D2Win_DrawText:
-			hModule = _hD2WinDll;
-			ordinal = 10076;
-			break;
-		case D2Function::D2Win_DrawTextEx:
-			hModule = _hD2WinDll;
-			ordinal = 10084;
-			break;
-		case D2Function::D2Win_DrawFramedText:
-			hModule = _hD2WinDll;
-			ordinal = 10137;
-			break;
-		case D2Function::D2Win_DrawRectangledText:
-			hModule = _hD2WinDll;
-			ordinal = 10078;
-			break;
-		case D2Function::D2Client_DrawUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x605b0);
-		case D2Function::D2Client_DrawMissile:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x60C70);
-		case D2Function::D2Client_DrawWeatherParticles:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x4AD90);
-		case D2Function::D2Client_FindClientSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x620B0);
-		case D2Function::D2Client_FindServerSideUnit:
-			return (void*)((uintptr_t)_hD2ClientDll + 0x620D0);
-		default:
-			break;
-		}
-		break;
-	case GameVersion::Lod114d:
-		switch (function)
-		{
-		case D2Function::D2Gfx_DrawImage:
-			return (void*)((uintptr_t)_hGameExe + 0xF6480);
-		case D2Function::D2Gfx_DrawShiftedImage:
-			return (void*)((uintptr_t)_hGameExe + 0xF64B0);
-		case D2Function::D2Gfx_DrawVerticalCropImage:
-			return (void*)((uintptr_t)_hGameExe + 0xF64E0);
-		case D2Function::D2Gfx_DrawClippedImage:
-			return (void*)((uintptr_t)_hGameExe + 0xF6510);
-		case D2Function::D2Gfx_DrawImageFast:
-			return (void*)((uintptr_t)_hGameExe + 0xF6570);
-		case D2Function::D2Gfx_DrawShadow:
-			return (void*)((uintptr_t)_hGameExe + 0xF6540);
-		case D2Function::D2Win_DrawText:
-			return (void*)((uintptr_t)_hGameExe + 0x102320);
-		case D2Function::D2Win_DrawTextEx:
-			return (void*)((uintptr_t)_hGameExe + 0x102360);
-		case D2Function::D2Win_DrawFramedText:
-			return (void*)((uintptr_t)_hGameExe + 0x102280);
-		case D2Function::D2Win_DrawRectangledText:
-			return (void*)((uintptr_t)_hGameExe + 0x1023B0);
-		case D2Function::D2Client_DrawUnit:
-			return (void*)((uintptr_t)_hGameExe + 0x70EC0);
-		case D2Function::D2Client_DrawMissile:
-			return (void*)((uintptr_t)_hGameExe + 0x71EC0);
-		case D2Function::D2Client_DrawWeatherParticles:
-			return (void*)((uintptr_t)_hGameExe + 0x73470);
-		case D2Function::D2Client_FindClientSideUnit:
-			return (void*)((uintptr_t)_hGameExe + 0x63990);
-		case D2Function::D2Client_FindServerSideUnit:
-			return (void*)((uintptr_t)_hGameExe + 0x639B0);
-		default:
-			break;
-		}
-		break;
-	default:
-		break;
-	}
-
-	if (!hModule || !ordinal)
-	{
-		return nullptr;
-	}
-
-	return GetProcAddress((HMODULE)hModule, MAKEINTRESOURCEA(ordinal));
+	return _layout.GetFunction(function);
 }
 
 _Use_decl_annotations_
@@ -1187,46 +782,29 @@ int32_t GameHelper::GetCurrentAct() const
 
 bool GameHelper::IsGameMenuOpen() const
 {
-	switch (_version)
-	{
-	case GameVersion::Lod109d:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0x1248D8)) != 0;
-	case GameVersion::Lod110f:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0x11A6CC)) != 0;
-	case GameVersion::Lod112:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0x102B7C)) != 0;
-	case GameVersion::Lod113c:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0xFADA4)) != 0;
-	case GameVersion::Lod113d:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0x11C8B4)) != 0;
-	case GameVersion::Lod114d:
-		return *((uint32_t*)((uint32_t)_hGameExe + 0x3A27E4)) != 0;
-	default:
-		return false;
-	}
+	const uint32_t* gameMenuOpen = (const uint32_t*)_layout.GetData(GameData::GameMenuOpen);
+	return gameMenuOpen && *gameMenuOpen != 0;
 }
 
 bool GameHelper::IsInGame() const
 {
+	const uint32_t* inGame = (const uint32_t*)_layout.GetData(GameData::InGame);
+
+	if (!inGame || *inGame == 0)
+	{
+		return false;
+	}
+
 	auto playerUnit = GetPlayerUnit();
 
-	switch (_version)
+	if (!playerUnit)
 	{
-	case GameVersion::Lod109d:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0x1109FC)) != 0 && playerUnit != 0 && playerUnit->u.v109.path != 0;
-	case GameVersion::Lod110f:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0x1077C4)) != 0 && playerUnit != 0 && playerUnit->u.v109.path != 0;
-	case GameVersion::Lod112:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0x11BCC4)) != 0 && playerUnit != 0 && playerUnit->u.v112.path != 0;
-	case GameVersion::Lod113c:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0xF8C9C)) != 0 && playerUnit != 0 && playerUnit->u.v112.path != 0;
-	case GameVersion::Lod113d:
-		return *((uint32_t*)((uint32_t)_hD2ClientDll + 0xF79E0)) != 0 && playerUnit != 0 && playerUnit->u.v112.path != 0;
-	case GameVersion::Lod114d:
-		return *((uint32_t*)((uint32_t)_hGameExe + 0x3A27C0)) != 0 && playerUnit != 0 && playerUnit->u.v112.path != 0;
-	default:
 		return false;
 	}
+
+	return _version == GameVersion::Lod109d || _version == GameVersion::Lod110f ?
+		playerUnit->u.v109.path != 0 :
+		playerUnit->u.v112.path != 0;
 }
 
 bool GameHelper::IsProjectDiablo2() const
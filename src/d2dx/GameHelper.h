@@ -18,6 +18,8 @@
 */
 #pragma once
 
+#include "GameAddressTable.h"
+#include "GameLayout.h"
 #include "IGameHelper.h"
 #include "Types.h"
 
@@ -84,8 +86,9 @@ namespace d2dx
 
 	private:
 		GameVersion GetGameVersion();
-		
-		void InitializeTextureHashPrefixTable();
+
+		static const GameAddressTable* SelectGameAddressTable(
+			_In_ GameVersion version);
 		
 		bool ProbeUInt32(
 			_In_ HANDLE hModule, 
@@ -104,6 +107,8 @@ namespace d2dx
 		HANDLE _hD2GfxDll;
 		HANDLE _hD2WinDll;
 		GameVersion _version;
+		const GameAddressTable* _gameAddressTable;
 		bool _isProjectDiablo2;
+		GameLayout _layout;
 	};
 }
@@ -0,0 +1,309 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "GameLayout.h"
+
+using namespace d2dx;
+
+/* A function or variable in a game module: at an offset from the module base, exported by ordinal,
+   or (for functions d2dx implements itself) at a fixed address. */
+struct GameSymbol final
+{
+	GameModule module;
+	uint32_t offset;
+	int32_t ordinal;
+	void* address;
+};
+
+struct GameSymbols final
+{
+	GameSymbol functions[(int32_t)D2Function::Count];
+	GameSymbol data[(int32_t)GameData::Count];
+};
+
+static D2::UnitAny* __fastcall FindClientSideUnit109d(DWORD unitId, DWORD unitType)
+{
+	uint32_t** unitPtrTable = (uint32_t**)0x6FBC4BF8;
+	uint32_t* unit = unitPtrTable[unitType * 128 + (unitId & 127)];
+
+	while (unit)
+	{
+		if (unit[0] == unitType && unit[2] == unitId)
+		{
+			return (D2::UnitAny*)unit;
+		}
+
+		unit = (uint32_t*)unit[66];
+	}
+
+	return nullptr;
+}
+
+static D2::UnitAny* __fastcall FindServerSideUnit109d(DWORD unitId, DWORD unitType)
+{
+	uint32_t** unitPtrTable = (uint32_t**)0x6FBC57F8;
+	uint32_t* unit = unitPtrTable[unitType * 128 + (unitId & 127)];
+
+	while (unit)
+	{
+		if (unit[0] == unitType && unit[2] == unitId)
+		{
+			return (D2::UnitAny*)unit;
+		}
+
+		unit = (uint32_t*)unit[66];
+	}
+
+	return nullptr;
+}
+
+static const GameSymbols gameSymbols_109d =
+{
+	{
+		{ GameModule::D2Gfx, 0, 10072 }, /* D2Gfx_DrawImage */
+		{ GameModule::D2Gfx, 0, 10073 }, /* D2Gfx_DrawShiftedImage */
+		{ GameModule::D2Gfx, 0, 10074 }, /* D2Gfx_DrawVerticalCropImage */
+		{ GameModule::D2Gfx, 0, 10077 }, /* D2Gfx_DrawClippedImage */
+		{ GameModule::D2Gfx, 0, 10076 }, /* D2Gfx_DrawImageFast */
+		{ GameModule::D2Gfx, 0, 10075 }, /* D2Gfx_DrawShadow */
+		{ GameModule::D2Win, 0, 10117 }, /* D2Win_DrawText */
+		{ }, /* D2Win_DrawTextEx */
+		{ }, /* D2Win_DrawFramedText */
+		{ }, /* D2Win_DrawRectangledText */
+		{ GameModule::D2Client, 0xB8350 }, /* D2Client_DrawUnit */
+		{ }, /* D2Client_DrawMissile */
+		{ GameModule::D2Client, 0x07BC0 }, /* D2Client_DrawWeatherParticles */
+		{ GameModule::None, 0, 0, (void*)FindClientSideUnit109d }, /* D2Client_FindClientSideUnit */
+		{ GameModule::None, 0, 0, (void*)FindServerSideUnit109d }, /* D2Client_FindServerSideUnit */
+		{ GameModule::D2Client, 0x8CFC0 }, /* D2Client_GetPlayerUnit */
+	},
+	{
+		{ GameModule::D2Client, 0x115C10 }, /* ScreenOpenMode */
+		{ GameModule::D2Client, 0x1248D8 }, /* GameMenuOpen */
+		{ GameModule::D2Client, 0x1109FC }, /* InGame */
+		{ }, /* PlayerUnit */
+	}
+};
+
+static const GameSymbols gameSymbols_110 =
+{
+	{
+		{ GameModule::D2Gfx, 0, 10072 }, /* D2Gfx_DrawImage */
+		{ GameModule::D2Gfx, 0, 10073 }, /* D2Gfx_DrawShiftedImage */
+		{ GameModule::D2Gfx, 0, 10074 }, /* D2Gfx_DrawVerticalCropImage */
+		{ GameModule::D2Gfx, 0, 10077 }, /* D2Gfx_DrawClippedImage */
+		{ GameModule::D2Gfx, 0, 10076 }, /* D2Gfx_DrawImageFast */
+		{ GameModule::D2Gfx, 0, 10075 }, /* D2Gfx_DrawShadow */
+		{ GameModule::D2Win, 0, 10117 }, /* D2Win_DrawText */
+		{ }, /* D2Win_DrawTextEx */
+		{ }, /* D2Win_DrawFramedText */
+		{ }, /* D2Win_DrawRectangledText */
+		{ GameModule::D2Client, 0xBA720 }, /* D2Client_DrawUnit */
+		{ }, /* D2Client_DrawMissile */
+		{ GameModule::D2Client, 0x08690 }, /* D2Client_DrawWeatherParticles */
+		{ GameModule::D2Client, 0x86BE0 }, /* D2Client_FindClientSideUnit */
+		{ GameModule::D2Client, 0x86C70 }, /* D2Client_FindServerSideUnit */
+		{ GameModule::D2Client, 0x883D0 }, /* D2Client_GetPlayerUnit */
+	},
+	{
+		{ GameModule::D2Client, 0x10B9C4 }, /* ScreenOpenMode */
+		{ GameModule::D2Client, 0x11A6CC }, /* GameMenuOpen */
+		{ GameModule::D2Client, 0x1077C4 }, /* InGame */
+		{ }, /* PlayerUnit */
+	}
+};
+
+static const GameSymbols gameSymbols_112 =
+{
+	{
+		{ GameModule::D2Gfx, 0, 10024 }, /* D2Gfx_DrawImage */
+		{ GameModule::D2Gfx, 0, 10044 }, /* D2Gfx_DrawShiftedImage */
+		{ GameModule::D2Gfx, 0, 10046 }, /* D2Gfx_DrawVerticalCropImage */
+		{ GameModule::D2Gfx, 0, 10061 }, /* D2Gfx_DrawClippedImage */
+		{ GameModule::D2Gfx, 0, 10012 }, /* D2Gfx_DrawImageFast */
+		{ GameModule::D2Gfx, 0, 10030 }, /* D2Gfx_DrawShadow */
+		{ GameModule::D2Win, 0, 10001 }, /* D2Win_DrawText */
+		{ }, /* D2Win_DrawTextEx */
+		{ }, /* D2Win_DrawFramedText */
+		{ }, /* D2Win_DrawRectangledText */
+		{ GameModule::D2Client, 0x94250 }, /* D2Client_DrawUnit */
+		{ GameModule::D2Client, 0x949C0 }, /* D2Client_DrawMissile */
+		{ GameModule::D2Client, 0x14210 }, /* D2Client_DrawWeatherParticles */
+		{ GameModule::D2Client, 0x1F1A0 }, /* D2Client_FindClientSideUnit */
+		{ GameModule::D2Client, 0x1F1C0 }, /* D2Client_FindServerSideUnit */
+		{ }, /* D2Client_GetPlayerUnit */
+	},
+	{
+		{ GameModule::D2Client, 0x11C1D0 }, /* ScreenOpenMode */
+		{ GameModule::D2Client, 0x102B7C }, /* GameMenuOpen */
+		{ GameModule::D2Client, 0x11BCC4 }, /* InGame */
+		{ GameModule::D2Client, 0x11C3D0 }, /* PlayerUnit */
+	}
+};
+
+static const GameSymbols gameSymbols_113c =
+{
+	{
+		{ GameModule::D2Gfx, 0, 10041 }, /* D2Gfx_DrawImage */
+		{ GameModule::D2Gfx, 0, 10019 }, /* D2Gfx_DrawShiftedImage */
+		{ GameModule::D2Gfx, 0, 10074 }, /* D2Gfx_DrawVerticalCropImage */
+		{ GameModule::D2Gfx, 0, 10079 }, /* D2Gfx_DrawClippedImage */
+		{ GameModule::D2Gfx, 0, 10046 }, /* D2Gfx_DrawImageFast */
+		{ GameModule::D2Gfx, 0, 10011 }, /* D2Gfx_DrawShadow */
+		{ GameModule::D2Win, 0, 10096 }, /* D2Win_DrawText */
+		{ }, /* D2Win_DrawTextEx */
+		{ GameModule::D2Win, 0, 10085 }, /* D2Win_DrawFramedText */
+		{ GameModule::D2Win, 0, 10013 }, /* D2Win_DrawRectangledText */
+		{ GameModule::D2Client, 0x6C490 }, /* D2Client_DrawUnit */
+		{ GameModule::D2Client, 0x6CC00 }, /* D2Client_DrawMissile */
+		{ GameModule::D2Client, 0x7FE80 }, /* D2Client_DrawWeatherParticles */
+		{ GameModule::D2Client, 0xA5B20 }, /* D2Client_FindClientSideUnit */
+		{ GameModule::D2Client, 0xA5B40 }, /* D2Client_FindServerSideUnit */
+		{ }, /* D2Client_GetPlayerUnit */
+	},
+	{
+		{ GameModule::D2Client, 0x11C414 }, /* ScreenOpenMode */
+		{ GameModule::D2Client, 0xFADA4 }, /* GameMenuOpen */
+		{ GameModule::D2Client, 0xF8C9C }, /* InGame */
+		{ GameModule::D2Client, 0x11BBFC }, /* PlayerUnit */
+	}
+};
+
+static const GameSymbols gameSymbols_113d =
+{
+	{
+		{ GameModule::D2Gfx, 0, 10042 }, /* D2Gfx_DrawImage */
+		{ GameModule::D2Gfx, 0, 10067 }, /* D2Gfx_DrawShiftedImage */
+		{ GameModule::D2Gfx, 0, 10082 }, /* D2Gfx_DrawVerticalCropImage */
+		{ GameModule::D2Gfx, 0, 10015 }, /* D2Gfx_DrawClippedImage */
+		{ GameModule::D2Gfx, 0, 10006 }, /* D2Gfx_DrawImageFast */
+		{ GameModule::D2Gfx, 0, 10084 }, /* D2Gfx_DrawShadow */
+		{ GameModule::D2Win, 0, 10076 }, /* D2Win_DrawText */
+		{ GameModule::D2Win, 0, 10084 }, /* D2Win_DrawTextEx */
+		{ GameModule::D2Win, 0, 10137 }, /* D2Win_DrawFramedText */
+		{ GameModule::D2Win, 0, 10078 }, /* D2Win_DrawRectangledText */
+		{ GameModule::D2Client, 0x605b0 }, /* D2Client_DrawUnit */
+		{ GameModule::D2Client, 0x60C70 }, /* D2Client_DrawMissile */
+		{ GameModule::D2Client, 0x4AD90 }, /* D2Client_DrawWeatherParticles */
+		{ GameModule::D2Client, 0x620B0 }, /* D2Client_FindClientSideUnit */
+		{ GameModule::D2Client, 0x620D0 }, /* D2Client_FindServerSideUnit */
+		{ }, /* D2Client_GetPlayerUnit */
+	},
+	{
+		{ GameModule::D2Client, 0x11D070 }, /* ScreenOpenMode */
+		{ GameModule::D2Client, 0x11C8B4 }, /* GameMenuOpen */
+		{ GameModule::D2Client, 0xF79E0 }, /* InGame */
+		{ GameModule::D2Client, 0x11D050 }, /* PlayerUnit */
+	}
+};
+
+static const GameSymbols gameSymbols_114d =
+{
+	{
+		{ GameModule::GameExe, 0xF6480 }, /* D2Gfx_DrawImage */
+		{ GameModule::GameExe, 0xF64B0 }, /* D2Gfx_DrawShiftedImage */
+		{ GameModule::GameExe, 0xF64E0 }, /* D2Gfx_DrawVerticalCropImage */
+		{ GameModule::GameExe, 0xF6510 }, /* D2Gfx_DrawClippedImage */
+		{ GameModule::GameExe, 0xF6570 }, /* D2Gfx_DrawImageFast */
+		{ GameModule::GameExe, 0xF6540 }, /* D2Gfx_DrawShadow */
+		{ GameModule::GameExe, 0x102320 }, /* D2Win_DrawText */
+		{ GameModule::GameExe, 0x102360 }, /* D2Win_DrawTextEx */
+		{ GameModule::GameExe, 0x102280 }, /* D2Win_DrawFramedText */
+		{ GameModule::GameExe, 0x1023B0 }, /* D2Win_DrawRectangledText */
+		{ GameModule::GameExe, 0x70EC0 }, /* D2Client_DrawUnit */
+		{ GameModule::GameExe, 0x71EC0 }, /* D2Client_DrawMissile */
+		{ GameModule::GameExe, 0x73470 }, /* D2Client_DrawWeatherParticles */
+		{ GameModule::GameExe, 0x63990 }, /* D2Client_FindClientSideUnit */
+		{ GameModule::GameExe, 0x639B0 }, /* D2Client_FindServerSideUnit */
+		{ }, /* D2Client_GetPlayerUnit */
+	},
+	{
+		{ GameModule::GameExe, 0x3A5210 }, /* ScreenOpenMode */
+		{ GameModule::GameExe, 0x3A27E4 }, /* GameMenuOpen */
+		{ GameModule::GameExe, 0x3A27C0 }, /* InGame */
+		{ GameModule::GameExe, 0x3A6A70 }, /* PlayerUnit */
+	}
+};
+
+static void* ResolveSymbol(
+	_In_ const GameSymbol& symbol,
+	_In_ const IGameModules& modules)
+{
+	if (symbol.address)
+	{
+		return symbol.address;
+	}
+
+	if (symbol.module == GameModule::None)
+	{
+		return nullptr;
+	}
+
+	if (symbol.ordinal)
+	{
+		return modules.GetExportByOrdinal(symbol.module, symbol.ordinal);
+	}
+
+	const uintptr_t baseAddress = modules.GetBaseAddress(symbol.module);
+	return baseAddress ? (void*)(baseAddress + symbol.offset) : nullptr;
+}
+
+_Use_decl_annotations_
+GameLayout::GameLayout(
+	GameVersion version,
+	const IGameModules& modules) :
+	_functions{},
+	_data{}
+{
+	const GameSymbols* symbols = nullptr;
+
+	switch (version)
+	{
+	case GameVersion::Lod109d:
+		symbols = &gameSymbols_109d;
+		break;
+	case GameVersion::Lod110f:
+		symbols = &gameSymbols_110;
+		break;
+	case GameVersion::Lod112:
+		symbols = &gameSymbols_112;
+		break;
+	case GameVersion::Lod113c:
+		symbols = &gameSymbols_113c;
+		break;
+	case GameVersion::Lod113d:
+		symbols = &gameSymbols_113d;
+		break;
+	case GameVersion::Lod114d:
+		symbols = &gameSymbols_114d;
+		break;
+	default:
+		return;
+	}
+
+	for (int32_t i = 0; i < (int32_t)D2Function::Count; ++i)
+	{
+		_functions[i] = ResolveSymbol(symbols->functions[i], modules);
+	}
+
+	for (int32_t i = 0; i < (int32_t)GameData::Count; ++i)
+	{
+		_data[i] = ResolveSymbol(symbols->data[i], modules);
+	}
+}
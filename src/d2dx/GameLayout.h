@@ -0,0 +1,65 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "IGameHelper.h"
+#include "IGameModules.h"
+
+namespace d2dx
+{
+	enum class GameData
+	{
+		ScreenOpenMode = 0,
+		GameMenuOpen = 1,
+		InGame = 2,
+		PlayerUnit = 3,
+		Count = 4
+	};
+
+	/*
+		The addresses of the game functions and variables that d2dx uses, for one game version.
+
+		These are resolved once, when the game version is known, so that looking one up is a plain load
+		instead of a switch on the version (and possibly a GetProcAddress).
+	*/
+	class GameLayout final
+	{
+	public:
+		GameLayout(
+			_In_ GameVersion version,
+			_In_ const IGameModules& modules);
+
+		inline void* GetFunction(
+			_In_ D2Function function) const noexcept
+		{
+			const int32_t index = (int32_t)function;
+			return index >= 0 && index < (int32_t)D2Function::Count ? _functions[index] : nullptr;
+		}
+
+		inline const void* GetData(
+			_In_ GameData data) const noexcept
+		{
+			return _data[(int32_t)data];
+		}
+
+	private:
+		void* _functions[(int32_t)D2Function::Count];
+		const void* _data[(int32_t)GameData::Count];
+	};
+}
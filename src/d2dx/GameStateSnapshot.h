@@ -0,0 +1,60 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "D2Types.h"
+
+namespace d2dx
+{
+	enum class GameStateChange
+	{
+		ScreenOpenMode = 1,
+		InGame = 2,
+		GameMenuOpen = 4,
+		PlayerUnit = 8,
+		CurrentAct = 16,
+	};
+
+	/* Game state that is read from game memory once per frame, rather than on every draw. */
+	struct GameStateSnapshot final
+	{
+		uint32_t screenOpenMode = 0;
+		bool isInGame = false;
+		bool isGameMenuOpen = false;
+		D2::UnitAny* playerUnit = nullptr;
+		int32_t currentAct = -1;
+
+		/* The fields that differ from the previous snapshot, as GameStateChange flags. */
+		uint32_t changes = 0;
+
+		inline bool HasChanged(
+			_In_ GameStateChange change) const noexcept
+		{
+			return (changes & (uint32_t)change) != 0;
+		}
+	};
+
+	struct IGameStateObserver abstract
+	{
+		virtual ~IGameStateObserver() noexcept {}
+
+		virtual void OnGameStateChanged(
+			_In_ const GameStateSnapshot& gameState) = 0;
+	};
+}
@@ -0,0 +1,79 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "GameStateTracker.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+GameStateTracker::GameStateTracker(
+	const std::shared_ptr<IGameHelper>& gameHelper) :
+	_gameHelper{ gameHelper },
+	_observers{ 8, true }
+{
+}
+
+_Use_decl_annotations_
+void GameStateTracker::AddObserver(
+	IGameStateObserver* observer)
+{
+	if (_observerCount >= _observers.capacity)
+	{
+		D2DX_FATAL_ERROR("Too many game state observers.");
+	}
+
+	_observers.items[_observerCount++] = observer;
+}
+
+const GameStateSnapshot& GameStateTracker::Capture()
+{
+	GameStateSnapshot snapshot;
+
+	snapshot.screenOpenMode = _gameHelper->ScreenOpenMode();
+	snapshot.isInGame = _gameHelper->IsInGame();
+	snapshot.isGameMenuOpen = _gameHelper->IsGameMenuOpen();
+	snapshot.playerUnit = _gameHelper->GetPlayerUnit();
+
+	/* The player unit may not be valid outside of the game. */
+	snapshot.currentAct = snapshot.isInGame ? _gameHelper->GetCurrentAct() : -1;
+
+	snapshot.changes =
+		(snapshot.screenOpenMode != _snapshot.screenOpenMode ? (uint32_t)GameStateChange::ScreenOpenMode : 0) |
+		(snapshot.isInGame != _snapshot.isInGame ? (uint32_t)GameStateChange::InGame : 0) |
+		(snapshot.isGameMenuOpen != _snapshot.isGameMenuOpen ? (uint32_t)GameStateChange::GameMenuOpen : 0) |
+		(snapshot.playerUnit != _snapshot.playerUnit ? (uint32_t)GameStateChange::PlayerUnit : 0) |
+		(snapshot.currentAct != _snapshot.currentAct ? (uint32_t)GameStateChange::CurrentAct : 0);
+
+	_snapshot = snapshot;
+
+	if (_snapshot.changes)
+	{
+		for (uint32_t i = 0; i < _observerCount; ++i)
+		{
+			_observers.items[i]->OnGameStateChanged(_snapshot);
+		}
+	}
+
+	return _snapshot;
+}
+
+const GameStateSnapshot& GameStateTracker::GetSnapshot() const
+{
+	return _snapshot;
+}
@@ -0,0 +1,112 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "GpuRingAllocator.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+GpuRingAllocator::GpuRingAllocator(
+	uint32_t capacity,
+	uint32_t maxFramesInFlight) :
+	_fences{ maxFramesInFlight + 1, true },
+	_capacity{ capacity }
+{
+	assert(capacity > 0);
+}
+
+_Use_decl_annotations_
+GpuRingAllocation GpuRingAllocator::Allocate(
+	uint32_t size,
+	uint32_t alignment)
+{
+	assert(size <= _capacity);
+	assert(alignment > 0 && !(alignment & (alignment - 1)));
+
+	size = min(size, _capacity);
+
+	if (_usedSize == 0)
+	{
+		/* Nothing is in flight, so start over from the beginning rather than wrap later. */
+		_head = 0;
+		_retiredPosition = 0;
+	}
+
+	uint32_t offset = (_head + alignment - 1) & ~(alignment - 1);
+
+	if ((uint64_t)offset + size > _capacity)
+	{
+		/* Wrap around, skipping the space at the end. */
+		offset = 0;
+	}
+
+	/* The padding and any skipped space are used up too, until the frame retires. */
+	const uint32_t consumed = (offset >= _head ? offset - _head : _capacity - _head) + size;
+
+	if ((uint64_t)_usedSize + consumed > _capacity)
+	{
+		/* Discarding the buffer releases the space of all frames in flight. */
+		_fenceCount = 0;
+		_retiredPosition = 0;
+		_usedSize = size;
+		_frameSize = size;
+		_head = size;
+		++_discardCount;
+		return { 0, true };
+	}
+
+	_usedSize += consumed;
+	_frameSize += consumed;
+	_head = offset + size;
+	return { offset, false };
+}
+
+void GpuRingAllocator::EndFrame()
+{
+	_fences.items[(_oldestFence + _fenceCount) % _fences.capacity] = { _head, _frameSize };
+	_frameSize = 0;
+
+	if (++_fenceCount == _fences.capacity)
+	{
+		_usedSize -= _fences.items[_oldestFence].size;
+		_retiredPosition = _fences.items[_oldestFence].position;
+		_oldestFence = (_oldestFence + 1) % _fences.capacity;
+		--_fenceCount;
+	}
+}
+
+uint32_t GpuRingAllocator::GetCapacity() const
+{
+	return _capacity;
+}
+
+uint32_t GpuRingAllocator::GetRetiredPosition() const
+{
+	return _retiredPosition;
+}
+
+uint32_t GpuRingAllocator::GetUsedSize() const
+{
+	return _usedSize;
+}
+
+uint32_t GpuRingAllocator::GetDiscardCount() const
+{
+	return _discardCount;
+}
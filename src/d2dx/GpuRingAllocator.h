@@ -0,0 +1,92 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	struct GpuRingAllocation final
+	{
+		uint32_t offset = 0;
+
+		/* The buffer must be mapped with WRITE_DISCARD rather than WRITE_NO_OVERWRITE, because the
+		   allocation would have overlapped data still in use by the GPU. */
+		bool discard = false;
+	};
+
+	/*
+		Sub-allocates per-frame uploads (vertices, constants) from a dynamic buffer used as a ring.
+
+		Each frame's allocations follow the previous frame's. The end position of every frame is recorded
+		as a fence when the frame ends, and the space used by a frame is only reused once the frame has
+		retired, i.e. when more than maxFramesInFlight newer frames have ended. When an allocation doesn't
+		fit in the space not used by frames in flight, it is placed at the start of the buffer and must be
+		written with a discard, which gives the buffer fresh storage and so releases everything in it.
+
+		Sizes and offsets are in whatever unit the caller uses (vertices, bytes).
+	*/
+	class GpuRingAllocator final
+	{
+	public:
+		GpuRingAllocator(
+			_In_ uint32_t capacity,
+			_In_ uint32_t maxFramesInFlight);
+
+		GpuRingAllocator(const GpuRingAllocator&) = delete;
+		GpuRingAllocator& operator=(const GpuRingAllocator&) = delete;
+
+		/* The size must not exceed the capacity, and the alignment must be a power of two. */
+		GpuRingAllocation Allocate(
+			_In_ uint32_t size,
+			_In_ uint32_t alignment = 1);
+
+		/* Records a fence at the current position, and retires the oldest frame if there are
+		   now more than maxFramesInFlight frames in flight. */
+		void EndFrame();
+
+		uint32_t GetCapacity() const;
+
+		/* The fence position of the most recently retired frame. The space from here up to the
+		   oldest frame in flight is free. */
+		uint32_t GetRetiredPosition() const;
+
+		/* The space used by frames in flight and by the current frame. */
+		uint32_t GetUsedSize() const;
+
+		uint32_t GetDiscardCount() const;
+
+	private:
+		struct Fence final
+		{
+			uint32_t position;
+			uint32_t size;
+		};
+
+		Buffer<Fence> _fences;
+		uint32_t _fenceCount = 0;
+		uint32_t _oldestFence = 0;
+		uint32_t _capacity = 0;
+		uint32_t _head = 0;
+		uint32_t _retiredPosition = 0;
+		uint32_t _usedSize = 0;
+		uint32_t _frameSize = 0;
+		uint32_t _discardCount = 0;
+	};
+}
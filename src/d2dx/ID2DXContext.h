@@ -52,5 +52,8 @@ namespace d2dx
 		
 		virtual bool IsFeatureEnabled(
 			_In_ Feature feature) = 0;
+
+		/* Writes the recorded frame metrics to a file, if metrics are enabled. */
+		virtual void ExportMetrics() = 0;
 	};
 }
@@ -40,6 +40,8 @@ namespace d2dx
 		D2Client_DrawWeatherParticles = 12,
 		D2Client_FindClientSideUnit = 13,
 		D2Client_FindServerSideUnit = 14,
+		D2Client_GetPlayerUnit = 15,
+		Count = 16
 	};
 
 	struct DrawParameters
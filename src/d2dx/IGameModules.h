@@ -0,0 +1,44 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+namespace d2dx
+{
+	enum class GameModule
+	{
+		None = 0,
+		GameExe = 1,
+		D2Client = 2,
+		D2Gfx = 3,
+		D2Win = 4,
+		Count = 5
+	};
+
+	struct IGameModules abstract
+	{
+		virtual ~IGameModules() noexcept {}
+
+		virtual uintptr_t GetBaseAddress(
+			_In_ GameModule module) const = 0;
+
+		virtual void* GetExportByOrdinal(
+			_In_ GameModule module,
+			_In_ int32_t ordinal) const = 0;
+	};
+}
@@ -27,6 +27,13 @@ namespace d2dx
 	class Vertex;
 	class Batch;
 
+	/* Running totals of pipeline state binds, and of those dropped because they changed nothing. */
+	struct StateChangeStats final
+	{
+		uint64_t issued = 0;
+		uint64_t filtered = 0;
+	};
+
 	struct IRenderContext abstract
 	{
 		virtual ~IRenderContext() noexcept {}
@@ -52,6 +59,16 @@ namespace d2dx
 
 		virtual void Present() = 0;
 
+		/* Presents the last presented frame again, without rendering it. Returns false if that frame is
+		   no longer available, e.g. because something has been drawn since or the window was resized. */
+		virtual bool PresentAgain() = 0;
+
+		/* Presents what has been drawn since the last present, like Present, but as a repeat of the game's
+		   last frame: the frame time is still measured between the game's own frames. The lock on the render
+		   context may be released before the swap chain presents, which can block until vsync. */
+		virtual void PresentRepeat(
+			_Inout_ std::unique_lock<std::recursive_mutex>& lock) = 0;
+
 		virtual void WriteToScreen(
 			_In_reads_(width * height) const uint32_t* pixels,
 			_In_ int32_t width,
@@ -66,6 +83,12 @@ namespace d2dx
 		virtual ITextureCache* GetTextureCache(
 			_In_ const Batch& batch) const = 0;
 
+		/* Index is below D2DX_TEXTURE_CACHE_COUNT. */
+		virtual ITextureCache* GetTextureCacheByIndex(
+			_In_ uint32_t index) const = 0;
+
+		virtual uint32_t GetVertexBufferSize() const = 0;
+
 		virtual void SetSizes(
 			_In_ Size gameSize,
 			_In_ Size windowSize) = 0;
@@ -82,5 +105,13 @@ namespace d2dx
 		virtual int32_t GetFrameTimeFp() const = 0;
 
 		virtual ScreenMode GetScreenMode() const = 0;
+
+		virtual TextureCacheStats GetTextureCacheStats() const = 0;
+
+		virtual StateChangeStats GetStateChangeStats() const = 0;
+
+		/* Must be held by any thread other than the game thread while it uses the render context, and by
+		   the game thread while such a thread may be running. */
+		virtual std::recursive_mutex& GetMutex() = 0;
 	};
 }
@@ -30,5 +30,20 @@ namespace d2dx
 			_In_reads_(itemsCount) const uint32_t* __restrict items,
 			_In_ uint32_t itemsCount,
 			_In_ uint32_t item) = 0;
+
+		virtual bool AreEqualUInt32(
+			_In_reads_(itemsCount) const uint32_t* __restrict itemsA,
+			_In_reads_(itemsCount) const uint32_t* __restrict itemsB,
+			_In_ uint32_t itemsCount) = 0;
+
+		/* Copies rows of width items with non-temporal stores, for destinations that won't be read back soon (e.g.
+		   mapped GPU memory). The stores are fenced once, after the last row. */
+		virtual void CopyUInt32NonTemporal(
+			_Out_writes_bytes_(dstPitchInBytes * height) uint32_t* __restrict dst,
+			_In_ uint32_t dstPitchInBytes,
+			_In_reads_bytes_(srcPitchInBytes * height) const uint32_t* __restrict src,
+			_In_ uint32_t srcPitchInBytes,
+			_In_ uint32_t width,
+			_In_ uint32_t height) = 0;
 	};
 }
@@ -33,6 +33,15 @@ namespace d2dx
 
 	static_assert(sizeof(TextureCacheLocation) == 4, "sizeof(TextureCacheLocation) == 4");
 
+	/* Running totals over all texture caches. */
+	struct TextureCacheStats final
+	{
+		uint64_t finds = 0;
+		uint64_t misses = 0;
+		uint64_t uploadBytes = 0;
+		uint32_t committedBytes = 0;
+	};
+
 	struct ITextureCache abstract
 	{
 		virtual ~ITextureCache() noexcept {}
@@ -52,8 +61,22 @@ namespace d2dx
 		virtual ID3D11ShaderResourceView* GetSrv(
 			_In_ uint32_t atlasIndex) const = 0;
 
+		/* The memory needed if every atlas is in use. */
 		virtual uint32_t GetMemoryFootprint() const = 0;
 
+		/* The memory used by the atlases created so far. */
+		virtual uint32_t GetCommittedMemoryFootprint() const = 0;
+
+		virtual uint32_t GetAtlasMemoryFootprint() const = 0;
+
+		/* The memory the cache could make use of, judging by the textures in it and those evicted recently. */
+		virtual uint32_t GetMemoryDemand() const = 0;
+
+		/* Limits the atlases in use to what fits in the given memory (but at least one), and releases the
+		   others. The textures in them are dropped, so this must not be called in the middle of a frame. */
+		virtual void SetMemoryLimit(
+			_In_ uint32_t bytes) = 0;
+
 		virtual uint32_t GetUsedCount() const = 0;
 	};
 }
@@ -0,0 +1,46 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+namespace d2dx
+{
+	/* The device operations needed by a texture cache. Kept separate so that the cache's
+	   allocation policy can be tested without a D3D device. */
+	struct ITextureCacheDevice abstract
+	{
+		virtual ~ITextureCacheDevice() noexcept {}
+
+		/* The largest number of slices supported in a texture array. */
+		virtual uint32_t GetMaxTextureArraySize() = 0;
+
+		virtual void CreateTextureArray(
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_ uint32_t arraySize,
+			_Outptr_ ID3D11Texture2D** texture,
+			_Outptr_ ID3D11ShaderResourceView** srv) = 0;
+
+		virtual void UpdateTextureArraySlice(
+			_In_ ID3D11Texture2D* texture,
+			_In_ uint32_t slice,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint8_t* data) = 0;
+	};
+}
@@ -32,6 +32,10 @@ namespace d2dx
 		virtual Offset OnMouseMoveMessage(
 			_In_ Offset pos) = 0;
 
+		/* A WM_MOUSEMOVE is delivered to the game's window. The position is in game coordinates. */
+		virtual void OnGameMouseMove(
+			_In_ Offset pos) = 0;
+
 		virtual int32_t OnSleep(
 			_In_ int32_t ms) = 0;
 	};
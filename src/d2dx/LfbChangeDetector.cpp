@@ -0,0 +1,96 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "LfbChangeDetector.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+LfbChangeDetector::LfbChangeDetector(
+	const std::shared_ptr<ISimd>& simd,
+	int32_t width,
+	int32_t height) :
+	_simd{ simd },
+	_previousFrame{ (uint32_t)(width * height) },
+	_width{ width },
+	_height{ height }
+{
+	assert(width > 0 && height > 0);
+}
+
+_Use_decl_annotations_
+bool LfbChangeDetector::Update(
+	const uint32_t* pixels,
+	uint32_t strideInBytes) noexcept
+{
+	assert(strideInBytes >= (uint32_t)_width * sizeof(uint32_t));
+
+	_firstDirtyRow = -1;
+	_lastDirtyRow = -1;
+
+	for (int32_t y = 0; y < _height; ++y)
+	{
+		const uint32_t* row = (const uint32_t*)((const uint8_t*)pixels + y * strideInBytes);
+		uint32_t* previousRow = &_previousFrame.items[y * _width];
+
+		if (_hasPreviousFrame && _simd->AreEqualUInt32(row, previousRow, _width))
+		{
+			continue;
+		}
+
+		memcpy(previousRow, row, _width * sizeof(uint32_t));
+
+		if (_firstDirtyRow < 0)
+		{
+			_firstDirtyRow = y;
+		}
+
+		_lastDirtyRow = y;
+	}
+
+	_hasPreviousFrame = true;
+
+	if (_firstDirtyRow < 0)
+	{
+		++_unchangedFrameCount;
+		return false;
+	}
+
+	return true;
+}
+
+void LfbChangeDetector::Reset() noexcept
+{
+	_hasPreviousFrame = false;
+}
+
+int32_t LfbChangeDetector::GetFirstDirtyRow() const noexcept
+{
+	return _firstDirtyRow;
+}
+
+int32_t LfbChangeDetector::GetLastDirtyRow() const noexcept
+{
+	return _lastDirtyRow;
+}
+
+uint64_t LfbChangeDetector::GetUnchangedFrameCount() const noexcept
+{
+	return _unchangedFrameCount;
+}
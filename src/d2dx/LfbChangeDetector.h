@@ -0,0 +1,67 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "ISimd.h"
+
+namespace d2dx
+{
+	/*
+		Finds the rows of the linear frame buffer (which the game uses for video playback) that changed since
+		the previous frame, by comparing with a copy of that frame.
+	*/
+	class LfbChangeDetector final
+	{
+	public:
+		LfbChangeDetector(
+			_In_ const std::shared_ptr<ISimd>& simd,
+			_In_ int32_t width,
+			_In_ int32_t height);
+
+		LfbChangeDetector(const LfbChangeDetector&) = delete;
+		LfbChangeDetector& operator=(const LfbChangeDetector&) = delete;
+
+		/* Compares a frame with the previous one, and keeps it for the next comparison. Returns false if
+		   nothing changed. */
+		bool Update(
+			_In_reads_bytes_(strideInBytes * height) const uint32_t* pixels,
+			_In_ uint32_t strideInBytes) noexcept;
+
+		/* Makes the next frame count as changed, e.g. because something else has been presented since. */
+		void Reset() noexcept;
+
+		/* The changed rows of the last frame passed to Update are firstDirtyRow...lastDirtyRow, inclusive. */
+		int32_t GetFirstDirtyRow() const noexcept;
+
+		int32_t GetLastDirtyRow() const noexcept;
+
+		uint64_t GetUnchangedFrameCount() const noexcept;
+
+	private:
+		std::shared_ptr<ISimd> _simd;
+		Buffer<uint32_t> _previousFrame;
+		int32_t _width = 0;
+		int32_t _height = 0;
+		bool _hasPreviousFrame = false;
+		int32_t _firstDirtyRow = -1;
+		int32_t _lastDirtyRow = -1;
+		uint64_t _unchangedFrameCount = 0;
+	};
+}
@@ -0,0 +1,310 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "LogQueue.h"
+
+using namespace d2dx;
+
+/* How long to wait for the writer thread before writing on the calling thread instead. */
+static const std::chrono::milliseconds writerTimeout{ 500 };
+
+_Use_decl_annotations_
+LogQueue::LogQueue(
+	uint32_t capacity,
+	const std::shared_ptr<ILogSink>& sink) :
+	_records{ capacity },
+	_mask{ capacity - 1 },
+	_sink{ sink },
+	_enqueuePosition{ 0 },
+	_dequeuePosition{ 0 },
+	_droppedCount{ 0 },
+	_writtenCount{ 0 },
+	_batch{ 64 * 1024 }
+{
+	assert(capacity > 0 && !(capacity & (capacity - 1)));
+
+	/* A record is free for the producer at position p when its sequence is p, and ready for the consumer
+	   when its sequence is p + 1. */
+	for (uint32_t i = 0; i < capacity; ++i)
+	{
+		new (&_records.items[i].sequence) std::atomic<uint32_t>(i);
+		_records.items[i].length = 0;
+	}
+
+	_writerThread = std::thread{ &LogQueue::RunWriter, this };
+}
+
+LogQueue::~LogQueue() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		_isStopping = true;
+	}
+
+	_wakeWriter.notify_one();
+
+	if (_writerThread.joinable())
+	{
+		_writerThread.join();
+	}
+}
+
+_Use_decl_annotations_
+bool LogQueue::TryPush(
+	const char* message) noexcept
+{
+	if (_isStopped.load(std::memory_order_acquire))
+	{
+		std::lock_guard<std::timed_mutex> drainLock{ _drainMutex };
+		const uint32_t length = (uint32_t)strnlen(message, MaxMessageLength);
+		AppendToBatch(message, length);
+		WriteBatch();
+		_writtenCount.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	uint32_t position = _enqueuePosition.load(std::memory_order_relaxed);
+	Record* record;
+
+	for (;;)
+	{
+		record = &_records.items[position & _mask];
+		const uint32_t sequence = record->sequence.load(std::memory_order_acquire);
+		const int32_t difference = (int32_t)(sequence - position);
+
+		if (difference == 0)
+		{
+			if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			_droppedCount.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+		{
+			position = _enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	uint32_t length = 0;
+
+	while (length < MaxMessageLength && message[length])
+	{
+		record->text[length] = message[length];
+		++length;
+	}
+
+	record->length = length;
+	record->sequence.store(position + 1, std::memory_order_release);
+
+	/* Wake the writer early during bursts, rather than waiting for it to poll. */
+	if (!(position & (_mask >> 1)))
+	{
+		_wakeWriter.notify_one();
+	}
+
+	return true;
+}
+
+void LogQueue::Flush()
+{
+	const uint32_t target = _enqueuePosition.load(std::memory_order_acquire);
+	bool isFlushed = false;
+
+	if (_isWriterRunning.load(std::memory_order_acquire))
+	{
+		std::unique_lock<std::mutex> lock{ _mutex };
+		_isFlushRequested = true;
+		_wakeWriter.notify_one();
+
+		isFlushed = _flushed.wait_for(lock, writerTimeout, [&]() {
+			return (int32_t)(_dequeuePosition.load(std::memory_order_acquire) - target) >= 0 || _hasWriterStopped;
+		});
+	}
+
+	if (!isFlushed)
+	{
+		DrainOnCallingThread();
+	}
+}
+
+void LogQueue::Stop()
+{
+	{
+		std::unique_lock<std::mutex> lock{ _mutex };
+
+		if (_isStopping)
+		{
+			return;
+		}
+
+		_isStopping = true;
+		_wakeWriter.notify_one();
+
+		if (_isWriterRunning.load(std::memory_order_acquire))
+		{
+			_flushed.wait_for(lock, writerTimeout, [&]() { return _hasWriterStopped; });
+		}
+	}
+
+	/* Joining could deadlock under the loader lock, since the exiting thread needs it. The writer has
+	   stopped touching the queue once it reports that it has stopped. */
+	if (_writerThread.joinable())
+	{
+		_writerThread.detach();
+	}
+
+	DrainOnCallingThread();
+
+	_isStopped.store(true, std::memory_order_release);
+
+	/* Catch messages pushed while stopping. */
+	DrainOnCallingThread();
+}
+
+uint64_t LogQueue::GetDroppedCount() const noexcept
+{
+	return _droppedCount.load(std::memory_order_relaxed);
+}
+
+uint64_t LogQueue::GetWrittenCount() const noexcept
+{
+	return _writtenCount.load(std::memory_order_relaxed);
+}
+
+void LogQueue::RunWriter()
+{
+	_isWriterRunning.store(true, std::memory_order_release);
+
+	for (;;)
+	{
+		bool isStopping;
+
+		{
+			std::unique_lock<std::mutex> lock{ _mutex };
+
+			/* Producers only signal when the queue is filling up, so that pushing stays cheap. Otherwise poll. */
+			_wakeWriter.wait_for(lock, std::chrono::milliseconds(20), [&]() {
+				return _isFlushRequested || _isStopping || IsHalfFull();
+			});
+			_isFlushRequested = false;
+			isStopping = _isStopping;
+		}
+
+		{
+			std::lock_guard<std::timed_mutex> drainLock{ _drainMutex };
+			DrainToSink();
+		}
+
+		std::lock_guard<std::mutex> lock{ _mutex };
+
+		if (isStopping)
+		{
+			_hasWriterStopped = true;
+			_isWriterRunning.store(false, std::memory_order_release);
+			_flushed.notify_all();
+			break;
+		}
+
+		_flushed.notify_all();
+	}
+}
+
+void LogQueue::DrainOnCallingThread()
+{
+	std::unique_lock<std::timed_mutex> drainLock{ _drainMutex, writerTimeout };
+
+	if (drainLock.owns_lock())
+	{
+		DrainToSink();
+	}
+}
+
+bool LogQueue::IsHalfFull() const noexcept
+{
+	const uint32_t used = _enqueuePosition.load(std::memory_order_relaxed) - _dequeuePosition.load(std::memory_order_relaxed);
+	return used > (_mask >> 1);
+}
+
+void LogQueue::DrainToSink()
+{
+	uint32_t position = _dequeuePosition.load(std::memory_order_relaxed);
+	uint64_t writtenCount = 0;
+
+	for (;;)
+	{
+		Record& record = _records.items[position & _mask];
+
+		if (record.sequence.load(std::memory_order_acquire) != position + 1)
+		{
+			break;
+		}
+
+		AppendToBatch(record.text, record.length);
+
+		record.sequence.store(position + _mask + 1, std::memory_order_release);
+		++position;
+		++writtenCount;
+		_dequeuePosition.store(position, std::memory_order_release);
+	}
+
+	const uint64_t droppedCount = _droppedCount.load(std::memory_order_relaxed);
+
+	if (droppedCount != _reportedDroppedCount)
+	{
+		char message[64];
+		const int32_t length = sprintf_s(message, "%llu log messages were dropped.\n", droppedCount - _reportedDroppedCount);
+		AppendToBatch(message, length > 0 ? (uint32_t)length : 0);
+		_reportedDroppedCount = droppedCount;
+	}
+
+	WriteBatch();
+
+	_writtenCount.fetch_add(writtenCount, std::memory_order_relaxed);
+}
+
+_Use_decl_annotations_
+void LogQueue::AppendToBatch(
+	const char* text,
+	uint32_t length)
+{
+	if (_batchLength + length + 1 > _batch.capacity)
+	{
+		WriteBatch();
+	}
+
+	memcpy(_batch.items + _batchLength, text, length);
+	_batchLength += length;
+}
+
+void LogQueue::WriteBatch()
+{
+	if (_batchLength == 0)
+	{
+		return;
+	}
+
+	_batch.items[_batchLength] = 0;
+	_sink->Write(_batch.items, _batchLength);
+	_batchLength = 0;
+}
@@ -0,0 +1,124 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	struct ILogSink abstract
+	{
+		virtual ~ILogSink() noexcept {}
+
+		/* Writes a batch of log text. The text is null terminated, at text[length]. */
+		virtual void Write(
+			_In_reads_(length) const char* text,
+			_In_ uint32_t length) = 0;
+	};
+
+	/*
+		Bounded multi-producer, single-consumer queue of log messages, with a writer thread that drains it
+		into an ILogSink in batches.
+
+		Messages are copied into preallocated fixed-size records, so pushing never allocates or blocks. Long
+		messages are truncated. When the queue is full the message is dropped and counted instead, and the
+		writer reports the number of dropped messages in the log.
+
+		The writer thread can't run while the loader lock is held (in DllMain), so Flush and Stop never wait
+		for it indefinitely: if it doesn't respond in time, the calling thread writes the messages itself.
+	*/
+	class LogQueue final
+	{
+	public:
+		static constexpr uint32_t MaxMessageLength = 247;
+
+		LogQueue(
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ILogSink>& sink);
+
+		~LogQueue() noexcept;
+
+		LogQueue(const LogQueue&) = delete;
+		LogQueue& operator=(const LogQueue&) = delete;
+
+		/* Returns false (and counts the message as dropped) if the queue is full. */
+		bool TryPush(
+			_In_z_ const char* message) noexcept;
+
+		/* Blocks until all messages pushed before the call have been written to the sink. */
+		void Flush();
+
+		/* Writes all pending messages and stops the writer thread. Messages pushed afterwards are written
+		   to the sink immediately, by the pushing thread. */
+		void Stop();
+
+		uint64_t GetDroppedCount() const noexcept;
+
+		uint64_t GetWrittenCount() const noexcept;
+
+	private:
+		struct Record final
+		{
+			std::atomic<uint32_t> sequence;
+			uint32_t length;
+			char text[MaxMessageLength + 1];
+		};
+
+		static_assert(sizeof(Record) == 256, "Unexpected log record size.");
+
+		void RunWriter();
+
+		bool IsHalfFull() const noexcept;
+
+		void DrainToSink();
+
+		/* Drains the queue on the calling thread, unless the writer thread keeps it busy for too long. */
+		void DrainOnCallingThread();
+
+		void AppendToBatch(
+			_In_reads_(length) const char* text,
+			_In_ uint32_t length);
+
+		void WriteBatch();
+
+		Buffer<Record> _records;
+		uint32_t _mask;
+		std::shared_ptr<ILogSink> _sink;
+
+		alignas(64) std::atomic<uint32_t> _enqueuePosition;
+		alignas(64) std::atomic<uint32_t> _dequeuePosition;
+		std::atomic<uint64_t> _droppedCount;
+		std::atomic<uint64_t> _writtenCount;
+
+		uint64_t _reportedDroppedCount = 0;
+		Buffer<char> _batch;
+		uint32_t _batchLength = 0;
+
+		std::mutex _mutex;
+		std::condition_variable _wakeWriter;
+		std::condition_variable _flushed;
+		bool _isFlushRequested = false;
+		bool _isStopping = false;
+		bool _hasWriterStopped = false;
+		std::atomic<bool> _isWriterRunning{ false };
+		std::atomic<bool> _isStopped{ false };
+		std::timed_mutex _drainMutex;
+		std::thread _writerThread;
+	};
+}
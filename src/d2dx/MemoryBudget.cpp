@@ -0,0 +1,148 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "MemoryBudget.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+MemoryBudget::MemoryBudget(
+	uint32_t consumerCount,
+	uint64_t budget) :
+	_consumers{ consumerCount, true },
+	_budget{ budget }
+{
+	assert(consumerCount > 0);
+}
+
+_Use_decl_annotations_
+void MemoryBudget::SetBudget(
+	uint64_t budget)
+{
+	_budget = budget;
+}
+
+uint64_t MemoryBudget::GetBudget() const
+{
+	return _budget;
+}
+
+_Use_decl_annotations_
+void MemoryBudget::SetLimits(
+	uint32_t consumer,
+	uint64_t minBytes,
+	uint64_t maxBytes)
+{
+	assert(consumer < _consumers.capacity && minBytes <= maxBytes);
+	_consumers.items[consumer].minBytes = minBytes;
+	_consumers.items[consumer].maxBytes = maxBytes;
+}
+
+_Use_decl_annotations_
+void MemoryBudget::ReportDemand(
+	uint32_t consumer,
+	uint64_t bytes)
+{
+	assert(consumer < _consumers.capacity);
+	Consumer& c = _consumers.items[consumer];
+	c.peakDemand = max(c.peakDemand, bytes);
+}
+
+_Use_decl_annotations_
+void MemoryBudget::ReportUsage(
+	uint32_t consumer,
+	uint64_t bytes)
+{
+	assert(consumer < _consumers.capacity);
+	_consumers.items[consumer].usage = bytes;
+}
+
+bool MemoryBudget::Rebalance()
+{
+	uint64_t minTotal = 0;
+	uint64_t wantTotal = 0;
+	uint64_t headroomTotal = 0;
+
+	for (uint32_t i = 0; i < _consumers.capacity; ++i)
+	{
+		Consumer& c = _consumers.items[i];
+
+		c.demand = max(c.peakDemand, c.demand - c.demand / 4);
+		c.peakDemand = 0;
+
+		const uint64_t want = min(c.maxBytes, max(c.minBytes, c.demand));
+		minTotal += c.minBytes;
+		wantTotal += want;
+		headroomTotal += c.maxBytes - want;
+	}
+
+	bool hasChanged = false;
+
+	for (uint32_t i = 0; i < _consumers.capacity; ++i)
+	{
+		Consumer& c = _consumers.items[i];
+		const uint64_t want = min(c.maxBytes, max(c.minBytes, c.demand));
+		uint64_t allowance;
+
+		if (_budget == 0)
+		{
+			allowance = c.maxBytes;
+		}
+		else if (wantTotal <= _budget)
+		{
+			const uint64_t leftover = _budget - wantTotal;
+			allowance = headroomTotal <= leftover ? c.maxBytes :
+				want + (uint64_t)((double)(c.maxBytes - want) * leftover / headroomTotal);
+		}
+		else if (minTotal >= _budget)
+		{
+			/* The minimums can't be given up, even if they exceed the budget. */
+			allowance = c.minBytes;
+		}
+		else
+		{
+			allowance = c.minBytes + (uint64_t)((double)(want - c.minBytes) * (_budget - minTotal) / (wantTotal - minTotal));
+		}
+
+		hasChanged |= allowance != c.allowance;
+		c.allowance = allowance;
+	}
+
+	return hasChanged;
+}
+
+_Use_decl_annotations_
+uint64_t MemoryBudget::GetAllowance(
+	uint32_t consumer) const
+{
+	assert(consumer < _consumers.capacity);
+	return _consumers.items[consumer].allowance;
+}
+
+uint64_t MemoryBudget::GetTotalUsage() const
+{
+	uint64_t usage = 0;
+
+	for (uint32_t i = 0; i < _consumers.capacity; ++i)
+	{
+		usage += _consumers.items[i].usage;
+	}
+
+	return usage;
+}
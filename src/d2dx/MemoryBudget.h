@@ -0,0 +1,83 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	/*
+		Splits a total memory budget between a number of consumers (caches and buffers).
+
+		Each consumer has a minimum that it always gets, and a maximum beyond which more memory is of no use
+		to it. In between, consumers get memory according to their demand: the most they could have used
+		recently. Demand rises immediately and decays slowly, so that a short lull doesn't shrink a cache that
+		will be needed again. Memory left over after meeting all demand is shared out in proportion to the
+		headroom of each consumer. A budget of 0 means no limit, and every consumer gets its maximum.
+	*/
+	class MemoryBudget final
+	{
+	public:
+		MemoryBudget(
+			_In_ uint32_t consumerCount,
+			_In_ uint64_t budget);
+
+		/* Takes effect on the next Rebalance. */
+		void SetBudget(
+			_In_ uint64_t budget);
+
+		uint64_t GetBudget() const;
+
+		void SetLimits(
+			_In_ uint32_t consumer,
+			_In_ uint64_t minBytes,
+			_In_ uint64_t maxBytes);
+
+		/* The highest demand reported between two rebalances is used. */
+		void ReportDemand(
+			_In_ uint32_t consumer,
+			_In_ uint64_t bytes);
+
+		void ReportUsage(
+			_In_ uint32_t consumer,
+			_In_ uint64_t bytes);
+
+		/* Recomputes the allowances. Returns true if any of them changed. */
+		bool Rebalance();
+
+		uint64_t GetAllowance(
+			_In_ uint32_t consumer) const;
+
+		uint64_t GetTotalUsage() const;
+
+	private:
+		struct Consumer final
+		{
+			uint64_t minBytes;
+			uint64_t maxBytes;
+			uint64_t demand;
+			uint64_t peakDemand;
+			uint64_t usage;
+			uint64_t allowance;
+		};
+
+		Buffer<Consumer> _consumers;
+		uint64_t _budget = 0;
+	};
+}
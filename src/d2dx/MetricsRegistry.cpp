@@ -0,0 +1,227 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "MetricsRegistry.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+namespace
+{
+	struct MetricInfo final
+	{
+		const char* name;
+		MetricKind kind;
+	};
+
+	const MetricInfo metricInfos[] =
+	{
+		{ "batches", MetricKind::Counter },
+		{ "vertices", MetricKind::Counter },
+		{ "draw_calls", MetricKind::Counter },
+		{ "texture_finds", MetricKind::Counter },
+		{ "texture_misses", MetricKind::Counter },
+		{ "texture_upload_bytes", MetricKind::Counter },
+		{ "hash_cache_hits", MetricKind::Counter },
+		{ "hash_cache_misses", MetricKind::Counter },
+		{ "sleeps", MetricKind::Counter },
+		{ "texture_dump_drops", MetricKind::Counter },
+		{ "repeated_frames", MetricKind::Counter },
+		{ "mid_frame_flushes", MetricKind::Counter },
+		{ "render_thread_frames", MetricKind::Counter },
+		{ "state_changes_issued", MetricKind::Counter },
+		{ "state_changes_filtered", MetricKind::Counter },
+		{ "predicted_units", MetricKind::Gauge },
+		{ "predicted_texts", MetricKind::Gauge },
+		{ "predicted_weather_particles", MetricKind::Gauge },
+		{ "tmu_committed_bytes", MetricKind::Gauge },
+		{ "texture_cache_committed_bytes", MetricKind::Gauge },
+		{ "memory_used_bytes", MetricKind::Gauge },
+		{ "present_time_us", MetricKind::Gauge },
+		{ "cursor_age_us", MetricKind::Gauge },
+		{ "pacing_jitter_us", MetricKind::Gauge },
+		{ "frame_time_us", MetricKind::Gauge },
+	};
+
+	static_assert(ARRAYSIZE(metricInfos) == (size_t)Metric::Count, "Missing metric info.");
+}
+
+_Use_decl_annotations_
+MetricsRegistry::MetricsRegistry(
+	uint32_t historyLength) :
+	_current{ (uint32_t)Metric::Count, true },
+	_totals{ (uint32_t)Metric::Count, true },
+	_history{ historyLength * (uint32_t)Metric::Count, true },
+	_historyLength{ historyLength }
+{
+	assert(historyLength > 0);
+}
+
+_Use_decl_annotations_
+void MetricsRegistry::AddFromTotal(
+	Metric metric,
+	uint64_t total) noexcept
+{
+	Add(metric, (int64_t)(total - _totals.items[(int32_t)metric]));
+	_totals.items[(int32_t)metric] = total;
+}
+
+_Use_decl_annotations_
+int64_t MetricsRegistry::GetCurrent(
+	Metric metric) const noexcept
+{
+	return _current.items[(int32_t)metric];
+}
+
+void MetricsRegistry::EndFrame() noexcept
+{
+	const uint32_t row = (uint32_t)(_frameCount % _historyLength);
+	memcpy(&_history.items[row * (uint32_t)Metric::Count], _current.items, sizeof(int64_t) * (uint32_t)Metric::Count);
+	++_frameCount;
+
+	for (int32_t i = 0; i < (int32_t)Metric::Count; ++i)
+	{
+		if (metricInfos[i].kind == MetricKind::Counter)
+		{
+			_current.items[i] = 0;
+		}
+	}
+}
+
+uint32_t MetricsRegistry::GetHistoryCount() const noexcept
+{
+	return (uint32_t)min(_frameCount, (uint64_t)_historyLength);
+}
+
+_Use_decl_annotations_
+uint64_t MetricsRegistry::GetHistoryFrame(
+	uint32_t historyIndex) const noexcept
+{
+	assert(historyIndex < GetHistoryCount());
+	return _frameCount - GetHistoryCount() + historyIndex;
+}
+
+_Use_decl_annotations_
+int64_t MetricsRegistry::GetHistoryValue(
+	uint32_t historyIndex,
+	Metric metric) const noexcept
+{
+	const uint32_t row = (uint32_t)(GetHistoryFrame(historyIndex) % _historyLength);
+	return _history.items[row * (uint32_t)Metric::Count + (uint32_t)metric];
+}
+
+_Use_decl_annotations_
+void MetricsRegistry::Write(
+	FILE* file,
+	MetricsFormat format) const
+{
+	if (format == MetricsFormat::Json)
+	{
+		WriteJson(file);
+	}
+	else
+	{
+		WriteCsv(file);
+	}
+}
+
+_Use_decl_annotations_
+bool MetricsRegistry::Export(
+	const char* path,
+	MetricsFormat format) const
+{
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, path, "w") != 0 || !file)
+	{
+		D2DX_LOG("Failed to open %s for writing metrics.", path);
+		return false;
+	}
+
+	Write(file, format);
+	fclose(file);
+
+	D2DX_LOG("Wrote metrics for %u frames to %s.", GetHistoryCount(), path);
+	return true;
+}
+
+_Use_decl_annotations_
+const char* MetricsRegistry::GetName(
+	Metric metric) noexcept
+{
+	return metricInfos[(int32_t)metric].name;
+}
+
+_Use_decl_annotations_
+MetricKind MetricsRegistry::GetKind(
+	Metric metric) noexcept
+{
+	return metricInfos[(int32_t)metric].kind;
+}
+
+_Use_decl_annotations_
+void MetricsRegistry::WriteCsv(
+	FILE* file) const
+{
+	fprintf(file, "frame");
+
+	for (int32_t i = 0; i < (int32_t)Metric::Count; ++i)
+	{
+		fprintf(file, ",%s", metricInfos[i].name);
+	}
+
+	fprintf(file, "\n");
+
+	const uint32_t historyCount = GetHistoryCount();
+
+	for (uint32_t frame = 0; frame < historyCount; ++frame)
+	{
+		fprintf(file, "%llu", (unsigned long long)GetHistoryFrame(frame));
+
+		for (int32_t i = 0; i < (int32_t)Metric::Count; ++i)
+		{
+			fprintf(file, ",%lld", (long long)GetHistoryValue(frame, (Metric)i));
+		}
+
+		fprintf(file, "\n");
+	}
+}
+
+_Use_decl_annotations_
+void MetricsRegistry::WriteJson(
+	FILE* file) const
+{
+	fprintf(file, "{\n\t\"frames\": [");
+
+	const uint32_t historyCount = GetHistoryCount();
+
+	for (uint32_t frame = 0; frame < historyCount; ++frame)
+	{
+		fprintf(file, "%s\n\t\t{ \"frame\": %llu", frame > 0 ? "," : "", (unsigned long long)GetHistoryFrame(frame));
+
+		for (int32_t i = 0; i < (int32_t)Metric::Count; ++i)
+		{
+			fprintf(file, ", \"%s\": %lld", metricInfos[i].name, (long long)GetHistoryValue(frame, (Metric)i));
+		}
+
+		fprintf(file, " }");
+	}
+
+	fprintf(file, "\n\t]\n}\n");
+}
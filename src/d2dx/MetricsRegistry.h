@@ -0,0 +1,142 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "Options.h"
+
+namespace d2dx
+{
+	enum class Metric
+	{
+		Batches,
+		Vertices,
+		DrawCalls,
+		TextureFinds,
+		TextureMisses,
+		TextureUploadBytes,
+		HashCacheHits,
+		HashCacheMisses,
+		Sleeps,
+		TextureDumpDrops,
+		RepeatedFrames,
+		MidFrameFlushes,
+		RenderThreadFrames,
+		StateChangesIssued,
+		StateChangesFiltered,
+		PredictedUnits,
+		PredictedTexts,
+		PredictedWeatherParticles,
+		TmuCommittedBytes,
+		TextureCacheCommittedBytes,
+		MemoryUsedBytes,
+		PresentTimeUs,
+		CursorAgeUs,
+		PacingJitterUs,
+		FrameTimeUs,
+		Count
+	};
+
+	enum class MetricKind
+	{
+		/* Accumulates over a frame, and starts from zero on the next. */
+		Counter,
+
+		/* Holds the last value set, across frames. */
+		Gauge,
+	};
+
+	/*
+		Per-frame counters and gauges, with a rolling history of the most recent frames that can be written
+		out as CSV or JSON.
+	*/
+	class MetricsRegistry final
+	{
+	public:
+		MetricsRegistry(
+			_In_ uint32_t historyLength);
+
+		MetricsRegistry(const MetricsRegistry&) = delete;
+		MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+		inline void Add(
+			_In_ Metric metric,
+			_In_ int64_t value) noexcept
+		{
+			assert(GetKind(metric) == MetricKind::Counter);
+			_current.items[(int32_t)metric] += value;
+		}
+
+		inline void Set(
+			_In_ Metric metric,
+			_In_ int64_t value) noexcept
+		{
+			assert(GetKind(metric) == MetricKind::Gauge);
+			_current.items[(int32_t)metric] = value;
+		}
+
+		/* Adds the increase of a running total kept elsewhere since the previous call. */
+		void AddFromTotal(
+			_In_ Metric metric,
+			_In_ uint64_t total) noexcept;
+
+		int64_t GetCurrent(
+			_In_ Metric metric) const noexcept;
+
+		/* Moves the current values into the history, and resets the counters. */
+		void EndFrame() noexcept;
+
+		uint32_t GetHistoryCount() const noexcept;
+
+		/* Index 0 is the oldest frame in the history. */
+		uint64_t GetHistoryFrame(
+			_In_ uint32_t historyIndex) const noexcept;
+
+		int64_t GetHistoryValue(
+			_In_ uint32_t historyIndex,
+			_In_ Metric metric) const noexcept;
+
+		void Write(
+			_In_ FILE* file,
+			_In_ MetricsFormat format) const;
+
+		bool Export(
+			_In_z_ const char* path,
+			_In_ MetricsFormat format) const;
+
+		static _Ret_z_ const char* GetName(
+			_In_ Metric metric) noexcept;
+
+		static MetricKind GetKind(
+			_In_ Metric metric) noexcept;
+
+	private:
+		void WriteCsv(
+			_In_ FILE* file) const;
+
+		void WriteJson(
+			_In_ FILE* file) const;
+
+		Buffer<int64_t> _current;
+		Buffer<uint64_t> _totals;
+		Buffer<int64_t> _history;
+		uint32_t _historyLength = 0;
+		uint64_t _frameCount = 0;
+	};
+}
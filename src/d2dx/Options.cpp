@@ -79,6 +79,7 @@ void Options::ApplyCfg(
 		READ_OPTOUTS_FLAG(OptionsFlag::NoCompatModeFix, "nocompatmodefix");
 		READ_OPTOUTS_FLAG(OptionsFlag::NoTitleChange, "notitlechange");
 		READ_OPTOUTS_FLAG(OptionsFlag::NoMotionPrediction, "nomotionprediction");
+		READ_OPTOUTS_FLAG(OptionsFlag::NoLateCursor, "nolatecursor");
 
 #undef READ_OPTOUTS_FLAG
 	}
@@ -104,6 +105,82 @@ void Options::ApplyCfg(
 		{
 			_filtering = (FilteringOption)filtering.u.i;
 		}
+
+		auto renderThread = toml_bool_in(game, "renderthread");
+		if (renderThread.ok)
+		{
+			SetFlag(OptionsFlag::RenderThread, renderThread.u.b);
+		}
+
+		auto adaptiveSleep = toml_bool_in(game, "adaptivesleep");
+		if (adaptiveSleep.ok)
+		{
+			SetFlag(OptionsFlag::AdaptiveSleep, adaptiveSleep.u.b);
+		}
+
+		auto targetFps = toml_int_in(game, "targetfps");
+		if (targetFps.ok)
+		{
+			SetTargetFps((int32_t)targetFps.u.i);
+		}
+
+		/* Frames are paced while they hold the render context, which would keep the render thread from
+		   repeating them anyway. */
+		if (GetFlag(OptionsFlag::RenderThread) && _targetFps > 0)
+		{
+			D2DX_LOG("Ignoring renderthread=true in d2dx.cfg, since it can't be combined with targetfps=%i.", _targetFps);
+			SetFlag(OptionsFlag::RenderThread, false);
+		}
+	}
+
+	auto motionPrediction = toml_table_in(root, "motionprediction");
+
+	if (motionPrediction)
+	{
+		MotionPredictionSettings settings = _motionPredictionSettings;
+
+		auto mode = toml_int_in(motionPrediction, "mode");
+		if (mode.ok)
+		{
+			settings.mode = (MotionPredictionMode)mode.u.i;
+		}
+
+		auto alpha = toml_double_in(motionPrediction, "alpha");
+		if (alpha.ok)
+		{
+			settings.alpha = (float)alpha.u.d;
+		}
+
+		auto beta = toml_double_in(motionPrediction, "beta");
+		if (beta.ok)
+		{
+			settings.beta = (float)beta.u.d;
+		}
+
+		auto gamma = toml_double_in(motionPrediction, "gamma");
+		if (gamma.ok)
+		{
+			settings.gamma = (float)gamma.u.d;
+		}
+
+		auto maxOvershoot = toml_double_in(motionPrediction, "maxovershoot");
+		if (maxOvershoot.ok)
+		{
+			settings.maxOvershoot = (float)maxOvershoot.u.d;
+		}
+
+		SetMotionPredictionSettings(settings);
+	}
+
+	auto memory = toml_table_in(root, "memory");
+
+	if (memory)
+	{
+		auto budget = toml_int_in(memory, "budget");
+		if (budget.ok && budget.u.i >= 0)
+		{
+			SetMemoryBudget((uint64_t)budget.u.i * 1024 * 1024);
+		}
 	}
 
 	auto window = toml_table_in(root, "window");
@@ -144,6 +221,36 @@ void Options::ApplyCfg(
 		{
 			SetFlag(OptionsFlag::DbgDumpTextures, dumpTextures.u.b);
 		}
+
+		auto metrics = toml_bool_in(debug, "metrics");
+		if (metrics.ok)
+		{
+			SetFlag(OptionsFlag::DbgMetrics, metrics.u.b);
+		}
+
+		auto costOverlay = toml_bool_in(debug, "costoverlay");
+		if (costOverlay.ok)
+		{
+			SetFlag(OptionsFlag::DbgCostOverlay, costOverlay.u.b);
+		}
+
+		auto metricsFormat = toml_int_in(debug, "metricsformat");
+		if (metricsFormat.ok && metricsFormat.u.i >= 0 && metricsFormat.u.i < (int64_t)MetricsFormat::Count)
+		{
+			_metricsFormat = (MetricsFormat)metricsFormat.u.i;
+		}
+
+		auto traceFrames = toml_array_in(debug, "traceframes");
+		if (traceFrames)
+		{
+			auto first = toml_int_at(traceFrames, 0);
+			auto last = toml_int_at(traceFrames, 1);
+
+			if (first.ok && last.ok && first.u.i >= 0 && last.u.i >= first.u.i)
+			{
+				_traceFrames = { (int32_t)first.u.i, (int32_t)last.u.i };
+			}
+		}
 	}
 
 	toml_free(root);
@@ -163,6 +270,7 @@ void Options::ApplyCommandLine(
 	if (strstr(cmdLine, "-dxnocompatmodefix")) SetFlag(OptionsFlag::NoCompatModeFix, true);
 	if (strstr(cmdLine, "-dxnotitlechange")) SetFlag(OptionsFlag::NoTitleChange, true);
 	if (strstr(cmdLine, "-dxnomop")) SetFlag(OptionsFlag::NoMotionPrediction, true);
+	if (strstr(cmdLine, "-dxnolatecursor")) SetFlag(OptionsFlag::NoLateCursor, true);
 
 	if (strstr(cmdLine, "-dxscale3")) SetWindowScale(3);
 	else if (strstr(cmdLine, "-dxscale2")) SetWindowScale(2);
@@ -227,3 +335,54 @@ FilteringOption Options::GetFiltering() const
 {
 	return _filtering;
 }
+
+MetricsFormat Options::GetMetricsFormat() const
+{
+	return _metricsFormat;
+}
+
+FrameRange Options::GetTraceFrames() const
+{
+	return _traceFrames;
+}
+
+const MotionPredictionSettings& Options::GetMotionPredictionSettings() const
+{
+	return _motionPredictionSettings;
+}
+
+_Use_decl_annotations_
+void Options::SetMotionPredictionSettings(
+	const MotionPredictionSettings& settings)
+{
+	_motionPredictionSettings.mode = (settings.mode >= MotionPredictionMode::Blend && settings.mode < MotionPredictionMode::Count) ?
+		settings.mode : MotionPredictionMode::Blend;
+	_motionPredictionSettings.alpha = min(1.0f, max(0.01f, settings.alpha));
+	_motionPredictionSettings.beta = min(2.0f, max(0.0f, settings.beta));
+	_motionPredictionSettings.gamma = min(1.0f, max(0.0f, settings.gamma));
+	_motionPredictionSettings.maxOvershoot = min(2.0f, max(0.0f, settings.maxOvershoot));
+}
+
+uint64_t Options::GetMemoryBudget() const
+{
+	return _memoryBudget;
+}
+
+_Use_decl_annotations_
+void Options::SetMemoryBudget(
+	uint64_t memoryBudget)
+{
+	_memoryBudget = memoryBudget;
+}
+
+int32_t Options::GetTargetFps() const
+{
+	return _targetFps;
+}
+
+_Use_decl_annotations_
+void Options::SetTargetFps(
+	int32_t targetFps)
+{
+	_targetFps = min(1000, max(0, targetFps));
+}
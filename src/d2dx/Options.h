@@ -34,10 +34,15 @@ namespace d2dx
 		NoTitleChange,
 		NoVSync,
 		NoMotionPrediction,
+		NoLateCursor,
 
 		DbgDumpTextures,
+		DbgMetrics,
+		DbgCostOverlay,
 
 		Frameless,
+		RenderThread,
+		AdaptiveSleep,
 
 		Count
 	};
@@ -50,6 +55,39 @@ namespace d2dx
 		Count = 3
 	};
 
+	enum class MetricsFormat
+	{
+		Csv = 0,
+		Json = 1,
+		Count = 2
+	};
+
+	enum class MotionPredictionMode
+	{
+		Blend = 0,
+		AlphaBetaGamma = 1,
+		Count = 2
+	};
+
+	struct FrameRange final
+	{
+		int32_t first = -1;
+		int32_t last = -1;
+	};
+
+	struct MotionPredictionSettings final
+	{
+		MotionPredictionMode mode = MotionPredictionMode::Blend;
+
+		/* Gains for the alpha-beta-gamma filter (position, velocity and acceleration). */
+		float alpha = 0.85f;
+		float beta = 0.5f;
+		float gamma = 0.0f;
+
+		/* How far past the expected next game tick to keep extrapolating, in ticks. */
+		float maxOvershoot = 0.1f;
+	};
+
 	class Options final
 	{
 	public:
@@ -86,11 +124,37 @@ namespace d2dx
 
 		FilteringOption GetFiltering() const;
 
+		MetricsFormat GetMetricsFormat() const;
+
+		FrameRange GetTraceFrames() const;
+
+		const MotionPredictionSettings& GetMotionPredictionSettings() const;
+
+		void SetMotionPredictionSettings(
+			_In_ const MotionPredictionSettings& settings);
+
+		/* In bytes, 0 if there is no limit. */
+		uint64_t GetMemoryBudget() const;
+
+		void SetMemoryBudget(
+			_In_ uint64_t memoryBudget);
+
+		/* 0 if the frame rate isn't capped (other than by vsync). */
+		int32_t GetTargetFps() const;
+
+		void SetTargetFps(
+			_In_ int32_t targetFps);
+
 	private:
 		uint32_t _flags = 0;
 		int32_t _windowScale = 1;
 		Offset _windowPosition{ -1, -1 };
 		Size _userSpecifiedGameSize{ -1, -1 };
 		FilteringOption _filtering{ FilteringOption::HighQuality };
+		MetricsFormat _metricsFormat{ MetricsFormat::Csv };
+		FrameRange _traceFrames;
+		MotionPredictionSettings _motionPredictionSettings;
+		uint64_t _memoryBudget = 0;
+		int32_t _targetFps = 0;
 	};
 }
\ No newline at end of file
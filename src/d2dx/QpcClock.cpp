@@ -0,0 +1,40 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "QpcClock.h"
+
+using namespace d2dx;
+
+QpcClock::QpcClock()
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	_frequency = frequency.QuadPart;
+}
+
+int64_t QpcClock::GetTimeUs() const
+{
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	/* Split the conversion to avoid overflowing the intermediate product. */
+	const int64_t seconds = counter.QuadPart / _frequency;
+	const int64_t remainder = counter.QuadPart % _frequency;
+	return seconds * 1000000 + remainder * 1000000 / _frequency;
+}
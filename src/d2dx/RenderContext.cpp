@@ -26,6 +26,14 @@
 #include "Utils.h"
 
 #define MAX_FRAME_LATENCY 1
+
+/* DXGI may queue up to three frames by default, and one more can be in the process of being rendered. */
+#define MAX_FRAMES_IN_FLIGHT 4
+
+/* Offsets into a constant buffer are given in units of 16 constants (256 bytes). */
+#define CONSTANTS_ALIGNMENT 256
+#define CONSTANT_BUFFER_SIZE (64 * 1024)
+
 #undef ALLOW_SET_SOURCE_SIZE
 
 using namespace d2dx;
@@ -65,8 +73,6 @@ RenderContext::RenderContext(
 	_d2dxContext = d2dxContext;
 	_simd = simd;
 
-	memset(&_shadowState, 0, sizeof(_shadowState));
-
 	_desktopSize = { GetSystemMetrics(SM_CXSCREEN), GetSystemMetrics(SM_CYSCREEN) };
 	_desktopClientMaxHeight = GetSystemMetrics(SM_CYFULLSCREEN);
 
@@ -182,6 +188,8 @@ RenderContext::RenderContext(
 			&_featureLevel,
 			&_deviceContext));
 
+	_stateCache = std::make_unique<DeviceContextStateCache<ID3D11DeviceContext>>(_deviceContext.Get());
+
 	D2DX_LOG("Created device supports %s.",
 		_featureLevel == D3D_FEATURE_LEVEL_11_1 ? "D3D_FEATURE_LEVEL_11_1" :
 		_featureLevel == D3D_FEATURE_LEVEL_11_0 ? "D3D_FEATURE_LEVEL_11_0" :
@@ -218,6 +226,16 @@ RenderContext::RenderContext(
 		D2DX_LOG("Using 'ResizeBuffers' backbuffer sizing strategy.")
 	}
 
+	/* The render thread presents repeated frames while the game thread may already draw its next frame. */
+	ComPtr<ID3D11Multithread> multithread;
+	if (_d2dxContext->GetOptions().GetFlag(OptionsFlag::RenderThread) &&
+		SUCCEEDED(_deviceContext->QueryInterface(IID_PPV_ARGS(&multithread))))
+	{
+		multithread->SetMultithreadProtected(TRUE);
+		_isMultithreadProtected = true;
+		D2DX_LOG("Device context is multithread protected. Will present repeated frames without blocking the game.");
+	}
+
 	if (SUCCEEDED(_deviceContext->QueryInterface(IID_PPV_ARGS(&_deviceContext1))))
 	{
 		D2DX_LOG("Device context supports ID3D11DeviceContext1. Will use this to discard resources and views.");
@@ -227,6 +245,16 @@ RenderContext::RenderContext(
 		D2DX_LOG("Device context does not support ID3D11DeviceContext1.");
 	}
 
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = { };
+	if (_deviceContext1 &&
+		SUCCEEDED(_device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+		options.ConstantBufferOffsetting &&
+		options.MapNoOverwriteOnDynamicConstantBuffer)
+	{
+		D2DX_LOG("Device supports constant buffer offsetting. Will sub-allocate constants.");
+		_isConstantBufferOffsettingSupported = true;
+	}
+
 	if (_syncStrategy == RenderContextSyncStrategy::FrameLatencyWaitableObject)
 	{
 		assert(_swapChain2);
@@ -268,12 +296,32 @@ RenderContext::RenderContext(
 
 	_vbCapacity = 4 * 1024 * 1024;
 
+	const uint64_t memoryBudget = _d2dxContext->GetOptions().GetMemoryBudget();
+
+	if (memoryBudget > 0)
+	{
+		/* Use at most an eighth of the budget, but leave room for at least two vertex arena chunks. */
+		while (_vbCapacity > 2 * D2DX_VERTEX_ARENA_CHUNK_SIZE && (uint64_t)_vbCapacity * sizeof(Vertex) > memoryBudget / 8)
+		{
+			_vbCapacity /= 2;
+		}
+
+		D2DX_LOG("Limited the vertex buffer to %u kB.", _vbCapacity * (uint32_t)sizeof(Vertex) / 1024);
+	}
+
 	SetSizes(_gameSize, _windowSize);
 
+	/* Without constant buffer offsetting, the ring holds a single set of constants, and every update discards. */
+	const uint32_t cbSizeBytes = _isConstantBufferOffsettingSupported ? CONSTANT_BUFFER_SIZE : CONSTANTS_ALIGNMENT;
+
+	_vertexRing = std::make_unique<GpuRingAllocator>(_vbCapacity, MAX_FRAMES_IN_FLIGHT);
+	_constantRing = std::make_unique<GpuRingAllocator>(cbSizeBytes, MAX_FRAMES_IN_FLIGHT);
+
 	_resources = std::make_unique<RenderContextResources>(
 			_vbCapacity * sizeof(Vertex),
-			16 * sizeof(Constants),
+			cbSizeBytes,
 			renderTargetSize,
+			memoryBudget > 0,
 			_device.Get(),
 			simd);
 
@@ -312,6 +360,11 @@ void RenderContext::Draw(
 	const Batch& batch,
 	uint32_t startVertexLocation)
 {
+	if (!_isFrameBegun)
+	{
+		BeginFrame();
+	}
+
 	SetBlendState(batch.GetAlphaBlend());
 
 	ITextureCache* atlas = GetTextureCache(batch);
@@ -335,7 +388,12 @@ bool RenderContext::IsIntegerScale() const
 
 void RenderContext::Present()
 {
-	_deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	if (!_isFrameBegun)
+	{
+		BeginFrame();
+	}
+
+	_stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	float color[] = { .0f, .0f, .0f, .0f };
 
@@ -354,13 +412,12 @@ void RenderContext::Present()
 		_resources->GetFramebufferSrv(RenderContextFramebuffer::Game),
 		_resources->GetTexture1DSrv(RenderContextTexture1D::GammaTable));
 
-	auto startVertexLocation = _vbWriteIndex;
-	uint32_t vertexCount = UpdateVerticesWithFullScreenTriangle(
+	uint32_t startVertexLocation = UpdateVerticesWithFullScreenTriangle(
 		_gameSize,
 		_resources->GetFramebufferSize(),
 		{ 0,0,_gameSize.width, _gameSize.height });
 
-	_deviceContext->Draw(vertexCount, startVertexLocation);
+	_deviceContext->Draw(3, startVertexLocation);
 
 	if (!_d2dxContext->GetOptions().GetFlag(OptionsFlag::NoAntiAliasing))
 	{
@@ -383,15 +440,58 @@ void RenderContext::Present()
 			_resources->GetFramebufferSrv(RenderContextFramebuffer::GammaCorrected),
 			_resources->GetFramebufferSrv(RenderContextFramebuffer::SurfaceId));
 
-		startVertexLocation = _vbWriteIndex;
-		vertexCount = UpdateVerticesWithFullScreenTriangle(
+		startVertexLocation = UpdateVerticesWithFullScreenTriangle(
 			_gameSize,
 			_resources->GetFramebufferSize(),
 			{ 0,0,_gameSize.width, _gameSize.height });
 
-		_deviceContext->Draw(vertexCount, startVertexLocation);
+		_deviceContext->Draw(3, startVertexLocation);
+	}
+
+	/* The post-processed frame is kept (in the Game or GammaCorrected framebuffer) until the next frame begins.
+	   A repeat was drawn with an extrapolated camera, so it mustn't be presented again in place of the game's
+	   last frame. */
+	_canPresentAgain = !_isPresentingRepeat;
+
+	PresentBackbuffer();
+}
+
+bool RenderContext::PresentAgain()
+{
+	if (!_canPresentAgain || _isFrameBegun)
+	{
+		return false;
 	}
 
+	_stateCache->SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	SetBlendState(AlphaBlend::Opaque);
+
+	PresentBackbuffer();
+	return true;
+}
+
+_Use_decl_annotations_
+void RenderContext::PresentRepeat(
+	std::unique_lock<std::recursive_mutex>& lock)
+{
+	_isPresentingRepeat = true;
+	_repeatLock = &lock;
+	Present();
+}
+
+void RenderContext::PresentBackbuffer()
+{
+	/* Taken over while the render context is still locked, since the lock may be released before presenting. */
+	std::unique_lock<std::recursive_mutex>* repeatLock = _repeatLock;
+	const bool isPresentingRepeat = _isPresentingRepeat;
+	_repeatLock = nullptr;
+	_isPresentingRepeat = false;
+
+	/* Guards the backbuffer and the swap chain, which a repeat uses after releasing the render context. */
+	std::lock_guard<std::mutex> swapChainLock{ _swapChainMutex };
+
+	float color[] = { .0f, .0f, .0f, .0f };
+
 	SetRasterizerState(_resources->GetRasterizerState(false));
 
 	SetRenderTargets(_backbufferRtv.Get(), nullptr);
@@ -423,13 +523,12 @@ void RenderContext::Present()
 		_d2dxContext->GetOptions().GetFlag(OptionsFlag::NoAntiAliasing) ? _resources->GetFramebufferSrv(RenderContextFramebuffer::GammaCorrected) : _resources->GetFramebufferSrv(RenderContextFramebuffer::Game),
 		nullptr);
 
-	startVertexLocation = _vbWriteIndex;
-	vertexCount = UpdateVerticesWithFullScreenTriangle(
+	const uint32_t startVertexLocation = UpdateVerticesWithFullScreenTriangle(
 		_gameSize,
 		_resources->GetFramebufferSize(),
 		_renderRect);
 
-	_deviceContext->Draw(vertexCount, startVertexLocation);
+	_deviceContext->Draw(3, startVertexLocation);
 
 	SetShaderState(
 		nullptr,
@@ -451,6 +550,20 @@ void RenderContext::Present()
 	}
 #endif
 
+	_resources->OnNewFrame();
+
+	_vertexRing->EndFrame();
+	_constantRing->EndFrame();
+
+	_isFrameBegun = false;
+	++_frameCount;
+
+	/* Presenting can block for up to a refresh interval, and doesn't need the render context. */
+	if (repeatLock && _isMultithreadProtected)
+	{
+		repeatLock->unlock();
+	}
+
 	switch (_syncStrategy)
 	{
 	case RenderContextSyncStrategy::AllowTearing:
@@ -468,17 +581,28 @@ void RenderContext::Present()
 		break;
 	}
 
-	double curTime = TimeEndMs(_timeStart);
-	_frameTimeMs = curTime - _prevTime;
-	_prevTime = curTime;
+	/* The motion predictors advance by the frame time, once per game frame. */
+	if (!isPresentingRepeat)
+	{
+		double curTime = TimeEndMs(_timeStart);
+		_frameTimeMs = curTime - _prevTime;
+		_prevTime = curTime;
+	}
 
 	if (_deviceContext1)
 	{
-		_deviceContext1->DiscardView(_resources->GetFramebufferRtv(RenderContextFramebuffer::Game));
 		_deviceContext1->DiscardView(_backbufferRtv.Get());
 	}
+}
 
-	_resources->OnNewFrame();
+void RenderContext::BeginFrame()
+{
+	float color[] = { .0f, .0f, .0f, .0f };
+
+	if (_deviceContext1)
+	{
+		_deviceContext1->DiscardView(_resources->GetFramebufferRtv(RenderContextFramebuffer::Game));
+	}
 
 	SetRenderTargets(
 		_resources->GetFramebufferRtv(RenderContextFramebuffer::Game),
@@ -498,7 +622,7 @@ void RenderContext::Present()
 		nullptr,
 		nullptr);
 
-	++_frameCount;
+	_isFrameBegun = true;
 }
 
 _Use_decl_annotations_
@@ -516,9 +640,17 @@ void RenderContext::WriteToScreen(
 	int32_t width,
 	int32_t height)
 {
+	if (!_isFrameBegun)
+	{
+		BeginFrame();
+	}
+
 	D3D11_MAPPED_SUBRESOURCE ms;
 	D2DX_CHECK_HR(_deviceContext->Map(_resources->GetVideoTexture(), 0, D3D11_MAP_WRITE_DISCARD, 0, &ms));
-	memcpy(ms.pData, pixels, width * height * 4);
+
+	/* The texture is mapped with discard, so all rows must be written, not just the ones that changed. */
+	_simd->CopyUInt32NonTemporal((uint32_t*)ms.pData, ms.RowPitch, pixels, width * sizeof(uint32_t), width, height);
+
 	_deviceContext->Unmap(_resources->GetVideoTexture(), 0);
 
 	SetBlendState(AlphaBlend::Opaque);
@@ -529,12 +661,14 @@ void RenderContext::WriteToScreen(
 		_resources->GetVideoSrv(),
 		nullptr);
 
-	uint32_t startVertexLocation = _vbWriteIndex;
-	uint32_t vertexCount = UpdateVerticesWithFullScreenTriangle(_gameSize, _resources->GetVideoTextureSize(), { 0,0,_gameSize.width, _gameSize.height });
+	const uint32_t startVertexLocation = UpdateVerticesWithFullScreenTriangle(_gameSize, _resources->GetVideoTextureSize(), { 0,0,_gameSize.width, _gameSize.height });
 	UpdateViewport({ 0,0,_gameSize.width, _gameSize.height });
-	_deviceContext->Draw(vertexCount, startVertexLocation);
+	_deviceContext->Draw(3, startVertexLocation);
 
 	Present();
+
+	/* Video frames aren't tracked by the caller, so don't let them be presented again by mistake. */
+	_canPresentAgain = false;
 }
 
 _Use_decl_annotations_
@@ -549,29 +683,23 @@ uint32_t RenderContext::BulkWriteVertices(
 	const Vertex* vertices,
 	uint32_t vertexCount)
 {
-	auto mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
-	if ((_vbWriteIndex + vertexCount) > _vbCapacity)
-	{
-		mapType = D3D11_MAP_WRITE_DISCARD;
-		_vbWriteIndex = 0;
-		assert(vertexCount <= _vbCapacity);
-		vertexCount = min(vertexCount, _vbCapacity);
-	}
+	assert(vertexCount <= _vbCapacity);
+	vertexCount = min(vertexCount, _vbCapacity);
 
-	const uint32_t startVertexLocation = _vbWriteIndex;
-
-	if (vertexCount > 0)
+	if (vertexCount == 0)
 	{
-		D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 };
-		D2DX_CHECK_HR(_deviceContext->Map(_resources->GetVertexBuffer(), 0, mapType, 0, &mappedSubResource));
-		Vertex* pMappedVertices = (Vertex*)mappedSubResource.pData + _vbWriteIndex;
-		memcpy(pMappedVertices, vertices, sizeof(Vertex) * vertexCount);
-		_deviceContext->Unmap(_resources->GetVertexBuffer(), 0);
+		return 0;
 	}
 
-	_vbWriteIndex += vertexCount;
+	const GpuRingAllocation allocation = _vertexRing->Allocate(vertexCount);
+
+	D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 };
+	D2DX_CHECK_HR(_deviceContext->Map(_resources->GetVertexBuffer(), 0, allocation.discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedSubResource));
+	Vertex* pMappedVertices = (Vertex*)mappedSubResource.pData + allocation.offset;
+	memcpy(pMappedVertices, vertices, sizeof(Vertex) * vertexCount);
+	_deviceContext->Unmap(_resources->GetVertexBuffer(), 0);
 
-	return startVertexLocation;
+	return allocation.offset;
 }
 
 _Use_decl_annotations_
@@ -586,23 +714,7 @@ uint32_t RenderContext::UpdateVerticesWithFullScreenTriangle(
 		Vertex{ 0, dstRect.size.height * 2, srcTextureSize.width, srcTextureSize.height, 0xFFFFFFFF, false, srcSize.height, 0, srcSize.width },
 	};
 
-	auto mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
-
-	if ((_vbWriteIndex + ARRAYSIZE(vertices)) > _vbCapacity)
-	{
-		mapType = D3D11_MAP_WRITE_DISCARD;
-		_vbWriteIndex = 0;
-	}
-
-	D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 };
-	D2DX_CHECK_HR(_deviceContext->Map(_resources->GetVertexBuffer(), 0, mapType, 0, &mappedSubResource));
-	Vertex* pMappedVertices = (Vertex*)mappedSubResource.pData + _vbWriteIndex;
-	memcpy(pMappedVertices, vertices, sizeof(Vertex) * ARRAYSIZE(vertices));
-	_deviceContext->Unmap(_resources->GetVertexBuffer(), 0);
-
-	_vbWriteIndex += ARRAYSIZE(vertices);
-
-	return ARRAYSIZE(vertices);
+	return BulkWriteVertices(vertices, ARRAYSIZE(vertices));
 }
 
 _Use_decl_annotations_
@@ -622,9 +734,14 @@ TextureCacheLocation RenderContext::UpdateTexture(
 
 	auto tcl = atlas->FindTexture(contentKey, -1);
 
+	++_textureCacheStats.finds;
+
 	if (tcl._textureAtlas < 0)
 	{
 		tcl = atlas->InsertTexture(contentKey, batch, tmuData, tmuDataSize);
+
+		++_textureCacheStats.misses;
+		_textureCacheStats.uploadBytes += (uint64_t)batch.GetTextureWidth() * batch.GetTextureHeight();
 	}
 
 	return tcl;
@@ -635,10 +752,10 @@ void RenderContext::UpdateViewport(
 	Rect rect)
 {
 	CD3D11_VIEWPORT viewport{ (float)rect.offset.x, (float)rect.offset.y, (float)rect.size.width, (float)rect.size.height };
-	_deviceContext->RSSetViewports(1, &viewport);
+	_stateCache->SetViewport(viewport);
 
 	CD3D11_RECT scissorRect{ rect.offset.x, rect.offset.y, rect.size.width, rect.size.height };
-	_deviceContext->RSSetScissorRects(1, &scissorRect);
+	_stateCache->SetScissorRect(scissorRect);
 
 	_constants.screenSize[0] = (float)rect.size.width;
 	_constants.screenSize[1] = (float)rect.size.height;
@@ -646,13 +763,25 @@ void RenderContext::UpdateViewport(
 	_constants.invScreenSize[1] = 1.0f / _constants.screenSize[1];
 	_constants.flags[0] = _d2dxContext->GetOptions().GetFlag(OptionsFlag::NoAntiAliasing) ? 0 : 1;
 	_constants.flags[1] = 0;
-	if (memcmp(&_constants, &_shadowState.constants, sizeof(Constants)) != 0)
+	if (memcmp(&_constants, &_shadowConstants, sizeof(Constants)) != 0)
 	{
+		const GpuRingAllocation allocation = _constantRing->Allocate(CONSTANTS_ALIGNMENT, CONSTANTS_ALIGNMENT);
+		const bool discard = allocation.discard || !_isConstantBufferOffsettingSupported;
+
 		D3D11_MAPPED_SUBRESOURCE mappedSubResource = { 0 };
-		D2DX_CHECK_HR(_deviceContext->Map(_resources->GetConstantBuffer(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedSubResource));
-		memcpy(mappedSubResource.pData, &_constants, sizeof(Constants));
+		D2DX_CHECK_HR(_deviceContext->Map(_resources->GetConstantBuffer(), 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mappedSubResource));
+		memcpy((uint8_t*)mappedSubResource.pData + allocation.offset, &_constants, sizeof(Constants));
 		_deviceContext->Unmap(_resources->GetConstantBuffer(), 0);
-		_shadowState.constants = _constants;
+		_shadowConstants = _constants;
+
+		if (_isConstantBufferOffsettingSupported)
+		{
+			ID3D11Buffer* cb = _resources->GetConstantBuffer();
+			const UINT firstConstant = allocation.offset / 16;
+			const UINT numConstants = CONSTANTS_ALIGNMENT / 16;
+			_deviceContext1->VSSetConstantBuffers1(0, 1, &cb, &firstConstant, &numConstants);
+			_deviceContext1->PSSetConstantBuffers1(0, 1, &cb, &firstConstant, &numConstants);
+		}
 	}
 }
 
@@ -703,6 +832,16 @@ static LRESULT CALLBACK d2dxSubclassWndProc(
 			renderContext->ToggleFullscreen();
 			return 0;
 		}
+		else if (wParam == 'M' && (HIWORD(lParam) & KF_ALTDOWN) &&
+			renderContext->GetOptions().GetFlag(OptionsFlag::DbgMetrics))
+		{
+			auto d2dxContext = D2DXContextFactory::GetInstance(false);
+			if (d2dxContext)
+			{
+				d2dxContext->ExportMetrics();
+			}
+			return 0;
+		}
 	}
 	else if (uMsg == WM_DESTROY)
 	{
@@ -735,6 +874,15 @@ static LRESULT CALLBACK d2dxSubclassWndProc(
 
 		lParam = mousePos.x;
 		lParam |= mousePos.y << 16;
+
+		if (uMsg == WM_MOUSEMOVE)
+		{
+			auto d2dxContext = D2DXContextFactory::GetInstance(false);
+			if (d2dxContext)
+			{
+				d2dxContext->OnGameMouseMove(mousePos);
+			}
+		}
 	}
 
 	return DefSubclassProc(hWnd, uMsg, wParam, lParam);
@@ -745,38 +893,21 @@ void RenderContext::SetRenderTargets(
 	ID3D11RenderTargetView* rtv0,
 	ID3D11RenderTargetView* rtv1)
 {
-	if (rtv0 != _shadowState.rtv0 ||
-		rtv1 != _shadowState.rtv1)
-	{
-		ID3D11RenderTargetView* rtvs[2] = { rtv0, rtv1 };
-		_deviceContext->OMSetRenderTargets(2, rtvs, nullptr);
-		_shadowState.rtv0 = rtv0;
-		_shadowState.rtv1 = rtv1;
-	}
+	_stateCache->SetRenderTargets(rtv0, rtv1);
 }
 
 _Use_decl_annotations_
 void RenderContext::SetRasterizerState(
 	ID3D11RasterizerState* rs)
 {
-	if (rs != _shadowState.rs)
-	{
-		_deviceContext->RSSetState(rs);
-		_shadowState.rs = rs;
-	}
+	_stateCache->SetRasterizerState(rs);
 }
 
 _Use_decl_annotations_
 void RenderContext::SetBlendState(
 	ID3D11BlendState* blendState)
 {
-	if (blendState != _shadowState.bs)
-	{
-		float blendFactor[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
-		UINT sampleMask = 0xffffffff;
-		_deviceContext->OMSetBlendState(blendState, blendFactor, sampleMask);
-		_shadowState.bs = blendState;
-	}
+	_stateCache->SetBlendState(blendState);
 }
 
 _Use_decl_annotations_
@@ -786,26 +917,9 @@ void RenderContext::SetShaderState(
 	ID3D11ShaderResourceView* srv0,
 	ID3D11ShaderResourceView* srv1)
 {
-	if (vs != _shadowState.vs)
-	{
-		_deviceContext->VSSetShader(vs, NULL, 0);
-		_shadowState.vs = vs;
-	}
-
-	if (ps != _shadowState.ps)
-	{
-		_deviceContext->PSSetShader(ps, NULL, 0);
-		_shadowState.ps = ps;
-	}
-
-	if (srv0 != _shadowState.psSrv0 ||
-		srv1 != _shadowState.psSrv1)
-	{
-		ID3D11ShaderResourceView* srvs[2] = { srv0, srv1 };
-		_deviceContext->PSSetShaderResources(0, 2, srvs);
-		_shadowState.psSrv0 = srv0;
-		_shadowState.psSrv1 = srv1;
-	}
+	_stateCache->SetVertexShader(vs);
+	_stateCache->SetPixelShader(ps);
+	_stateCache->SetPixelShaderResources(srv0, srv1);
 }
 
 _Use_decl_annotations_
@@ -815,8 +929,22 @@ ITextureCache* RenderContext::GetTextureCache(
 	return _resources->GetTextureCache(batch.GetTextureWidth(), batch.GetTextureHeight());
 }
 
+_Use_decl_annotations_
+ITextureCache* RenderContext::GetTextureCacheByIndex(
+	uint32_t index) const
+{
+	return _resources->GetTextureCacheByIndex(index);
+}
+
+uint32_t RenderContext::GetVertexBufferSize() const
+{
+	return _vbCapacity * sizeof(Vertex);
+}
+
 void RenderContext::ResizeBackbuffer()
 {
+	std::lock_guard<std::mutex> swapChainLock{ _swapChainMutex };
+
 	if (_backbufferSizingStrategy == RenderContextBackbufferSizingStrategy::SetSourceSize)
 	{
 		D2DX_CHECK_HR(_swapChain2->SetSourceSize(
@@ -841,6 +969,9 @@ void RenderContext::SetSizes(
 	Size gameSize,
 	Size windowSize)
 {
+	/* May be called from the window procedure, e.g. when toggling fullscreen. */
+	std::lock_guard<std::recursive_mutex> lock{ _mutex };
+
 	_gameSize = gameSize;
 	_windowSize = windowSize;
 
@@ -948,6 +1079,7 @@ void RenderContext::SetSizes(
 		ResizeBackbuffer();
 		UpdateViewport({ 0,0,_gameSize.width, _gameSize.height });
 		Present();
+		_canPresentAgain = false;
 	}
 }
 
@@ -1053,3 +1185,20 @@ ScreenMode RenderContext::GetScreenMode() const
 {
 	return _screenMode;
 }
+
+TextureCacheStats RenderContext::GetTextureCacheStats() const
+{
+	TextureCacheStats stats = _textureCacheStats;
+	stats.committedBytes = _resources->GetTextureCacheCommittedBytes();
+	return stats;
+}
+
+StateChangeStats RenderContext::GetStateChangeStats() const
+{
+	return { _stateCache->GetIssuedCount(), _stateCache->GetFilteredCount() };
+}
+
+std::recursive_mutex& RenderContext::GetMutex()
+{
+	return _mutex;
+}
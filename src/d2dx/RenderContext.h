@@ -18,6 +18,8 @@
 */
 #pragma once
 
+#include "DeviceContextStateCache.h"
+#include "GpuRingAllocator.h"
 #include "IRenderContext.h"
 #include "ISimd.h"
 #include "ITextureCache.h"
@@ -83,6 +85,11 @@ namespace d2dx
 
 		virtual void Present() override;
 
+		virtual bool PresentAgain() override;
+
+		virtual void PresentRepeat(
+			_Inout_ std::unique_lock<std::recursive_mutex>& lock) override;
+
 		virtual void WriteToScreen(
 			_In_reads_(width* height) const uint32_t* pixels,
 			_In_ int32_t width,
@@ -97,6 +104,11 @@ namespace d2dx
 		virtual ITextureCache* GetTextureCache(
 			_In_ const Batch& batch) const override;
 
+		virtual ITextureCache* GetTextureCacheByIndex(
+			_In_ uint32_t index) const override;
+
+		virtual uint32_t GetVertexBufferSize() const override;
+
 		virtual void SetSizes(
 			_In_ Size gameSize,
 			_In_ Size windowSize) override;
@@ -113,6 +125,12 @@ namespace d2dx
 
 		virtual ScreenMode GetScreenMode() const override;
 
+		virtual TextureCacheStats GetTextureCacheStats() const override;
+
+		virtual StateChangeStats GetStateChangeStats() const override;
+
+		virtual std::recursive_mutex& GetMutex() override;
+
 		void ClipCursor();
 		void UnclipCursor();
 
@@ -135,6 +153,7 @@ namespace d2dx
 		void AdjustWindowPlacement(
 			_In_ HWND hWnd);
 
+		/* Returns the start vertex location of the three vertices. */
 		uint32_t UpdateVerticesWithFullScreenTriangle(
 			_In_ Size srcSize,
 			_In_ Size srcTextureSize,
@@ -155,6 +174,10 @@ namespace d2dx
 		void SetBlendState(
 			_In_ ID3D11BlendState* blendState);
 
+		void BeginFrame();
+
+		void PresentBackbuffer();
+
 		struct Constants final
 		{
 			float screenSize[2] = { 0.0f, 0.0f };
@@ -164,19 +187,6 @@ namespace d2dx
 
 		static_assert(sizeof(Constants) == 8 * 4, "size of Constants");
 
-		struct DeviceContextState final
-		{
-			Constants constants;
-			ID3D11RasterizerState* rs = nullptr;
-			ID3D11VertexShader* vs = nullptr;
-			ID3D11PixelShader* ps = nullptr;
-			ID3D11BlendState* bs = nullptr;
-			ID3D11ShaderResourceView* psSrv0 = nullptr;
-			ID3D11ShaderResourceView* psSrv1 = nullptr;
-			ID3D11RenderTargetView* rtv0 = nullptr;
-			ID3D11RenderTargetView* rtv1 = nullptr;
-		};
-
 		ScreenMode _screenMode = ScreenMode::Windowed;
 		ComPtr<ID3D11Device> _device;
 		ComPtr<ID3D11Device3> _device3;
@@ -194,8 +204,10 @@ namespace d2dx
 		Size _windowSize = { 0,0 };
 		Size _desktopSize = { 0,0 };
 		int32_t _desktopClientMaxHeight = 0;
-		uint32_t _vbWriteIndex = 0;
 		uint32_t _vbCapacity = 0;
+		std::unique_ptr<GpuRingAllocator> _vertexRing;
+		std::unique_ptr<GpuRingAllocator> _constantRing;
+		bool _isConstantBufferOffsettingSupported = false;
 		Constants _constants;
 		RenderContextSyncStrategy _syncStrategy = RenderContextSyncStrategy::AllowTearing;
 		RenderContextSwapStrategy _swapStrategy = RenderContextSwapStrategy::FlipDiscard;
@@ -206,12 +218,22 @@ namespace d2dx
 		D3D_FEATURE_LEVEL _featureLevel = D3D_FEATURE_LEVEL_11_0;
 		HWND _hWnd = nullptr;
 		ID2DXContext* _d2dxContext = nullptr;
-		DeviceContextState _shadowState;
+		std::unique_ptr<DeviceContextStateCache<ID3D11DeviceContext>> _stateCache;
+		Constants _shadowConstants;
 		EventHandle _frameLatencyWaitableObject;
 		int64_t _timeStart;
 		bool _hasAdjustedWindowPlacement = false;
+		bool _isFrameBegun = false;
+		bool _canPresentAgain = false;
+		bool _isPresentingRepeat = false;
+		std::unique_lock<std::recursive_mutex>* _repeatLock = nullptr;
+		bool _isMultithreadProtected = false;
+		std::recursive_mutex _mutex;
+		std::mutex _swapChainMutex;
 
 		double _prevTime;
 		double _frameTimeMs;
+
+		TextureCacheStats _textureCacheStats;
 	};
 }
\ No newline at end of file
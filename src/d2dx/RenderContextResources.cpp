@@ -21,6 +21,7 @@
 #include "Utils.h"
 #include "Types.h"
 #include "TextureCache.h"
+#include "TextureCacheDevice.h"
 #include "DisplayVS_cso.h"
 #include "DisplayNonintegerScalePS_cso.h"
 #include "DisplayIntegerScalePS_cso.h"
@@ -40,11 +41,12 @@ RenderContextResources::RenderContextResources(
 	uint32_t vbSizeBytes,
 	uint32_t cbSizeBytes,
 	Size framebufferSize,
+	bool useSmallTextureAtlases,
 	ID3D11Device* device,
 	const std::shared_ptr<ISimd>& simd)
 {
 	CreateTexture1Ds(device);
-	CreateTextureCaches(device, simd);
+	CreateTextureCaches(useSmallTextureAtlases, device, simd);
 	CreateVideoTextures(device);
 	CreateShadersAndInputLayout(device);
 	CreateRasterizerState(device);
@@ -179,12 +181,15 @@ void RenderContextResources::CreateTexture1Ds(
 
 _Use_decl_annotations_
 void RenderContextResources::CreateTextureCaches(
+	bool useSmallAtlases,
 	ID3D11Device* device,
 	const std::shared_ptr<ISimd>& simd)
 {
-	static const uint32_t capacities[7] = { 512, 1024, 2048, 2048, 1024, 512, 1024 };
+	static const uint32_t capacities[D2DX_TEXTURE_CACHE_COUNT] = { 512, 1024, 2048, 2048, 1024, 512, 1024 };
 
-	const uint32_t texturesPerAtlas = DetermineMaxTextureArraySize(device);
+	auto textureCacheDevice = std::make_shared<TextureCacheDevice>(device);
+
+	const uint32_t texturesPerAtlas = textureCacheDevice->GetMaxTextureArraySize();
 	D2DX_LOG("The device supports %u textures per atlas.", texturesPerAtlas);
 
 	uint32_t totalSize = 0;
@@ -199,42 +204,29 @@ void RenderContextResources::CreateTextureCaches(
 			height = 128;
 		}
 
-		_textureCaches[i] = std::make_unique<TextureCache>(width, height, capacities[i], texturesPerAtlas, device, simd);
+		/* Smaller atlases let a memory budget limit each cache more finely, at the cost of more draw calls. */
+		const uint32_t atlasSize = useSmallAtlases ? min(texturesPerAtlas, capacities[i] / 4) : texturesPerAtlas;
+
+		_textureCaches[i] = std::make_unique<TextureCache>(width, height, capacities[i], atlasSize, textureCacheDevice, simd);
 
-		D2DX_DEBUG_LOG("Creating texture cache for %i x %i with capacity %u (%u kB).", width, height, capacities[i], _textureCaches[i]->GetMemoryFootprint() / 1024);
+		D2DX_DEBUG_LOG("Creating texture cache for %i x %i with capacity %u (up to %u kB).", width, height, capacities[i], _textureCaches[i]->GetMemoryFootprint() / 1024);
 
 		totalSize += _textureCaches[i]->GetMemoryFootprint();
 	}
 
-	D2DX_LOG("Total size of texture caches is %u kB.", totalSize / 1024);
+	D2DX_LOG("Reserved %u kB for texture caches, to be committed on first use.", totalSize / 1024);
 }
 
-_Use_decl_annotations_
-uint32_t RenderContextResources::DetermineMaxTextureArraySize(
-	ID3D11Device* device)
+uint32_t RenderContextResources::GetTextureCacheCommittedBytes() const
 {
-	for (uint32_t arraySize = 2048; arraySize > 512; arraySize /= 2)
+	uint32_t committedBytes = 0;
+
+	for (int32_t i = 0; i < ARRAYSIZE(_textureCaches); ++i)
 	{
-		CD3D11_TEXTURE2D_DESC desc{
-			DXGI_FORMAT_R8G8B8A8_UNORM,
-			16U,
-			16U,
-			arraySize,
-			1U,
-			D3D11_BIND_SHADER_RESOURCE,
-			D3D11_USAGE_DEFAULT
-		};
-
-		ComPtr<ID3D11Texture2D> tempTexture;
-		HRESULT hr = device->CreateTexture2D(&desc, nullptr, &tempTexture);
-
-		if (SUCCEEDED(hr))
-		{
-			return arraySize;
-		}
+		committedBytes += _textureCaches[i]->GetCommittedMemoryFootprint();
 	}
 
-	return 512;
+	return committedBytes;
 }
 
 _Use_decl_annotations_
@@ -72,6 +72,7 @@ namespace d2dx
 			_In_ uint32_t vbSizeBytes,
 			_In_ uint32_t cbSizeBytes,
 			_In_ Size framebufferSize,
+			_In_ bool useSmallTextureAtlases,
 			_In_ ID3D11Device* device,
 			_In_ const std::shared_ptr<ISimd>& simd);
 		
@@ -95,6 +96,15 @@ namespace d2dx
 			int32_t textureWidth, 
 			int32_t textureHeight) const;
 
+		ITextureCache* GetTextureCacheByIndex(
+			_In_ uint32_t index) const
+		{
+			assert(index < D2DX_TEXTURE_CACHE_COUNT);
+			return _textureCaches[index].get();
+		}
+
+		uint32_t GetTextureCacheCommittedBytes() const;
+
 		ID3D11Texture1D* GetTexture1D(RenderContextTexture1D texture1d) const
 		{ 
 			return _texture1Ds[(int32_t)texture1d].texture.Get();
@@ -175,10 +185,8 @@ namespace d2dx
 		void CreateTexture1Ds(
 			_In_ ID3D11Device* device);
 
-		uint32_t DetermineMaxTextureArraySize(
-			_In_ ID3D11Device* device);
-
 		void CreateTextureCaches(
+			_In_ bool useSmallAtlases,
 			_In_ ID3D11Device* device,
 			_In_ const std::shared_ptr<ISimd>& simd);
 	
@@ -220,7 +228,7 @@ namespace d2dx
 		ComPtr<ID3D11Texture2D> _videoTexture;
 		ComPtr<ID3D11ShaderResourceView> _videoTextureSrv;
 
-		std::unique_ptr<ITextureCache> _textureCaches[7];
+		std::unique_ptr<ITextureCache> _textureCaches[D2DX_TEXTURE_CACHE_COUNT];
 
 		ComPtr<ID3D11RasterizerState> _rasterizerStateNoScissor;
 		ComPtr<ID3D11RasterizerState> _rasterizerState;
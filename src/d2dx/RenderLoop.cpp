@@ -0,0 +1,166 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "RenderLoop.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+RenderLoop::RenderLoop(
+	const std::shared_ptr<IClock>& clock,
+	int64_t presentIntervalUs,
+	int64_t maxExtrapolationUs,
+	uint32_t maxVertexCount) :
+	_clock{ clock },
+	_presentIntervalUs{ presentIntervalUs },
+	_maxExtrapolationUs{ maxExtrapolationUs },
+	_maxVertexCount{ maxVertexCount }
+{
+	assert(presentIntervalUs > 0);
+}
+
+_Use_decl_annotations_
+void RenderLoop::SubmitFrame(
+	const FrameArena<Batch>& batches,
+	const FrameArena<Vertex>& vertices,
+	OffsetF cameraVelocity)
+{
+	const int64_t timeUs = _clock->GetTimeUs();
+
+	std::lock_guard<std::mutex> lock{ _mutex };
+
+	RenderLoopFrame& frame = _frames[_pendingIndex];
+	frame.batchCount = 0;
+	frame.vertexCount = 0;
+	frame.cameraVelocity = cameraVelocity;
+	frame.timeUs = timeUs;
+
+	_hasPendingFrame = true;
+	_hasRepeatedSincePresent = false;
+	_lastPresentTimeUs = timeUs;
+
+	if (vertices.GetCount() > _maxVertexCount)
+	{
+		return;
+	}
+
+	if (frame.batches.capacity < batches.GetCount())
+	{
+		frame.batches = Buffer<Batch>{ batches.GetCapacity() };
+	}
+
+	if (frame.vertices.capacity < vertices.GetCount())
+	{
+		frame.vertices = Buffer<Vertex>{ vertices.GetCapacity() };
+	}
+
+	/* The vertices of a batch are contiguous, but there may be gaps at the ends of the arena's chunks. */
+	for (uint32_t i = 0; i < batches.GetCount(); ++i)
+	{
+		Batch batch = batches[i];
+
+		if (!batch.IsValid() || batch.GetVertexCount() == 0)
+		{
+			continue;
+		}
+
+		memcpy(&frame.vertices.items[frame.vertexCount], &vertices[batch.GetStartVertex()], sizeof(Vertex) * batch.GetVertexCount());
+		batch.SetStartVertex(frame.vertexCount);
+		frame.vertexCount += batch.GetVertexCount();
+		frame.batches.items[frame.batchCount++] = batch;
+	}
+}
+
+void RenderLoop::DropFrame()
+{
+	std::lock_guard<std::mutex> lock{ _mutex };
+
+	_frames[_pendingIndex].batchCount = 0;
+	_frames[_pendingIndex].vertexCount = 0;
+	_hasPendingFrame = true;
+}
+
+void RenderLoop::OnPresented()
+{
+	const int64_t timeUs = _clock->GetTimeUs();
+
+	std::lock_guard<std::mutex> lock{ _mutex };
+	_lastPresentTimeUs = timeUs;
+	_hasRepeatedSincePresent = false;
+}
+
+bool RenderLoop::HasRepeatedSincePresent() const
+{
+	std::lock_guard<std::mutex> lock{ _mutex };
+	return _hasRepeatedSincePresent;
+}
+
+int64_t RenderLoop::GetTimeUntilRepeatUs() const
+{
+	const int64_t timeUs = _clock->GetTimeUs();
+
+	std::lock_guard<std::mutex> lock{ _mutex };
+	return max((int64_t)0, _lastPresentTimeUs + _presentIntervalUs - timeUs);
+}
+
+_Use_decl_annotations_
+const RenderLoopFrame* RenderLoop::BeginRepeat(
+	Offset* worldOffset)
+{
+	const int64_t timeUs = _clock->GetTimeUs();
+
+	*worldOffset = { 0, 0 };
+
+	std::lock_guard<std::mutex> lock{ _mutex };
+
+	if (_hasPendingFrame)
+	{
+		/* Hand the submitted frame over to the render thread, and let the game thread reuse the other. */
+		_pendingIndex ^= 1;
+		_hasPendingFrame = false;
+		_hasCurrentFrame = true;
+	}
+
+	const RenderLoopFrame& frame = _frames[_pendingIndex ^ 1];
+
+	if (!_hasCurrentFrame ||
+		frame.batchCount == 0 ||
+		timeUs - _lastPresentTimeUs < _presentIntervalUs)
+	{
+		return nullptr;
+	}
+
+	const float dt = (float)min(timeUs - frame.timeUs, _maxExtrapolationUs) / 1000000.0f;
+
+	/* The world moves opposite to the camera. */
+	*worldOffset = {
+		-(int32_t)floorf(frame.cameraVelocity.x * dt + 0.5f),
+		-(int32_t)floorf(frame.cameraVelocity.y * dt + 0.5f) };
+
+	_lastPresentTimeUs = timeUs;
+	_hasRepeatedSincePresent = true;
+	++_repeatCount;
+	return &frame;
+}
+
+uint64_t RenderLoop::GetRepeatCount() const
+{
+	std::lock_guard<std::mutex> lock{ _mutex };
+	return _repeatCount;
+}
@@ -0,0 +1,107 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Batch.h"
+#include "Buffer.h"
+#include "FrameArena.h"
+#include "IClock.h"
+#include "Vertex.h"
+
+namespace d2dx
+{
+	/* A complete frame as the game delivered it, with the vertices of each batch stored contiguously. */
+	struct RenderLoopFrame final
+	{
+		Buffer<Batch> batches;
+		Buffer<Vertex> vertices;
+		uint32_t batchCount = 0;
+		uint32_t vertexCount = 0;
+		OffsetF cameraVelocity{ 0.0f, 0.0f };
+		int64_t timeUs = 0;
+	};
+
+	/*
+		Pacing and handoff for a render thread that presents the game's last frame again while the game is
+		late with the next one, e.g. when loading or in heavy scenes.
+
+		The game thread submits each frame it presents, along with the camera velocity (in pixels per second).
+		The render thread asks for a frame to present whenever one is due: when neither the game nor the render
+		thread has presented for a display refresh interval. The camera motion is extrapolated from the time
+		the game presented the frame, for at most maxExtrapolationUs, and returned as an offset for the
+		frame's world-space vertices.
+
+		Frames are double buffered, so the game thread can submit while the render thread draws.
+	*/
+	class RenderLoop final
+	{
+	public:
+		RenderLoop(
+			_In_ const std::shared_ptr<IClock>& clock,
+			_In_ int64_t presentIntervalUs,
+			_In_ int64_t maxExtrapolationUs,
+			_In_ uint32_t maxVertexCount);
+
+		RenderLoop(const RenderLoop&) = delete;
+		RenderLoop& operator=(const RenderLoop&) = delete;
+
+		/* Game thread: a frame has been presented. Frames with more than maxVertexCount vertices are
+		   not repeated. */
+		void SubmitFrame(
+			_In_ const FrameArena<Batch>& batches,
+			_In_ const FrameArena<Vertex>& vertices,
+			_In_ OffsetF cameraVelocity);
+
+		/* Game thread: the last submitted frame must no longer be repeated, e.g. because it uses textures
+		   that are gone. */
+		void DropFrame();
+
+		/* Game thread: something other than a submitted frame has been presented (the last frame again,
+		   or a video frame). */
+		void OnPresented();
+
+		/* Game thread: returns true if the render thread has presented a repeat since the game last presented.
+		   The screen then no longer shows the game's last frame, so an unchanged frame must be drawn again. */
+		bool HasRepeatedSincePresent() const;
+
+		/* Render thread: the time until the next repeat may be due. */
+		int64_t GetTimeUntilRepeatUs() const;
+
+		/* Render thread: returns the frame to present again, or nullptr if none is due. The frame stays
+		   valid until the next call. */
+		const RenderLoopFrame* BeginRepeat(
+			_Out_ Offset* worldOffset);
+
+		uint64_t GetRepeatCount() const;
+
+	private:
+		std::shared_ptr<IClock> _clock;
+		mutable std::mutex _mutex;
+		RenderLoopFrame _frames[2];
+		uint32_t _pendingIndex = 0;
+		bool _hasPendingFrame = false;
+		bool _hasCurrentFrame = false;
+		bool _hasRepeatedSincePresent = false;
+		int64_t _presentIntervalUs = 0;
+		int64_t _maxExtrapolationUs = 0;
+		uint32_t _maxVertexCount = 0;
+		int64_t _lastPresentTimeUs = 0;
+		uint64_t _repeatCount = 0;
+	};
+}
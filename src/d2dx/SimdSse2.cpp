@@ -117,3 +117,80 @@ int32_t SimdSse2::IndexOfUInt32(
 
 	return -1;
 }
+
+_Use_decl_annotations_
+bool SimdSse2::AreEqualUInt32(
+	const uint32_t* __restrict itemsA,
+	const uint32_t* __restrict itemsB,
+	uint32_t itemsCount)
+{
+	uint32_t i = 0;
+
+	for (; (i + 16) <= itemsCount; i += 16)
+	{
+		const __m128i cmp0 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&itemsA[i + 0]), _mm_loadu_si128((const __m128i*)&itemsB[i + 0]));
+		const __m128i cmp1 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&itemsA[i + 4]), _mm_loadu_si128((const __m128i*)&itemsB[i + 4]));
+		const __m128i cmp2 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&itemsA[i + 8]), _mm_loadu_si128((const __m128i*)&itemsB[i + 8]));
+		const __m128i cmp3 = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)&itemsA[i + 12]), _mm_loadu_si128((const __m128i*)&itemsB[i + 12]));
+
+		const __m128i cmp = _mm_and_si128(_mm_and_si128(cmp0, cmp1), _mm_and_si128(cmp2, cmp3));
+
+		if (_mm_movemask_epi8(cmp) != 0xFFFF)
+		{
+			return false;
+		}
+	}
+
+	for (; i < itemsCount; ++i)
+	{
+		if (itemsA[i] != itemsB[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+_Use_decl_annotations_
+void SimdSse2::CopyUInt32NonTemporal(
+	uint32_t* __restrict dst,
+	uint32_t dstPitchInBytes,
+	const uint32_t* __restrict src,
+	uint32_t srcPitchInBytes,
+	uint32_t width,
+	uint32_t height)
+{
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		uint32_t* __restrict dstRow = (uint32_t*)((uint8_t*)dst + y * dstPitchInBytes);
+		const uint32_t* __restrict srcRow = (const uint32_t*)((const uint8_t*)src + y * srcPitchInBytes);
+		uint32_t i = 0;
+
+		/* Streaming stores need an aligned destination. */
+		for (; i < width && ((uintptr_t)&dstRow[i] & 15); ++i)
+		{
+			dstRow[i] = srcRow[i];
+		}
+
+		for (; (i + 16) <= width; i += 16)
+		{
+			const __m128i v0 = _mm_loadu_si128((const __m128i*)&srcRow[i + 0]);
+			const __m128i v1 = _mm_loadu_si128((const __m128i*)&srcRow[i + 4]);
+			const __m128i v2 = _mm_loadu_si128((const __m128i*)&srcRow[i + 8]);
+			const __m128i v3 = _mm_loadu_si128((const __m128i*)&srcRow[i + 12]);
+
+			_mm_stream_si128((__m128i*)&dstRow[i + 0], v0);
+			_mm_stream_si128((__m128i*)&dstRow[i + 4], v1);
+			_mm_stream_si128((__m128i*)&dstRow[i + 8], v2);
+			_mm_stream_si128((__m128i*)&dstRow[i + 12], v3);
+		}
+
+		for (; i < width; ++i)
+		{
+			dstRow[i] = srcRow[i];
+		}
+	}
+
+	_mm_sfence();
+}
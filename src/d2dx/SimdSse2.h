@@ -31,5 +31,18 @@ namespace d2dx
 			_In_reads_(itemsCount) const uint32_t* __restrict items,
 			_In_ uint32_t itemsCount,
 			_In_ uint32_t item) override;
+
+		virtual bool AreEqualUInt32(
+			_In_reads_(itemsCount) const uint32_t* __restrict itemsA,
+			_In_reads_(itemsCount) const uint32_t* __restrict itemsB,
+			_In_ uint32_t itemsCount) override;
+
+		virtual void CopyUInt32NonTemporal(
+			_Out_writes_bytes_(dstPitchInBytes * height) uint32_t* __restrict dst,
+			_In_ uint32_t dstPitchInBytes,
+			_In_reads_bytes_(srcPitchInBytes * height) const uint32_t* __restrict src,
+			_In_ uint32_t srcPitchInBytes,
+			_In_ uint32_t width,
+			_In_ uint32_t height) override;
 	};
 }
@@ -0,0 +1,119 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "SleepPolicy.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+SleepPolicy::SleepPolicy(
+	const std::shared_ptr<IClock>& clock) :
+	_clock{ clock }
+{
+}
+
+_Use_decl_annotations_
+int32_t SleepPolicy::OnSleep(
+	MajorGameState majorGameState,
+	int32_t requestedMs,
+	int64_t frameBudgetUs,
+	int64_t deadlineUs)
+{
+	int32_t grantedMs = requestedMs;
+
+	/* Zero sleeps are yields, and don't delay the frame. */
+	if (requestedMs > 0 &&
+		(majorGameState == MajorGameState::Menus ||
+		 majorGameState == MajorGameState::TitleScreen ||
+		 majorGameState == MajorGameState::InGame))
+	{
+		const int64_t timeUs = _clock->GetTimeUs();
+		bool hasLimit = false;
+		int64_t availableUs = 0;
+
+		if (deadlineUs >= 0)
+		{
+			hasLimit = true;
+			availableUs = deadlineUs - timeUs;
+		}
+		else if (frameBudgetUs > 0 && _lastPresentUs >= 0)
+		{
+			hasLimit = true;
+			availableUs = _lastPresentUs + frameBudgetUs - timeUs;
+		}
+
+		if (hasLimit && availableUs < (int64_t)requestedMs * 1000)
+		{
+			/* Round down, so that the sleep ends in time. */
+			grantedMs = (int32_t)(max((int64_t)0, availableUs) / 1000);
+
+			if (grantedMs == 0 && majorGameState == MajorGameState::InGame)
+			{
+				grantedMs = -1;
+			}
+		}
+	}
+
+	const uint32_t stateIndex = min((uint32_t)majorGameState, MajorGameStateCount - 1);
+	_requested[stateIndex].Record((int64_t)max(0, requestedMs) * 1000);
+	_granted[stateIndex].Record((int64_t)max(0, grantedMs) * 1000);
+
+	return grantedMs;
+}
+
+void SleepPolicy::OnPresented()
+{
+	_lastPresentUs = _clock->GetTimeUs();
+}
+
+_Use_decl_annotations_
+const FrameTimeHistogram& SleepPolicy::GetRequestedHistogram(
+	MajorGameState majorGameState) const
+{
+	return _requested[min((uint32_t)majorGameState, MajorGameStateCount - 1)];
+}
+
+_Use_decl_annotations_
+const FrameTimeHistogram& SleepPolicy::GetGrantedHistogram(
+	MajorGameState majorGameState) const
+{
+	return _granted[min((uint32_t)majorGameState, MajorGameStateCount - 1)];
+}
+
+void SleepPolicy::LogSummary() const
+{
+	static const char* const stateNames[MajorGameStateCount] = { "unknown", "fmv intro", "menus", "in game", "title screen" };
+
+	for (uint32_t i = 0; i < MajorGameStateCount; ++i)
+	{
+		if (!_requested[i].GetCount())
+		{
+			continue;
+		}
+
+		D2DX_LOG("Sleeps (%s): %llu, requested p50 %.1f ms, max %.1f ms, granted p50 %.1f ms, max %.1f ms.",
+			stateNames[i],
+			_requested[i].GetCount(),
+			_requested[i].GetPercentile(50.0f) / 1000.0f,
+			_requested[i].GetMax() / 1000.0f,
+			_granted[i].GetPercentile(50.0f) / 1000.0f,
+			_granted[i].GetMax() / 1000.0f);
+	}
+}
@@ -0,0 +1,75 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "FrameTimeHistogram.h"
+#include "IClock.h"
+#include "Types.h"
+
+namespace d2dx
+{
+	/*
+		Decides how long the game's Sleep calls actually sleep.
+
+		The game sleeps with fixed durations in menus and in its main loop, to limit the frame rate and to
+		wait for the next game tick. When the frame has to be done by some time, e.g. the frame pacer's
+		deadline or one frame budget after the last present, a sleep that would run past that time is
+		shortened to end before it. If no time is left, the sleep is skipped in game, and replaced by a
+		zero sleep (a yield) elsewhere. Videos are timed by their sleeps, so those are left alone.
+
+		The requested and granted sleep times are recorded in a histogram per major game state.
+	*/
+	class SleepPolicy final
+	{
+	public:
+		SleepPolicy(
+			_In_ const std::shared_ptr<IClock>& clock);
+
+		SleepPolicy(const SleepPolicy&) = delete;
+		SleepPolicy& operator=(const SleepPolicy&) = delete;
+
+		/* Returns the time to sleep in milliseconds instead of requestedMs, or -1 to skip the sleep.
+		   frameBudgetUs is 0 if unknown, and deadlineUs is -1 if there is none. */
+		int32_t OnSleep(
+			_In_ MajorGameState majorGameState,
+			_In_ int32_t requestedMs,
+			_In_ int64_t frameBudgetUs,
+			_In_ int64_t deadlineUs);
+
+		/* Call when a frame has been presented. */
+		void OnPresented();
+
+		/* In microseconds. Skipped sleeps are recorded as granted zero. */
+		const FrameTimeHistogram& GetRequestedHistogram(
+			_In_ MajorGameState majorGameState) const;
+
+		const FrameTimeHistogram& GetGrantedHistogram(
+			_In_ MajorGameState majorGameState) const;
+
+		void LogSummary() const;
+
+	private:
+		static constexpr uint32_t MajorGameStateCount = (uint32_t)MajorGameState::TitleScreen + 1;
+
+		std::shared_ptr<IClock> _clock;
+		int64_t _lastPresentUs = -1;
+		FrameTimeHistogram _requested[MajorGameStateCount];
+		FrameTimeHistogram _granted[MajorGameStateCount];
+	};
+}
@@ -0,0 +1,330 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	struct SlotMapHandle final
+	{
+		uint32_t slot = 0;
+		uint32_t generation = 0;
+
+		inline bool IsValid() const noexcept
+		{
+			return generation != 0;
+		}
+	};
+
+	/*
+		Associative container for entities identified by a 64-bit key (unit id, text id, particle index...).
+
+		Values are stored densely and can be iterated without gaps. Each value also has a stable slot, and
+		handles to slots carry a generation, so a handle to an erased entity never resolves to a newer one
+		that reused the slot. A hash index maps keys to slots. Insert, lookup and erase are all O(1), and the
+		storage grows on demand, so there is no fixed entity limit.
+
+		Erasing moves the last value into the erased position, so when erasing while iterating, iterate
+		backwards.
+	*/
+	template<typename T>
+	class SlotMap final
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "SlotMap values must be trivially copyable.");
+
+	public:
+		SlotMap(
+			_In_ uint32_t initialCapacity = 64) noexcept
+		{
+			uint32_t capacity = 16;
+			while (capacity < initialCapacity)
+			{
+				capacity <<= 1;
+			}
+			Reserve(capacity);
+		}
+
+		SlotMap(const SlotMap&) = delete;
+		SlotMap& operator=(const SlotMap&) = delete;
+
+		inline uint32_t GetCount() const noexcept
+		{
+			return _count;
+		}
+
+		inline uint32_t GetCapacity() const noexcept
+		{
+			return _values.capacity;
+		}
+
+		inline T& GetAt(
+			_In_ uint32_t denseIndex) noexcept
+		{
+			assert(denseIndex < _count);
+			return _values.items[denseIndex];
+		}
+
+		inline const T& GetAt(
+			_In_ uint32_t denseIndex) const noexcept
+		{
+			assert(denseIndex < _count);
+			return _values.items[denseIndex];
+		}
+
+		inline uint64_t GetKeyAt(
+			_In_ uint32_t denseIndex) const noexcept
+		{
+			assert(denseIndex < _count);
+			return _keys.items[denseIndex];
+		}
+
+		inline SlotMapHandle GetHandleAt(
+			_In_ uint32_t denseIndex) const noexcept
+		{
+			assert(denseIndex < _count);
+			const uint32_t slot = _denseToSlot.items[denseIndex];
+			return { slot, _slots.items[slot].generation };
+		}
+
+		SlotMapHandle FindHandle(
+			_In_ uint64_t key) const noexcept
+		{
+			const uint32_t bucket = FindBucket(key);
+			if (!_buckets.items[bucket])
+			{
+				return { };
+			}
+			const uint32_t slot = _buckets.items[bucket] - 1;
+			return { slot, _slots.items[slot].generation };
+		}
+
+		T* Find(
+			_In_ uint64_t key) noexcept
+		{
+			const uint32_t bucket = FindBucket(key);
+			if (!_buckets.items[bucket])
+			{
+				return nullptr;
+			}
+			return &_values.items[_slots.items[_buckets.items[bucket] - 1].denseIndex];
+		}
+
+		T* Get(
+			_In_ SlotMapHandle handle) noexcept
+		{
+			if (handle.slot >= _slots.capacity ||
+				_slots.items[handle.slot].generation != handle.generation ||
+				!(handle.generation & 1))
+			{
+				return nullptr;
+			}
+			return &_values.items[_slots.items[handle.slot].denseIndex];
+		}
+
+		/* Inserts a value for a key that must not already be present. */
+		SlotMapHandle Insert(
+			_In_ uint64_t key,
+			_In_ const T& value) noexcept
+		{
+			assert(!FindHandle(key).IsValid());
+
+			if (_count >= _values.capacity)
+			{
+				Reserve(_values.capacity * 2);
+			}
+
+			const uint32_t slot = _freeSlot;
+			Slot& s = _slots.items[slot];
+			_freeSlot = s.denseIndex;
+
+			/* Odd generations are live, even ones are free. */
+			++s.generation;
+			s.denseIndex = _count;
+
+			_values.items[_count] = value;
+			_keys.items[_count] = key;
+			_denseToSlot.items[_count] = slot;
+			++_count;
+
+			_buckets.items[FindBucket(key)] = slot + 1;
+
+			return { slot, s.generation };
+		}
+
+		bool Erase(
+			_In_ SlotMapHandle handle) noexcept
+		{
+			if (!Get(handle))
+			{
+				return false;
+			}
+			EraseAt(_slots.items[handle.slot].denseIndex);
+			return true;
+		}
+
+		bool Erase(
+			_In_ uint64_t key) noexcept
+		{
+			const SlotMapHandle handle = FindHandle(key);
+			return handle.IsValid() ? Erase(handle) : false;
+		}
+
+		void EraseAt(
+			_In_ uint32_t denseIndex) noexcept
+		{
+			assert(denseIndex < _count);
+
+			RemoveFromIndex(_keys.items[denseIndex]);
+
+			const uint32_t slot = _denseToSlot.items[denseIndex];
+			Slot& s = _slots.items[slot];
+			++s.generation;
+			s.denseIndex = _freeSlot;
+			_freeSlot = slot;
+
+			const uint32_t lastIndex = --_count;
+
+			if (denseIndex != lastIndex)
+			{
+				_values.items[denseIndex] = _values.items[lastIndex];
+				_keys.items[denseIndex] = _keys.items[lastIndex];
+				_denseToSlot.items[denseIndex] = _denseToSlot.items[lastIndex];
+				_slots.items[_denseToSlot.items[denseIndex]].denseIndex = denseIndex;
+			}
+		}
+
+		void Clear() noexcept
+		{
+			while (_count > 0)
+			{
+				EraseAt(_count - 1);
+			}
+		}
+
+	private:
+		struct Slot final
+		{
+			uint32_t denseIndex;
+			uint32_t generation;
+		};
+
+		static inline uint32_t HashKey(
+			_In_ uint64_t key) noexcept
+		{
+			key ^= key >> 33;
+			key *= 0xFF51AFD7ED558CCDULL;
+			key ^= key >> 33;
+			return (uint32_t)key;
+		}
+
+		/* Returns the bucket holding the key, or the empty bucket where it would be inserted. */
+		uint32_t FindBucket(
+			_In_ uint64_t key) const noexcept
+		{
+			const uint32_t mask = _buckets.capacity - 1;
+			uint32_t bucket = HashKey(key) & mask;
+
+			while (_buckets.items[bucket])
+			{
+				if (_keys.items[_slots.items[_buckets.items[bucket] - 1].denseIndex] == key)
+				{
+					break;
+				}
+				bucket = (bucket + 1) & mask;
+			}
+
+			return bucket;
+		}
+
+		void RemoveFromIndex(
+			_In_ uint64_t key) noexcept
+		{
+			const uint32_t mask = _buckets.capacity - 1;
+			uint32_t hole = FindBucket(key);
+			assert(_buckets.items[hole]);
+
+			/* Backward-shift deletion keeps probe sequences intact without tombstones. */
+			for (uint32_t bucket = (hole + 1) & mask; _buckets.items[bucket]; bucket = (bucket + 1) & mask)
+			{
+				const uint64_t bucketKey = _keys.items[_slots.items[_buckets.items[bucket] - 1].denseIndex];
+				const uint32_t home = HashKey(bucketKey) & mask;
+
+				if (((bucket - home) & mask) >= ((bucket - hole) & mask))
+				{
+					_buckets.items[hole] = _buckets.items[bucket];
+					hole = bucket;
+				}
+			}
+
+			_buckets.items[hole] = 0;
+		}
+
+		void Reserve(
+			_In_ uint32_t capacity) noexcept
+		{
+			assert(capacity > _values.capacity && !(capacity & (capacity - 1)));
+
+			const uint32_t oldCapacity = _values.capacity;
+
+			Buffer<T> values{ capacity };
+			Buffer<uint64_t> keys{ capacity };
+			Buffer<uint32_t> denseToSlot{ capacity };
+			Buffer<Slot> slots{ capacity };
+
+			if (oldCapacity > 0)
+			{
+				memcpy(values.items, _values.items, sizeof(T) * _count);
+				memcpy(keys.items, _keys.items, sizeof(uint64_t) * _count);
+				memcpy(denseToSlot.items, _denseToSlot.items, sizeof(uint32_t) * _count);
+				memcpy(slots.items, _slots.items, sizeof(Slot) * oldCapacity);
+			}
+
+			/* Growing only happens when all slots are in use, so the free list is empty and can be
+			   replaced by the new slots. The list is terminated by the (new) capacity. */
+			for (uint32_t i = oldCapacity; i < capacity; ++i)
+			{
+				slots.items[i].denseIndex = i + 1;
+				slots.items[i].generation = 0;
+			}
+			_freeSlot = oldCapacity;
+
+			_values = std::move(values);
+			_keys = std::move(keys);
+			_denseToSlot = std::move(denseToSlot);
+			_slots = std::move(slots);
+
+			/* Keep the hash index at most half full. */
+			_buckets = Buffer<uint32_t>{ capacity * 2, true };
+
+			for (uint32_t i = 0; i < _count; ++i)
+			{
+				_buckets.items[FindBucket(_keys.items[i])] = _denseToSlot.items[i] + 1;
+			}
+		}
+
+		Buffer<T> _values;
+		Buffer<uint64_t> _keys;
+		Buffer<uint32_t> _denseToSlot;
+		Buffer<Slot> _slots;
+		Buffer<uint32_t> _buckets;
+		uint32_t _count = 0;
+		uint32_t _freeSlot = 0;
+	};
+}
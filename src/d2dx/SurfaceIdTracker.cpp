@@ -24,10 +24,10 @@
 using namespace d2dx;
 
 _Use_decl_annotations_
-SurfaceIdTracker::SurfaceIdTracker(
-	const std::shared_ptr<IGameHelper>& gameHelper) :
-	_gameHelper{ gameHelper }
+void SurfaceIdTracker::OnGameStateChanged(
+	const GameStateSnapshot& gameState)
 {
+	_screenOpenMode = gameState.screenOpenMode;
 }
 
 void SurfaceIdTracker::OnNewFrame()
@@ -85,11 +85,11 @@ void SurfaceIdTracker::UpdateBatchSurfaceId(
 		{
 			surfaceId = D2DX_SURFACE_ID_USER_INTERFACE;
 		}
-		else if ((_gameHelper->ScreenOpenMode() & 1) && minx >= gameSize.width / 2)
+		else if ((_screenOpenMode & 1) && minx >= gameSize.width / 2)
 		{
 			surfaceId = D2DX_SURFACE_ID_USER_INTERFACE;
 		}
-		else if ((_gameHelper->ScreenOpenMode() & 2) && maxx <= gameSize.width / 2)
+		else if ((_screenOpenMode & 2) && maxx <= gameSize.width / 2)
 		{
 			surfaceId = D2DX_SURFACE_ID_USER_INTERFACE;
 		}
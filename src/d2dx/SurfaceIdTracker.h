@@ -18,19 +18,21 @@
 */
 #pragma once
 
+#include "GameStateSnapshot.h"
 #include "Types.h"
 
 namespace d2dx
 {
 	class Batch;
 	class Vertex;
-	struct IGameHelper;
 
-	class SurfaceIdTracker final
+	class SurfaceIdTracker final : public IGameStateObserver
 	{
 	public:
-		SurfaceIdTracker(
-			_In_ const std::shared_ptr<IGameHelper>& gameHelper);
+		SurfaceIdTracker() noexcept = default;
+
+		virtual void OnGameStateChanged(
+			_In_ const GameStateSnapshot& gameState) override;
 
 		void OnNewFrame();
 
@@ -44,7 +46,7 @@ namespace d2dx
 		int32_t GetCurrentSurfaceId() const;
 
 	private:
-		std::shared_ptr<IGameHelper> _gameHelper;
+		uint32_t _screenOpenMode = 0;
 		int32_t _nextSurfaceId = 0;
 		int32_t _previousSurfaceId = -1;
 		Rect _previousDrawCallRect = { 0,0,0,0 };
@@ -22,16 +22,25 @@
 using namespace d2dx;
 using namespace DirectX;
 
-_Use_decl_annotations_
-TextMotionPredictor::TextMotionPredictor(
-	const std::shared_ptr<IGameHelper>& gameHelper) :
-	_gameHelper{ gameHelper },
-	_textMotions{ 128, true },
-	_textsCount{ 0 },
+TextMotionPredictor::TextMotionPredictor() :
+	_textMotions{ 128 },
+	_textIdCache{ 256, true },
 	_frame{ 0 }
 {
 }
 
+_Use_decl_annotations_
+void TextMotionPredictor::OnGameStateChanged(
+	const GameStateSnapshot& gameState)
+{
+	_screenOpenMode = gameState.screenOpenMode;
+
+	if (gameState.HasChanged(GameStateChange::InGame))
+	{
+		_textMotions.Clear();
+	}
+}
+
 _Use_decl_annotations_
 void TextMotionPredictor::Update(
 	IRenderContext* renderContext)
@@ -39,22 +48,15 @@ void TextMotionPredictor::Update(
 	renderContext->GetCurrentMetrics(&_gameSize, nullptr, nullptr);
 
 	const float dt = renderContext->GetFrameTime();
-	int32_t expiredTextIndex = -1;
 
-	for (int32_t i = 0; i < _textsCount; ++i)
+	/* Iterate backwards, since erasing moves the last text into the erased position. */
+	for (int32_t i = (int32_t)_textMotions.GetCount() - 1; i >= 0; --i)
 	{
-		TextMotion& tm = _textMotions.items[i];
-
-		if (!tm.id)
-		{
-			expiredTextIndex = i;
-			continue;
-		}
+		TextMotion& tm = _textMotions.GetAt(i);
 
 		if (abs((int64_t)_frame - (int64_t)tm.lastUsedFrame) > 2)
 		{
-			tm.id = 0;
-			expiredTextIndex = i;
+			_textMotions.EraseAt(i);
 			continue;
 		}
 
@@ -69,24 +71,6 @@ void TextMotionPredictor::Update(
 		tm.currentPos += moveVec;
 	}
 
-	// Gradually (one change per frame) compact the list.
-	if (_textsCount > 0)
-	{
-		if (!_textMotions.items[_textsCount - 1].id)
-		{
-			// The last entry is expired. Shrink the list.
-			_textMotions.items[_textsCount - 1] = { };
-			--_textsCount;
-		}
-		else if (expiredTextIndex >= 0 && expiredTextIndex < (_textsCount - 1))
-		{
-			// Some entry is expired. Move the last entry to that place, and shrink the list.
-			_textMotions.items[expiredTextIndex] = _textMotions.items[_textsCount - 1];
-			_textMotions.items[_textsCount - 1] = { };
-			--_textsCount;
-		}
-	}
-
 	++_frame;
 }
 
@@ -96,63 +80,88 @@ Offset TextMotionPredictor::GetOffset(
 	Offset posFromGame)
 {
 	OffsetF posFromGameF{ (float)posFromGame.x, (float)posFromGame.y };
-	int32_t textIndex = -1;
+	TextMotion* tm = _textMotions.Find(textId);
 
-	for (int32_t i = 0; i < _textsCount; ++i)
+	if (tm)
 	{
-		if (_textMotions.items[i].id == textId)
-		{
-			bool resetCurrentPos = false;
+		bool resetCurrentPos = false;
 
-			if ((_gameHelper->ScreenOpenMode() & 1) && posFromGameF.x >= _gameSize.width / 2)
-			{
-				resetCurrentPos = true;
-			}
-			else if ((_gameHelper->ScreenOpenMode() & 2) && posFromGameF.x <= _gameSize.width / 2)
+		if ((_screenOpenMode & 1) && posFromGameF.x >= _gameSize.width / 2)
+		{
+			resetCurrentPos = true;
+		}
+		else if ((_screenOpenMode & 2) && posFromGameF.x <= _gameSize.width / 2)
+		{
+			resetCurrentPos = true;
+		}
+		else
+		{
+			auto distance = (posFromGameF - tm->targetPos).Length();
+			if (distance > 32.0f)
 			{
 				resetCurrentPos = true;
 			}
-			else
-			{
-				auto distance = (posFromGameF - _textMotions.items[i].targetPos).Length();
-				if (distance > 32.0f)
-				{
-					resetCurrentPos = true;
-				}
-			}
-
-			_textMotions.items[i].targetPos = posFromGameF;
-			if (resetCurrentPos)
-			{
-				_textMotions.items[i].currentPos = posFromGameF;
-			}
-			_textMotions.items[i].lastUsedFrame = _frame;
-			textIndex = i;
-			break;
 		}
-	}
 
-	if (textIndex < 0)
-	{
-		if (_textsCount < (int32_t)_textMotions.capacity)
-		{
-			textIndex = _textsCount++;
-			_textMotions.items[textIndex].id = textId;
-			_textMotions.items[textIndex].targetPos = posFromGameF;
-			_textMotions.items[textIndex].currentPos = posFromGameF;
-			_textMotions.items[textIndex].lastUsedFrame = _frame;
-		}
-		else
+		tm->targetPos = posFromGameF;
+		if (resetCurrentPos)
 		{
-			D2DX_DEBUG_LOG("TMP: Too many texts.");
+			tm->currentPos = posFromGameF;
 		}
+		tm->lastUsedFrame = _frame;
 	}
+	else
+	{
+		TextMotion newTm;
+		newTm.targetPos = posFromGameF;
+		newTm.currentPos = posFromGameF;
+		newTm.lastUsedFrame = _frame;
+		tm = _textMotions.Get(_textMotions.Insert(textId, newTm));
+	}
+
+	return { (int32_t)(tm->currentPos.x - posFromGame.x), (int32_t)(tm->currentPos.y - posFromGame.y) };
+}
 
-	if (textIndex < 0)
+_Use_decl_annotations_
+uint64_t TextMotionPredictor::GetTextId(
+	uint32_t returnAddress,
+	const wchar_t* str,
+	uint32_t length)
+{
+	/* The game redraws the same labels from the same buffers every frame, so cache the id by call site,
+	   string pointer and length, and only hash the contents on a miss. A few sampled characters guard
+	   against a buffer being reused for a different string of the same length. */
+	const uint32_t fingerprint = length > 0 ?
+		((uint32_t)str[0] | ((uint32_t)str[length - 1] << 16)) ^ ((uint32_t)str[length / 2] << 8) : 0;
+
+	const uint32_t cacheIndex = (uint32_t)(((returnAddress ^ (uint32_t)(uintptr_t)str ^ (length << 24)) * 0x9E3779B1U) >> 24);
+	TextIdCacheEntry& entry = _textIdCache.items[cacheIndex];
+
+	if (entry.str == (uintptr_t)str &&
+		entry.returnAddress == returnAddress &&
+		entry.length == length &&
+		entry.fingerprint == fingerprint)
 	{
-		return { 0, 0 };
+		return entry.textId;
 	}
 
-	TextMotion& tm = _textMotions.items[textIndex];
-	return { (int32_t)(tm.currentPos.x - posFromGame.x), (int32_t)(tm.currentPos.y - posFromGame.y) };
+	const uint32_t hash = fnv_32a_buf((void*)str, length * sizeof(wchar_t), FNV1_32A_INIT);
+
+	const uint64_t textId =
+		(((uint64_t)(returnAddress & 0xFFFFFF) << 40ULL) |
+		((uint64_t)((uintptr_t)str & 0xFFFFFF) << 16ULL)) ^
+		(uint64_t)hash;
+
+	entry.returnAddress = returnAddress;
+	entry.length = length;
+	entry.str = (uintptr_t)str;
+	entry.fingerprint = fingerprint;
+	entry.textId = textId;
+
+	return textId;
+}
+
+uint32_t TextMotionPredictor::GetTrackedCount() const
+{
+	return _textMotions.GetCount();
 }
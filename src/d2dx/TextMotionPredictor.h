@@ -18,16 +18,19 @@
 */
 #pragma once
 
-#include "IGameHelper.h"
+#include "GameStateSnapshot.h"
 #include "IRenderContext.h"
+#include "SlotMap.h"
 
 namespace d2dx
 {
-	class TextMotionPredictor
+	class TextMotionPredictor : public IGameStateObserver
 	{
 	public:
-		TextMotionPredictor(
-			_In_ const std::shared_ptr<IGameHelper>& gameHelper);
+		TextMotionPredictor();
+
+		virtual void OnGameStateChanged(
+			_In_ const GameStateSnapshot& gameState) override;
 
 		void Update(
 			_In_ IRenderContext* renderContext);
@@ -36,20 +39,35 @@ namespace d2dx
 			_In_ uint64_t textId,
 			_In_ Offset posFromGame);
 
+		uint64_t GetTextId(
+			_In_ uint32_t returnAddress,
+			_In_reads_(length) const wchar_t* str,
+			_In_ uint32_t length);
+
+		uint32_t GetTrackedCount() const;
+
 	private:
+		struct TextIdCacheEntry final
+		{
+			uint32_t returnAddress;
+			uint32_t length;
+			uintptr_t str;
+			uint32_t fingerprint;
+			uint64_t textId;
+		};
+
 		struct TextMotion final
 		{
-			uint64_t id = 0;
 			uint32_t lastUsedFrame = 0;
 			OffsetF targetPos = { 0, 0 };
 			OffsetF currentPos = { 0, 0 };
 			int64_t dtLastPosChange = 0;
 		};
 
-		std::shared_ptr<IGameHelper> _gameHelper;
 		uint32_t _frame = 0;
-		Buffer<TextMotion> _textMotions;
-		int32_t _textsCount;
+		uint32_t _screenOpenMode = 0;
+		SlotMap<TextMotion> _textMotions;
+		Buffer<TextIdCacheEntry> _textIdCache;
 		Size _gameSize;
 	};
 }
@@ -21,6 +21,7 @@
 #include "Utils.h"
 #include "TextureCache.h"
 #include "TextureCachePolicyBitPmru.h"
+#include "Tracer.h"
 
 using namespace d2dx;
 using namespace std;
@@ -31,47 +32,107 @@ TextureCache::TextureCache(
 	int32_t height,
 	uint32_t capacity,
 	uint32_t texturesPerAtlas,
-	ID3D11Device* device,
-	const std::shared_ptr<ISimd>& simd)
+	const std::shared_ptr<ITextureCacheDevice>& device,
+	const std::shared_ptr<ISimd>& simd) :
+	_device{ device }
 {
-	assert(_atlasCount <= 4);
+	assert(capacity > 0 && !(capacity & (capacity - 1)));
+	assert(texturesPerAtlas > 0 && !(texturesPerAtlas & (texturesPerAtlas - 1)));
 
 	_width = width;
 	_height = height;
 	_capacity = capacity;
-	_texturesPerAtlas = texturesPerAtlas;
-	_atlasCount = (int32_t)max(1, capacity / texturesPerAtlas);
+
+	/* Don't make the atlases larger than the whole cache. */
+	_texturesPerAtlas = min(texturesPerAtlas, capacity);
+	_atlasCount = (int32_t)(capacity / _texturesPerAtlas);
+	_maxAtlasCount = _atlasCount;
 	_policy = TextureCachePolicyBitPmru(capacity, simd);
 
-#ifndef D2DX_UNITTEST
+	assert(_atlasCount <= (int32_t)ARRAYSIZE(_textures));
+
+	/* The atlases are created on first insert, since many size classes see little or no use. */
+}
+
+uint32_t TextureCache::GetMemoryFootprint() const
+{
+	return GetAtlasMemoryFootprint() * _atlasCount;
+}
+
+uint32_t TextureCache::GetCommittedMemoryFootprint() const
+{
+	return GetAtlasMemoryFootprint() * _committedAtlasCount;
+}
+
+uint32_t TextureCache::GetAtlasMemoryFootprint() const
+{
+	return _width * _height * _texturesPerAtlas;
+}
+
+uint32_t TextureCache::GetMemoryDemand() const
+{
+	const uint32_t demandedCount = min(_capacity, _policy.GetUsedCount() + _recentEvictionCount);
+	const uint32_t demandedAtlasCount = (demandedCount + _texturesPerAtlas - 1) / _texturesPerAtlas;
+	return GetAtlasMemoryFootprint() * demandedAtlasCount;
+}
+
+_Use_decl_annotations_
+void TextureCache::SetMemoryLimit(
+	uint32_t bytes)
+{
+	/* Never shrink below what a single frame has needed, or a busy frame would evict textures it still draws. */
+	const uint32_t peakUsedInFrameCount = max(_peakUsedInFrameCount, _policy.GetUsedInFrameCount());
+	const uint32_t minAtlasCount = max(1U, (peakUsedInFrameCount + _texturesPerAtlas - 1) / _texturesPerAtlas);
+
+	int32_t maxAtlasCount = (int32_t)min((uint32_t)_atlasCount, max(minAtlasCount, bytes / GetAtlasMemoryFootprint()));
+
+	/* Release atlases only down to the last one that was used recently. */
+	for (int32_t textureAtlas = _maxAtlasCount - 1; textureAtlas >= maxAtlasCount; --textureAtlas)
+	{
+		if (_atlasIdleFrameCounts[textureAtlas] < AtlasIdleFrameCount)
+		{
+			maxAtlasCount = textureAtlas + 1;
+			break;
+		}
+	}
 
-	CD3D11_TEXTURE2D_DESC desc
+	if (maxAtlasCount == _maxAtlasCount)
 	{
-		DXGI_FORMAT_R8_UINT,
-		(UINT)width,
-		(UINT)height,
-		_texturesPerAtlas,
-		1U,
-		D3D11_BIND_SHADER_RESOURCE,
-		D3D11_USAGE_DEFAULT
-	};
-
-	uint32_t capacityPerPartition = _capacity;
-
-	for (int32_t partition = 0; partition < 4; ++partition)
+		return;
+	}
+
+	_maxAtlasCount = maxAtlasCount;
+	_policy.SetActiveCapacity(_maxAtlasCount * _texturesPerAtlas);
+
+	for (int32_t textureAtlas = _maxAtlasCount; textureAtlas < _atlasCount; ++textureAtlas)
 	{
-		D2DX_CHECK_HR(device->CreateTexture2D(&desc, nullptr, &_textures[partition]));
-		D2DX_CHECK_HR(device->CreateShaderResourceView(_textures[partition].Get(), NULL, _srvs[partition].GetAddressOf()));
+		if (_committedAtlasMask & (1U << textureAtlas))
+		{
+			_textures[textureAtlas] = nullptr;
+			_srvs[textureAtlas] = nullptr;
+			_committedAtlasMask &= ~(1U << textureAtlas);
+			--_committedAtlasCount;
+		}
 	}
 
-	device->GetImmediateContext(&_deviceContext);
-	assert(_deviceContext);
-#endif
+	D2DX_LOG("Limited the cache for %i x %i textures to %i of %i atlases (%u kB committed).",
+		_width, _height, _maxAtlasCount, _atlasCount, GetCommittedMemoryFootprint() / 1024);
 }
 
-uint32_t TextureCache::GetMemoryFootprint() const
+_Use_decl_annotations_
+void TextureCache::CommitAtlas(
+	int32_t textureAtlas)
 {
-	return _width * _height * _texturesPerAtlas * _atlasCount;
+	assert(textureAtlas >= 0 && textureAtlas < _atlasCount);
+	assert(!(_committedAtlasMask & (1U << textureAtlas)));
+
+	_device->CreateTextureArray(_width, _height, _texturesPerAtlas, &_textures[textureAtlas], &_srvs[textureAtlas]);
+
+	_committedAtlasMask |= 1U << textureAtlas;
+	++_committedAtlasCount;
+
+	D2DX_LOG("Created atlas %i for %i x %i textures (%u of %u kB committed).",
+		textureAtlas, _width, _height, GetCommittedMemoryFootprint() / 1024, GetMemoryFootprint() / 1024);
 }
 
 _Use_decl_annotations_
@@ -86,7 +147,10 @@ TextureCacheLocation TextureCache::FindTexture(
 		return { -1, -1 };
 	}
 
-	return { (int16_t)(index / _texturesPerAtlas), (int16_t)(index & (_texturesPerAtlas - 1)) };
+	const int32_t textureAtlas = (int32_t)(index / _texturesPerAtlas);
+	_atlasUsedInFrameMask |= 1U << textureAtlas;
+
+	return { (int16_t)textureAtlas, (int16_t)(index & (_texturesPerAtlas - 1)) };
 }
 
 _Use_decl_annotations_
@@ -96,6 +160,8 @@ TextureCacheLocation TextureCache::InsertTexture(
 	const uint8_t* tmuData,
 	uint32_t tmuDataSize)
 {
+	D2DX_TRACE_SCOPE("TextureCache::InsertTexture");
+
 	assert(batch.IsValid() && batch.GetTextureWidth() > 0 && batch.GetTextureHeight() > 0);
 
 	bool evicted = false;
@@ -103,24 +169,28 @@ TextureCacheLocation TextureCache::InsertTexture(
 
 	if (evicted)
 	{
+		++_recentEvictionCount;
 		D2DX_DEBUG_LOG("Evicted %ix%i texture %i from cache.", batch.GetTextureWidth(), batch.GetTextureHeight(), replacementIndex);
 	}
 
-#ifndef D2DX_UNITTEST
-	CD3D11_BOX box;
-	box.left = 0;
-	box.top = 0;
-	box.right = batch.GetTextureWidth();
-	box.bottom = batch.GetTextureHeight();
-	box.front = 0;
-	box.back = 1;
+	const int32_t textureAtlas = (int32_t)(replacementIndex / _texturesPerAtlas);
+	const int32_t textureIndex = (int32_t)(replacementIndex & (_texturesPerAtlas - 1));
 
-	const uint8_t* pData = tmuData + batch.GetTextureStartAddress();
+	if (!(_committedAtlasMask & (1U << textureAtlas)))
+	{
+		CommitAtlas(textureAtlas);
+	}
+
+	_atlasUsedInFrameMask |= 1U << textureAtlas;
 
-	_deviceContext->UpdateSubresource(_textures[replacementIndex / _texturesPerAtlas].Get(), replacementIndex & (_texturesPerAtlas - 1), &box, pData, batch.GetTextureWidth(), 0);
-#endif
+	_device->UpdateTextureArraySlice(
+		_textures[textureAtlas].Get(),
+		textureIndex,
+		batch.GetTextureWidth(),
+		batch.GetTextureHeight(),
+		tmuData + batch.GetTextureStartAddress());
 
-	return { (int16_t)(replacementIndex / _texturesPerAtlas), (int16_t)(replacementIndex & (_texturesPerAtlas - 1)) };
+	return { (int16_t)textureAtlas, (int16_t)textureIndex };
 }
 
 _Use_decl_annotations_
@@ -133,7 +203,26 @@ ID3D11ShaderResourceView* TextureCache::GetSrv(
 
 void TextureCache::OnNewFrame()
 {
+	_peakUsedInFrameCount = max(_peakUsedInFrameCount, _policy.GetUsedInFrameCount());
+
+	for (int32_t textureAtlas = 0; textureAtlas < _atlasCount; ++textureAtlas)
+	{
+		if (_atlasUsedInFrameMask & (1U << textureAtlas))
+		{
+			_atlasIdleFrameCounts[textureAtlas] = 0;
+		}
+		else if (_atlasIdleFrameCounts[textureAtlas] < AtlasIdleFrameCount)
+		{
+			++_atlasIdleFrameCounts[textureAtlas];
+		}
+	}
+
+	_atlasUsedInFrameMask = 0;
+
 	_policy.OnNewFrame();
+
+	/* Let evictions count towards the demand for a few hundred frames. */
+	_recentEvictionCount -= (_recentEvictionCount + 63) / 64;
 }
 
 _Use_decl_annotations_
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "ITextureCache.h"
+#include "ITextureCacheDevice.h"
 #include "TextureCachePolicyBitPmru.h"
 
 namespace d2dx
@@ -26,12 +27,15 @@ namespace d2dx
 	class TextureCache final : public ITextureCache
 	{
 	public:
+		/* SetMemoryLimit only releases atlases that haven't been used for this many frames. */
+		static constexpr uint32_t AtlasIdleFrameCount = 256;
+
 		TextureCache(
 			_In_ int32_t width,
 			_In_ int32_t height,
 			_In_ uint32_t capacity,
 			_In_ uint32_t texturesPerAtlas,
-			_In_ ID3D11Device* device,
+			_In_ const std::shared_ptr<ITextureCacheDevice>& device,
 			_In_ const std::shared_ptr<ISimd>& simd);
 		
 		virtual ~TextureCache() noexcept {}
@@ -52,10 +56,22 @@ namespace d2dx
 			_In_ uint32_t atlasIndex) const override;
 		
 		virtual uint32_t GetMemoryFootprint() const override;
+
+		virtual uint32_t GetCommittedMemoryFootprint() const override;
+
+		virtual uint32_t GetAtlasMemoryFootprint() const override;
+
+		virtual uint32_t GetMemoryDemand() const override;
+
+		virtual void SetMemoryLimit(
+			_In_ uint32_t bytes) override;
 		
 		virtual uint32_t GetUsedCount() const override;
 
 	private:
+		void CommitAtlas(
+			_In_ int32_t textureAtlas);
+
 		void CopyPixels(
 			_In_ int32_t srcWidth,
 			_In_ int32_t srcHeight,
@@ -69,7 +85,14 @@ namespace d2dx
 		uint32_t _capacity = 0;
 		uint32_t _texturesPerAtlas = 0;
 		int32_t _atlasCount = 0;
-		ComPtr<ID3D11DeviceContext> _deviceContext;
+		int32_t _maxAtlasCount = 0;
+		int32_t _committedAtlasCount = 0;
+		uint32_t _recentEvictionCount = 0;
+		uint32_t _committedAtlasMask = 0;
+		uint32_t _atlasUsedInFrameMask = 0;
+		uint32_t _atlasIdleFrameCounts[4] = { AtlasIdleFrameCount, AtlasIdleFrameCount, AtlasIdleFrameCount, AtlasIdleFrameCount };
+		uint32_t _peakUsedInFrameCount = 0;
+		std::shared_ptr<ITextureCacheDevice> _device;
 		ComPtr<ID3D11Texture2D> _textures[4];
 		ComPtr<ID3D11ShaderResourceView> _srvs[4];
 		TextureCachePolicyBitPmru _policy;
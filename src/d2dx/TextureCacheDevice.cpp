@@ -0,0 +1,86 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureCacheDevice.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TextureCacheDevice::TextureCacheDevice(
+	ID3D11Device* device) :
+	_device{ device }
+{
+	_device->GetImmediateContext(&_deviceContext);
+	assert(_deviceContext);
+}
+
+uint32_t TextureCacheDevice::GetMaxTextureArraySize()
+{
+	if (!_maxTextureArraySize)
+	{
+		/* The limit is implied by the feature level, so there is no need to probe for it by creating textures. */
+		_maxTextureArraySize = _device->GetFeatureLevel() >= D3D_FEATURE_LEVEL_11_0 ?
+			D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION : D3D10_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION;
+	}
+
+	return _maxTextureArraySize;
+}
+
+_Use_decl_annotations_
+void TextureCacheDevice::CreateTextureArray(
+	int32_t width,
+	int32_t height,
+	uint32_t arraySize,
+	ID3D11Texture2D** texture,
+	ID3D11ShaderResourceView** srv)
+{
+	CD3D11_TEXTURE2D_DESC desc
+	{
+		DXGI_FORMAT_R8_UINT,
+		(UINT)width,
+		(UINT)height,
+		arraySize,
+		1U,
+		D3D11_BIND_SHADER_RESOURCE,
+		D3D11_USAGE_DEFAULT
+	};
+
+	D2DX_CHECK_HR(_device->CreateTexture2D(&desc, nullptr, texture));
+	D2DX_CHECK_HR(_device->CreateShaderResourceView(*texture, NULL, srv));
+}
+
+_Use_decl_annotations_
+void TextureCacheDevice::UpdateTextureArraySlice(
+	ID3D11Texture2D* texture,
+	uint32_t slice,
+	int32_t width,
+	int32_t height,
+	const uint8_t* data)
+{
+	CD3D11_BOX box;
+	box.left = 0;
+	box.top = 0;
+	box.right = width;
+	box.bottom = height;
+	box.front = 0;
+	box.back = 1;
+
+	_deviceContext->UpdateSubresource(texture, slice, &box, data, width, 0);
+}
@@ -0,0 +1,54 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "ITextureCacheDevice.h"
+
+namespace d2dx
+{
+	class TextureCacheDevice final : public ITextureCacheDevice
+	{
+	public:
+		TextureCacheDevice(
+			_In_ ID3D11Device* device);
+
+		virtual ~TextureCacheDevice() noexcept {}
+
+		virtual uint32_t GetMaxTextureArraySize() override;
+
+		virtual void CreateTextureArray(
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_ uint32_t arraySize,
+			_Outptr_ ID3D11Texture2D** texture,
+			_Outptr_ ID3D11ShaderResourceView** srv) override;
+
+		virtual void UpdateTextureArraySlice(
+			_In_ ID3D11Texture2D* texture,
+			_In_ uint32_t slice,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint8_t* data) override;
+
+	private:
+		ComPtr<ID3D11Device> _device;
+		ComPtr<ID3D11DeviceContext> _deviceContext;
+		uint32_t _maxTextureArraySize = 0;
+	};
+}
@@ -82,7 +82,7 @@ int32_t TextureCachePolicyBitPmru::Insert(
 
 	int32_t replacementIndex = -1;
 
-	for (uint32_t i = 0; i < _mruBits.capacity; ++i)
+	for (uint32_t i = 0; i < (_capacity >> 5); ++i)
 	{
 		DWORD ri;
 		if (BitScanForward(&ri, (DWORD)~_mruBits.items[i]))
@@ -94,9 +94,9 @@ int32_t TextureCachePolicyBitPmru::Insert(
 
 	if (replacementIndex < 0)
 	{
-		memcpy(_mruBits.items, _usedInFrameBits.items, sizeof(uint32_t) * _mruBits.capacity);
+		memcpy(_mruBits.items, _usedInFrameBits.items, sizeof(uint32_t) * (_capacity >> 5));
 
-		for (uint32_t i = 0; i < _mruBits.capacity; ++i)
+		for (uint32_t i = 0; i < (_capacity >> 5); ++i)
 		{
 			DWORD ri;
 			if (BitScanForward(&ri, (DWORD)~_mruBits.items[i]))
@@ -110,10 +110,10 @@ int32_t TextureCachePolicyBitPmru::Insert(
 	if (replacementIndex < 0)
 	{
 		D2DX_LOG("All texture atlas entries used in a single frame, starting over!");
-		memset(_mruBits.items, 0, sizeof(uint32_t) * _mruBits.capacity);
-		memset(_usedInFrameBits.items, 0, sizeof(uint32_t) * _usedInFrameBits.capacity);
+		memset(_mruBits.items, 0, sizeof(uint32_t) * (_capacity >> 5));
+		memset(_usedInFrameBits.items, 0, sizeof(uint32_t) * (_capacity >> 5));
 
-		for (uint32_t i = 0; i < _mruBits.capacity; ++i)
+		for (uint32_t i = 0; i < (_capacity >> 5); ++i)
 		{
 			DWORD ri;
 			if (BitScanForward(&ri, (DWORD)~_mruBits.items[i]))
@@ -141,10 +141,48 @@ int32_t TextureCachePolicyBitPmru::Insert(
 
 void TextureCachePolicyBitPmru::OnNewFrame()
 {
-	memset(_usedInFrameBits.items, 0, sizeof(uint32_t) * _usedInFrameBits.capacity);
+	memset(_usedInFrameBits.items, 0, sizeof(uint32_t) * (_capacity >> 5));
+}
+
+_Use_decl_annotations_
+void TextureCachePolicyBitPmru::SetActiveCapacity(
+	uint32_t activeCapacity)
+{
+	assert(activeCapacity > 0 && activeCapacity <= _contentKeys.capacity && !(activeCapacity & 31));
+
+	for (uint32_t i = activeCapacity; i < _capacity; ++i)
+	{
+		if (_contentKeys.items[i])
+		{
+			_contentKeys.items[i] = 0;
+			--_usedCount;
+		}
+	}
+
+	const uint32_t firstWord = min(activeCapacity, _capacity) >> 5;
+	const uint32_t wordCount = (_mruBits.capacity - firstWord);
+	memset(_mruBits.items + firstWord, 0, sizeof(uint32_t) * wordCount);
+	memset(_usedInFrameBits.items + firstWord, 0, sizeof(uint32_t) * wordCount);
+
+	_capacity = activeCapacity;
 }
 
 uint32_t TextureCachePolicyBitPmru::GetUsedCount() const
 {
 	return _usedCount;
 }
+
+uint32_t TextureCachePolicyBitPmru::GetUsedInFrameCount() const
+{
+	uint32_t usedInFrameCount = 0;
+
+	for (uint32_t i = 0; i < (_capacity >> 5); ++i)
+	{
+		uint32_t bits = _usedInFrameBits.items[i];
+		bits = bits - ((bits >> 1) & 0x55555555);
+		bits = (bits & 0x33333333) + ((bits >> 2) & 0x33333333);
+		usedInFrameCount += (((bits + (bits >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+	}
+
+	return usedInFrameCount;
+}
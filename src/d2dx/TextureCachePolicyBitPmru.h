@@ -44,8 +44,15 @@ namespace d2dx
 		
 		void OnNewFrame();
 
+		/* Limits the entries in use to the first activeCapacity. Entries beyond it are dropped. */
+		void SetActiveCapacity(
+			_In_ uint32_t activeCapacity);
+
 		uint32_t GetUsedCount() const;
 
+		/* The number of entries used since the last call to OnNewFrame. */
+		uint32_t GetUsedInFrameCount() const;
+
 	private:
 		uint32_t _capacity = 0;
 		std::shared_ptr<ISimd> _simd;
@@ -0,0 +1,132 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Types.h"
+
+namespace d2dx
+{
+	struct TextureHashList final
+	{
+		TextureCategory category;
+		const uint32_t* hashes;
+		uint32_t count;
+	};
+
+	/*
+		Maps texture hashes to texture categories. The table is built and sorted at compile time from a set
+		of per-category hash lists, and a lookup is a branchless binary search with a fixed number of steps
+		(log2 of the capacity). Unused entries are padded with 0xFFFFFFFF at the end.
+
+		Declare instances constexpr and static_assert on HasDuplicates() and HasOverflowed(), so that a bad
+		hash list fails the build.
+	*/
+	template<uint32_t Capacity>
+	class TextureCategoryTable final
+	{
+		static_assert(Capacity > 0 && !(Capacity & (Capacity - 1)), "Capacity must be a power of two.");
+
+	public:
+		template<size_t ListCount>
+		constexpr TextureCategoryTable(
+			_In_ const TextureHashList (&lists)[ListCount]) noexcept :
+			_hashes{},
+			_categories{}
+		{
+			for (uint32_t i = 0; i < Capacity; ++i)
+			{
+				_hashes[i] = 0xFFFFFFFF;
+				_categories[i] = TextureCategory::Unknown;
+			}
+
+			for (size_t listIndex = 0; listIndex < ListCount; ++listIndex)
+			{
+				for (uint32_t hashIndex = 0; hashIndex < lists[listIndex].count; ++hashIndex)
+				{
+					Insert(lists[listIndex].hashes[hashIndex], lists[listIndex].category);
+				}
+			}
+		}
+
+		constexpr uint32_t GetCount() const noexcept
+		{
+			return _count;
+		}
+
+		constexpr bool HasDuplicates() const noexcept
+		{
+			return _hasDuplicates;
+		}
+
+		constexpr bool HasOverflowed() const noexcept
+		{
+			return _hasOverflowed;
+		}
+
+		TextureCategory Find(
+			_In_ uint32_t hash) const noexcept
+		{
+			uint32_t base = 0;
+
+			for (uint32_t n = Capacity; n > 1; n -= n / 2)
+			{
+				const uint32_t half = n / 2;
+				base = _hashes[base + half] <= hash ? base + half : base;
+			}
+
+			return _hashes[base] == hash ? _categories[base] : TextureCategory::Unknown;
+		}
+
+	private:
+		constexpr void Insert(
+			_In_ uint32_t hash,
+			_In_ TextureCategory category) noexcept
+		{
+			if (_count >= Capacity)
+			{
+				_hasOverflowed = true;
+				return;
+			}
+
+			uint32_t position = _count;
+
+			while (position > 0 && _hashes[position - 1] > hash)
+			{
+				_hashes[position] = _hashes[position - 1];
+				_categories[position] = _categories[position - 1];
+				--position;
+			}
+
+			if (position > 0 && _hashes[position - 1] == hash)
+			{
+				_hasDuplicates = true;
+			}
+
+			_hashes[position] = hash;
+			_categories[position] = category;
+			++_count;
+		}
+
+		uint32_t _hashes[Capacity];
+		TextureCategory _categories[Capacity];
+		uint32_t _count = 0;
+		bool _hasDuplicates = false;
+		bool _hasOverflowed = false;
+	};
+}
@@ -0,0 +1,205 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TextureDumper.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION 1
+#include "../../thirdparty/stb_image/stb_image_write.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+void PngTextureDumpSink::Write(
+	uint32_t hash,
+	uint32_t textureCategory,
+	int32_t width,
+	int32_t height,
+	const uint32_t* pixels)
+{
+	char path[64];
+
+	if (textureCategory < (uint32_t)TextureCategory::Count && !_isDirectoryCreated[textureCategory])
+	{
+		sprintf_s(path, "dump/%u", textureCategory);
+		std::error_code errorCode;
+		std::filesystem::create_directories(path, errorCode);
+		_isDirectoryCreated[textureCategory] = true;
+	}
+
+	sprintf_s(path, "dump/%u/%08x.png", textureCategory, hash);
+	stbi_write_png(path, width, height, 4, pixels, width * 4);
+}
+
+_Use_decl_annotations_
+TextureDumper::TextureDumper(
+	uint32_t capacity,
+	const std::shared_ptr<ITextureDumpSink>& sink) :
+	_jobs{ capacity },
+	_jobPixels{ capacity * MaxTextureSize * MaxTextureSize },
+	_rgbaPixels{ MaxTextureSize * MaxTextureSize },
+	_sink{ sink },
+	_queuedTextures{ 4096 },
+	_enqueuePosition{ 0 },
+	_dequeuePosition{ 0 },
+	_droppedCount{ 0 },
+	_writtenCount{ 0 }
+{
+	assert(capacity > 0);
+
+	_workerThread = std::thread{ &TextureDumper::RunWorker, this };
+}
+
+TextureDumper::~TextureDumper() noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		_isStopping = true;
+	}
+
+	_wakeWorker.notify_one();
+	_workerThread.join();
+}
+
+_Use_decl_annotations_
+bool TextureDumper::TryDump(
+	uint32_t hash,
+	int32_t width,
+	int32_t height,
+	const uint8_t* pixels,
+	uint32_t textureCategory,
+	const uint32_t* palette) noexcept
+{
+	const uint64_t key = ((uint64_t)textureCategory << 32) | hash;
+
+	if (_queuedTextures.Find(key))
+	{
+		return true;
+	}
+
+	assert(width > 0 && width <= MaxTextureSize && height > 0 && height <= MaxTextureSize);
+
+	const uint32_t position = _enqueuePosition.load(std::memory_order_relaxed);
+
+	if ((position - _dequeuePosition.load(std::memory_order_acquire)) >= _jobs.capacity)
+	{
+		_droppedCount.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	const uint32_t jobIndex = position % _jobs.capacity;
+	Job& job = _jobs.items[jobIndex];
+	job.hash = hash;
+	job.textureCategory = textureCategory;
+	job.width = width;
+	job.height = height;
+	memcpy(job.palette, palette, sizeof(job.palette));
+	memcpy(&_jobPixels.items[jobIndex * MaxTextureSize * MaxTextureSize], pixels, width * height);
+
+	_enqueuePosition.store(position + 1, std::memory_order_release);
+	_queuedTextures.Insert(key, 0);
+
+	_wakeWorker.notify_one();
+	return true;
+}
+
+void TextureDumper::Flush()
+{
+	const uint32_t target = _enqueuePosition.load(std::memory_order_acquire);
+
+	std::unique_lock<std::mutex> lock{ _mutex };
+	_isFlushRequested = true;
+	_wakeWorker.notify_one();
+
+	_flushed.wait(lock, [&]() {
+		return (int32_t)(_dequeuePosition.load(std::memory_order_acquire) - target) >= 0 || _isStopping;
+	});
+}
+
+uint64_t TextureDumper::GetDroppedCount() const noexcept
+{
+	return _droppedCount.load(std::memory_order_relaxed);
+}
+
+uint64_t TextureDumper::GetWrittenCount() const noexcept
+{
+	return _writtenCount.load(std::memory_order_relaxed);
+}
+
+uint64_t TextureDumper::GetMemoryFootprint() const noexcept
+{
+	return (uint64_t)_jobs.capacity * sizeof(Job) + _jobPixels.capacity + (uint64_t)_rgbaPixels.capacity * sizeof(uint32_t);
+}
+
+void TextureDumper::RunWorker()
+{
+	for (;;)
+	{
+		bool isStopping;
+
+		{
+			std::unique_lock<std::mutex> lock{ _mutex };
+
+			/* The game thread notifies without taking the lock, so a wakeup can be missed. Poll as a fallback. */
+			_wakeWorker.wait_for(lock, std::chrono::milliseconds(20), [&]() {
+				return _isFlushRequested || _isStopping ||
+					_enqueuePosition.load(std::memory_order_relaxed) != _dequeuePosition.load(std::memory_order_relaxed);
+			});
+			_isFlushRequested = false;
+			isStopping = _isStopping;
+		}
+
+		DrainToSink();
+
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_flushed.notify_all();
+		}
+
+		if (isStopping)
+		{
+			break;
+		}
+	}
+}
+
+void TextureDumper::DrainToSink()
+{
+	uint32_t position = _dequeuePosition.load(std::memory_order_relaxed);
+
+	while (position != _enqueuePosition.load(std::memory_order_acquire))
+	{
+		const uint32_t jobIndex = position % _jobs.capacity;
+		const Job& job = _jobs.items[jobIndex];
+		const uint8_t* pixels = &_jobPixels.items[jobIndex * MaxTextureSize * MaxTextureSize];
+		const int32_t pixelCount = job.width * job.height;
+
+		/* The palette is in BGRA order. */
+		for (int32_t i = 0; i < pixelCount; ++i)
+		{
+			const uint32_t c = job.palette[pixels[i]] | 0xFF000000;
+			_rgbaPixels.items[i] = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
+		}
+
+		_sink->Write(job.hash, job.textureCategory, job.width, job.height, _rgbaPixels.items);
+
+		++position;
+		_writtenCount.fetch_add(1, std::memory_order_relaxed);
+		_dequeuePosition.store(position, std::memory_order_release);
+	}
+}
@@ -0,0 +1,130 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "SlotMap.h"
+#include "Types.h"
+
+namespace d2dx
+{
+	struct ITextureDumpSink abstract
+	{
+		virtual ~ITextureDumpSink() noexcept {}
+
+		/* Writes a texture, given as 32-bit RGBA pixels. */
+		virtual void Write(
+			_In_ uint32_t hash,
+			_In_ uint32_t textureCategory,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint32_t* pixels) = 0;
+	};
+
+	/* Writes textures to dump/<texture category>/<hash>.png. */
+	class PngTextureDumpSink final : public ITextureDumpSink
+	{
+	public:
+		virtual ~PngTextureDumpSink() noexcept {}
+
+		virtual void Write(
+			_In_ uint32_t hash,
+			_In_ uint32_t textureCategory,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint32_t* pixels) override;
+
+	private:
+		bool _isDirectoryCreated[(int32_t)TextureCategory::Count] = { };
+	};
+
+	/*
+		Dumps textures from a worker thread, so that the game thread only has to copy the texture.
+
+		Each texture (by hash and category) is dumped once. The queue is bounded: when it is full the
+		texture is dropped and counted, and will be queued again the next time it is used.
+	*/
+	class TextureDumper final
+	{
+	public:
+		static constexpr int32_t MaxTextureSize = 256;
+
+		TextureDumper(
+			_In_ uint32_t capacity,
+			_In_ const std::shared_ptr<ITextureDumpSink>& sink);
+
+		~TextureDumper() noexcept;
+
+		TextureDumper(const TextureDumper&) = delete;
+		TextureDumper& operator=(const TextureDumper&) = delete;
+
+		/* Must always be called from the same thread. Returns false if the texture was dropped. */
+		bool TryDump(
+			_In_ uint32_t hash,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint8_t* pixels,
+			_In_ uint32_t textureCategory,
+			_In_reads_(256) const uint32_t* palette) noexcept;
+
+		/* Blocks until all textures queued before the call have been written to the sink. */
+		void Flush();
+
+		uint64_t GetDroppedCount() const noexcept;
+
+		uint64_t GetWrittenCount() const noexcept;
+
+		/* The size of the queue and the conversion buffer. */
+		uint64_t GetMemoryFootprint() const noexcept;
+
+	private:
+		struct Job final
+		{
+			uint32_t hash;
+			uint32_t textureCategory;
+			int32_t width;
+			int32_t height;
+			uint32_t palette[256];
+		};
+
+		void RunWorker();
+
+		void DrainToSink();
+
+		Buffer<Job> _jobs;
+		Buffer<uint8_t> _jobPixels;
+		Buffer<uint32_t> _rgbaPixels;
+		std::shared_ptr<ITextureDumpSink> _sink;
+
+		/* Only used as a set of the textures that have been queued. */
+		SlotMap<uint8_t> _queuedTextures;
+
+		alignas(64) std::atomic<uint32_t> _enqueuePosition;
+		alignas(64) std::atomic<uint32_t> _dequeuePosition;
+		std::atomic<uint64_t> _droppedCount;
+		std::atomic<uint64_t> _writtenCount;
+
+		std::mutex _mutex;
+		std::condition_variable _wakeWorker;
+		std::condition_variable _flushed;
+		bool _isFlushRequested = false;
+		bool _isStopping = false;
+		std::thread _workerThread;
+	};
+}
@@ -32,19 +32,48 @@ TextureHasher::TextureHasher() :
 
 _Use_decl_annotations_
 void TextureHasher::Invalidate(
-	uint32_t startAddress)
+	const TmuMemory& tmuMemory,
+	uint32_t startAddress,
+	uint32_t size)
 {
-	_cache.items[startAddress >> 8] = 0;
+	/* A download can overwrite the start of other textures too, not just the one at startAddress. */
+	const uint32_t endPage = min((startAddress + max(size, 1U) + 255) >> 8, _cache.capacity);
+
+	for (uint32_t page = startAddress >> 8; page < endPage; ++page)
+	{
+		/* Hashes are only cached for textures starting in written pages. */
+		if (tmuMemory.IsWritten(page << 8))
+		{
+			_cache.items[page] = 0;
+		}
+	}
 }
 
 _Use_decl_annotations_
 uint32_t TextureHasher::GetHash(
+	const TmuMemory& tmuMemory,
 	uint32_t startAddress,
 	const uint8_t* pixels,
 	uint32_t pixelsSize)
 {
 	assert((startAddress & 255) == 0);
 
+	if (!tmuMemory.IsAnyWritten(startAddress, pixelsSize))
+	{
+		if (pixelsSize == _zeroPixelsSize)
+		{
+			++_cacheHits;
+		}
+		else
+		{
+			++_cacheMisses;
+			_zeroPixelsHash = fnv_32a_buf((void*)pixels, pixelsSize, FNV1_32A_INIT);
+			_zeroPixelsSize = pixelsSize;
+		}
+
+		return _zeroPixelsHash;
+	}
+
 	uint32_t hash = _cache.items[startAddress >> 8];
 
 	if (hash)
@@ -68,4 +97,14 @@ void TextureHasher::PrintStats()
 		(int32_t)(100.0f * (float)_cacheHits / (_cacheHits + _cacheMisses)),
 		_cacheMisses
 	);
-}
\ No newline at end of file
+}
+
+uint32_t TextureHasher::GetCacheHits() const
+{
+	return _cacheHits;
+}
+
+uint32_t TextureHasher::GetCacheMisses() const
+{
+	return _cacheMisses;
+}
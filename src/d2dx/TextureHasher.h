@@ -19,6 +19,7 @@
 #pragma once
 
 #include "Buffer.h"
+#include "TmuMemory.h"
 
 namespace d2dx
 {
@@ -28,18 +29,30 @@ namespace d2dx
 		TextureHasher();
 		~TextureHasher() noexcept {}
 
+		/* Forgets the hashes of all textures starting within the given range of TMU memory. Call before
+		   writing the range. */
 		void Invalidate(
-			_In_ uint32_t startAddress);
+			_In_ const TmuMemory& tmuMemory,
+			_In_ uint32_t startAddress,
+			_In_ uint32_t size);
 
+		/* Textures in memory that was never written are all zeros, so their hash only depends on the size. */
 		uint32_t GetHash(
+			_In_ const TmuMemory& tmuMemory,
 			_In_ uint32_t startAddress,
 			_In_reads_(pixelsSize) const uint8_t* pixels,
 			_In_ uint32_t pixelsSize);
 
 		void PrintStats();
 
+		uint32_t GetCacheHits() const;
+
+		uint32_t GetCacheMisses() const;
+
 	private:
 		Buffer<uint32_t> _cache;
+		uint32_t _zeroPixelsSize = 0;
+		uint32_t _zeroPixelsHash = FNV1_32A_INIT;
 		uint32_t _cacheHits;
 		uint32_t _cacheMisses;
 	};
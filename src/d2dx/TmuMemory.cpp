@@ -0,0 +1,192 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "TmuMemory.h"
+#include "Types.h"
+
+using namespace d2dx;
+
+_Use_decl_annotations_
+TmuMemory::TmuMemory(
+	uint32_t size) :
+	_size{ size }
+{
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	_osPageSize = systemInfo.dwPageSize;
+
+	assert(!(_osPageSize & (_osPageSize - 1)) && !(size & (_osPageSize - 1)));
+
+	_committedOsPages = Buffer<uint32_t>{ (size / _osPageSize + 31) / 32, true };
+	_writtenPages = Buffer<uint32_t>{ (size / D2DX_TMU_ADDRESS_ALIGNMENT + 31) / 32, true };
+
+	_data = (uint8_t*)VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+
+	if (!_data)
+	{
+		D2DX_FATAL_ERROR("Out of memory.");
+	}
+}
+
+TmuMemory::~TmuMemory() noexcept
+{
+	if (_data)
+	{
+		VirtualFree(_data, 0, MEM_RELEASE);
+	}
+}
+
+_Use_decl_annotations_
+void TmuMemory::Write(
+	uint32_t address,
+	const uint8_t* data,
+	uint32_t size)
+{
+	memcpy(GetWritable(address, size), data, size);
+}
+
+_Use_decl_annotations_
+uint8_t* TmuMemory::GetWritable(
+	uint32_t address,
+	uint32_t size)
+{
+	Commit(address, size);
+
+	if (size > 0)
+	{
+		const uint32_t lastPage = (address + size - 1) / D2DX_TMU_ADDRESS_ALIGNMENT;
+
+		for (uint32_t page = address / D2DX_TMU_ADDRESS_ALIGNMENT; page <= lastPage; ++page)
+		{
+			_writtenPages.items[page >> 5] |= 1U << (page & 31);
+		}
+	}
+
+	return _data + address;
+}
+
+_Use_decl_annotations_
+const uint8_t* TmuMemory::GetReadable(
+	uint32_t address,
+	uint32_t size)
+{
+	/* Committed memory is zero-filled, so reading what was never written works like before. */
+	Commit(address, size);
+	return _data + address;
+}
+
+const uint8_t* TmuMemory::GetData() const noexcept
+{
+	return _data;
+}
+
+uint32_t TmuMemory::GetSize() const noexcept
+{
+	return _size;
+}
+
+_Use_decl_annotations_
+bool TmuMemory::IsWritten(
+	uint32_t address) const noexcept
+{
+	assert(address < _size);
+	const uint32_t page = address / D2DX_TMU_ADDRESS_ALIGNMENT;
+	return (_writtenPages.items[page >> 5] & (1U << (page & 31))) != 0;
+}
+
+_Use_decl_annotations_
+bool TmuMemory::IsAnyWritten(
+	uint32_t address,
+	uint32_t size) const noexcept
+{
+	assert(address <= _size && size <= (_size - address));
+
+	if (size == 0 || address >= _size)
+	{
+		return false;
+	}
+
+	const uint32_t lastPage = (min(address + size, _size) - 1) / D2DX_TMU_ADDRESS_ALIGNMENT;
+
+	for (uint32_t page = address / D2DX_TMU_ADDRESS_ALIGNMENT; page <= lastPage; ++page)
+	{
+		if (_writtenPages.items[page >> 5] & (1U << (page & 31)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint64_t TmuMemory::GetCommittedBytes() const noexcept
+{
+	return _committedBytes;
+}
+
+_Use_decl_annotations_
+void TmuMemory::Commit(
+	uint32_t address,
+	uint32_t size)
+{
+	assert(address <= _size && size <= (_size - address));
+
+	if (size == 0 || address >= _size)
+	{
+		return;
+	}
+
+	size = min(size, _size - address);
+
+	const uint32_t firstOsPage = address / _osPageSize;
+	const uint32_t lastOsPage = (address + size - 1) / _osPageSize;
+
+	uint32_t osPage = firstOsPage;
+
+	while (osPage <= lastOsPage)
+	{
+		if (_committedOsPages.items[osPage >> 5] & (1U << (osPage & 31)))
+		{
+			++osPage;
+			continue;
+		}
+
+		/* Commit the whole run of uncommitted pages with one call. */
+		uint32_t runEnd = osPage + 1;
+
+		while (runEnd <= lastOsPage && !(_committedOsPages.items[runEnd >> 5] & (1U << (runEnd & 31))))
+		{
+			++runEnd;
+		}
+
+		const uint32_t runSize = (runEnd - osPage) * _osPageSize;
+
+		if (!VirtualAlloc(_data + osPage * _osPageSize, runSize, MEM_COMMIT, PAGE_READWRITE))
+		{
+			D2DX_FATAL_ERROR("Out of memory.");
+		}
+
+		_committedBytes += runSize;
+
+		for (; osPage < runEnd; ++osPage)
+		{
+			_committedOsPages.items[osPage >> 5] |= 1U << (osPage & 31);
+		}
+	}
+}
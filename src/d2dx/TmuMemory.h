@@ -0,0 +1,87 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+
+namespace d2dx
+{
+	/*
+		Shadow copy of the texture memory of a TMU.
+
+		The game only uses a small part of the 16 MB address space, so the memory is reserved up front and
+		committed one OS page at a time, as it is touched. Memory that hasn't been written reads as zero.
+
+		Also tracks which 256-byte pages (the TMU address alignment) have been written to.
+	*/
+	class TmuMemory final
+	{
+	public:
+		TmuMemory(
+			_In_ uint32_t size);
+
+		~TmuMemory() noexcept;
+
+		TmuMemory(const TmuMemory&) = delete;
+		TmuMemory& operator=(const TmuMemory&) = delete;
+
+		void Write(
+			_In_ uint32_t address,
+			_In_reads_(size) const uint8_t* data,
+			_In_ uint32_t size);
+
+		/* Returns size bytes at address for writing in place. They are marked as written. */
+		uint8_t* GetWritable(
+			_In_ uint32_t address,
+			_In_ uint32_t size);
+
+		/* Returns size bytes at address for reading. The memory stays readable until destruction. */
+		const uint8_t* GetReadable(
+			_In_ uint32_t address,
+			_In_ uint32_t size);
+
+		/* The base of the whole address space. Only the ranges returned by GetWritable/GetReadable may be
+		   accessed through it. */
+		const uint8_t* GetData() const noexcept;
+
+		uint32_t GetSize() const noexcept;
+
+		bool IsWritten(
+			_In_ uint32_t address) const noexcept;
+
+		/* Returns true if any of the size bytes at address have been written. */
+		bool IsAnyWritten(
+			_In_ uint32_t address,
+			_In_ uint32_t size) const noexcept;
+
+		uint64_t GetCommittedBytes() const noexcept;
+
+	private:
+		void Commit(
+			_In_ uint32_t address,
+			_In_ uint32_t size);
+
+		uint8_t* _data = nullptr;
+		uint32_t _size = 0;
+		uint32_t _osPageSize = 0;
+		Buffer<uint32_t> _committedOsPages;
+		Buffer<uint32_t> _writtenPages;
+		uint64_t _committedBytes = 0;
+	};
+}
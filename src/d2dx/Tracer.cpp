@@ -0,0 +1,254 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "Tracer.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+std::atomic<Tracer*> Tracer::_instance{ nullptr };
+
+static std::atomic<uint32_t> nextTracerId{ 1 };
+
+/* Tracers are identified by id rather than address, since a new tracer may reuse the address of an old one. */
+static thread_local uint32_t threadBufferTracerId = 0;
+static thread_local void* threadBuffer = nullptr;
+
+_Use_decl_annotations_
+Tracer::Tracer(
+	const std::shared_ptr<IClock>& clock,
+	uint32_t eventsPerThread) :
+	_clock{ clock },
+	_eventsPerThread{ eventsPerThread },
+	_id{ nextTracerId.fetch_add(1) },
+	_isRecording{ false },
+	_threadBuffers{ MaxThreads, true }
+{
+}
+
+Tracer::~Tracer() noexcept
+{
+	Tracer* self = this;
+	_instance.compare_exchange_strong(self, nullptr);
+
+	for (uint32_t i = 0; i < _threadBufferCount; ++i)
+	{
+		delete _threadBuffers.items[i];
+	}
+}
+
+_Use_decl_annotations_
+void Tracer::SetFrameRange(
+	uint64_t firstFrame,
+	uint64_t lastFrame)
+{
+	_firstFrame = firstFrame;
+	_lastFrame = max(firstFrame, lastFrame);
+}
+
+_Use_decl_annotations_
+bool Tracer::OnNewFrame(
+	uint64_t frame)
+{
+	if (frame == _firstFrame)
+	{
+		std::lock_guard<std::mutex> lock{ _threadBuffersMutex };
+
+		for (uint32_t i = 0; i < _threadBufferCount; ++i)
+		{
+			_threadBuffers.items[i]->count = 0;
+		}
+
+		_startTimeUs = _clock->GetTimeUs();
+		_isRecording.store(true, std::memory_order_release);
+	}
+	else if (frame == _lastFrame + 1 && IsRecording())
+	{
+		_isRecording.store(false, std::memory_order_release);
+		return true;
+	}
+
+	return false;
+}
+
+bool Tracer::IsRecording() const noexcept
+{
+	return _isRecording.load(std::memory_order_acquire);
+}
+
+_Use_decl_annotations_
+bool Tracer::Begin(
+	const char* name) noexcept
+{
+	if (!IsRecording())
+	{
+		return false;
+	}
+
+	ThreadBuffer* buffer = GetThreadBuffer();
+
+	/* Leave room for the end event. */
+	if (!buffer || buffer->count + 1 >= buffer->events.capacity)
+	{
+		return false;
+	}
+
+	Record(name, true);
+	return true;
+}
+
+_Use_decl_annotations_
+void Tracer::End(
+	const char* name) noexcept
+{
+	/* Recorded even if recording has stopped since the begin event, to keep the pair. */
+	Record(name, false);
+}
+
+_Use_decl_annotations_
+void Tracer::Record(
+	const char* name,
+	bool isBegin) noexcept
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+
+	if (!buffer || buffer->count >= buffer->events.capacity)
+	{
+		return;
+	}
+
+	Event& event = buffer->events.items[buffer->count++];
+	event.name = name;
+	event.timeUs = _clock->GetTimeUs() - _startTimeUs;
+	event.isBegin = isBegin;
+}
+
+Tracer::ThreadBuffer* Tracer::GetThreadBuffer() noexcept
+{
+	if (threadBufferTracerId == _id)
+	{
+		return (ThreadBuffer*)threadBuffer;
+	}
+
+	std::lock_guard<std::mutex> lock{ _threadBuffersMutex };
+
+	ThreadBuffer* buffer = _threadBufferCount < MaxThreads ? new (std::nothrow) ThreadBuffer(_eventsPerThread) : nullptr;
+
+	if (buffer)
+	{
+		_threadBuffers.items[_threadBufferCount++] = buffer;
+	}
+
+	/* A thread that didn't get a buffer doesn't ask again. */
+	threadBuffer = buffer;
+	threadBufferTracerId = _id;
+	return buffer;
+}
+
+_Use_decl_annotations_
+void Tracer::Write(
+	FILE* file) const
+{
+	std::lock_guard<std::mutex> lock{ _threadBuffersMutex };
+
+	Buffer<const Event*> stack{ _eventsPerThread };
+	bool isFirst = true;
+
+	fprintf(file, "{\"traceEvents\":[");
+
+	auto writeEvent = [&](const char* name, bool isBegin, int64_t timeUs, uint32_t threadId) {
+		fprintf(file, "%s\n{\"name\":\"", isFirst ? "" : ",");
+		isFirst = false;
+
+		for (const char* c = name; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				fputc('\\', file);
+			}
+			fputc(*c, file);
+		}
+
+		fprintf(file, "\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":1,\"tid\":%u}", isBegin ? 'B' : 'E', (long long)timeUs, threadId);
+	};
+
+	for (uint32_t threadIndex = 0; threadIndex < _threadBufferCount; ++threadIndex)
+	{
+		const ThreadBuffer& buffer = *_threadBuffers.items[threadIndex];
+		const uint32_t threadId = threadIndex + 1;
+		uint32_t depth = 0;
+		int64_t lastTimeUs = 0;
+
+		for (uint32_t i = 0; i < buffer.count; ++i)
+		{
+			const Event& event = buffer.events.items[i];
+			lastTimeUs = event.timeUs;
+
+			if (event.isBegin)
+			{
+				stack.items[depth++] = &event;
+			}
+			else if (depth > 0 && !strcmp(stack.items[depth - 1]->name, event.name))
+			{
+				--depth;
+			}
+			else
+			{
+				/* Begun before recording started. */
+				continue;
+			}
+
+			writeEvent(event.name, event.isBegin, event.timeUs, threadId);
+		}
+
+		/* Still open when recording stopped. */
+		while (depth > 0)
+		{
+			writeEvent(stack.items[--depth]->name, false, lastTimeUs, threadId);
+		}
+	}
+
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+}
+
+_Use_decl_annotations_
+bool Tracer::Export(
+	const char* path) const
+{
+	FILE* file = nullptr;
+
+	if (fopen_s(&file, path, "w") != 0 || !file)
+	{
+		D2DX_LOG("Failed to open %s for writing the trace.", path);
+		return false;
+	}
+
+	Write(file);
+	fclose(file);
+
+	D2DX_LOG("Wrote trace of frames %llu to %llu to %s.", _firstFrame, _lastFrame, path);
+	return true;
+}
+
+_Use_decl_annotations_
+void Tracer::SetInstance(
+	Tracer* tracer) noexcept
+{
+	_instance.store(tracer, std::memory_order_release);
+}
@@ -0,0 +1,164 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "Buffer.h"
+#include "IClock.h"
+
+namespace d2dx
+{
+	/*
+		Records begin/end events of scoped trace markers for a range of frames, and writes them in the Chrome
+		trace event format (load the file in chrome://tracing or ui.perfetto.dev).
+
+		Each thread records into its own fixed-size buffer, so recording never locks or allocates, except
+		when a thread records its first event. Events that don't fit are dropped, as are events from more
+		than MaxThreads threads. The output is always well formed: unmatched end events are skipped,
+		and unmatched begin events are closed at the end.
+
+		The D2DX_TRACE_SCOPE markers compile to nothing unless D2DX_TRACE is defined, as it is in the Profile
+		build configuration. In such a build, set traceframes=[first,last] in the [debug] section of d2dx.cfg
+		to write d2dx_trace.json.
+	*/
+	class Tracer final
+	{
+	public:
+		static constexpr uint32_t MaxThreads = 16;
+
+		Tracer(
+			_In_ const std::shared_ptr<IClock>& clock,
+			_In_ uint32_t eventsPerThread);
+
+		~Tracer() noexcept;
+
+		Tracer(const Tracer&) = delete;
+		Tracer& operator=(const Tracer&) = delete;
+
+		/* Frames are numbered by the caller of OnNewFrame. The range is inclusive. */
+		void SetFrameRange(
+			_In_ uint64_t firstFrame,
+			_In_ uint64_t lastFrame);
+
+		/* Call when a new frame starts. Returns true when the last frame of the range has been recorded. */
+		bool OnNewFrame(
+			_In_ uint64_t frame);
+
+		bool IsRecording() const noexcept;
+
+		/* Returns false if the event was not recorded; then End must not be called. */
+		bool Begin(
+			_In_z_ const char* name) noexcept;
+
+		void End(
+			_In_z_ const char* name) noexcept;
+
+		/* Must not be called while other threads are recording. */
+		void Write(
+			_In_ FILE* file) const;
+
+		bool Export(
+			_In_z_ const char* path) const;
+
+		/* The tracer that D2DX_TRACE_SCOPE markers record to, or null. */
+		static void SetInstance(
+			_In_opt_ Tracer* tracer) noexcept;
+
+		static Tracer* GetInstance() noexcept
+		{
+			return _instance.load(std::memory_order_acquire);
+		}
+
+	private:
+		struct Event final
+		{
+			const char* name;
+			int64_t timeUs;
+			bool isBegin;
+		};
+
+		struct ThreadBuffer final
+		{
+			ThreadBuffer(
+				_In_ uint32_t capacity) :
+				events{ capacity }
+			{
+			}
+
+			Buffer<Event> events;
+			uint32_t count = 0;
+		};
+
+		static std::atomic<Tracer*> _instance;
+
+		ThreadBuffer* GetThreadBuffer() noexcept;
+
+		void Record(
+			_In_z_ const char* name,
+			_In_ bool isBegin) noexcept;
+
+		std::shared_ptr<IClock> _clock;
+		uint32_t _eventsPerThread;
+		uint32_t _id;
+		uint64_t _firstFrame = 0;
+		uint64_t _lastFrame = 0;
+		int64_t _startTimeUs = 0;
+		std::atomic<bool> _isRecording;
+		mutable std::mutex _threadBuffersMutex;
+		Buffer<ThreadBuffer*> _threadBuffers;
+		uint32_t _threadBufferCount = 0;
+	};
+
+	class TraceScope final
+	{
+	public:
+		TraceScope(
+			_In_z_ const char* name) noexcept
+		{
+			Tracer* tracer = Tracer::GetInstance();
+			if (tracer && tracer->Begin(name))
+			{
+				_tracer = tracer;
+				_name = name;
+			}
+		}
+
+		~TraceScope() noexcept
+		{
+			if (_tracer)
+			{
+				_tracer->End(_name);
+			}
+		}
+
+		TraceScope(const TraceScope&) = delete;
+		TraceScope& operator=(const TraceScope&) = delete;
+
+	private:
+		Tracer* _tracer = nullptr;
+		const char* _name = nullptr;
+	};
+}
+
+#ifdef D2DX_TRACE
+#define D2DX_TRACE_CONCAT_INNER(a, b) a##b
+#define D2DX_TRACE_CONCAT(a, b) D2DX_TRACE_CONCAT_INNER(a, b)
+#define D2DX_TRACE_SCOPE(name) d2dx::TraceScope D2DX_TRACE_CONCAT(traceScope, __LINE__){ name }
+#else
+#define D2DX_TRACE_SCOPE(name)
+#endif
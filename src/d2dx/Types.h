@@ -23,6 +23,9 @@
 #define D2DX_SIDE_TMU_MEMORY_SIZE (1 * 1024 * 1024)
 #define D2DX_MAX_BATCHES_PER_FRAME 16384
 #define D2DX_MAX_VERTICES_PER_FRAME (1024 * 1024)
+#define D2DX_BATCH_ARENA_CHUNK_SIZE 1024
+#define D2DX_VERTEX_ARENA_CHUNK_SIZE (64 * 1024)
+#define D2DX_TEXTURE_CACHE_COUNT 7
 
 #define D2DX_MAX_GAME_PALETTES 14
 #define D2DX_WHITE_PALETTE_INDEX 14
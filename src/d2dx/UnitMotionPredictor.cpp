@@ -22,14 +22,33 @@
 using namespace d2dx;
 using namespace DirectX;
 
+/* Converts a distance in world units to screen pixels. */
+static OffsetF WorldToScreen(
+	_In_ OffsetF offset)
+{
+	const OffsetF scaleFactors{ 32.0f / sqrtf(2.0f), 16.0f / sqrtf(2.0f) };
+	return scaleFactors * OffsetF{ offset.x - offset.y, offset.x + offset.y };
+}
+
 _Use_decl_annotations_
 UnitMotionPredictor::UnitMotionPredictor(
-	const std::shared_ptr<IGameHelper>& gameHelper) :
+	const std::shared_ptr<IGameHelper>& gameHelper,
+	const MotionPredictionSettings& settings) :
 	_gameHelper{ gameHelper },
-	_unitIdAndTypes{ 1024, true },
-	_unitMotions{ 1024, true },
-	_unitScreenPositions{ 1024, true }
+	_settings{ settings },
+	_units{ 1024 }
+{
+}
+
+_Use_decl_annotations_
+void UnitMotionPredictor::OnGameStateChanged(
+	const GameStateSnapshot& gameState)
 {
+	/* Unit ids are reused between games. */
+	if (gameState.HasChanged(GameStateChange::InGame))
+	{
+		_units.Clear();
+	}
 }
 
 _Use_decl_annotations_
@@ -37,217 +56,264 @@ void UnitMotionPredictor::Update(
 	IRenderContext* renderContext)
 {
 	const int32_t dt = renderContext->GetFrameTimeFp();
-	int32_t expiredUnitIndex = -1;
 
-	for (int32_t i = 0; i < _unitsCount; ++i)
+	/* Iterate backwards, since erasing moves the last unit into the erased position. */
+	for (int32_t i = (int32_t)_units.GetCount() - 1; i >= 0; --i)
 	{
-		UnitIdAndType& uiat = _unitIdAndTypes.items[i];
-
-		if (!uiat.unitId)
-		{
-			expiredUnitIndex = i;
-			continue;
-		}
-
-		auto unit = _gameHelper->FindUnit(uiat.unitId, (D2::UnitType)uiat.unitType);
+		const uint64_t key = _units.GetKeyAt(i);
+		auto unit = _gameHelper->FindUnit((uint32_t)key, (D2::UnitType)(key >> 32));
 
 		if (!unit)
 		{
-			uiat.unitId = 0;
-			expiredUnitIndex = i;
+			_units.EraseAt(i);
 			continue;
 		}
 
-		UnitMotion& um = _unitMotions.items[i];
-		const Offset pos = _gameHelper->GetUnitPos(unit);
-
-		Offset posWhole{ pos.x >> 16, pos.y >> 16 };
-		Offset lastPosWhole{ um.lastPos.x >> 16, um.lastPos.y >> 16 };
-		Offset predictedPosWhole{ um.predictedPos.x >> 16, um.predictedPos.y >> 16 };
-
-		int32_t lastPosMd = max(abs(posWhole.x - lastPosWhole.x), abs(posWhole.y - lastPosWhole.y));
-		int32_t predictedPosMd = max(abs(posWhole.x - predictedPosWhole.x), abs(posWhole.y - predictedPosWhole.y));
+		_units.GetAt(i).motion.Update(_gameHelper->GetUnitPos(unit), dt, _settings);
+	}
 
-		if (lastPosMd > 2 || predictedPosMd > 2)
-		{
-			um.predictedPos = pos;
-			um.correctedPos = pos;
-			um.lastPos = pos;
-			um.velocity = { 0,0 };
-		}
+	++_frame;
+}
 
-		const int32_t dx = pos.x - um.lastPos.x;
-		const int32_t dy = pos.y - um.lastPos.y;
+_Use_decl_annotations_
+Offset UnitMotionPredictor::GetOffset(
+	const D2::UnitAny* unit)
+{
+	const uint64_t key = GetUnitKey(unit);
+	TrackedUnit* trackedUnit = _units.Find(key);
 
-		um.dtLastPosChange += dt;
+	if (!trackedUnit)
+	{
+		trackedUnit = _units.Get(_units.Insert(key, { }));
+	}
 
-		if (dx != 0 || dy != 0 || um.dtLastPosChange >= (65536 / 25))
-		{
-			um.correctedPos.x = ((int64_t)pos.x + um.lastPos.x) >> 1;
-			um.correctedPos.y = ((int64_t)pos.y + um.lastPos.y) >> 1;
-			//D2DX_DEBUG_LOG("Server %f %f", pos.x / 65536.0f, pos.y / 65536.0f);
+	trackedUnit->motion.lastUsedFrame = _frame;
+	return trackedUnit->motion.GetOffset();
+}
 
-			um.velocity.x = 25 * dx;
-			um.velocity.y = 25 * dy;
+_Use_decl_annotations_
+OffsetF UnitMotionPredictor::GetScreenVelocity(
+	const D2::UnitAny* unit)
+{
+	const TrackedUnit* trackedUnit = _units.Find(GetUnitKey(unit));
+	return trackedUnit ? trackedUnit->motion.GetScreenVelocity() : OffsetF{ 0.0f, 0.0f };
+}
 
-			um.lastPos = pos;
-			um.dtLastPosChange = 0;
-		}
+_Use_decl_annotations_
+void UnitMotionPredictor::SetUnitScreenPos(
+	const D2::UnitAny* unit,
+	int32_t x,
+	int32_t y)
+{
+	TrackedUnit* trackedUnit = _units.Find(GetUnitKey(unit));
 
-		if (um.velocity.x != 0 || um.velocity.y != 0)
-		{
-			if (um.dtLastPosChange < (65536 / 25))
-			{
-				Offset vStep{
-					(int32_t)(((int64_t)dt * um.velocity.x) >> 16),
-					(int32_t)(((int64_t)dt * um.velocity.y) >> 16) };
-
-				const int32_t correctionAmount = 7000;
-				const int32_t oneMinusCorrectionAmount = 65536 - correctionAmount;
-
-				um.predictedPos.x = (int32_t)(((int64_t)um.predictedPos.x * oneMinusCorrectionAmount + (int64_t)um.correctedPos.x * correctionAmount) >> 16);
-				um.predictedPos.y = (int32_t)(((int64_t)um.predictedPos.y * oneMinusCorrectionAmount + (int64_t)um.correctedPos.y * correctionAmount) >> 16);
-				//D2DX_DEBUG_LOG("Predicted %f %f", um.predictedPos.x / 65536.0f, um.predictedPos.y / 65536.0f);
-
-			/*	int32_t ex = um.correctedPos.x - um.predictedPos.x;
-				int32_t ey = um.correctedPos.y - um.predictedPos.y;
-
-				if (unit->dwType == D2::UnitType::Player && (ex != 0 || ey != 0))
-				{
-					D2DX_DEBUG_LOG("%f, %f, %f, %f, %f, %f, %f, %f",
-						pos.x / 65536.0f,
-						pos.y / 65536.0f,
-						um.correctedPos.x / 65536.0f,
-						um.correctedPos.y / 65536.0f,
-						um.predictedPos.x / 65536.0f,
-						um.predictedPos.y / 65536.0f,
-						ex / 65536.0f,
-						ey / 65536.0f);
-				}*/
-
-				um.predictedPos.x += vStep.x;
-				um.predictedPos.y += vStep.y;
-
-				um.correctedPos.x += vStep.x;
-				um.correctedPos.y += vStep.y;
-			}
-		}
+	if (trackedUnit)
+	{
+		trackedUnit->screenPos = { x, y };
 	}
+}
 
-	// Gradually (one change per frame) compact the unit list.
-	if (_unitsCount > 1)
+_Use_decl_annotations_
+Offset UnitMotionPredictor::GetOffsetForShadow(
+	_In_ int32_t x,
+	_In_ int32_t y)
+{
+	for (uint32_t i = 0; i < _units.GetCount(); ++i)
 	{
-		if (!_unitIdAndTypes.items[_unitsCount - 1].unitId)
-		{
-			// The last entry is expired. Shrink the list.
-			_unitMotions.items[_unitsCount - 1] = { };
-			--_unitsCount;
-		}
-		else if (expiredUnitIndex >= 0 && expiredUnitIndex < (_unitsCount - 1))
+		const TrackedUnit& trackedUnit = _units.GetAt(i);
+		const int32_t dist = max(abs(trackedUnit.screenPos.x - x), abs(trackedUnit.screenPos.y - y));
+
+		if (dist < 8)
 		{
-			// Some entry is expired. Move the last entry to that place, and shrink the list.
-			_unitIdAndTypes.items[expiredUnitIndex] = _unitIdAndTypes.items[_unitsCount - 1];
-			_unitMotions.items[expiredUnitIndex] = _unitMotions.items[_unitsCount - 1];
-			_unitIdAndTypes.items[_unitsCount - 1] = { 0,0 };
-			_unitMotions.items[_unitsCount - 1] = { };
-			--_unitsCount;
+			return trackedUnit.motion.GetOffset();
 		}
 	}
 
-	++_frame;
+	return { 0, 0 };
 }
 
 _Use_decl_annotations_
-Offset UnitMotionPredictor::GetOffset(
-	const D2::UnitAny* unit)
+uint64_t UnitMotionPredictor::GetUnitKey(
+	const D2::UnitAny* unit) const
 {
-	int32_t unitIndex = -1;
+	return ((uint64_t)_gameHelper->GetUnitType(unit) << 32) | _gameHelper->GetUnitId(unit);
+}
 
-	auto unitId = _gameHelper->GetUnitId(unit);
-	auto unitType = _gameHelper->GetUnitType(unit);
+Offset UnitMotionPredictor::UnitMotion::GetOffset() const
+{
+	const OffsetF offset{ (predictedPos.x - lastPos.x) / 65536.0f, (predictedPos.y - lastPos.y) / 65536.0f };
+	const OffsetF screenOffset = WorldToScreen(offset) + 0.5f;
+	return { (int32_t)screenOffset.x, (int32_t)screenOffset.y };
+}
+
+OffsetF UnitMotionPredictor::UnitMotion::GetScreenVelocity() const
+{
+	/* The velocity is in world units (16.16) per second. */
+	return WorldToScreen({ velocity.x / 65536.0f, velocity.y / 65536.0f });
+}
+
+_Use_decl_annotations_
+void UnitMotionPredictor::UnitMotion::Update(
+	Offset pos,
+	int32_t dt,
+	const MotionPredictionSettings& settings)
+{
+	Offset posWhole{ pos.x >> 16, pos.y >> 16 };
+	Offset lastPosWhole{ lastPos.x >> 16, lastPos.y >> 16 };
+	Offset predictedPosWhole{ predictedPos.x >> 16, predictedPos.y >> 16 };
+
+	int32_t lastPosMd = max(abs(posWhole.x - lastPosWhole.x), abs(posWhole.y - lastPosWhole.y));
+	int32_t predictedPosMd = max(abs(posWhole.x - predictedPosWhole.x), abs(posWhole.y - predictedPosWhole.y));
 
-	for (int32_t i = 0; i < _unitsCount; ++i)
+	if (lastPosMd > 2 || predictedPosMd > 2)
 	{
-		if (_unitIdAndTypes.items[i].unitId == (uint16_t)unitId &&
-			_unitIdAndTypes.items[i].unitType == (uint16_t)unitType)
-		{
-			_unitMotions.items[i].lastUsedFrame = _frame;
-			unitIndex = i;
-			break;
-		}
+		predictedPos = pos;
+		correctedPos = pos;
+		lastPos = pos;
+		velocity = { 0,0 };
+		acceleration = { 0,0 };
 	}
 
-	if (unitIndex < 0)
+	if (settings.mode == MotionPredictionMode::AlphaBetaGamma)
 	{
-		if (_unitsCount < (int32_t)_unitIdAndTypes.capacity)
-		{
-			unitIndex = _unitsCount++;
-			_unitIdAndTypes.items[unitIndex].unitId = (uint16_t)unitId;
-			_unitIdAndTypes.items[unitIndex].unitType = (uint16_t)unitType;
-			_unitMotions.items[unitIndex] = { };
-			_unitMotions.items[unitIndex].lastUsedFrame = _frame;
-		}
-		else
-		{
-			D2DX_DEBUG_LOG("UMP: Too many units.");
-		}
+		UpdateAlphaBetaGamma(pos, dt, settings);
 	}
-
-	if (unitIndex < 0)
+	else
 	{
-		return { 0, 0 };
+		UpdateBlend(pos, dt);
 	}
-
-	return _unitMotions.items[unitIndex].GetOffset();
 }
 
 _Use_decl_annotations_
-void UnitMotionPredictor::SetUnitScreenPos(
-	const D2::UnitAny* unit,
-	int32_t x,
-	int32_t y)
+void UnitMotionPredictor::UnitMotion::UpdateBlend(
+	Offset pos,
+	int32_t dt)
 {
-	auto unitId = _gameHelper->GetUnitId(unit);
-	auto unitType = _gameHelper->GetUnitType(unit);
+	const int32_t dx = pos.x - lastPos.x;
+	const int32_t dy = pos.y - lastPos.y;
 
-	for (int32_t unitIndex = 0; unitIndex < _unitsCount; ++unitIndex)
+	dtLastPosChange += dt;
+
+	if (dx != 0 || dy != 0 || dtLastPosChange >= (65536 / 25))
 	{
-		if (_unitIdAndTypes.items[unitIndex].unitId == (uint16_t)unitId &&
-			_unitIdAndTypes.items[unitIndex].unitType == (uint16_t)unitType)
+		correctedPos.x = ((int64_t)pos.x + lastPos.x) >> 1;
+		correctedPos.y = ((int64_t)pos.y + lastPos.y) >> 1;
+		//D2DX_DEBUG_LOG("Server %f %f", pos.x / 65536.0f, pos.y / 65536.0f);
+
+		velocity.x = 25 * dx;
+		velocity.y = 25 * dy;
+
+		lastPos = pos;
+		dtLastPosChange = 0;
+	}
+
+	if (velocity.x != 0 || velocity.y != 0)
+	{
+		if (dtLastPosChange < (65536 / 25))
 		{
-			_unitScreenPositions.items[unitIndex] = { x, y };
-			break;
+			Offset vStep{
+				(int32_t)(((int64_t)dt * velocity.x) >> 16),
+				(int32_t)(((int64_t)dt * velocity.y) >> 16) };
+
+			const int32_t correctionAmount = 7000;
+			const int32_t oneMinusCorrectionAmount = 65536 - correctionAmount;
+
+			predictedPos.x = (int32_t)(((int64_t)predictedPos.x * oneMinusCorrectionAmount + (int64_t)correctedPos.x * correctionAmount) >> 16);
+			predictedPos.y = (int32_t)(((int64_t)predictedPos.y * oneMinusCorrectionAmount + (int64_t)correctedPos.y * correctionAmount) >> 16);
+			//D2DX_DEBUG_LOG("Predicted %f %f", predictedPos.x / 65536.0f, predictedPos.y / 65536.0f);
+
+		/*	int32_t ex = correctedPos.x - predictedPos.x;
+			int32_t ey = correctedPos.y - predictedPos.y;
+
+			if (unit->dwType == D2::UnitType::Player && (ex != 0 || ey != 0))
+			{
+				D2DX_DEBUG_LOG("%f, %f, %f, %f, %f, %f, %f, %f",
+					pos.x / 65536.0f,
+					pos.y / 65536.0f,
+					correctedPos.x / 65536.0f,
+					correctedPos.y / 65536.0f,
+					predictedPos.x / 65536.0f,
+					predictedPos.y / 65536.0f,
+					ex / 65536.0f,
+					ey / 65536.0f);
+			}*/
+
+			predictedPos.x += vStep.x;
+			predictedPos.y += vStep.y;
+
+			correctedPos.x += vStep.x;
+			correctedPos.y += vStep.y;
 		}
 	}
 }
 
 _Use_decl_annotations_
-Offset UnitMotionPredictor::GetOffsetForShadow(
-	_In_ int32_t x,
-	_In_ int32_t y)
+void UnitMotionPredictor::UnitMotion::UpdateAlphaBetaGamma(
+	Offset pos,
+	int32_t dt,
+	const MotionPredictionSettings& settings)
 {
-	for (int32_t i = 0; i < _unitsCount; ++i)
+	/* Extrapolate from the current estimate, but stop a bounded distance past the point where
+	   the next game tick was expected. This limits overshoot when a unit stops or turns. */
+	const int64_t horizon = (int64_t)(tickPeriod * (1.0f + settings.maxOvershoot));
+	const int64_t predictDt = max((int64_t)0, min((int64_t)dt, horizon - dtLastPosChange));
+
+	if (predictDt > 0)
 	{
-		if (!_unitIdAndTypes.items[i].unitId)
-		{
-			continue;
-		}
+		const int64_t halfPredictDtSquared = (predictDt * predictDt) >> 17;
 
-		const int32_t dist = max(abs(_unitScreenPositions.items[i].x - x), abs(_unitScreenPositions.items[i].y - y));
+		predictedPos.x += (int32_t)(((int64_t)velocity.x * predictDt + (int64_t)acceleration.x * halfPredictDtSquared) >> 16);
+		predictedPos.y += (int32_t)(((int64_t)velocity.y * predictDt + (int64_t)acceleration.y * halfPredictDtSquared) >> 16);
 
-		if (dist < 8)
+		velocity.x += (int32_t)(((int64_t)acceleration.x * predictDt) >> 16);
+		velocity.y += (int32_t)(((int64_t)acceleration.y * predictDt) >> 16);
+	}
+
+	dtLastPosChange += dt;
+
+	if (pos.x != lastPos.x || pos.y != lastPos.y)
+	{
+		/* Measure the game tick rate from the intervals between observed position changes,
+		   ignoring intervals that span dropped or coalesced ticks. */
+		const int64_t t = max((int64_t)(tickPeriod / 2), min(dtLastPosChange, (int64_t)tickPeriod * 2));
+
+		if (t == dtLastPosChange)
 		{
-			return _unitMotions.items[i].GetOffset();
+			tickPeriod += (int32_t)((dtLastPosChange - tickPeriod) / 8);
 		}
+
+		const Offset residual{ pos.x - predictedPos.x, pos.y - predictedPos.y };
+
+		predictedPos.x += (int32_t)(settings.alpha * residual.x);
+		predictedPos.y += (int32_t)(settings.alpha * residual.y);
+
+		velocity.x += (int32_t)(settings.beta * (float)((int64_t)residual.x * 65536 / t));
+		velocity.y += (int32_t)(settings.beta * (float)((int64_t)residual.y * 65536 / t));
+
+		acceleration.x += (int32_t)(2.0f * settings.gamma * (float)((int64_t)residual.x * 65536 * 65536 / (t * t)));
+		acceleration.y += (int32_t)(2.0f * settings.gamma * (float)((int64_t)residual.y * 65536 * 65536 / (t * t)));
+
+		lastPos = pos;
+		dtLastPosChange = 0;
+	}
+	else if (dtLastPosChange >= (int64_t)tickPeriod * 2)
+	{
+		/* No movement for a couple of ticks: the unit has stopped. */
+		velocity = { 0, 0 };
+		acceleration = { 0, 0 };
 	}
 
-	return { 0, 0 };
+	if (velocity.x == 0 && velocity.y == 0 && acceleration.x == 0 && acceleration.y == 0)
+	{
+		/* Settle onto the last known position at a rate independent of the frame rate. */
+		const int64_t settleAmount = min((int64_t)65536, (int64_t)(settings.alpha * 65536.0f) * dt / tickPeriod);
+
+		predictedPos.x += (int32_t)(((int64_t)(lastPos.x - predictedPos.x) * settleAmount) >> 16);
+		predictedPos.y += (int32_t)(((int64_t)(lastPos.y - predictedPos.y) * settleAmount) >> 16);
+	}
 }
 
-Offset UnitMotionPredictor::UnitMotion::GetOffset() const
+uint32_t UnitMotionPredictor::GetTrackedCount() const
 {
-	const OffsetF offset{ (predictedPos.x - lastPos.x) / 65536.0f, (predictedPos.y - lastPos.y) / 65536.0f };
-	const OffsetF scaleFactors{ 32.0f / sqrtf(2.0f), 16.0f / sqrtf(2.0f) };
-	const OffsetF screenOffset = scaleFactors * OffsetF{ offset.x - offset.y, offset.x + offset.y } + 0.5f;
-	return { (int32_t)screenOffset.x, (int32_t)screenOffset.y };
+	return _units.GetCount();
 }
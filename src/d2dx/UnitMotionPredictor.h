@@ -18,16 +18,22 @@
 */
 #pragma once
 
+#include "GameStateSnapshot.h"
 #include "IGameHelper.h"
 #include "IRenderContext.h"
+#include "SlotMap.h"
 
 namespace d2dx
 {
-	class UnitMotionPredictor final
+	class UnitMotionPredictor final : public IGameStateObserver
 	{
 	public:
 		UnitMotionPredictor(
-			_In_ const std::shared_ptr<IGameHelper>& gameHelper);
+			_In_ const std::shared_ptr<IGameHelper>& gameHelper,
+			_In_ const MotionPredictionSettings& settings);
+
+		virtual void OnGameStateChanged(
+			_In_ const GameStateSnapshot& gameState) override;
 
 		void Update(
 			_In_ IRenderContext* renderContext);
@@ -35,6 +41,10 @@ namespace d2dx
 		Offset GetOffset(
 			_In_ const D2::UnitAny* unit);
 
+		/* In screen pixels per second, or zero if the unit isn't tracked. */
+		OffsetF GetScreenVelocity(
+			_In_ const D2::UnitAny* unit);
+
 		void SetUnitScreenPos(
 			_In_ const D2::UnitAny* unit,
 			_In_ int32_t x,
@@ -44,30 +54,52 @@ namespace d2dx
 			_In_ int32_t x,
 			_In_ int32_t y);
 
-	private:
-		struct UnitIdAndType final
-		{
-			uint16_t unitType = 0;
-			uint16_t unitId = 0;
-		};
+		uint32_t GetTrackedCount() const;
 
 		struct UnitMotion final
 		{
+			void Update(
+				_In_ Offset pos,
+				_In_ int32_t dt,
+				_In_ const MotionPredictionSettings& settings);
+
 			Offset GetOffset() const;
 
+			OffsetF GetScreenVelocity() const;
+
 			uint32_t lastUsedFrame = 0;
 			Offset lastPos = { 0, 0 };
 			Offset velocity = { 0, 0 };
+			Offset acceleration = { 0, 0 };
 			Offset predictedPos = { 0, 0 };
 			Offset correctedPos = { 0, 0 };
 			int64_t dtLastPosChange = 0;
+			int32_t tickPeriod = 65536 / 25;
+
+		private:
+			void UpdateBlend(
+				_In_ Offset pos,
+				_In_ int32_t dt);
+
+			void UpdateAlphaBetaGamma(
+				_In_ Offset pos,
+				_In_ int32_t dt,
+				_In_ const MotionPredictionSettings& settings);
 		};
 
+	private:
+		struct TrackedUnit final
+		{
+			UnitMotion motion;
+			Offset screenPos = { 0, 0 };
+		};
+
+		uint64_t GetUnitKey(
+			_In_ const D2::UnitAny* unit) const;
+
 		std::shared_ptr<IGameHelper> _gameHelper;
+		MotionPredictionSettings _settings;
 		uint32_t _frame = 0;
-		Buffer<UnitIdAndType> _unitIdAndTypes;
-		Buffer<UnitMotion> _unitMotions;
-		Buffer<Offset> _unitScreenPositions;
-		int32_t _unitsCount = 0;
+		SlotMap<TrackedUnit> _units;
 	};
 }
@@ -18,9 +18,7 @@
 */
 #include "pch.h"
 #include "Utils.h"
-
-#define STB_IMAGE_WRITE_IMPLEMENTATION 1
-#include "../../thirdparty/stb_image/stb_image_write.h"
+#include "LogQueue.h"
 
 #define POCKETLZMA_LZMA_C_DEFINE
 #include "../../thirdparty/pocketlzma/pocketlzma.hpp"
@@ -111,50 +109,105 @@ WindowsVersion d2dx::GetActualWindowsVersion()
     return windowsVersion;
 }
 
-static bool logFileOpened = false;
-static FILE* logFile = nullptr;
-static CRITICAL_SECTION logFileCS;
-
-static void EnsureLogFileOpened()
+namespace
 {
-    if (!logFileOpened)
+    class LogFileSink final : public ILogSink
     {
-        logFileOpened = true;
-        if (fopen_s(&logFile, "d2dx_log.txt", "w") != 0)
+    public:
+        LogFileSink()
         {
-            logFile = nullptr;
+            if (fopen_s(&_file, "d2dx_log.txt", "w") != 0)
+            {
+                _file = nullptr;
+            }
         }
-        InitializeCriticalSection(&logFileCS);
-    }
+
+        virtual ~LogFileSink() noexcept
+        {
+            if (_file)
+            {
+                fclose(_file);
+            }
+        }
+
+        virtual void Write(
+            _In_reads_(length) const char* text,
+            _In_ uint32_t length) override
+        {
+            OutputDebugStringA(text);
+
+            if (_file)
+            {
+                fwrite(text, length, 1, _file);
+                fflush(_file);
+            }
+        }
+
+    private:
+        FILE* _file = nullptr;
+    };
 }
 
-static DWORD WINAPI WriteToLogFileWorkItemFunc(PVOID pvContext)
+static std::atomic<bool> isLogQueueConstructing{ false };
+
+static LogQueue* CreateLogQueue()
 {
-    char* s = (char*)pvContext;
+    isLogQueueConstructing = true;
 
-    OutputDebugStringA(s);
+    /* Intentionally leaked: the writer thread can't be joined while the DLL is being unloaded. */
+    LogQueue* logQueue = new LogQueue(1024, std::make_shared<LogFileSink>());
 
-    EnterCriticalSection(&logFileCS);
+    isLogQueueConstructing = false;
+    return logQueue;
+}
 
-    if (logFile)
+/* Returns null while the queue is being constructed, so that a fatal error raised from the constructor
+   (e.g. a failed allocation) doesn't re-enter the initialization of the singleton. */
+static LogQueue* GetLogQueue()
+{
+    if (isLogQueueConstructing)
     {
-        fwrite(s, strlen(s), 1, logFile);
-        fflush(logFile);
+        return nullptr;
     }
 
-    LeaveCriticalSection(&logFileCS);
-
-    free(s);
-
-    return 0;
+    static LogQueue* logQueue = CreateLogQueue();
+    return logQueue;
 }
 
 _Use_decl_annotations_
 void d2dx::detail::Log(
     const char* s)
 {
-    EnsureLogFileOpened();
-    QueueUserWorkItem(WriteToLogFileWorkItemFunc, _strdup(s), WT_EXECUTEDEFAULT);
+    LogQueue* logQueue = GetLogQueue();
+
+    if (logQueue)
+    {
+        logQueue->TryPush(s);
+    }
+    else
+    {
+        OutputDebugStringA(s);
+    }
+}
+
+void d2dx::detail::FlushLog()
+{
+    LogQueue* logQueue = GetLogQueue();
+
+    if (logQueue)
+    {
+        logQueue->Flush();
+    }
+}
+
+void d2dx::detail::ShutdownLog()
+{
+    LogQueue* logQueue = GetLogQueue();
+
+    if (logQueue)
+    {
+        logQueue->Stop();
+    }
 }
 
 _Use_decl_annotations_
@@ -241,58 +294,11 @@ void d2dx::detail::FatalError(
     const char* msg) noexcept
 {
     D2DX_LOG("%s", msg);
+    detail::FlushLog();
     MessageBoxA(nullptr, msg, "D2DX Fatal Error", MB_OK | MB_ICONSTOP);
     TerminateProcess(GetCurrentProcess(), -1);
 }
 
-_Use_decl_annotations_
-void d2dx::DumpTexture(
-    uint32_t hash,
-    int32_t w,
-    int32_t h,
-    const uint8_t* pixels,
-    uint32_t pixelsSize,
-    uint32_t textureCategory,
-    const uint32_t* palette)
-{
-    char s[256];
-
-    if (!std::filesystem::exists("dump"))
-    {
-        std::filesystem::create_directory("dump");
-    }
-
-    sprintf_s(s, "dump/%u", textureCategory);
-
-    if (!std::filesystem::exists(s))
-    {
-        std::filesystem::create_directory(s);
-    }
-
-    sprintf_s(s, "dump/%u/%08x.bmp", textureCategory, hash);
-
-    if (std::filesystem::exists(s))
-    {
-        return;
-    }
-
-    Buffer<uint32_t> data(w * h * 4);
-
-    for (int32_t j = 0; j < h; ++j)
-    {
-        for (int32_t i = 0; i < w; ++i)
-        {
-            uint8_t idx = pixels[i + j * w];
-            uint32_t c = palette[idx] | 0xFF000000;
-        
-            c = (c & 0xFF00FF00) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF);
-
-            data.items[i + j * w] = c;
-        }
-    }
-    stbi_write_bmp(s, w, h, 4, data.items);
-}
-
 _Use_decl_annotations_
 bool d2dx::DecompressLZMAToFile(
     const uint8_t* data,
@@ -26,6 +26,13 @@ namespace d2dx
 	namespace detail
 	{
 		__declspec(noinline) void Log(_In_z_ const char* s);
+
+		/* Blocks until all messages logged so far have been written. */
+		void FlushLog();
+
+		/* Writes all pending messages and stops the log writer thread. Messages logged afterwards are
+		   written immediately. */
+		void ShutdownLog();
 	}
 
 	int64_t TimeStart();
@@ -37,7 +44,7 @@ namespace d2dx
 #else
 #define D2DX_DEBUG_LOG(fmt, ...) \
 	{ \
-		static char ss[256]; \
+		char ss[256]; \
 		sprintf_s(ss, fmt "\n", __VA_ARGS__); \
 		d2dx::detail::Log(ss); \
 	}
@@ -45,7 +52,7 @@ namespace d2dx
 
 #define D2DX_LOG(fmt, ...) \
 	{ \
-		static char ssss[256]; \
+		char ssss[256]; \
 		sprintf_s(ssss, fmt "\n", __VA_ARGS__); \
 		d2dx::detail::Log(ssss); \
 	}
@@ -64,15 +71,6 @@ namespace d2dx
 	Buffer<char> ReadTextFile(
 		_In_z_ const char* filename);
 
-	void DumpTexture(
-		_In_ uint32_t hash,
-		_In_ int32_t w,
-		_In_ int32_t h,
-		_In_reads_(pixelsSize) const uint8_t* pixels,
-		_In_ uint32_t pixelsSize,
-		_In_ uint32_t textureCategory,
-		_In_reads_(256) const uint32_t* palette);
-
 	bool DecompressLZMAToFile(
 		_In_reads_(dataSize) const uint8_t* data,
 		_In_ uint32_t dataSize,
@@ -22,19 +22,38 @@
 using namespace d2dx;
 using namespace DirectX;
 
+WeatherMotionPredictor::WeatherMotionPredictor() :
+	_particleMotions{ 512 }
+{
+}
+
 _Use_decl_annotations_
-WeatherMotionPredictor::WeatherMotionPredictor(
-	const std::shared_ptr<IGameHelper>& gameHelper) :
-	_gameHelper{ gameHelper },
-	_particleMotions{ 512, true }
+void WeatherMotionPredictor::OnGameStateChanged(
+	const GameStateSnapshot& gameState)
 {
+	_isGameMenuOpen = gameState.isGameMenuOpen;
+
+	if (gameState.HasChanged(GameStateChange::InGame))
+	{
+		_particleMotions.Clear();
+	}
 }
 
 _Use_decl_annotations_
 void WeatherMotionPredictor::Update(
 	IRenderContext* renderContext)
 {
-	_dt = _gameHelper->IsGameMenuOpen() ? 0.0f : renderContext->GetFrameTime();
+	_dt = _isGameMenuOpen ? 0.0f : renderContext->GetFrameTime();
+
+	/* Iterate backwards, since erasing moves the last particle into the erased position. */
+	for (int32_t i = (int32_t)_particleMotions.GetCount() - 1; i >= 0; --i)
+	{
+		if (abs(_frame - _particleMotions.GetAt(i).lastUsedFrame) > 2)
+		{
+			_particleMotions.EraseAt(i);
+		}
+	}
+
 	++_frame;
 }
 
@@ -43,13 +62,22 @@ OffsetF WeatherMotionPredictor::GetOffset(
 	int32_t particleIndex,
 	OffsetF posFromGame) 
 {
-	ParticleMotion& pm = _particleMotions.items[particleIndex & 511];
+	ParticleMotion* particleMotion = _particleMotions.Find((uint32_t)particleIndex);
+
+	if (!particleMotion)
+	{
+		ParticleMotion newPm;
+		newPm.lastPos = posFromGame;
+		newPm.predictedPos = posFromGame;
+		particleMotion = _particleMotions.Get(_particleMotions.Insert((uint32_t)particleIndex, newPm));
+	}
+
+	ParticleMotion& pm = *particleMotion;
 
 	const OffsetF diff = posFromGame - pm.lastPos;
 	const float error = max(abs(diff.x), abs(diff.y));
 
-	if (abs(_frame - pm.lastUsedFrame) > 2 ||
-		error > 100.0f)
+	if (error > 100.0f)
 	{
 		pm.velocity = { 0.0f, 0.0f };
 		pm.lastPos = posFromGame;
@@ -69,3 +97,8 @@ OffsetF WeatherMotionPredictor::GetOffset(
 
 	return pm.predictedPos - pm.lastPos;
 }
+
+uint32_t WeatherMotionPredictor::GetTrackedCount() const
+{
+	return _particleMotions.GetCount();
+}
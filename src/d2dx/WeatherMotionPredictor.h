@@ -18,17 +18,19 @@
 */
 #pragma once
 
-#include "IGameHelper.h"
+#include "GameStateSnapshot.h"
 #include "IRenderContext.h"
+#include "SlotMap.h"
 
 namespace d2dx
 {
-#pragma once
-	class WeatherMotionPredictor
+	class WeatherMotionPredictor : public IGameStateObserver
 	{
 	public:
-		WeatherMotionPredictor(
-			_In_ const std::shared_ptr<IGameHelper>& gameHelper);
+		WeatherMotionPredictor();
+
+		virtual void OnGameStateChanged(
+			_In_ const GameStateSnapshot& gameState) override;
 
 		void Update(
 			_In_ IRenderContext* renderContext);
@@ -37,6 +39,8 @@ namespace d2dx
 			_In_ int32_t particleIndex,
 			_In_ OffsetF posFromGame);
 
+		uint32_t GetTrackedCount() const;
+
 	private:
 		struct ParticleMotion final
 		{
@@ -46,9 +50,9 @@ namespace d2dx
 			int32_t lastUsedFrame = 0;
 		};
 
-		std::shared_ptr<IGameHelper> _gameHelper;
 		int32_t _frame = 0;
+		bool _isGameMenuOpen = false;
 		float _dt = 0;
-		Buffer<ParticleMotion> _particleMotions;
+		SlotMap<ParticleMotion> _particleMotions;
 	};
 }
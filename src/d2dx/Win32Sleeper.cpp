@@ -0,0 +1,62 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "Win32Sleeper.h"
+#include "Utils.h"
+
+using namespace d2dx;
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+Win32Sleeper::Win32Sleeper()
+{
+	_timer.Attach(CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS));
+
+	if (!_timer.IsValid())
+	{
+		D2DX_LOG("High-resolution waitable timers are not supported, sleeping with Sleep.");
+	}
+}
+
+_Use_decl_annotations_
+void Win32Sleeper::SleepUs(
+	int64_t us)
+{
+	if (_timer.IsValid())
+	{
+		/* A negative due time is relative, in 100 ns units. */
+		LARGE_INTEGER dueTime;
+		dueTime.QuadPart = -us * 10;
+
+		if (SetWaitableTimer(_timer.Get(), &dueTime, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(_timer.Get(), INFINITE);
+			return;
+		}
+	}
+
+	::Sleep((DWORD)((us + 999) / 1000));
+}
+
+void Win32Sleeper::Spin()
+{
+	YieldProcessor();
+}
@@ -18,6 +18,7 @@
 */
 #include "pch.h"
 #include "Detours.h"
+#include "Utils.h"
 
 #pragma comment(lib, "comctl32.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -45,6 +46,10 @@ BOOL APIENTRY DllMain(
 		break;
 	case DLL_PROCESS_DETACH:
 		DetachDetours();
+
+		/* The log queue is never destroyed, so write what is left. The context is destroyed after this,
+		   and what it logs is then written directly. */
+		detail::ShutdownLog();
 		break;
 	}
 	return TRUE;
@@ -18,6 +18,7 @@
 */
 #include "pch.h"
 #include "D2DXContextFactory.h"
+#include "Tracer.h"
 #include "Utils.h"
 
 using namespace d2dx;
@@ -37,6 +38,7 @@ FX_ENTRY void FX_CALL
 	try
 	{
 		const auto returnAddress = (uintptr_t)_ReturnAddress();
+		D2DX_TRACE_SCOPE("grDrawPoint");
 		D2DXContextFactory::GetInstance()->OnDrawPoint(pt, returnAddress);
 	}
 	catch (...)
@@ -51,6 +53,7 @@ FX_ENTRY void FX_CALL
 	try
 	{
 		const auto returnAddress = (uintptr_t)_ReturnAddress();
+		D2DX_TRACE_SCOPE("grDrawLine");
 		D2DXContextFactory::GetInstance()->OnDrawLine(v1, v2, returnAddress);
 	}
 	catch (...)
@@ -78,6 +81,7 @@ FX_ENTRY void FX_CALL
 	const auto returnAddress = (uintptr_t)_ReturnAddress();
 	try
 	{
+		D2DX_TRACE_SCOPE("grDrawVertexArray");
 		D2DXContextFactory::GetInstance()->OnDrawVertexArray(mode, Count, (uint8_t**)pointers, returnAddress);	
 	}
 	catch (...)
@@ -93,6 +97,7 @@ FX_ENTRY void FX_CALL
 
 	try
 	{
+		D2DX_TRACE_SCOPE("grDrawVertexArrayContiguous");
 		D2DXContextFactory::GetInstance()->OnDrawVertexArrayContiguous(mode, Count, (uint8_t*)vertex, stride, returnAddress);
 	}
 	catch (...)
@@ -106,6 +111,7 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		D2DX_TRACE_SCOPE("grBufferClear");
 		D2DXContextFactory::GetInstance()->OnBufferClear();
 	}
 	catch (...)
@@ -119,6 +125,7 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		D2DX_TRACE_SCOPE("grBufferSwap");
 		D2DXContextFactory::GetInstance()->OnBufferSwap();
 	}
 	catch (...)
@@ -398,6 +405,7 @@ FX_ENTRY void FX_CALL
 
 	try
 	{
+		D2DX_TRACE_SCOPE("grTexSource");
 		D2DXContextFactory::GetInstance()->OnTexSource(tmu, startAddress, w, h);
 	}
 	catch (...)
@@ -442,6 +450,7 @@ FX_ENTRY void FX_CALL
 
 	try
 	{
+		D2DX_TRACE_SCOPE("grTexDownloadMipMap");
 		D2DXContextFactory::GetInstance()->OnTexDownload(tmu, (const uint8_t*)info->data, startAddress, (int32_t)width, (int32_t)height);
 	}
 	catch (...)
@@ -456,6 +465,7 @@ FX_ENTRY void FX_CALL
 {
 	try
 	{
+		D2DX_TRACE_SCOPE("grTexDownloadTable");
 		D2DXContextFactory::GetInstance()->OnTexDownloadTable(type, data);
 	}
 	catch (...)
@@ -511,6 +521,7 @@ FX_ENTRY FxBool FX_CALL
 	{
 		if (type == GR_LFB_WRITE_ONLY && buffer == GR_BUFFER_FRONTBUFFER)
 		{
+			D2DX_TRACE_SCOPE("grLfbUnlock");
 			D2DXContextFactory::GetInstance()->OnLfbUnlock((const uint32_t*)lfbInfo.lfbPtr, lfbInfo.strideInBytes);
 			return FXTRUE;
 		}
@@ -23,6 +23,10 @@
 #define __MSC__
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <stdexcept>
 #include <cstdio>
 #include <cstdint>
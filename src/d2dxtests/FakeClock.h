@@ -0,0 +1,45 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "../d2dx/IClock.h"
+
+namespace d2dxtests
+{
+	/* A clock that is set by the test. If stepUs isn't zero, the time also advances by that much on each read. */
+	class FakeClock final : public d2dx::IClock
+	{
+	public:
+		FakeClock(
+			_In_ int64_t timeUs = 1000000,
+			_In_ int64_t stepUs = 0) noexcept :
+			timeUs{ timeUs },
+			stepUs{ stepUs }
+		{
+		}
+
+		virtual int64_t GetTimeUs() const override
+		{
+			return timeUs += stepUs;
+		}
+
+		mutable int64_t timeUs;
+		int64_t stepUs;
+	};
+}
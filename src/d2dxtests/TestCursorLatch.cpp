@@ -0,0 +1,119 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "FakeClock.h"
+#include "../d2dx/CursorLatch.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestCursorLatch)
+	{
+	public:
+		TEST_METHOD(CursorIsMovedToTheNewestPosition)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			CursorLatch cursorLatch{ clock };
+
+			cursorLatch.OnGameMousePos({ 100, 100 });
+			cursorLatch.OnCursorDrawn();
+
+			const Offset newestPos{ 110, 95 };
+			const Offset offset = cursorLatch.Latch(&newestPos);
+
+			Assert::AreEqual(10, offset.x);
+			Assert::AreEqual(-5, offset.y);
+		}
+
+		TEST_METHOD(CursorStaysPutWithoutTheNewestPosition)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			CursorLatch cursorLatch{ clock };
+
+			cursorLatch.OnGameMousePos({ 100, 100 });
+			cursorLatch.OnCursorDrawn();
+
+			const Offset offset = cursorLatch.Latch(nullptr);
+
+			Assert::AreEqual(0, offset.x);
+			Assert::AreEqual(0, offset.y);
+		}
+
+		TEST_METHOD(AgeIsMeasuredFromThePresentedPosition)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			CursorLatch cursorLatch{ clock };
+			const Offset newestPos{ 0, 0 };
+
+			cursorLatch.OnGameMousePos({ 100, 100 });
+			clock->timeUs += 16000;
+			cursorLatch.OnCursorDrawn();
+			clock->timeUs += 4000;
+			cursorLatch.Latch(&newestPos);
+			clock->timeUs += 2000;
+			Assert::AreEqual((int64_t)2000, cursorLatch.EndFrame());
+
+			cursorLatch.OnGameMousePos({ 100, 100 });
+			clock->timeUs += 16000;
+			cursorLatch.OnCursorDrawn();
+			clock->timeUs += 4000;
+			cursorLatch.Latch(nullptr);
+			clock->timeUs += 2000;
+			Assert::AreEqual((int64_t)22000, cursorLatch.EndFrame());
+		}
+
+		TEST_METHOD(NothingIsLatchedWhenTheCursorIsNotDrawn)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			CursorLatch cursorLatch{ clock };
+			const Offset newestPos{ 50, 50 };
+
+			cursorLatch.OnGameMousePos({ 100, 100 });
+			cursorLatch.OnCursorDrawn();
+			cursorLatch.Latch(&newestPos);
+			cursorLatch.EndFrame();
+
+			const Offset offset = cursorLatch.Latch(&newestPos);
+
+			Assert::AreEqual(0, offset.x);
+			Assert::AreEqual(0, offset.y);
+			Assert::AreEqual((int64_t)-1, cursorLatch.EndFrame());
+		}
+
+		TEST_METHOD(FirstDrawnPositionIsUsed)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			CursorLatch cursorLatch{ clock };
+
+			cursorLatch.OnGameMousePos({ 100, 100 });
+			cursorLatch.OnCursorDrawn();
+			cursorLatch.OnGameMousePos({ 120, 100 });
+			cursorLatch.OnCursorDrawn();
+
+			const Offset newestPos{ 130, 100 };
+			const Offset offset = cursorLatch.Latch(&newestPos);
+
+			Assert::AreEqual(30, offset.x);
+			Assert::AreEqual(0, offset.y);
+		}
+	};
+}
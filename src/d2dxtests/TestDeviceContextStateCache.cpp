@@ -0,0 +1,222 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <vector>
+#include "CppUnitTest.h"
+#include "../d2dx/DeviceContextStateCache.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	/* Records the binds that reach the device context, in order. */
+	class FakeDeviceContext final
+	{
+	public:
+		struct Call final
+		{
+			const char* name;
+			const void* arg0;
+			const void* arg1;
+
+			bool operator==(const Call& other) const
+			{
+				return !strcmp(name, other.name) && arg0 == other.arg0 && arg1 == other.arg1;
+			}
+		};
+
+		void VSSetShader(ID3D11VertexShader* vs, ID3D11ClassInstance* const* classInstances, UINT classInstanceCount)
+		{
+			calls.push_back({ "VSSetShader", vs, nullptr });
+		}
+
+		void PSSetShader(ID3D11PixelShader* ps, ID3D11ClassInstance* const* classInstances, UINT classInstanceCount)
+		{
+			calls.push_back({ "PSSetShader", ps, nullptr });
+		}
+
+		void PSSetShaderResources(UINT startSlot, UINT viewCount, ID3D11ShaderResourceView* const* srvs)
+		{
+			Assert::AreEqual(2U, viewCount);
+			calls.push_back({ "PSSetShaderResources", srvs[0], srvs[1] });
+		}
+
+		void OMSetBlendState(ID3D11BlendState* blendState, const FLOAT blendFactor[4], UINT sampleMask)
+		{
+			calls.push_back({ "OMSetBlendState", blendState, nullptr });
+		}
+
+		void RSSetState(ID3D11RasterizerState* rs)
+		{
+			calls.push_back({ "RSSetState", rs, nullptr });
+		}
+
+		void OMSetRenderTargets(UINT viewCount, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv)
+		{
+			Assert::AreEqual(2U, viewCount);
+			calls.push_back({ "OMSetRenderTargets", rtvs[0], rtvs[1] });
+		}
+
+		void RSSetViewports(UINT viewportCount, const D3D11_VIEWPORT* viewports)
+		{
+			calls.push_back({ "RSSetViewports", (const void*)(uintptr_t)viewports->Width, nullptr });
+		}
+
+		void RSSetScissorRects(UINT rectCount, const D3D11_RECT* rects)
+		{
+			calls.push_back({ "RSSetScissorRects", (const void*)(uintptr_t)rects->right, nullptr });
+		}
+
+		void IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+		{
+			calls.push_back({ "IASetPrimitiveTopology", (const void*)(uintptr_t)topology, nullptr });
+		}
+
+		std::vector<Call> calls;
+	};
+
+	template<typename T>
+	static T* FakeObject(uintptr_t id)
+	{
+		return reinterpret_cast<T*>(id * 16);
+	}
+
+	TEST_CLASS(TestDeviceContextStateCache)
+	{
+	public:
+		TEST_METHOD(RedundantBindsAreFiltered)
+		{
+			FakeDeviceContext deviceContext;
+			DeviceContextStateCache<FakeDeviceContext> stateCache{ &deviceContext };
+
+			stateCache.SetVertexShader(FakeObject<ID3D11VertexShader>(1));
+			stateCache.SetVertexShader(FakeObject<ID3D11VertexShader>(1));
+			stateCache.SetVertexShader(FakeObject<ID3D11VertexShader>(2));
+
+			Assert::AreEqual((size_t)2, deviceContext.calls.size());
+			Assert::AreEqual(2ULL, stateCache.GetIssuedCount());
+			Assert::AreEqual(1ULL, stateCache.GetFilteredCount());
+		}
+
+		TEST_METHOD(UnboundStateOfNewContextIsNotBoundAgain)
+		{
+			FakeDeviceContext deviceContext;
+			DeviceContextStateCache<FakeDeviceContext> stateCache{ &deviceContext };
+
+			stateCache.SetPixelShaderResources(nullptr, nullptr);
+			stateCache.SetBlendState(nullptr);
+			stateCache.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED);
+
+			Assert::AreEqual((size_t)0, deviceContext.calls.size());
+			Assert::AreEqual(3ULL, stateCache.GetFilteredCount());
+		}
+
+		TEST_METHOD(InvalidateIssuesEverythingAgain)
+		{
+			FakeDeviceContext deviceContext;
+			DeviceContextStateCache<FakeDeviceContext> stateCache{ &deviceContext };
+			const D3D11_VIEWPORT viewport{ 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f };
+
+			stateCache.SetViewport(viewport);
+			stateCache.SetRasterizerState(nullptr);
+			stateCache.Invalidate();
+			stateCache.SetViewport(viewport);
+			stateCache.SetRasterizerState(nullptr);
+
+			/* The first rasterizer state bind is filtered, since a new context has none bound. */
+			Assert::AreEqual((size_t)3, deviceContext.calls.size());
+			Assert::AreEqual(1ULL, stateCache.GetFilteredCount());
+		}
+
+		TEST_METHOD(FrameIssuesTheSameBindsMinusRedundantOnes)
+		{
+			FakeDeviceContext deviceContext;
+			DeviceContextStateCache<FakeDeviceContext> stateCache{ &deviceContext };
+
+			auto gameVs = FakeObject<ID3D11VertexShader>(1);
+			auto gamePs = FakeObject<ID3D11PixelShader>(2);
+			auto displayVs = FakeObject<ID3D11VertexShader>(3);
+			auto gammaPs = FakeObject<ID3D11PixelShader>(4);
+			auto atlas = FakeObject<ID3D11ShaderResourceView>(5);
+			auto palette = FakeObject<ID3D11ShaderResourceView>(6);
+			auto gameSrv = FakeObject<ID3D11ShaderResourceView>(7);
+			auto gameRtv = FakeObject<ID3D11RenderTargetView>(8);
+			auto surfaceIdRtv = FakeObject<ID3D11RenderTargetView>(9);
+			auto gammaRtv = FakeObject<ID3D11RenderTargetView>(10);
+			auto blend = FakeObject<ID3D11BlendState>(11);
+			auto opaque = FakeObject<ID3D11BlendState>(12);
+			const D3D11_VIEWPORT viewport{ 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f };
+			const D3D11_RECT scissorRect{ 0, 0, 640, 480 };
+
+			/* The binds RenderContext makes for a frame with three batches from the same atlas: BeginFrame,
+			   Draw per batch, then the gamma pass of Present. */
+			stateCache.SetRenderTargets(gameRtv, surfaceIdRtv);
+			stateCache.SetViewport(viewport);
+			stateCache.SetScissorRect(scissorRect);
+			stateCache.SetVertexShader(gameVs);
+			stateCache.SetPixelShader(gamePs);
+			stateCache.SetPixelShaderResources(nullptr, nullptr);
+
+			for (int32_t i = 0; i < 3; ++i)
+			{
+				stateCache.SetBlendState(blend);
+				stateCache.SetVertexShader(gameVs);
+				stateCache.SetPixelShader(gamePs);
+				stateCache.SetPixelShaderResources(atlas, palette);
+			}
+
+			stateCache.SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+			stateCache.SetBlendState(opaque);
+			stateCache.SetRenderTargets(gammaRtv, nullptr);
+			stateCache.SetViewport(viewport);
+			stateCache.SetScissorRect(scissorRect);
+			stateCache.SetVertexShader(displayVs);
+			stateCache.SetPixelShader(gammaPs);
+			stateCache.SetPixelShaderResources(gameSrv, nullptr);
+
+			const std::vector<FakeDeviceContext::Call> expectedCalls =
+			{
+				{ "OMSetRenderTargets", gameRtv, surfaceIdRtv },
+				{ "RSSetViewports", (const void*)640, nullptr },
+				{ "RSSetScissorRects", (const void*)640, nullptr },
+				{ "VSSetShader", gameVs, nullptr },
+				{ "PSSetShader", gamePs, nullptr },
+				{ "OMSetBlendState", blend, nullptr },
+				{ "PSSetShaderResources", atlas, palette },
+				{ "IASetPrimitiveTopology", (const void*)D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST, nullptr },
+				{ "OMSetBlendState", opaque, nullptr },
+				{ "OMSetRenderTargets", gammaRtv, nullptr },
+				{ "VSSetShader", displayVs, nullptr },
+				{ "PSSetShader", gammaPs, nullptr },
+				{ "PSSetShaderResources", gameSrv, nullptr },
+			};
+
+			Assert::AreEqual(expectedCalls.size(), deviceContext.calls.size());
+
+			for (size_t i = 0; i < expectedCalls.size(); ++i)
+			{
+				Assert::IsTrue(expectedCalls[i] == deviceContext.calls[i]);
+			}
+
+			Assert::AreEqual((uint64_t)expectedCalls.size(), stateCache.GetIssuedCount());
+			Assert::AreEqual(13ULL, stateCache.GetFilteredCount());
+		}
+	};
+}
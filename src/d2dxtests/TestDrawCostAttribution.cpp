@@ -0,0 +1,163 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/DrawCostAttribution.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	static std::string WriteToString(
+		_In_ const DrawCostAttribution& drawCosts,
+		_In_ MetricsFormat format)
+	{
+		FILE* file = nullptr;
+		Assert::AreEqual(0, (int32_t)tmpfile_s(&file));
+
+		drawCosts.Write(file, format);
+
+		std::string text;
+		char buffer[1024];
+		rewind(file);
+
+		for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0; )
+		{
+			text.append(buffer, count);
+		}
+
+		fclose(file);
+		return text;
+	}
+
+	TEST_CLASS(TestDrawCostAttribution)
+	{
+	public:
+		TEST_METHOD(AttributesToBothGameAddressAndTextureCategory)
+		{
+			DrawCostAttribution drawCosts{ 16 };
+
+			drawCosts.AddBatch(GameAddress::DrawFloor, TextureCategory::Floor, 6);
+			drawCosts.AddBatch(GameAddress::DrawFloor, TextureCategory::Floor, 6);
+			drawCosts.AddBatch(GameAddress::DrawWall1, TextureCategory::Wall, 12);
+			drawCosts.AddDrawCall(GameAddress::DrawFloor, TextureCategory::Floor);
+			drawCosts.AddTextureMiss(GameAddress::DrawWall1, TextureCategory::Wall, 4096);
+			drawCosts.EndFrame();
+
+			Assert::AreEqual(2U, drawCosts.GetLastFrame(GameAddress::DrawFloor, DrawCost::Batches));
+			Assert::AreEqual(12U, drawCosts.GetLastFrame(GameAddress::DrawFloor, DrawCost::Vertices));
+			Assert::AreEqual(12U, drawCosts.GetLastFrame(TextureCategory::Floor, DrawCost::Vertices));
+			Assert::AreEqual(1U, drawCosts.GetLastFrame(TextureCategory::Floor, DrawCost::DrawCalls));
+			Assert::AreEqual(12U, drawCosts.GetLastFrame(GameAddress::DrawWall1, DrawCost::Vertices));
+			Assert::AreEqual(1U, drawCosts.GetLastFrame(TextureCategory::Wall, DrawCost::TextureMisses));
+			Assert::AreEqual(4096U, drawCosts.GetLastFrame(GameAddress::DrawWall1, DrawCost::TextureUploadBytes));
+			Assert::AreEqual(0U, drawCosts.GetLastFrame(GameAddress::DrawShadow, DrawCost::Vertices));
+			Assert::AreEqual(0U, drawCosts.GetLastFrame(TextureCategory::UserInterface, DrawCost::Batches));
+		}
+
+		TEST_METHOD(EachFrameStartsFromZero)
+		{
+			DrawCostAttribution drawCosts{ 16 };
+
+			Assert::AreEqual(0U, drawCosts.GetLastFrame(GameAddress::DrawFloor, DrawCost::Vertices));
+
+			drawCosts.AddBatch(GameAddress::DrawFloor, TextureCategory::Floor, 6);
+			drawCosts.EndFrame();
+			drawCosts.EndFrame();
+
+			Assert::AreEqual(0U, drawCosts.GetLastFrame(GameAddress::DrawFloor, DrawCost::Vertices));
+			Assert::AreEqual((uint64_t)6, drawCosts.GetTotal(GameAddress::DrawFloor, DrawCost::Vertices));
+			Assert::AreEqual(2U, drawCosts.GetHistoryCount());
+		}
+
+		TEST_METHOD(TotalsCoverOnlyTheHistory)
+		{
+			DrawCostAttribution drawCosts{ 4 };
+
+			for (uint32_t i = 0; i < 10; ++i)
+			{
+				drawCosts.AddBatch(GameAddress::DrawShadow, TextureCategory::Unknown, i);
+				drawCosts.EndFrame();
+			}
+
+			Assert::AreEqual(4U, drawCosts.GetHistoryCount());
+			Assert::AreEqual((uint64_t)(6 + 7 + 8 + 9), drawCosts.GetTotal(GameAddress::DrawShadow, DrawCost::Vertices));
+			Assert::AreEqual((uint64_t)4, drawCosts.GetTotal(TextureCategory::Unknown, DrawCost::Batches));
+			Assert::AreEqual(9U, drawCosts.GetLastFrame(TextureCategory::Unknown, DrawCost::Vertices));
+		}
+
+		TEST_METHOD(EverythingHasAName)
+		{
+			for (int32_t i = 0; i < (int32_t)DrawCost::Count; ++i)
+			{
+				Assert::IsTrue(strlen(DrawCostAttribution::GetName((DrawCost)i)) > 0);
+			}
+
+			for (int32_t i = 0; i < (int32_t)GameAddress::Count; ++i)
+			{
+				Assert::IsTrue(strlen(DrawCostAttribution::GetName((GameAddress)i)) > 0);
+			}
+
+			for (int32_t i = 0; i < (int32_t)TextureCategory::Count; ++i)
+			{
+				Assert::IsTrue(strlen(DrawCostAttribution::GetName((TextureCategory)i)) > 0);
+			}
+		}
+
+		TEST_METHOD(WritesCsv)
+		{
+			DrawCostAttribution drawCosts{ 16 };
+
+			drawCosts.AddBatch(GameAddress::DrawFloor, TextureCategory::Floor, 6);
+			drawCosts.AddDrawCall(GameAddress::DrawFloor, TextureCategory::Floor);
+			drawCosts.EndFrame();
+			drawCosts.AddBatch(GameAddress::DrawFloor, TextureCategory::Floor, 6);
+			drawCosts.EndFrame();
+
+			const std::string csv = WriteToString(drawCosts, MetricsFormat::Csv);
+
+			Assert::AreEqual((size_t)0, csv.find("group,name,frames,vertices,batches,draw_calls,texture_misses,texture_upload_bytes\n"));
+			Assert::IsTrue(csv.find("\ngame_address,draw_floor,2,12,2,1,0,0\n") != std::string::npos);
+			Assert::IsTrue(csv.find("\ntexture_category,floor,2,12,2,1,0,0\n") != std::string::npos);
+			Assert::IsTrue(csv.find("\ngame_address,draw_wall1,2,0,0,0,0,0\n") != std::string::npos);
+			Assert::AreEqual((size_t)(1 + (size_t)GameAddress::Count + (size_t)TextureCategory::Count), (size_t)std::count(csv.begin(), csv.end(), '\n'));
+		}
+
+		TEST_METHOD(WritesJson)
+		{
+			DrawCostAttribution drawCosts{ 16 };
+
+			drawCosts.AddBatch(GameAddress::DrawLine, TextureCategory::UserInterface, 3);
+			drawCosts.EndFrame();
+
+			const std::string json = WriteToString(drawCosts, MetricsFormat::Json);
+
+			Assert::AreEqual((size_t)0, json.find("{\n\t\"frames\": 1,\n\t\"game_addresses\": [\n\t\t{ \"name\": \"unknown\", \"vertices\": 0,"));
+			Assert::IsTrue(json.find("{ \"name\": \"draw_line\", \"vertices\": 3, \"batches\": 1,") != std::string::npos);
+			Assert::IsTrue(json.find("\n\t],\n\t\"texture_categories\": [\n\t\t{ \"name\": \"unknown\",") != std::string::npos);
+			Assert::IsTrue(json.find("{ \"name\": \"user_interface\", \"vertices\": 3, \"batches\": 1,") != std::string::npos);
+			Assert::AreEqual((size_t)2, (size_t)std::count(json.begin(), json.end(), '['));
+			Assert::AreEqual((size_t)2, (size_t)std::count(json.begin(), json.end(), ']'));
+			Assert::AreEqual((size_t)17, (size_t)std::count(json.begin(), json.end(), '{'));
+			Assert::AreEqual((size_t)17, (size_t)std::count(json.begin(), json.end(), '}'));
+			Assert::IsTrue(json.find(",\n\t]") == std::string::npos);
+		}
+	};
+}
@@ -0,0 +1,183 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/FrameArena.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestFrameArena)
+	{
+	public:
+		TEST_METHOD(StartsEmpty)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+
+			Assert::AreEqual(0U, arena.GetCount());
+			Assert::AreEqual(0U, arena.GetCapacity());
+			Assert::AreEqual(0U, arena.GetChunkCount());
+		}
+
+		TEST_METHOD(AllocationsAreContiguousAndIndexable)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+
+			for (uint32_t i = 0; i < 8; ++i)
+			{
+				uint32_t index;
+				uint32_t* items = arena.Allocate(6, &index);
+				Assert::IsNotNull(items);
+
+				for (uint32_t j = 0; j < 6; ++j)
+				{
+					items[j] = i * 100 + j;
+				}
+
+				for (uint32_t j = 0; j < 6; ++j)
+				{
+					Assert::AreEqual(i * 100 + j, arena[index + j]);
+				}
+			}
+
+			Assert::AreEqual(48U, arena.GetCount());
+		}
+
+		TEST_METHOD(AllocationsThatDontFitSkipToTheNextChunk)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+			uint32_t index;
+
+			arena.Allocate(10, &index);
+			Assert::AreEqual(0U, index);
+
+			arena.Allocate(10, &index);
+			Assert::AreEqual(16U, index);
+			Assert::AreEqual(1U, arena.GetChunkIndex(index));
+
+			Assert::AreEqual(2U, arena.GetChunkCount());
+			Assert::AreEqual(10U, arena.GetChunkUsedCount(0));
+			Assert::AreEqual(10U, arena.GetChunkUsedCount(1));
+			Assert::AreEqual(20U, arena.GetCount());
+		}
+
+		TEST_METHOD(GrowingDoesNotMoveElements)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+			uint32_t index;
+
+			uint32_t* first = arena.Allocate(16, &index);
+			first[0] = 1234;
+
+			arena.Allocate(16, &index);
+			arena.Allocate(16, &index);
+
+			Assert::IsTrue(first == arena.GetChunk(0));
+			Assert::AreEqual(1234U, arena[0]);
+			Assert::AreEqual(48U, arena.GetCapacity());
+		}
+
+		TEST_METHOD(ReturnsNullWhenFull)
+		{
+			FrameArena<uint32_t> arena{ 16, 2 };
+			uint32_t index;
+
+			Assert::IsNotNull(arena.Allocate(12, &index));
+			Assert::IsNotNull(arena.Allocate(12, &index));
+			Assert::IsNull(arena.Allocate(12, &index));
+			Assert::IsNotNull(arena.Allocate(4, &index));
+		}
+
+		TEST_METHOD(ResetReusesChunks)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+			uint32_t index;
+
+			uint32_t* first = arena.Allocate(16, &index);
+			arena.Allocate(16, &index);
+			arena.Allocate(16, &index);
+
+			arena.Reset();
+
+			Assert::AreEqual(0U, arena.GetCount());
+			Assert::AreEqual(0U, arena.GetChunkCount());
+			Assert::AreEqual(48U, arena.GetCapacity());
+
+			Assert::IsTrue(first == arena.Allocate(4, &index));
+			Assert::AreEqual(0U, index);
+			Assert::AreEqual(48U, arena.GetCapacity());
+		}
+
+		TEST_METHOD(HighWaterMarkSpansResets)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+			uint32_t index;
+
+			arena.Allocate(16, &index);
+			arena.Allocate(14, &index);
+			arena.Reset();
+			arena.Allocate(5, &index);
+
+			Assert::AreEqual(30U, arena.GetHighWaterMark());
+		}
+
+		TEST_METHOD(ShrinkLastAllocation)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+			uint32_t index;
+
+			arena.Allocate(12, &index);
+			arena.ShrinkLastAllocation(8);
+
+			Assert::AreEqual(4U, arena.GetCount());
+			Assert::AreEqual(4U, arena.GetChunkUsedCount(0));
+
+			arena.Allocate(12, &index);
+			Assert::AreEqual(4U, index);
+		}
+
+		TEST_METHOD(LoweringMaxChunkCountFreesChunks)
+		{
+			FrameArena<uint32_t> arena{ 16, 4 };
+			uint32_t index;
+
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				arena.Allocate(16, &index);
+			}
+
+			arena.Reset();
+			arena.SetMaxChunkCount(2);
+
+			Assert::AreEqual(32U, arena.GetCapacity());
+			Assert::AreEqual(32U, arena.GetMaxCount());
+
+			Assert::IsNotNull(arena.Allocate(16, &index));
+			Assert::IsNotNull(arena.Allocate(16, &index));
+			Assert::IsNull(arena.Allocate(16, &index));
+
+			arena.Reset();
+			arena.SetMaxChunkCount(100);
+
+			Assert::AreEqual(4U, arena.GetMaxChunkCount());
+		}
+	};
+}
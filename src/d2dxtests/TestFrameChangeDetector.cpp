@@ -0,0 +1,157 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/FrameChangeDetector.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestFrameChangeDetector)
+	{
+	public:
+		TEST_METHOD(FirstFrameIsChanged)
+		{
+			FrameChangeDetector detector;
+			Frame frame;
+
+			Assert::IsTrue(Update(detector, frame));
+			Assert::AreEqual((uint64_t)0, detector.GetUnchangedFrameCount());
+		}
+
+		TEST_METHOD(RepeatedFramesAreUnchanged)
+		{
+			FrameChangeDetector detector;
+			Frame frame;
+
+			Assert::IsTrue(Update(detector, frame));
+
+			for (int32_t i = 0; i < 5; ++i)
+			{
+				Assert::IsFalse(Update(detector, frame));
+			}
+
+			Assert::AreEqual((uint64_t)5, detector.GetUnchangedFrameCount());
+		}
+
+		TEST_METHOD(MovedVertexIsChanged)
+		{
+			FrameChangeDetector detector;
+			Frame frame;
+
+			Assert::IsTrue(Update(detector, frame));
+			frame.vertices[frame.batches[10].GetStartVertex() + 2].AddOffset(1, 0);
+			Assert::IsTrue(Update(detector, frame));
+			Assert::IsFalse(Update(detector, frame));
+		}
+
+		TEST_METHOD(ChangedTextureIsChanged)
+		{
+			FrameChangeDetector detector;
+			Frame frame;
+
+			Assert::IsTrue(Update(detector, frame));
+			frame.batches[3].SetTextureHash(0x12345678);
+			Assert::IsTrue(Update(detector, frame));
+		}
+
+		TEST_METHOD(ChangedPaletteOrGammaIsChanged)
+		{
+			FrameChangeDetector detector;
+			Frame frame;
+
+			Assert::IsTrue(Update(detector, frame));
+			frame.paletteKeys[1] = 0xABCD;
+			Assert::IsTrue(Update(detector, frame));
+			frame.gammaTable[255] = 0;
+			Assert::IsTrue(Update(detector, frame));
+		}
+
+		TEST_METHOD(FewerVerticesIsChanged)
+		{
+			FrameChangeDetector detector;
+			Frame frame;
+
+			Assert::IsTrue(Update(detector, frame));
+			frame.vertices.ShrinkLastAllocation(6);
+			Assert::IsTrue(Update(detector, frame));
+		}
+
+		TEST_METHOD(ResetMakesNextFrameChanged)
+		{
+			FrameChangeDetector detector;
+			Frame frame;
+
+			Assert::IsTrue(Update(detector, frame));
+			detector.Reset();
+			Assert::IsTrue(Update(detector, frame));
+			Assert::IsFalse(Update(detector, frame));
+		}
+
+	private:
+		struct Frame final
+		{
+			Frame()
+			{
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					uint32_t batchIndex, startVertex;
+					Batch* batch = batches.Allocate(1, &batchIndex);
+					Vertex* pVertices = vertices.Allocate(6, &startVertex);
+
+					*batch = Batch();
+					batch->SetStartVertex(startVertex);
+					batch->SetVertexCount(6);
+					batch->SetTextureHash(i * 0x9E3779B9);
+
+					for (uint32_t j = 0; j < 6; ++j)
+					{
+						pVertices[j] = Vertex();
+						pVertices[j].SetPosition(i * 3, j * 7);
+						pVertices[j].SetColor(0xFF000000 | (i * 6 + j));
+					}
+				}
+
+				for (uint32_t i = 0; i < 256; ++i)
+				{
+					gammaTable[i] = i * 0x010101;
+				}
+			}
+
+			/* Small chunks, so that the frame spans several of them. */
+			FrameArena<Batch> batches{ 4, 8 };
+			FrameArena<Vertex> vertices{ 32, 8 };
+			uint32_t paletteKeys[D2DX_MAX_PALETTES] = { 0 };
+			uint32_t gammaTable[256];
+		};
+
+		static bool Update(
+			FrameChangeDetector& detector,
+			const Frame& frame)
+		{
+			return detector.Update(
+				frame.batches,
+				frame.vertices,
+				frame.paletteKeys, D2DX_MAX_PALETTES,
+				frame.gammaTable, 256);
+		}
+	};
+}
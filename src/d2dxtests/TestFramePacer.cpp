@@ -0,0 +1,183 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "FakeClock.h"
+#include "../d2dx/FramePacer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	/* Advances the clock instead of sleeping, oversleeping by a fixed amount. */
+	class PacerSleeper final : public ISleeper
+	{
+	public:
+		PacerSleeper(
+			_In_ const std::shared_ptr<FakeClock>& clock,
+			_In_ int64_t overshootUs) :
+			_clock{ clock },
+			_overshootUs{ overshootUs }
+		{
+		}
+
+		virtual void SleepUs(
+			_In_ int64_t us) override
+		{
+			_clock->timeUs += us + _overshootUs;
+			++sleepCount;
+		}
+
+		virtual void Spin() override
+		{
+			_clock->timeUs += 10;
+			++spinCount;
+		}
+
+		uint32_t sleepCount = 0;
+		uint32_t spinCount = 0;
+
+	private:
+		std::shared_ptr<FakeClock> _clock;
+		int64_t _overshootUs;
+	};
+
+	TEST_CLASS(TestFramePacer)
+	{
+	public:
+		TEST_METHOD(FramesArePresentedAtTheTargetRate)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			auto sleeper = std::make_shared<PacerSleeper>(clock, 1500);
+			FramePacer framePacer{ clock, sleeper, 100 };
+
+			int64_t lastPresentUs = 0;
+
+			for (int32_t i = 0; i < 200; ++i)
+			{
+				RunFrame(*clock, framePacer, 3000 + (i % 3) * 1000, 1000);
+
+				if (i >= 50)
+				{
+					const int64_t intervalUs = clock->timeUs - lastPresentUs;
+					Assert::IsTrue(intervalUs >= 9950 && intervalUs <= 10050);
+				}
+
+				lastPresentUs = clock->timeUs;
+			}
+
+			Assert::IsTrue(framePacer.GetJitterHistogram().GetPercentile(90.0f) <= 50);
+		}
+
+		TEST_METHOD(SleepOvershootIsCalibrated)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			auto sleeper = std::make_shared<PacerSleeper>(clock, 3000);
+			FramePacer framePacer{ clock, sleeper, 60 };
+
+			for (int32_t i = 0; i < 20; ++i)
+			{
+				RunFrame(*clock, framePacer, 1000, 1000);
+			}
+
+			Assert::IsTrue(framePacer.GetSleepOvershootUs() >= 2900 && framePacer.GetSleepOvershootUs() <= 3000);
+
+			/* Once calibrated, each frame sleeps once and spins for little more than the remainder. */
+			sleeper->sleepCount = 0;
+			sleeper->spinCount = 0;
+
+			for (int32_t i = 0; i < 10; ++i)
+			{
+				RunFrame(*clock, framePacer, 1000, 1000);
+			}
+
+			Assert::AreEqual(10U, sleeper->sleepCount);
+			Assert::IsTrue(sleeper->spinCount <= 10 * 20);
+		}
+
+		TEST_METHOD(SlowFramesAreNotDelayed)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			auto sleeper = std::make_shared<PacerSleeper>(clock, 1000);
+			FramePacer framePacer{ clock, sleeper, 100 };
+
+			for (int32_t i = 0; i < 20; ++i)
+			{
+				RunFrame(*clock, framePacer, 15000, 1000);
+			}
+
+			Assert::AreEqual(0U, sleeper->sleepCount);
+			Assert::AreEqual(0U, sleeper->spinCount);
+		}
+
+		TEST_METHOD(LateFrameRestartsTheCadence)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			auto sleeper = std::make_shared<PacerSleeper>(clock, 1000);
+			FramePacer framePacer{ clock, sleeper, 100 };
+
+			for (int32_t i = 0; i < 20; ++i)
+			{
+				RunFrame(*clock, framePacer, i == 10 ? 35000 : 2000, 1000);
+
+				if (i == 10)
+				{
+					/* The next frame isn't rushed to catch up. */
+					const int64_t lastPresentUs = clock->timeUs;
+
+					RunFrame(*clock, framePacer, 2000, 1000);
+
+					Assert::IsTrue(clock->timeUs - lastPresentUs >= 9500);
+				}
+			}
+		}
+
+		TEST_METHOD(JitterIsRecordedForEachInterval)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			auto sleeper = std::make_shared<PacerSleeper>(clock, 1000);
+			FramePacer framePacer{ clock, sleeper, 100 };
+
+			for (int32_t i = 0; i < 10; ++i)
+			{
+				RunFrame(*clock, framePacer, 2000, 1000);
+			}
+
+			RunFrame(*clock, framePacer, 14000, 1000);
+
+			Assert::AreEqual((uint64_t)10, framePacer.GetJitterHistogram().GetCount());
+			Assert::IsTrue(framePacer.GetLastJitterUs() >= 5000);
+		}
+
+	private:
+		/* The game's own work happens before Wait, and only drawing and presenting after it. */
+		static void RunFrame(
+			FakeClock& clock,
+			FramePacer& framePacer,
+			int64_t gameUs,
+			int64_t presentUs)
+		{
+			clock.timeUs += gameUs;
+			framePacer.Wait();
+			clock.timeUs += presentUs;
+			framePacer.OnPresented();
+		}
+	};
+}
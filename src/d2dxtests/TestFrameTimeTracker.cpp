@@ -0,0 +1,245 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "FakeClock.h"
+#include "../d2dx/FrameTimeTracker.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestFrameTimeHistogram)
+	{
+	public:
+		TEST_METHOD(SmallValuesAreExact)
+		{
+			FrameTimeHistogram histogram;
+
+			for (int64_t i = 1; i <= 50; ++i)
+			{
+				histogram.Record(i);
+			}
+
+			Assert::AreEqual((uint64_t)50, histogram.GetCount());
+			Assert::AreEqual((int64_t)25, histogram.GetPercentile(50.0f));
+			Assert::AreEqual((int64_t)45, histogram.GetPercentile(90.0f));
+			Assert::AreEqual((int64_t)50, histogram.GetPercentile(100.0f));
+			Assert::AreEqual((int64_t)50, histogram.GetMax());
+		}
+
+		TEST_METHOD(BucketsCoverTheRangeWithBoundedError)
+		{
+			uint32_t lastIndex = 0;
+
+			for (int64_t value = 0; value <= FrameTimeHistogram::MaxValue; value += 1 + value / 97)
+			{
+				const uint32_t index = FrameTimeHistogram::GetBucketIndex(value);
+				const int64_t bucketMax = FrameTimeHistogram::GetBucketMaxValue(index);
+
+				Assert::IsTrue(index < FrameTimeHistogram::BucketCount);
+				Assert::IsTrue(index >= lastIndex);
+				Assert::IsTrue(bucketMax >= value);
+				Assert::IsTrue(bucketMax - value <= value / 32);
+				Assert::AreEqual(index, FrameTimeHistogram::GetBucketIndex(bucketMax));
+
+				lastIndex = index;
+			}
+
+			Assert::AreEqual(FrameTimeHistogram::BucketCount - 1, FrameTimeHistogram::GetBucketIndex(FrameTimeHistogram::MaxValue));
+		}
+
+		TEST_METHOD(PercentilesOfUniformFrameTimes)
+		{
+			FrameTimeHistogram histogram;
+
+			/* 1 ms to 40 ms in 1 us steps. */
+			for (int64_t i = 1000; i < 41000; ++i)
+			{
+				histogram.Record(i);
+			}
+
+			const int64_t p50 = histogram.GetPercentile(50.0f);
+			const int64_t p99 = histogram.GetPercentile(99.0f);
+			const int64_t p999 = histogram.GetPercentile(99.9f);
+
+			Assert::IsTrue(p50 >= 20999 && p50 <= 20999 + 20999 / 32);
+			Assert::IsTrue(p99 >= 40599 && p99 <= 40599 + 40599 / 32);
+			Assert::IsTrue(p999 >= 40959 && p999 <= 40999);
+			Assert::AreEqual((int64_t)40999, histogram.GetMax());
+		}
+
+		TEST_METHOD(ValuesAreClamped)
+		{
+			FrameTimeHistogram histogram;
+
+			histogram.Record(-5);
+			histogram.Record(FrameTimeHistogram::MaxValue * 4);
+
+			Assert::AreEqual((int64_t)0, histogram.GetPercentile(50.0f));
+			Assert::AreEqual(FrameTimeHistogram::MaxValue, histogram.GetMax());
+
+			histogram.Reset();
+
+			Assert::AreEqual((uint64_t)0, histogram.GetCount());
+			Assert::AreEqual((int64_t)0, histogram.GetPercentile(99.0f));
+		}
+	};
+
+	TEST_CLASS(TestFrameTimeTracker)
+	{
+	public:
+		TEST_METHOD(FirstFrameOnlyStartsTheClock)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			FrameTimeTracker tracker{ clock };
+
+			Assert::IsFalse(tracker.EndFrame(nullptr));
+			Assert::AreEqual((uint64_t)0, tracker.GetHistogram().GetCount());
+
+			clock->timeUs += 16667;
+			tracker.EndFrame(nullptr);
+
+			Assert::AreEqual((uint64_t)1, tracker.GetHistogram().GetCount());
+			Assert::AreEqual((int64_t)16667, tracker.GetHistogram().GetMax());
+		}
+
+		TEST_METHOD(SteadyFramesWithJitterAreNotHitches)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			FrameTimeTracker tracker{ clock };
+
+			tracker.EndFrame(nullptr);
+
+			for (int32_t i = 0; i < 1000; ++i)
+			{
+				/* 60 fps, alternating between early and late by 4 ms. */
+				clock->timeUs += (i & 1) ? 12667 : 20667;
+				Assert::IsFalse(tracker.EndFrame(nullptr));
+			}
+
+			Assert::AreEqual((uint64_t)0, tracker.GetHitchCount());
+		}
+
+		TEST_METHOD(HitchIsDetectedWithItsMetrics)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			FrameTimeTracker tracker{ clock };
+			MetricsRegistry metrics{ 16 };
+
+			tracker.EndFrame(nullptr);
+
+			for (int32_t i = 0; i < 500; ++i)
+			{
+				metrics.Add(Metric::TextureMisses, i == 300 ? 40 : 0);
+				metrics.Set(Metric::PresentTimeUs, 500);
+
+				clock->timeUs += i == 300 ? 60000 : 16667;
+				const bool isHitch = tracker.EndFrame(&metrics);
+
+				Assert::AreEqual(i == 300, isHitch);
+
+				metrics.EndFrame();
+			}
+
+			Assert::AreEqual((uint64_t)1, tracker.GetHitchCount());
+			Assert::AreEqual(1U, tracker.GetRecentHitchCount());
+
+			const FrameHitch& hitch = tracker.GetRecentHitch(0);
+			Assert::AreEqual((uint64_t)300, hitch.frame);
+			Assert::AreEqual((int64_t)60000, hitch.frameTimeUs);
+			Assert::IsTrue(hitch.medianUs >= 16667 && hitch.medianUs <= 16667 + 16667 / 32);
+			Assert::IsTrue(hitch.hasMetrics);
+			Assert::AreEqual((int64_t)40, hitch.metrics[(int32_t)Metric::TextureMisses]);
+			Assert::AreEqual((int64_t)500, hitch.metrics[(int32_t)Metric::PresentTimeUs]);
+
+			tracker.LogSummary();
+		}
+
+		TEST_METHOD(HitchWithAllMetricsSetIsLogged)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			FrameTimeTracker tracker{ clock };
+			MetricsRegistry metrics{ 16 };
+
+			tracker.EndFrame(nullptr);
+
+			for (int32_t i = 0; i < 200; ++i)
+			{
+				for (int32_t m = 0; m < (int32_t)Metric::Count; ++m)
+				{
+					if (MetricsRegistry::GetKind((Metric)m) == MetricKind::Gauge)
+					{
+						metrics.Set((Metric)m, INT64_MIN);
+					}
+					else
+					{
+						metrics.Add((Metric)m, INT64_MIN);
+					}
+				}
+
+				clock->timeUs += i == 100 ? 60000 : 16667;
+				tracker.EndFrame(&metrics);
+
+				metrics.EndFrame();
+			}
+
+			Assert::AreEqual((uint64_t)1, tracker.GetHitchCount());
+			Assert::AreEqual(INT64_MIN, tracker.GetRecentHitch(0).metrics[0]);
+
+			tracker.LogSummary();
+		}
+
+		TEST_METHOD(NoHitchesDuringWarmup)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			FrameTimeTracker tracker{ clock };
+
+			tracker.EndFrame(nullptr);
+
+			/* Loading screens can be slow to begin with. */
+			for (int32_t i = 0; i < 10; ++i)
+			{
+				clock->timeUs += i == 5 ? 500000 : 16667;
+				Assert::IsFalse(tracker.EndFrame(nullptr));
+			}
+		}
+
+		TEST_METHOD(OnlyTheMostRecentHitchesAreKept)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			FrameTimeTracker tracker{ clock };
+
+			tracker.EndFrame(nullptr);
+
+			for (int32_t i = 0; i < 2000; ++i)
+			{
+				clock->timeUs += (i >= 100 && !(i % 20)) ? 100000 : 10000;
+				tracker.EndFrame(nullptr);
+			}
+
+			Assert::AreEqual((uint64_t)95, tracker.GetHitchCount());
+			Assert::AreEqual(FrameTimeTracker::MaxRecentHitches, tracker.GetRecentHitchCount());
+			Assert::AreEqual((uint64_t)(2000 - 20 * FrameTimeTracker::MaxRecentHitches), tracker.GetRecentHitch(0).frame);
+			Assert::AreEqual((uint64_t)1980, tracker.GetRecentHitch(FrameTimeTracker::MaxRecentHitches - 1).frame);
+			Assert::IsFalse(tracker.GetRecentHitch(0).hasMetrics);
+		}
+	};
+}
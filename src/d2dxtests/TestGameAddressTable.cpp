@@ -0,0 +1,155 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/Buffer.h"
+#include "../d2dx/GameAddressTable.h"
+#include "../d2dx/Utils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	/* Same as the 1.13c table in GameHelper. */
+	static constexpr uint32_t testGameAddresses[(int32_t)GameAddress::Count] =
+	{
+		0xFFFFFFFF,
+		0x6f8567ab, /* DrawWall1 */
+		0x6f8567b9, /* DrawWall2 */
+		0x6f85befc, /* DrawFloor */
+		0x50a995, /* DrawShadow */
+		0x6f85a344,  /* DrawDynamic */
+		0x0050c38d, /* DrawSomething1 */
+		0x0050c0de, /* DrawSomething2 */
+	};
+
+	static constexpr GameAddressTable testTable{ testGameAddresses };
+	static_assert(testTable.IsValid(), "");
+
+	/* The lookup as it was done before GameAddressTable. */
+	static GameAddress FindLinear(
+		_In_ uint32_t returnAddress)
+	{
+		for (uint32_t i = 0; i < ARRAYSIZE(testGameAddresses); ++i)
+		{
+			if (testGameAddresses[i] == returnAddress)
+			{
+				return (GameAddress)i;
+			}
+		}
+
+		return GameAddress::Unknown;
+	}
+
+	/* A typical stream of return addresses passed to PrepareBatchForSubmit in one in-game frame, as runs of
+	   (address, count). Most draws come from the floor/wall/dynamic call sites, the rest from UI and text
+	   call sites that are not in the table. */
+	static const uint32_t recordedGameContexts[][2] =
+	{
+		{ 0x6f85befc, 212 }, { 0x6f8567ab, 46 }, { 0x6f8567b9, 38 }, { 0x6f85a344, 3 }, { 0x50a995, 1 },
+		{ 0x6f85a344, 1 }, { 0x50a995, 1 }, { 0x6f85a344, 2 }, { 0x6f8567ab, 12 }, { 0x6f85a344, 17 },
+		{ 0x6f8ab12c, 1 }, { 0x6f8a9e7a, 4 }, { 0x6fa8b5e4, 31 }, { 0x6fa8b5e4, 18 }, { 0x6f8b1c0e, 9 },
+		{ 0x6f8ab12c, 2 }, { 0x6fa8c211, 65 }, { 0x6f8b1c0e, 40 }, { 0x0050c38d, 1 }, { 0x0050c0de, 1 },
+		{ 0x6fa8c211, 12 }, { 0x6f8a9e7a, 6 }, { 0x6fa8b5e4, 3 },
+	};
+
+	TEST_CLASS(TestGameAddressTable)
+	{
+	public:
+		TEST_METHOD(FindsAllAddresses)
+		{
+			for (int32_t i = 1; i < (int32_t)GameAddress::Count; ++i)
+			{
+				Assert::IsTrue((GameAddress)i == testTable.Find(testGameAddresses[i]));
+			}
+		}
+
+		TEST_METHOD(UnknownAddresses)
+		{
+			const GameAddressTable emptyTable;
+
+			Assert::IsTrue(GameAddress::Unknown == testTable.Find(0));
+			Assert::IsTrue(GameAddress::Unknown == testTable.Find(0xFFFFFFFF));
+			Assert::IsTrue(GameAddress::Unknown == emptyTable.Find(0));
+			Assert::IsTrue(GameAddress::Unknown == emptyTable.Find(0x6f8567ab));
+
+			for (uint32_t returnAddress = 0x6f850000; returnAddress < 0x6f860000; ++returnAddress)
+			{
+				Assert::IsTrue(FindLinear(returnAddress) == testTable.Find(returnAddress));
+			}
+		}
+
+		TEST_METHOD(BenchmarkRecordedGameContexts)
+		{
+			uint32_t streamLength = 0;
+
+			for (uint32_t i = 0; i < ARRAYSIZE(recordedGameContexts); ++i)
+			{
+				streamLength += recordedGameContexts[i][1];
+			}
+
+			Buffer<uint32_t> stream{ streamLength };
+			uint32_t position = 0;
+
+			for (uint32_t i = 0; i < ARRAYSIZE(recordedGameContexts); ++i)
+			{
+				for (uint32_t j = 0; j < recordedGameContexts[i][1]; ++j)
+				{
+					stream.items[position++] = recordedGameContexts[i][0];
+				}
+			}
+
+			const int32_t frameCount = 10000;
+
+			uint32_t linearChecksum = 0;
+			int64_t start = TimeStart();
+
+			for (int32_t frame = 0; frame < frameCount; ++frame)
+			{
+				for (uint32_t i = 0; i < streamLength; ++i)
+				{
+					linearChecksum += (uint32_t)FindLinear(stream.items[i]);
+				}
+			}
+
+			const float linearMs = TimeEndMs(start);
+
+			uint32_t tableChecksum = 0;
+			start = TimeStart();
+
+			for (int32_t frame = 0; frame < frameCount; ++frame)
+			{
+				for (uint32_t i = 0; i < streamLength; ++i)
+				{
+					tableChecksum += (uint32_t)testTable.Find(stream.items[i]);
+				}
+			}
+
+			const float tableMs = TimeEndMs(start);
+
+			char message[256];
+			sprintf_s(message, "%i frames x %u draws: linear search %f ms, direct-mapped table %f ms",
+				frameCount, streamLength, linearMs, tableMs);
+			Logger::WriteMessage(message);
+
+			Assert::AreEqual(linearChecksum, tableChecksum);
+		}
+	};
+}
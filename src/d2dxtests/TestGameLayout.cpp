@@ -0,0 +1,477 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/GameLayout.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	class FakeGameModules final : public IGameModules
+	{
+	public:
+		virtual uintptr_t GetBaseAddress(
+			_In_ GameModule module) const override
+		{
+			switch (module)
+			{
+			case GameModule::GameExe:
+				return 0x00400000;
+			case GameModule::D2Client:
+				return 0x6FAB0000;
+			case GameModule::D2Gfx:
+				return 0x6FA80000;
+			case GameModule::D2Win:
+				return 0x6F8E0000;
+			default:
+				return 0;
+			}
+		}
+
+		virtual void* GetExportByOrdinal(
+			_In_ GameModule module,
+			_In_ int32_t ordinal) const override
+		{
+			return (void*)(GetBaseAddress(module) + 0x10000 + ordinal * 16);
+		}
+	};
+
+	static const char implementedInD2dx[] = "";
+
+	/* GameHelper::GetFunction as it was before GameLayout, with the module handles faked. */
+	static void* GetFunctionReference(
+		_In_ GameVersion version,
+		_In_ D2Function function,
+		_In_ const FakeGameModules& modules)
+	{
+		const HANDLE hGameExe = (HANDLE)modules.GetBaseAddress(GameModule::GameExe);
+		const HANDLE hD2ClientDll = (HANDLE)modules.GetBaseAddress(GameModule::D2Client);
+		const HANDLE hD2GfxDll = (HANDLE)modules.GetBaseAddress(GameModule::D2Gfx);
+		const HANDLE hD2WinDll = (HANDLE)modules.GetBaseAddress(GameModule::D2Win);
+
+		if (function == D2Function::D2Client_GetPlayerUnit)
+		{
+			switch (version)
+			{
+			case GameVersion::Lod109d:
+				return (void*)((uintptr_t)hD2ClientDll + 0x8CFC0);
+			case GameVersion::Lod110f:
+				return (void*)((uintptr_t)hD2ClientDll + 0x883D0);
+			default:
+				return nullptr;
+			}
+		}
+
+		HANDLE hModule = nullptr;
+		int32_t ordinal = 0;
+
+		switch (version)
+		{
+		case GameVersion::Lod109d:
+			switch (function)
+			{
+			case D2Function::D2Gfx_DrawImage:
+				hModule = hD2GfxDll;
+				ordinal = 10072;
+				break;
+			case D2Function::D2Gfx_DrawShiftedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10073;
+				break;
+			case D2Function::D2Gfx_DrawVerticalCropImage:
+				hModule = hD2GfxDll;
+				ordinal = 10074;
+				break;
+			case D2Function::D2Gfx_DrawClippedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10077;
+				break;
+			case D2Function::D2Gfx_DrawImageFast:
+				hModule = hD2GfxDll;
+				ordinal = 10076;
+				break;
+			case D2Function::D2Gfx_DrawShadow:
+				hModule = hD2GfxDll;
+				ordinal = 10075;
+				break;
+			case D2Function::D2Win_DrawText:
+				hModule = hD2WinDll;
+				ordinal = 10117;
+				break;
+			case D2Function::D2Client_DrawUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0xB8350);
+			case D2Function::D2Client_FindClientSideUnit:
+				return (void*)implementedInD2dx;
+			case D2Function::D2Client_DrawWeatherParticles:
+				return (void*)((uintptr_t)hD2ClientDll + 0x07BC0);
+			case D2Function::D2Client_FindServerSideUnit:
+				return (void*)implementedInD2dx;
+			default:
+				break;
+			}
+			break;
+		case GameVersion::Lod110f:
+			switch (function)
+			{
+			case D2Function::D2Gfx_DrawImage:
+				hModule = hD2GfxDll;
+				ordinal = 10072;
+				break;
+			case D2Function::D2Gfx_DrawShiftedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10073;
+				break;
+			case D2Function::D2Gfx_DrawVerticalCropImage:
+				hModule = hD2GfxDll;
+				ordinal = 10074;
+				break;
+			case D2Function::D2Gfx_DrawClippedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10077;
+				break;
+			case D2Function::D2Gfx_DrawImageFast:
+				hModule = hD2GfxDll;
+				ordinal = 10076;
+				break;
+			case D2Function::D2Gfx_DrawShadow: 
+				hModule = hD2GfxDll;
+				ordinal = 10075;
+				break; 
+			case D2Function::D2Win_DrawText:
+				hModule = hD2WinDll;
+				ordinal = 10117;
+				break;
+			case D2Function::D2Client_DrawUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0xBA720);
+			case D2Function::D2Client_FindClientSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x86BE0);
+			case D2Function::D2Client_DrawWeatherParticles:
+				return (void*)((uintptr_t)hD2ClientDll + 0x08690);
+			case D2Function::D2Client_FindServerSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x86C70);
+			default:
+				break;
+			}
+			break;
+		case GameVersion::Lod112:
+			switch (function)
+			{
+			case D2Function::D2Gfx_DrawImage:
+				hModule = hD2GfxDll;
+				ordinal = 10024;
+				break;
+			case D2Function::D2Gfx_DrawShiftedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10044;
+				break;
+			case D2Function::D2Gfx_DrawVerticalCropImage:
+				hModule = hD2GfxDll;
+				ordinal = 10046;
+				break;
+			case D2Function::D2Gfx_DrawClippedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10061;
+				break;
+			case D2Function::D2Gfx_DrawImageFast:
+				hModule = hD2GfxDll;
+				ordinal = 10012;
+				break;
+			case D2Function::D2Gfx_DrawShadow:
+				hModule = hD2GfxDll;
+				ordinal = 10030;
+				break;
+			case D2Function::D2Win_DrawText:
+				hModule = hD2WinDll;
+				ordinal = 10001;
+				break;
+			//case D2Function::D2Win_DrawFramedText:
+			//	hModule = hD2WinDll;
+			//	ordinal = 10137;
+			//	break;
+			//case D2Function::D2Win_DrawRectangledText:
+			//	hModule = hD2WinDll;
+			//	ordinal = 10078;
+			//	break;
+			case D2Function::D2Client_DrawUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x94250);
+			case D2Function::D2Client_DrawMissile:
+				return (void*)((uintptr_t)hD2ClientDll + 0x949C0);
+			case D2Function::D2Client_DrawWeatherParticles:
+				return (void*)((uintptr_t)hD2ClientDll + 0x14210);
+			case D2Function::D2Client_FindClientSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x1F1A0);
+			case D2Function::D2Client_FindServerSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x1F1C0);
+			default:
+				break;
+			}
+			break;
+		case GameVersion::Lod113c:
+			switch (function)
+			{
+			case D2Function::D2Gfx_DrawImage:
+				hModule = hD2GfxDll;
+				ordinal = 10041;
+				break;
+			case D2Function::D2Gfx_DrawShiftedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10019;
+				break;
+			case D2Function::D2Gfx_DrawVerticalCropImage:
+				hModule = hD2GfxDll;
+				ordinal = 10074;
+				break;
+			case D2Function::D2Gfx_DrawClippedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10079;
+				break;
+			case D2Function::D2Gfx_DrawImageFast:
+				hModule = hD2GfxDll;
+				ordinal = 10046;
+				break;
+			case D2Function::D2Gfx_DrawShadow:
+				hModule = hD2GfxDll;
+				ordinal = 10011;
+				break;
+			case D2Function::D2Win_DrawText:
+				hModule = hD2WinDll;
+				ordinal = 10096;
+				break;
+			case D2Function::D2Win_DrawFramedText:
+				hModule = hD2WinDll; 
+				ordinal = 10085;
+				break;
+			case D2Function::D2Win_DrawRectangledText:
+				hModule = hD2WinDll;
+				ordinal = 10013;
+				break;
+			case D2Function::D2Client_DrawUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x6C490);
+			case D2Function::D2Client_DrawMissile:
+				return (void*)((uintptr_t)hD2ClientDll + 0x6CC00);
+			case D2Function::D2Client_DrawWeatherParticles:
+				return (void*)((uintptr_t)hD2ClientDll + 0x7FE80);
+			case D2Function::D2Client_FindClientSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0xA5B20);
+			case D2Function::D2Client_FindServerSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0xA5B40);
+			default:
+				break;
+			}
+			break;
+		case GameVersion::Lod113d:
+			switch (function)
+			{
+			case D2Function::D2Gfx_DrawImage:
+				hModule = hD2GfxDll;
+				ordinal = 10042;
+				break;
+			case D2Function::D2Gfx_DrawShiftedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10067;
+				break;
+			case D2Function::D2Gfx_DrawVerticalCropImage:
+				hModule = hD2GfxDll;
+				ordinal = 10082;
+				break;
+			case D2Function::D2Gfx_DrawClippedImage:
+				hModule = hD2GfxDll;
+				ordinal = 10015;
+				break;
+			case D2Function::D2Gfx_DrawImageFast:
+				hModule = hD2GfxDll;
+				ordinal = 10006;
+				break;
+			case D2Function::D2Gfx_DrawShadow:
+				hModule = hD2GfxDll;
+				ordinal = 10084;
+				break;
+			case D2Function::D2Win_DrawText:
+				hModule = hD2WinDll;
+				ordinal = 10076;
+				break;
+			case D2Function::D2Win_DrawTextEx:
+				hModule = hD2WinDll;
+				ordinal = 10084;
+				break;
+			case D2Function::D2Win_DrawFramedText:
+				hModule = hD2WinDll;
+				ordinal = 10137;
+				break;
+			case D2Function::D2Win_DrawRectangledText:
+				hModule = hD2WinDll;
+				ordinal = 10078;
+				break;
+			case D2Function::D2Client_DrawUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x605b0);
+			case D2Function::D2Client_DrawMissile:
+				return (void*)((uintptr_t)hD2ClientDll + 0x60C70);
+			case D2Function::D2Client_DrawWeatherParticles:
+				return (void*)((uintptr_t)hD2ClientDll + 0x4AD90);
+			case D2Function::D2Client_FindClientSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x620B0);
+			case D2Function::D2Client_FindServerSideUnit:
+				return (void*)((uintptr_t)hD2ClientDll + 0x620D0);
+			default:
+				break;
+			}
+			break;
+		case GameVersion::Lod114d:
+			switch (function)
+			{
+			case D2Function::D2Gfx_DrawImage:
+				return (void*)((uintptr_t)hGameExe + 0xF6480);
+			case D2Function::D2Gfx_DrawShiftedImage:
+				return (void*)((uintptr_t)hGameExe + 0xF64B0);
+			case D2Function::D2Gfx_DrawVerticalCropImage:
+				return (void*)((uintptr_t)hGameExe + 0xF64E0);
+			case D2Function::D2Gfx_DrawClippedImage:
+				return (void*)((uintptr_t)hGameExe + 0xF6510);
+			case D2Function::D2Gfx_DrawImageFast:
+				return (void*)((uintptr_t)hGameExe + 0xF6570);
+			case D2Function::D2Gfx_DrawShadow:
+				return (void*)((uintptr_t)hGameExe + 0xF6540);
+			case D2Function::D2Win_DrawText:
+				return (void*)((uintptr_t)hGameExe + 0x102320);
+			case D2Function::D2Win_DrawTextEx:
+				return (void*)((uintptr_t)hGameExe + 0x102360);
+			case D2Function::D2Win_DrawFramedText:
+				return (void*)((uintptr_t)hGameExe + 0x102280);
+			case D2Function::D2Win_DrawRectangledText:
+				return (void*)((uintptr_t)hGameExe + 0x1023B0);
+			case D2Function::D2Client_DrawUnit:
+				return (void*)((uintptr_t)hGameExe + 0x70EC0);
+			case D2Function::D2Client_DrawMissile:
+				return (void*)((uintptr_t)hGameExe + 0x71EC0);
+			case D2Function::D2Client_DrawWeatherParticles:
+				return (void*)((uintptr_t)hGameExe + 0x73470);
+			case D2Function::D2Client_FindClientSideUnit:
+				return (void*)((uintptr_t)hGameExe + 0x63990);
+			case D2Function::D2Client_FindServerSideUnit:
+				return (void*)((uintptr_t)hGameExe + 0x639B0);
+			default:
+				break;
+			}
+			break;
+		default:
+			break;
+		}
+
+		if (!hModule || !ordinal)
+		{
+			return nullptr;
+		}
+
+		return modules.GetExportByOrdinal(hModule == hD2GfxDll ? GameModule::D2Gfx : GameModule::D2Win, ordinal);
+	}
+
+	/* The addresses read by GameHelper's ScreenOpenMode, IsGameMenuOpen, IsInGame and GetPlayerUnit before GameLayout. */
+	static uintptr_t GetDataReference(
+		_In_ GameVersion version,
+		_In_ GameData data,
+		_In_ const FakeGameModules& modules)
+	{
+		const uintptr_t gameExe = modules.GetBaseAddress(GameModule::GameExe);
+		const uintptr_t d2ClientDll = modules.GetBaseAddress(GameModule::D2Client);
+
+		static const uint32_t d2ClientOffsets[][(int32_t)GameData::Count] =
+		{
+			{ 0x115C10, 0x1248D8, 0x1109FC, 0 }, /* Lod109d */
+			{ 0x10B9C4, 0x11A6CC, 0x1077C4, 0 }, /* Lod110f */
+			{ 0x11C1D0, 0x102B7C, 0x11BCC4, 0x11C3D0 }, /* Lod112 */
+			{ 0x11C414, 0xFADA4, 0xF8C9C, 0x11BBFC }, /* Lod113c */
+			{ 0x11D070, 0x11C8B4, 0xF79E0, 0x11D050 }, /* Lod113d */
+		};
+
+		static const uint32_t gameExeOffsets[(int32_t)GameData::Count] =
+		{
+			0x3A5210, 0x3A27E4, 0x3A27C0, 0x3A6A70 /* Lod114d */
+		};
+
+		if (version == GameVersion::Lod114d)
+		{
+			return gameExe + gameExeOffsets[(int32_t)data];
+		}
+
+		if (version >= GameVersion::Lod109d && version <= GameVersion::Lod113d)
+		{
+			const uint32_t offset = d2ClientOffsets[(int32_t)version - (int32_t)GameVersion::Lod109d][(int32_t)data];
+			return offset ? d2ClientDll + offset : 0;
+		}
+
+		return 0;
+	}
+
+	TEST_CLASS(TestGameLayout)
+	{
+	public:
+		TEST_METHOD(FunctionsMatchPerVersionSwitch)
+		{
+			const FakeGameModules modules;
+
+			for (int32_t version = (int32_t)GameVersion::Unsupported; version <= (int32_t)GameVersion::Lod114d; ++version)
+			{
+				const GameLayout layout{ (GameVersion)version, modules };
+
+				for (int32_t function = 0; function < (int32_t)D2Function::Count; ++function)
+				{
+					void* expected = GetFunctionReference((GameVersion)version, (D2Function)function, modules);
+					void* actual = layout.GetFunction((D2Function)function);
+
+					if (expected == (void*)implementedInD2dx)
+					{
+						Assert::IsNotNull(actual);
+					}
+					else
+					{
+						Assert::AreEqual((uintptr_t)expected, (uintptr_t)actual);
+					}
+				}
+			}
+		}
+
+		TEST_METHOD(DataMatchesPerVersionSwitch)
+		{
+			const FakeGameModules modules;
+
+			for (int32_t version = (int32_t)GameVersion::Unsupported; version <= (int32_t)GameVersion::Lod114d; ++version)
+			{
+				const GameLayout layout{ (GameVersion)version, modules };
+
+				for (int32_t data = 0; data < (int32_t)GameData::Count; ++data)
+				{
+					Assert::AreEqual(
+						GetDataReference((GameVersion)version, (GameData)data, modules),
+						(uintptr_t)layout.GetData((GameData)data));
+				}
+			}
+		}
+
+		TEST_METHOD(OutOfRangeFunctionIsNull)
+		{
+			const FakeGameModules modules;
+			const GameLayout layout{ GameVersion::Lod113c, modules };
+
+			Assert::IsNull(layout.GetFunction(D2Function::Count));
+			Assert::IsNull(layout.GetFunction((D2Function)-1));
+		}
+	};
+}
@@ -0,0 +1,140 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/GameStateTracker.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	class FakeGameStateHelper final : public IGameHelper
+	{
+	public:
+		virtual GameVersion GetVersion() const override { return GameVersion::Lod113c; }
+		virtual _Ret_z_ const char* GetVersionString() const override { return "fake"; }
+		virtual uint32_t ScreenOpenMode() const override { ++reads; return screenOpenMode; }
+		virtual Size GetConfiguredGameSize() const override { return { 800, 600 }; }
+		virtual GameAddress IdentifyGameAddress(uint32_t returnAddress) const override { return GameAddress::Unknown; }
+		virtual TextureCategory GetTextureCategoryFromHash(uint32_t textureHash) const override { return TextureCategory::Unknown; }
+		virtual TextureCategory RefineTextureCategoryFromGameAddress(TextureCategory previousCategory, GameAddress gameAddress) const override { return previousCategory; }
+		virtual bool TryApplyInGameFpsFix() override { return false; }
+		virtual bool TryApplyMenuFpsFix() override { return false; }
+		virtual bool TryApplyInGameSleepFixes() override { return false; }
+		virtual void* GetFunction(D2Function function) const override { return nullptr; }
+		virtual DrawParameters GetDrawParameters(const D2::CellContext* cellContext) const override { return { }; }
+		virtual D2::UnitAny* GetPlayerUnit() const override { ++reads; return playerUnit; }
+		virtual Offset GetUnitPos(const D2::UnitAny* unit) const override { return { 0, 0 }; }
+		virtual D2::UnitType GetUnitType(const D2::UnitAny* unit) const override { return D2::UnitType::Player; }
+		virtual uint32_t GetUnitId(const D2::UnitAny* unit) const override { return 0; }
+		virtual D2::UnitAny* FindUnit(uint32_t unitId, D2::UnitType unitType) const override { return nullptr; }
+		virtual int32_t GetCurrentAct() const override { ++reads; return currentAct; }
+		virtual bool IsGameMenuOpen() const override { ++reads; return isGameMenuOpen; }
+		virtual bool IsInGame() const override { ++reads; return isInGame; }
+		virtual bool IsProjectDiablo2() const override { return false; }
+
+		uint32_t screenOpenMode = 0;
+		bool isInGame = false;
+		bool isGameMenuOpen = false;
+		D2::UnitAny* playerUnit = nullptr;
+		int32_t currentAct = 0;
+		mutable int32_t reads = 0;
+	};
+
+	class RecordingGameStateObserver final : public IGameStateObserver
+	{
+	public:
+		virtual void OnGameStateChanged(
+			_In_ const GameStateSnapshot& gameState) override
+		{
+			++notifications;
+			lastGameState = gameState;
+		}
+
+		int32_t notifications = 0;
+		GameStateSnapshot lastGameState;
+	};
+
+	TEST_CLASS(TestGameStateTracker)
+	{
+	public:
+		TEST_METHOD(NoNotificationWithoutChanges)
+		{
+			auto gameHelper = std::make_shared<FakeGameStateHelper>();
+			GameStateTracker tracker{ gameHelper };
+			RecordingGameStateObserver observer;
+			tracker.AddObserver(&observer);
+
+			tracker.Capture();
+			tracker.Capture();
+
+			Assert::AreEqual(0, observer.notifications);
+			Assert::AreEqual(0U, tracker.GetSnapshot().changes);
+			Assert::AreEqual(-1, tracker.GetSnapshot().currentAct);
+		}
+
+		TEST_METHOD(NotifiesChangedFields)
+		{
+			auto gameHelper = std::make_shared<FakeGameStateHelper>();
+			GameStateTracker tracker{ gameHelper };
+			RecordingGameStateObserver observer;
+			tracker.AddObserver(&observer);
+
+			D2::UnitAny* playerUnit = (D2::UnitAny*)0x12345678;
+			gameHelper->isInGame = true;
+			gameHelper->playerUnit = playerUnit;
+			gameHelper->currentAct = 2;
+			tracker.Capture();
+
+			Assert::AreEqual(1, observer.notifications);
+			Assert::IsTrue(observer.lastGameState.HasChanged(GameStateChange::InGame));
+			Assert::IsTrue(observer.lastGameState.HasChanged(GameStateChange::PlayerUnit));
+			Assert::IsTrue(observer.lastGameState.HasChanged(GameStateChange::CurrentAct));
+			Assert::IsFalse(observer.lastGameState.HasChanged(GameStateChange::ScreenOpenMode));
+			Assert::IsFalse(observer.lastGameState.HasChanged(GameStateChange::GameMenuOpen));
+			Assert::IsTrue(observer.lastGameState.playerUnit == playerUnit);
+			Assert::AreEqual(2, observer.lastGameState.currentAct);
+
+			gameHelper->screenOpenMode = 1;
+			tracker.Capture();
+
+			Assert::AreEqual(2, observer.notifications);
+			Assert::AreEqual((uint32_t)GameStateChange::ScreenOpenMode, observer.lastGameState.changes);
+			Assert::AreEqual(1U, observer.lastGameState.screenOpenMode);
+		}
+
+		TEST_METHOD(ReadsGameStateOnlyOnCapture)
+		{
+			auto gameHelper = std::make_shared<FakeGameStateHelper>();
+			GameStateTracker tracker{ gameHelper };
+			gameHelper->isInGame = true;
+
+			tracker.Capture();
+			const int32_t readsPerCapture = gameHelper->reads;
+
+			for (int32_t i = 0; i < 1000; ++i)
+			{
+				Assert::IsTrue(tracker.GetSnapshot().isInGame);
+			}
+
+			Assert::AreEqual(readsPerCapture, gameHelper->reads);
+		}
+	};
+}
@@ -0,0 +1,146 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/GpuRingAllocator.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestGpuRingAllocator)
+	{
+	public:
+		TEST_METHOD(AllocationsFollowEachOther)
+		{
+			GpuRingAllocator ring{ 100, 2 };
+
+			auto a = ring.Allocate(10);
+			auto b = ring.Allocate(20);
+
+			Assert::AreEqual(0U, a.offset);
+			Assert::IsFalse(a.discard);
+			Assert::AreEqual(10U, b.offset);
+			Assert::IsFalse(b.discard);
+			Assert::AreEqual(30U, ring.GetUsedSize());
+		}
+
+		TEST_METHOD(AllocationsAreAligned)
+		{
+			GpuRingAllocator ring{ 1024, 2 };
+
+			ring.Allocate(32, 256);
+			auto b = ring.Allocate(32, 256);
+
+			Assert::AreEqual(256U, b.offset);
+			Assert::AreEqual(256U + 32U, ring.GetUsedSize());
+		}
+
+		TEST_METHOD(FramesInFlightAreNotOverwritten)
+		{
+			GpuRingAllocator ring{ 100, 2 };
+
+			ring.Allocate(40);
+			ring.EndFrame();
+			ring.Allocate(40);
+			ring.EndFrame();
+
+			/* Both frames are in flight, and only 20 is left at the end. */
+			auto a = ring.Allocate(30);
+			Assert::IsTrue(a.discard);
+			Assert::AreEqual(0U, a.offset);
+			Assert::AreEqual(1U, ring.GetDiscardCount());
+			Assert::AreEqual(30U, ring.GetUsedSize());
+		}
+
+		TEST_METHOD(RetiredFramesAreReused)
+		{
+			GpuRingAllocator ring{ 100, 2 };
+
+			ring.Allocate(40);
+			ring.EndFrame();
+			ring.Allocate(40);
+			ring.EndFrame();
+			ring.Allocate(10);
+			ring.EndFrame();
+
+			/* The first frame has retired. */
+			Assert::AreEqual(40U, ring.GetRetiredPosition());
+			Assert::AreEqual(50U, ring.GetUsedSize());
+
+			/* 10 is left at the end, so wrap into the space of the first frame. */
+			auto a = ring.Allocate(30);
+			Assert::IsFalse(a.discard);
+			Assert::AreEqual(0U, a.offset);
+			Assert::AreEqual(90U, ring.GetUsedSize());
+
+			auto b = ring.Allocate(20);
+			Assert::IsTrue(b.discard);
+		}
+
+		TEST_METHOD(SteadyStateNeverDiscards)
+		{
+			GpuRingAllocator ring{ 1000, 3 };
+
+			for (uint32_t frame = 0; frame < 1000; ++frame)
+			{
+				auto a = ring.Allocate(77);
+				auto b = ring.Allocate(3);
+				ring.EndFrame();
+
+				Assert::IsFalse(a.discard || b.discard);
+				Assert::IsTrue(a.offset + 77 <= 1000 && b.offset + 3 <= 1000);
+				Assert::IsTrue(ring.GetUsedSize() <= 1000U);
+			}
+
+			Assert::AreEqual(0U, ring.GetDiscardCount());
+		}
+
+		TEST_METHOD(DiscardReleasesFramesInFlight)
+		{
+			GpuRingAllocator ring{ 100, 4 };
+
+			ring.Allocate(60);
+			ring.EndFrame();
+			Assert::IsTrue(ring.Allocate(60).discard);
+			ring.EndFrame();
+
+			/* The frame before the discard no longer uses any space. */
+			auto a = ring.Allocate(40);
+			Assert::IsFalse(a.discard);
+			Assert::AreEqual(60U, a.offset);
+			Assert::AreEqual(100U, ring.GetUsedSize());
+		}
+
+		TEST_METHOD(IdleRingStartsOver)
+		{
+			GpuRingAllocator ring{ 100, 1 };
+
+			ring.Allocate(70);
+			ring.EndFrame();
+			ring.EndFrame();
+			Assert::AreEqual(0U, ring.GetUsedSize());
+
+			auto a = ring.Allocate(80);
+			Assert::IsFalse(a.discard);
+			Assert::AreEqual(0U, a.offset);
+		}
+	};
+}
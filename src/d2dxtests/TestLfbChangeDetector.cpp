@@ -0,0 +1,135 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/LfbChangeDetector.h"
+#include "../d2dx/SimdSse2.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestLfbChangeDetector)
+	{
+	public:
+		TEST_METHOD(FirstFrameIsChanged)
+		{
+			LfbChangeDetector detector{ std::make_shared<SimdSse2>(), 640, 480 };
+			std::vector<uint32_t> frame(640 * 480, 0);
+
+			Assert::IsTrue(detector.Update(frame.data(), 640 * 4));
+			Assert::AreEqual(0, detector.GetFirstDirtyRow());
+			Assert::AreEqual(479, detector.GetLastDirtyRow());
+		}
+
+		TEST_METHOD(RepeatedFramesAreUnchanged)
+		{
+			LfbChangeDetector detector{ std::make_shared<SimdSse2>(), 640, 480 };
+			std::vector<uint32_t> frame(640 * 480, 0xFF102030);
+
+			Assert::IsTrue(detector.Update(frame.data(), 640 * 4));
+
+			for (int32_t i = 0; i < 5; ++i)
+			{
+				Assert::IsFalse(detector.Update(frame.data(), 640 * 4));
+				Assert::AreEqual(-1, detector.GetFirstDirtyRow());
+			}
+
+			Assert::AreEqual((uint64_t)5, detector.GetUnchangedFrameCount());
+		}
+
+		TEST_METHOD(FindsTheChangedRows)
+		{
+			LfbChangeDetector detector{ std::make_shared<SimdSse2>(), 640, 480 };
+			std::vector<uint32_t> frame(640 * 480, 0);
+
+			detector.Update(frame.data(), 640 * 4);
+
+			/* A single pixel at the end of a row. */
+			frame[100 * 640 + 639] = 1;
+			Assert::IsTrue(detector.Update(frame.data(), 640 * 4));
+			Assert::AreEqual(100, detector.GetFirstDirtyRow());
+			Assert::AreEqual(100, detector.GetLastDirtyRow());
+
+			/* Subtitles: a band near the bottom. */
+			for (int32_t y = 400; y < 440; ++y)
+			{
+				for (int32_t x = 100; x < 540; x += 7)
+				{
+					frame[y * 640 + x] = 0xFFFFFFFF;
+				}
+			}
+
+			Assert::IsTrue(detector.Update(frame.data(), 640 * 4));
+			Assert::AreEqual(400, detector.GetFirstDirtyRow());
+			Assert::AreEqual(439, detector.GetLastDirtyRow());
+
+			Assert::IsFalse(detector.Update(frame.data(), 640 * 4));
+		}
+
+		TEST_METHOD(ComparesWithThePreviousFrameOnly)
+		{
+			LfbChangeDetector detector{ std::make_shared<SimdSse2>(), 640, 480 };
+			std::vector<uint32_t> frameA(640 * 480, 0);
+			std::vector<uint32_t> frameB(640 * 480, 0);
+			frameB[0] = 1;
+
+			/* Alternating between two frames changes the screen every time. */
+			for (int32_t i = 0; i < 4; ++i)
+			{
+				Assert::IsTrue(detector.Update(frameA.data(), 640 * 4));
+				Assert::IsTrue(detector.Update(frameB.data(), 640 * 4));
+				Assert::AreEqual(0, detector.GetFirstDirtyRow());
+				Assert::AreEqual(0, detector.GetLastDirtyRow());
+			}
+		}
+
+		TEST_METHOD(ResetMakesTheNextFrameChanged)
+		{
+			LfbChangeDetector detector{ std::make_shared<SimdSse2>(), 640, 480 };
+			std::vector<uint32_t> frame(640 * 480, 0);
+
+			detector.Update(frame.data(), 640 * 4);
+			detector.Reset();
+
+			Assert::IsTrue(detector.Update(frame.data(), 640 * 4));
+			Assert::AreEqual(0, detector.GetFirstDirtyRow());
+			Assert::AreEqual(479, detector.GetLastDirtyRow());
+			Assert::IsFalse(detector.Update(frame.data(), 640 * 4));
+		}
+
+		TEST_METHOD(HonorsTheStride)
+		{
+			LfbChangeDetector detector{ std::make_shared<SimdSse2>(), 64, 4 };
+			std::vector<uint32_t> frame(80 * 4, 0);
+
+			detector.Update(frame.data(), 80 * 4);
+
+			/* Padding between the rows isn't part of the image. */
+			frame[1 * 80 + 70] = 1;
+			Assert::IsFalse(detector.Update(frame.data(), 80 * 4));
+
+			frame[2 * 80 + 63] = 1;
+			Assert::IsTrue(detector.Update(frame.data(), 80 * 4));
+			Assert::AreEqual(2, detector.GetFirstDirtyRow());
+			Assert::AreEqual(2, detector.GetLastDirtyRow());
+		}
+	};
+}
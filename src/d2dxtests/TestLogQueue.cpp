@@ -0,0 +1,284 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/LogQueue.h"
+#include "../d2dx/Utils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	class RecordingLogSink final : public ILogSink
+	{
+	public:
+		virtual void Write(
+			_In_reads_(length) const char* text,
+			_In_ uint32_t length) override
+		{
+			isWriting = true;
+
+			while (isBlocked)
+			{
+				std::this_thread::yield();
+			}
+
+			Assert::AreEqual((size_t)length, strlen(text));
+			written.append(text, length);
+			++batches;
+		}
+
+		std::string written;
+		int32_t batches = 0;
+		std::atomic<bool> isBlocked{ false };
+		std::atomic<bool> isWriting{ false };
+	};
+
+	/* Checks that the lines written by each producer arrive complete and in order. */
+	class StressLogSink final : public ILogSink
+	{
+	public:
+		virtual void Write(
+			_In_reads_(length) const char* text,
+			_In_ uint32_t length) override
+		{
+			const char* end = text + length;
+
+			while (text < end)
+			{
+				const char* newline = (const char*)memchr(text, '\n', end - text);
+				Assert::IsNotNull(newline);
+
+				int32_t producer = 0;
+				int32_t sequence = 0;
+				uint32_t dropped = 0;
+
+				if (sscanf_s(text, "producer %d message %d", &producer, &sequence) == 2)
+				{
+					Assert::IsTrue(producer >= 0 && producer < 16);
+					Assert::IsTrue(sequence > lastSequence[producer]);
+					lastSequence[producer] = sequence;
+					++lines;
+				}
+				else
+				{
+					Assert::AreEqual(1, sscanf_s(text, "%u log messages were dropped.", &dropped));
+					reportedDropped += dropped;
+				}
+
+				text = newline + 1;
+			}
+		}
+
+		int32_t lastSequence[16] = { -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
+		uint64_t lines = 0;
+		uint64_t reportedDropped = 0;
+	};
+
+	class TempFileLogSink final : public ILogSink
+	{
+	public:
+		TempFileLogSink()
+		{
+			Assert::AreEqual(0, (int32_t)tmpfile_s(&_file));
+		}
+
+		virtual ~TempFileLogSink() noexcept
+		{
+			fclose(_file);
+		}
+
+		virtual void Write(
+			_In_reads_(length) const char* text,
+			_In_ uint32_t length) override
+		{
+			fwrite(text, length, 1, _file);
+			fflush(_file);
+		}
+
+	private:
+		FILE* _file = nullptr;
+	};
+
+	TEST_CLASS(TestLogQueue)
+	{
+	public:
+		TEST_METHOD(FlushWritesAllMessagesInOrder)
+		{
+			auto sink = std::make_shared<RecordingLogSink>();
+			LogQueue logQueue{ 16, sink };
+
+			Assert::IsTrue(logQueue.TryPush("first\n"));
+			Assert::IsTrue(logQueue.TryPush("second\n"));
+			Assert::IsTrue(logQueue.TryPush("third\n"));
+			logQueue.Flush();
+
+			Assert::AreEqual(std::string{ "first\nsecond\nthird\n" }, sink->written);
+			Assert::AreEqual((uint64_t)3, logQueue.GetWrittenCount());
+			Assert::AreEqual((uint64_t)0, logQueue.GetDroppedCount());
+		}
+
+		TEST_METHOD(StopWritesPendingMessagesAndLaterOnesDirectly)
+		{
+			auto sink = std::make_shared<RecordingLogSink>();
+			LogQueue logQueue{ 16, sink };
+
+			Assert::IsTrue(logQueue.TryPush("first\n"));
+			Assert::IsTrue(logQueue.TryPush("second\n"));
+			logQueue.Stop();
+
+			Assert::AreEqual(std::string{ "first\nsecond\n" }, sink->written);
+
+			Assert::IsTrue(logQueue.TryPush("third\n"));
+			Assert::AreEqual(std::string{ "first\nsecond\nthird\n" }, sink->written);
+
+			logQueue.Flush();
+			logQueue.Stop();
+			Assert::AreEqual((uint64_t)3, logQueue.GetWrittenCount());
+		}
+
+		TEST_METHOD(LongMessagesAreTruncated)
+		{
+			auto sink = std::make_shared<RecordingLogSink>();
+			LogQueue logQueue{ 16, sink };
+
+			std::string message(1000, 'x');
+			Assert::IsTrue(logQueue.TryPush(message.c_str()));
+			logQueue.Flush();
+
+			Assert::AreEqual((size_t)LogQueue::MaxMessageLength, sink->written.size());
+		}
+
+		TEST_METHOD(FullQueueDropsAndReportsMessages)
+		{
+			auto sink = std::make_shared<RecordingLogSink>();
+			LogQueue logQueue{ 16, sink };
+
+			/* Stall the writer inside the sink, after it has taken the first message off the queue. */
+			sink->isBlocked = true;
+			Assert::IsTrue(logQueue.TryPush("first\n"));
+
+			while (!sink->isWriting)
+			{
+				std::this_thread::yield();
+			}
+
+			for (int32_t i = 0; i < 16; ++i)
+			{
+				Assert::IsTrue(logQueue.TryPush("queued\n"));
+			}
+
+			for (int32_t i = 0; i < 5; ++i)
+			{
+				Assert::IsFalse(logQueue.TryPush("dropped\n"));
+			}
+
+			Assert::AreEqual((uint64_t)5, logQueue.GetDroppedCount());
+
+			sink->isBlocked = false;
+			logQueue.Flush();
+
+			Assert::AreEqual((uint64_t)17, logQueue.GetWrittenCount());
+			Assert::IsTrue(sink->written.find("dropped\n") == std::string::npos);
+			Assert::IsTrue(sink->written.find("5 log messages were dropped.\n") != std::string::npos);
+		}
+
+		TEST_METHOD(ManyProducersLoseNothingUnaccounted)
+		{
+			const int32_t producerCount = 8;
+			const int32_t messagesPerProducer = 20000;
+
+			auto sink = std::make_shared<StressLogSink>();
+			LogQueue logQueue{ 256, sink };
+			std::vector<std::thread> producers;
+
+			for (int32_t p = 0; p < producerCount; ++p)
+			{
+				producers.emplace_back([&logQueue, p]() {
+					char message[64];
+					for (int32_t i = 0; i < messagesPerProducer; ++i)
+					{
+						sprintf_s(message, "producer %d message %d\n", p, i);
+						logQueue.TryPush(message);
+					}
+				});
+			}
+
+			for (auto& producer : producers)
+			{
+				producer.join();
+			}
+
+			logQueue.Flush();
+
+			const uint64_t pushed = (uint64_t)producerCount * messagesPerProducer;
+			Assert::AreEqual(pushed, logQueue.GetWrittenCount() + logQueue.GetDroppedCount());
+			Assert::AreEqual(logQueue.GetWrittenCount(), sink->lines);
+			Assert::AreEqual(logQueue.GetDroppedCount(), sink->reportedDropped);
+		}
+
+		TEST_METHOD(BenchmarkThroughput)
+		{
+			const int32_t messageCount = 200000;
+			const char* message = "Texture hash 0x12345678 categorized as UI.\n";
+			float directMs = 0.0f;
+
+			/* The previous approach: each message written and flushed separately, under a lock. */
+			{
+				TempFileLogSink directSink;
+				std::mutex mutex;
+
+				int64_t start = TimeStart();
+
+				for (int32_t i = 0; i < messageCount; ++i)
+				{
+					std::lock_guard<std::mutex> lock{ mutex };
+					directSink.Write(message, (uint32_t)strlen(message));
+				}
+
+				directMs = TimeEndMs(start);
+			}
+
+			auto sink = std::make_shared<TempFileLogSink>();
+			LogQueue logQueue{ 1024, sink };
+
+			int64_t start = TimeStart();
+
+			for (int32_t i = 0; i < messageCount; ++i)
+			{
+				while (!logQueue.TryPush(message))
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			const float pushMs = TimeEndMs(start);
+			logQueue.Flush();
+			const float totalMs = TimeEndMs(start);
+
+			Assert::AreEqual((uint64_t)messageCount, logQueue.GetWrittenCount());
+
+			char report[256];
+			sprintf_s(report, "%i messages: locked write + flush per message %f ms, queue push %f ms, push + drain %f ms",
+				messageCount, directMs, pushMs, totalMs);
+			Logger::WriteMessage(report);
+		}
+	};
+}
@@ -0,0 +1,135 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/MemoryBudget.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestMemoryBudget)
+	{
+	public:
+		TEST_METHOD(NoBudgetGivesEveryoneTheirMaximum)
+		{
+			MemoryBudget budget{ 2, 0 };
+			budget.SetLimits(0, 100, 1000);
+			budget.SetLimits(1, 10, 20);
+
+			Assert::IsTrue(budget.Rebalance());
+			Assert::AreEqual(1000ULL, budget.GetAllowance(0));
+			Assert::AreEqual(20ULL, budget.GetAllowance(1));
+			Assert::IsFalse(budget.Rebalance());
+		}
+
+		TEST_METHOD(DemandIsMetAndLeftoverIsSharedByHeadroom)
+		{
+			MemoryBudget budget{ 2, 1000 };
+			budget.SetLimits(0, 100, 1000);
+			budget.SetLimits(1, 100, 400);
+			budget.ReportDemand(0, 400);
+			budget.ReportDemand(1, 200);
+			budget.Rebalance();
+
+			/* 400 are left over, and the headroom is 600 and 200. */
+			Assert::AreEqual(700ULL, budget.GetAllowance(0));
+			Assert::AreEqual(300ULL, budget.GetAllowance(1));
+		}
+
+		TEST_METHOD(DemandIsScaledDownWhenOverBudget)
+		{
+			MemoryBudget budget{ 2, 600 };
+			budget.SetLimits(0, 100, 1000);
+			budget.SetLimits(1, 100, 1000);
+			budget.ReportDemand(0, 900);
+			budget.ReportDemand(1, 300);
+			budget.Rebalance();
+
+			/* 400 above the minimums is split 4:1. */
+			Assert::AreEqual(420ULL, budget.GetAllowance(0));
+			Assert::AreEqual(180ULL, budget.GetAllowance(1));
+			Assert::AreEqual(600ULL, budget.GetAllowance(0) + budget.GetAllowance(1));
+		}
+
+		TEST_METHOD(MinimumsAreKeptEvenOverBudget)
+		{
+			MemoryBudget budget{ 2, 100 };
+			budget.SetLimits(0, 80, 1000);
+			budget.SetLimits(1, 80, 1000);
+			budget.ReportDemand(0, 500);
+			budget.Rebalance();
+
+			Assert::AreEqual(80ULL, budget.GetAllowance(0));
+			Assert::AreEqual(80ULL, budget.GetAllowance(1));
+		}
+
+		TEST_METHOD(DemandDecaysSlowly)
+		{
+			MemoryBudget budget{ 2, 1000 };
+			budget.SetLimits(0, 0, 1000);
+			budget.SetLimits(1, 0, 1000);
+			budget.ReportDemand(0, 800);
+			budget.ReportDemand(1, 200);
+			budget.Rebalance();
+
+			Assert::AreEqual(800ULL, budget.GetAllowance(0));
+
+			/* No demand reported since: consumer 0 gives up a quarter of its demand at a time, and the
+			   200 left over are shared by headroom (400 and 800). */
+			budget.ReportDemand(1, 200);
+			budget.Rebalance();
+
+			Assert::AreEqual(666ULL, budget.GetAllowance(0));
+			Assert::AreEqual(333ULL, budget.GetAllowance(1));
+		}
+
+		TEST_METHOD(ChangingTheBudgetShrinksAllowances)
+		{
+			MemoryBudget budget{ 2, 0 };
+			budget.SetLimits(0, 100, 1000);
+			budget.SetLimits(1, 100, 1000);
+			budget.ReportDemand(0, 1000);
+			budget.ReportDemand(1, 1000);
+			budget.Rebalance();
+
+			Assert::AreEqual(1000ULL, budget.GetAllowance(0));
+
+			budget.SetBudget(1000);
+			budget.ReportDemand(0, 1000);
+			budget.ReportDemand(1, 1000);
+
+			Assert::IsTrue(budget.Rebalance());
+			Assert::AreEqual(500ULL, budget.GetAllowance(0));
+			Assert::AreEqual(500ULL, budget.GetAllowance(1));
+		}
+
+		TEST_METHOD(TotalUsage)
+		{
+			MemoryBudget budget{ 3, 0 };
+			budget.ReportUsage(0, 1);
+			budget.ReportUsage(1, 20);
+			budget.ReportUsage(2, 300);
+			budget.ReportUsage(1, 40);
+
+			Assert::AreEqual(341ULL, budget.GetTotalUsage());
+		}
+	};
+}
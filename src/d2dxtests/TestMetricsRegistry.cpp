@@ -0,0 +1,165 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/MetricsRegistry.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	static std::string WriteToString(
+		_In_ const MetricsRegistry& metrics,
+		_In_ MetricsFormat format)
+	{
+		FILE* file = nullptr;
+		Assert::AreEqual(0, (int32_t)tmpfile_s(&file));
+
+		metrics.Write(file, format);
+
+		std::string text;
+		char buffer[1024];
+		rewind(file);
+
+		for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0; )
+		{
+			text.append(buffer, count);
+		}
+
+		fclose(file);
+		return text;
+	}
+
+	TEST_CLASS(TestMetricsRegistry)
+	{
+	public:
+		TEST_METHOD(CountersResetEachFrameAndGaugesPersist)
+		{
+			MetricsRegistry metrics{ 16 };
+
+			metrics.Add(Metric::DrawCalls, 3);
+			metrics.Add(Metric::DrawCalls, 4);
+			metrics.Set(Metric::PredictedUnits, 12);
+			metrics.EndFrame();
+
+			Assert::AreEqual((int64_t)0, metrics.GetCurrent(Metric::DrawCalls));
+			Assert::AreEqual((int64_t)12, metrics.GetCurrent(Metric::PredictedUnits));
+
+			metrics.Add(Metric::DrawCalls, 1);
+			metrics.EndFrame();
+
+			Assert::AreEqual(2U, metrics.GetHistoryCount());
+			Assert::AreEqual((int64_t)7, metrics.GetHistoryValue(0, Metric::DrawCalls));
+			Assert::AreEqual((int64_t)1, metrics.GetHistoryValue(1, Metric::DrawCalls));
+			Assert::AreEqual((int64_t)12, metrics.GetHistoryValue(1, Metric::PredictedUnits));
+		}
+
+		TEST_METHOD(AddFromTotalRecordsTheIncrease)
+		{
+			MetricsRegistry metrics{ 16 };
+
+			metrics.AddFromTotal(Metric::HashCacheHits, 100);
+			metrics.EndFrame();
+			metrics.AddFromTotal(Metric::HashCacheHits, 130);
+			metrics.EndFrame();
+			metrics.AddFromTotal(Metric::HashCacheHits, 130);
+			metrics.EndFrame();
+
+			Assert::AreEqual((int64_t)100, metrics.GetHistoryValue(0, Metric::HashCacheHits));
+			Assert::AreEqual((int64_t)30, metrics.GetHistoryValue(1, Metric::HashCacheHits));
+			Assert::AreEqual((int64_t)0, metrics.GetHistoryValue(2, Metric::HashCacheHits));
+		}
+
+		TEST_METHOD(HistoryKeepsTheMostRecentFrames)
+		{
+			MetricsRegistry metrics{ 4 };
+
+			for (int32_t i = 0; i < 10; ++i)
+			{
+				metrics.Add(Metric::Batches, i);
+				metrics.EndFrame();
+			}
+
+			Assert::AreEqual(4U, metrics.GetHistoryCount());
+
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				Assert::AreEqual((uint64_t)(6 + i), metrics.GetHistoryFrame(i));
+				Assert::AreEqual((int64_t)(6 + i), metrics.GetHistoryValue(i, Metric::Batches));
+			}
+		}
+
+		TEST_METHOD(EveryMetricHasAName)
+		{
+			for (int32_t i = 0; i < (int32_t)Metric::Count; ++i)
+			{
+				Assert::IsTrue(strlen(MetricsRegistry::GetName((Metric)i)) > 0);
+			}
+		}
+
+		TEST_METHOD(WritesCsv)
+		{
+			MetricsRegistry metrics{ 16 };
+
+			metrics.Add(Metric::Batches, 5);
+			metrics.Set(Metric::FrameTimeUs, 16667);
+			metrics.EndFrame();
+			metrics.Add(Metric::Batches, 6);
+			metrics.EndFrame();
+
+			const std::string csv = WriteToString(metrics, MetricsFormat::Csv);
+
+			Assert::AreEqual((size_t)0, csv.find("frame,batches,vertices,draw_calls,"));
+			Assert::IsTrue(csv.find(",frame_time_us\n0,5,0,") != std::string::npos);
+			Assert::IsTrue(csv.find(",16667\n1,6,0,") != std::string::npos);
+			Assert::AreEqual('\n', csv.back());
+			Assert::AreEqual((size_t)3, (size_t)std::count(csv.begin(), csv.end(), '\n'));
+		}
+
+		TEST_METHOD(WritesJson)
+		{
+			MetricsRegistry metrics{ 16 };
+
+			metrics.Add(Metric::Batches, 5);
+			metrics.EndFrame();
+			metrics.Add(Metric::Batches, 6);
+			metrics.EndFrame();
+
+			const std::string json = WriteToString(metrics, MetricsFormat::Json);
+
+			Assert::IsTrue(json.find("{ \"frame\": 0, \"batches\": 5,") != std::string::npos);
+			Assert::IsTrue(json.find("},\n\t\t{ \"frame\": 1, \"batches\": 6,") != std::string::npos);
+			Assert::AreEqual((size_t)1, (size_t)std::count(json.begin(), json.end(), '['));
+			Assert::AreEqual((size_t)1, (size_t)std::count(json.begin(), json.end(), ']'));
+			Assert::AreEqual((size_t)3, (size_t)std::count(json.begin(), json.end(), '{'));
+			Assert::AreEqual((size_t)3, (size_t)std::count(json.begin(), json.end(), '}'));
+		}
+
+		TEST_METHOD(WritesEmptyHistory)
+		{
+			MetricsRegistry metrics{ 16 };
+
+			const std::string csv = WriteToString(metrics, MetricsFormat::Csv);
+
+			Assert::AreEqual(std::string{ "{\n\t\"frames\": [\n\t]\n}\n" }, WriteToString(metrics, MetricsFormat::Json));
+			Assert::AreEqual((size_t)1, (size_t)std::count(csv.begin(), csv.end(), '\n'));
+		}
+	};
+}
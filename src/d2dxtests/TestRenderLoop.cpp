@@ -0,0 +1,277 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "FakeClock.h"
+#include "../d2dx/FrameChangeDetector.h"
+#include "../d2dx/RenderLoop.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestRenderLoop)
+	{
+	public:
+		TEST_METHOD(NothingIsRepeatedBeforeTheFirstFrame)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			Offset worldOffset{ 0, 0 };
+
+			clock->timeUs += 100000;
+			Assert::IsNull(renderLoop.BeginRepeat(&worldOffset));
+		}
+
+		TEST_METHOD(FrameIsRepeatedOnlyWhenTheGameIsLate)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			Offset worldOffset{ 0, 0 };
+
+			SubmitFrame(renderLoop, 1, 3);
+			Assert::AreEqual((int64_t)4000, renderLoop.GetTimeUntilRepeatUs());
+
+			clock->timeUs += 3999;
+			Assert::IsNull(renderLoop.BeginRepeat(&worldOffset));
+			Assert::AreEqual((int64_t)1, renderLoop.GetTimeUntilRepeatUs());
+
+			clock->timeUs += 1;
+			Assert::IsNotNull(renderLoop.BeginRepeat(&worldOffset));
+			Assert::IsNull(renderLoop.BeginRepeat(&worldOffset));
+			Assert::AreEqual((int64_t)4000, renderLoop.GetTimeUntilRepeatUs());
+
+			clock->timeUs += 4000;
+			Assert::IsNotNull(renderLoop.BeginRepeat(&worldOffset));
+			Assert::AreEqual(2ULL, renderLoop.GetRepeatCount());
+		}
+
+		TEST_METHOD(NewFrameReplacesTheRepeatedOne)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			Offset worldOffset{ 0, 0 };
+
+			SubmitFrame(renderLoop, 1, 3);
+			clock->timeUs += 4000;
+			Assert::AreEqual(1U, renderLoop.BeginRepeat(&worldOffset)->batchCount);
+
+			clock->timeUs += 1000;
+			SubmitFrame(renderLoop, 2, 6);
+
+			/* The game just presented, so the next repeat is due an interval later. */
+			clock->timeUs += 3999;
+			Assert::IsNull(renderLoop.BeginRepeat(&worldOffset));
+			clock->timeUs += 1;
+
+			const RenderLoopFrame* frame = renderLoop.BeginRepeat(&worldOffset);
+			Assert::IsNotNull(frame);
+			Assert::AreEqual(2U, frame->batchCount);
+			Assert::AreEqual(12U, frame->vertexCount);
+		}
+
+		TEST_METHOD(PresentingAgainDefersTheRepeat)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			Offset worldOffset{ 0, 0 };
+
+			SubmitFrame(renderLoop, 1, 3);
+			clock->timeUs += 3000;
+			renderLoop.OnPresented();
+			clock->timeUs += 3000;
+
+			Assert::IsNull(renderLoop.BeginRepeat(&worldOffset));
+		}
+
+		TEST_METHOD(DroppedFrameIsNotRepeated)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			Offset worldOffset{ 0, 0 };
+
+			SubmitFrame(renderLoop, 1, 3);
+			clock->timeUs += 4000;
+			Assert::IsNotNull(renderLoop.BeginRepeat(&worldOffset));
+
+			renderLoop.DropFrame();
+			clock->timeUs += 10000;
+
+			Assert::IsNull(renderLoop.BeginRepeat(&worldOffset));
+		}
+
+		TEST_METHOD(FrameWithTooManyVerticesIsNotRepeated)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 8 };
+			Offset worldOffset{ 0, 0 };
+
+			SubmitFrame(renderLoop, 3, 3);
+			clock->timeUs += 10000;
+
+			Assert::IsNull(renderLoop.BeginRepeat(&worldOffset));
+		}
+
+		TEST_METHOD(CameraMotionIsExtrapolatedAndBounded)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			Offset worldOffset{ 0, 0 };
+
+			SubmitFrame(renderLoop, 1, 3, { 100.0f, -60.0f });
+
+			clock->timeUs += 10000;
+			Assert::IsNotNull(renderLoop.BeginRepeat(&worldOffset));
+			Assert::AreEqual(-1, worldOffset.x);
+			Assert::AreEqual(1, worldOffset.y);
+
+			clock->timeUs += 20000;
+			renderLoop.BeginRepeat(&worldOffset);
+			Assert::AreEqual(-3, worldOffset.x);
+			Assert::AreEqual(2, worldOffset.y);
+
+			/* No further than 40 ms. */
+			clock->timeUs += 100000;
+			renderLoop.BeginRepeat(&worldOffset);
+			Assert::AreEqual(-4, worldOffset.x);
+			Assert::AreEqual(2, worldOffset.y);
+		}
+
+		TEST_METHOD(VerticesAreStoredContiguously)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			FrameArena<Batch> batches{ 16, 4 };
+			FrameArena<Vertex> vertices{ 8, 4 };
+
+			/* The second batch doesn't fit in the first chunk, and is placed at the start of the second. */
+			for (int32_t i = 0; i < 2; ++i)
+			{
+				uint32_t startVertex;
+				Vertex* pVertices = vertices.Allocate(6, &startVertex);
+
+				for (int32_t j = 0; j < 6; ++j)
+				{
+					pVertices[j] = Vertex{ i * 10 + j, 0, 0, 0, 0, false, 0, 0, 0 };
+				}
+
+				uint32_t batchIndex;
+				Batch* batch = batches.Allocate(1, &batchIndex);
+				*batch = Batch{ };
+				batch->SetTextureStartAddress(256);
+				batch->SetStartVertex(startVertex);
+				batch->SetVertexCount(6);
+			}
+
+			renderLoop.SubmitFrame(batches, vertices, { 0.0f, 0.0f });
+			clock->timeUs += 4000;
+
+			Offset worldOffset{ 0, 0 };
+			const RenderLoopFrame* frame = renderLoop.BeginRepeat(&worldOffset);
+			Assert::IsNotNull(frame);
+			Assert::AreEqual(12U, frame->vertexCount);
+			Assert::AreEqual(6, frame->batches.items[1].GetStartVertex());
+
+			for (uint32_t i = 0; i < 12; ++i)
+			{
+				Assert::AreEqual((int32_t)((i / 6) * 10 + i % 6), frame->vertices.items[i].GetX());
+			}
+		}
+
+		TEST_METHOD(UnchangedFrameAfterARepeatIsRedrawn)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			RenderLoop renderLoop{ clock, 4000, 40000, 1024 };
+			FrameChangeDetector frameChangeDetector;
+			FrameArena<Batch> batches{ 16, 4 };
+			FrameArena<Vertex> vertices{ 64, 4 };
+			Offset worldOffset{ 0, 0 };
+
+			uint32_t startVertex, batchIndex;
+			memset(vertices.Allocate(3, &startVertex), 0, sizeof(Vertex) * 3);
+			Batch* batch = batches.Allocate(1, &batchIndex);
+			*batch = Batch{ };
+			batch->SetTextureStartAddress(256);
+			batch->SetStartVertex(startVertex);
+			batch->SetVertexCount(3);
+
+			Assert::IsTrue(PresentGameFrame(renderLoop, frameChangeDetector, batches, vertices));
+			Assert::IsFalse(renderLoop.HasRepeatedSincePresent());
+
+			clock->timeUs += 1000;
+			Assert::IsFalse(PresentGameFrame(renderLoop, frameChangeDetector, batches, vertices));
+
+			clock->timeUs += 4000;
+			Assert::IsNotNull(renderLoop.BeginRepeat(&worldOffset));
+			Assert::IsTrue(renderLoop.HasRepeatedSincePresent());
+
+			/* The same frame again: the screen shows the repeat, so it must be drawn. */
+			Assert::IsTrue(PresentGameFrame(renderLoop, frameChangeDetector, batches, vertices));
+			Assert::IsFalse(renderLoop.HasRepeatedSincePresent());
+			Assert::IsFalse(PresentGameFrame(renderLoop, frameChangeDetector, batches, vertices));
+		}
+
+	private:
+		/* Does what the game thread does when presenting. Returns true if the frame has to be drawn. */
+		static bool PresentGameFrame(
+			RenderLoop& renderLoop,
+			FrameChangeDetector& frameChangeDetector,
+			const FrameArena<Batch>& batches,
+			const FrameArena<Vertex>& vertices)
+		{
+			const uint32_t paletteKeys[1] = { 0 };
+			const uint32_t gammaTable[1] = { 0 };
+
+			if (renderLoop.HasRepeatedSincePresent())
+			{
+				frameChangeDetector.Reset();
+			}
+
+			const bool isChanged = frameChangeDetector.Update(batches, vertices, paletteKeys, 1, gammaTable, 1);
+			renderLoop.SubmitFrame(batches, vertices, { 0.0f, 0.0f });
+			return isChanged;
+		}
+
+		static void SubmitFrame(
+			RenderLoop& renderLoop,
+			uint32_t batchCount,
+			uint32_t verticesPerBatch,
+			OffsetF cameraVelocity = { 0.0f, 0.0f })
+		{
+			FrameArena<Batch> batches{ 16, 4 };
+			FrameArena<Vertex> vertices{ 64, 4 };
+
+			for (uint32_t i = 0; i < batchCount; ++i)
+			{
+				uint32_t startVertex;
+				vertices.Allocate(verticesPerBatch, &startVertex);
+
+				uint32_t batchIndex;
+				Batch* batch = batches.Allocate(1, &batchIndex);
+				*batch = Batch{ };
+				batch->SetTextureStartAddress(256);
+				batch->SetStartVertex(startVertex);
+				batch->SetVertexCount(verticesPerBatch);
+			}
+
+			renderLoop.SubmitFrame(batches, vertices, cameraVelocity);
+		}
+	};
+}
@@ -51,5 +51,62 @@ namespace d2dxtests
 			Assert::AreEqual(1009, simd->IndexOfUInt32(items.data(), items.size(), 14));
 			Assert::AreEqual(114, simd->IndexOfUInt32(items.data(), items.size(), 909));
 		}
+
+		TEST_METHOD(CompareUInt32)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			std::array<uint32_t, 643> itemsA;
+			std::array<uint32_t, 643> itemsB;
+
+			for (int32_t i = 0; i < 643; ++i)
+			{
+				itemsA[i] = itemsB[i] = i * 2654435761U;
+			}
+
+			Assert::IsTrue(simd->AreEqualUInt32(itemsA.data(), itemsB.data(), 643));
+			Assert::IsTrue(simd->AreEqualUInt32(itemsA.data() + 1, itemsB.data() + 1, 642));
+
+			for (int32_t i : { 0, 15, 16, 400, 639, 640, 642 })
+			{
+				itemsB[i] ^= 0x100;
+				Assert::IsFalse(simd->AreEqualUInt32(itemsA.data(), itemsB.data(), 643));
+				itemsB[i] ^= 0x100;
+			}
+
+			itemsB[642] = 0;
+			Assert::IsTrue(simd->AreEqualUInt32(itemsA.data(), itemsB.data(), 642));
+		}
+
+		TEST_METHOD(CopyUInt32NonTemporal)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+
+			alignas(16) std::array<uint32_t, 2 * 700> src;
+			alignas(16) std::array<uint32_t, 2 * 700> dst;
+
+			for (int32_t i = 0; i < 2 * 700; ++i)
+			{
+				src[i] = i + 1;
+			}
+
+			/* Every alignment of the destination, and widths that aren't a multiple of the vector size. Rows
+			   are 700 items apart in the destination, and 650 in the source. */
+			for (int32_t offset = 0; offset < 4; ++offset)
+			{
+				dst.fill(0);
+				simd->CopyUInt32NonTemporal(dst.data() + offset, 700 * sizeof(uint32_t), src.data() + 1, 650 * sizeof(uint32_t), 643, 2);
+
+				for (int32_t y = 0; y < 2; ++y)
+				{
+					for (int32_t i = 0; i < 700; ++i)
+					{
+						Assert::AreEqual(
+							(i >= offset && i < offset + 643) ? (uint32_t)(y * 650 + i - offset + 2) : 0U,
+							dst[y * 700 + i]);
+					}
+				}
+			}
+		}
 	};
 }
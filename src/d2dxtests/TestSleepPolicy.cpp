@@ -0,0 +1,125 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "FakeClock.h"
+#include "../d2dx/SleepPolicy.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestSleepPolicy)
+	{
+	public:
+		TEST_METHOD(VideoSleepsArePassedThrough)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			SleepPolicy sleepPolicy{ clock };
+
+			sleepPolicy.OnPresented();
+			clock->timeUs += 10000;
+
+			Assert::AreEqual(40, sleepPolicy.OnSleep(MajorGameState::FmvIntro, 40, 16666, -1));
+		}
+
+		TEST_METHOD(ZeroSleepsArePassedThrough)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			SleepPolicy sleepPolicy{ clock };
+
+			sleepPolicy.OnPresented();
+			clock->timeUs += 20000;
+
+			Assert::AreEqual(0, sleepPolicy.OnSleep(MajorGameState::InGame, 0, 16666, -1));
+		}
+
+		TEST_METHOD(SleepsAreKeptWithoutBudgetOrDeadline)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			SleepPolicy sleepPolicy{ clock };
+
+			Assert::AreEqual(30, sleepPolicy.OnSleep(MajorGameState::Menus, 30, 16666, -1));
+
+			sleepPolicy.OnPresented();
+			Assert::AreEqual(30, sleepPolicy.OnSleep(MajorGameState::Menus, 30, 0, -1));
+		}
+
+		TEST_METHOD(SleepIsShortenedToTheFrameBudget)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			SleepPolicy sleepPolicy{ clock };
+
+			sleepPolicy.OnPresented();
+			clock->timeUs += 5000;
+
+			Assert::AreEqual(11, sleepPolicy.OnSleep(MajorGameState::Menus, 30, 16666, -1));
+			Assert::AreEqual(10, sleepPolicy.OnSleep(MajorGameState::Menus, 10, 16666, -1));
+		}
+
+		TEST_METHOD(DeadlineTakesPrecedenceOverTheFrameBudget)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			SleepPolicy sleepPolicy{ clock };
+
+			sleepPolicy.OnPresented();
+
+			Assert::AreEqual(3, sleepPolicy.OnSleep(MajorGameState::InGame, 10, 16666, clock->timeUs + 3500));
+		}
+
+		TEST_METHOD(SleepIsSkippedInGameAndYieldsElsewhereWhenOutOfTime)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			SleepPolicy sleepPolicy{ clock };
+
+			sleepPolicy.OnPresented();
+			clock->timeUs += 20000;
+
+			Assert::AreEqual(-1, sleepPolicy.OnSleep(MajorGameState::InGame, 10, 16666, -1));
+			Assert::AreEqual(0, sleepPolicy.OnSleep(MajorGameState::Menus, 10, 16666, -1));
+			Assert::AreEqual(0, sleepPolicy.OnSleep(MajorGameState::TitleScreen, 10, 16666, -1));
+		}
+
+		TEST_METHOD(RequestedAndGrantedSleepsAreRecordedPerState)
+		{
+			auto clock = std::make_shared<FakeClock>();
+			SleepPolicy sleepPolicy{ clock };
+
+			sleepPolicy.OnPresented();
+			clock->timeUs += 20000;
+
+			for (int32_t i = 0; i < 4; ++i)
+			{
+				sleepPolicy.OnSleep(MajorGameState::InGame, 10, 16666, -1);
+			}
+
+			sleepPolicy.OnSleep(MajorGameState::FmvIntro, 40, 16666, -1);
+
+			Assert::AreEqual((uint64_t)4, sleepPolicy.GetRequestedHistogram(MajorGameState::InGame).GetCount());
+			Assert::AreEqual((int64_t)10000, sleepPolicy.GetRequestedHistogram(MajorGameState::InGame).GetMax());
+			Assert::AreEqual((int64_t)0, sleepPolicy.GetGrantedHistogram(MajorGameState::InGame).GetMax());
+
+			Assert::AreEqual((uint64_t)1, sleepPolicy.GetGrantedHistogram(MajorGameState::FmvIntro).GetCount());
+			Assert::AreEqual((int64_t)40000, sleepPolicy.GetGrantedHistogram(MajorGameState::FmvIntro).GetMax());
+
+			Assert::AreEqual((uint64_t)0, sleepPolicy.GetRequestedHistogram(MajorGameState::Menus).GetCount());
+		}
+	};
+}
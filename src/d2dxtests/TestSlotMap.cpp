@@ -0,0 +1,159 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include <unordered_map>
+#include "CppUnitTest.h"
+#include "../d2dx/SlotMap.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestSlotMap)
+	{
+	public:
+		TEST_METHOD(InsertAndFind)
+		{
+			SlotMap<int32_t> slotMap;
+
+			auto h1 = slotMap.Insert(1, 100);
+			auto h2 = slotMap.Insert(0x100000002ULL, 200);
+
+			Assert::AreEqual(2U, slotMap.GetCount());
+			Assert::IsTrue(h1.IsValid());
+			Assert::IsTrue(h2.IsValid());
+			Assert::AreEqual(100, *slotMap.Find(1));
+			Assert::AreEqual(200, *slotMap.Find(0x100000002ULL));
+			Assert::AreEqual(200, *slotMap.Get(h2));
+			Assert::IsNull(slotMap.Find(2));
+			Assert::IsFalse(slotMap.FindHandle(2).IsValid());
+		}
+
+		TEST_METHOD(ErasedHandleDoesNotAliasReusedSlot)
+		{
+			SlotMap<int32_t> slotMap;
+
+			auto h1 = slotMap.Insert(1, 100);
+			Assert::IsTrue(slotMap.Erase(h1));
+			Assert::IsNull(slotMap.Get(h1));
+			Assert::IsNull(slotMap.Find(1));
+
+			/* The new entity gets the same slot, but the old handle must stay stale. */
+			auto h2 = slotMap.Insert(2, 200);
+			Assert::AreEqual(h1.slot, h2.slot);
+			Assert::IsNull(slotMap.Get(h1));
+			Assert::IsFalse(slotMap.Erase(h1));
+			Assert::AreEqual(200, *slotMap.Get(h2));
+		}
+
+		TEST_METHOD(GrowsPastInitialCapacity)
+		{
+			SlotMap<uint32_t> slotMap{ 16 };
+
+			for (uint32_t i = 0; i < 10000; ++i)
+			{
+				slotMap.Insert(i * 7919ULL, i);
+			}
+
+			Assert::AreEqual(10000U, slotMap.GetCount());
+			Assert::IsTrue(slotMap.GetCapacity() >= 10000U);
+
+			for (uint32_t i = 0; i < 10000; ++i)
+			{
+				Assert::AreEqual(i, *slotMap.Find(i * 7919ULL));
+			}
+		}
+
+		TEST_METHOD(DenseIterationWithErase)
+		{
+			SlotMap<uint32_t> slotMap;
+
+			for (uint32_t i = 0; i < 100; ++i)
+			{
+				slotMap.Insert(i, i);
+			}
+
+			for (int32_t i = (int32_t)slotMap.GetCount() - 1; i >= 0; --i)
+			{
+				if (slotMap.GetAt(i) & 1)
+				{
+					slotMap.EraseAt(i);
+				}
+			}
+
+			Assert::AreEqual(50U, slotMap.GetCount());
+
+			uint32_t sum = 0;
+			for (uint32_t i = 0; i < slotMap.GetCount(); ++i)
+			{
+				Assert::AreEqual(0U, slotMap.GetAt(i) & 1);
+				Assert::AreEqual((uint64_t)slotMap.GetAt(i), slotMap.GetKeyAt(i));
+				Assert::AreEqual(slotMap.GetAt(i), *slotMap.Get(slotMap.GetHandleAt(i)));
+				sum += slotMap.GetAt(i);
+			}
+
+			Assert::AreEqual(2450U, sum);
+		}
+
+		TEST_METHOD(MatchesReferenceMapUnderRandomOperations)
+		{
+			SlotMap<uint32_t> slotMap{ 16 };
+			std::unordered_map<uint64_t, uint32_t> reference;
+			uint32_t seed = 12345;
+
+			for (uint32_t i = 0; i < 100000; ++i)
+			{
+				seed = seed * 1664525 + 1013904223;
+
+				/* Small key range, so that keys collide and get erased and reinserted often. */
+				const uint64_t key = (uint64_t)((seed >> 8) & 1023) << ((seed & 1) ? 32 : 0);
+				const bool exists = reference.find(key) != reference.end();
+
+				if ((seed >> 28) < 9)
+				{
+					if (exists)
+					{
+						*slotMap.Find(key) = i;
+					}
+					else
+					{
+						slotMap.Insert(key, i);
+					}
+					reference[key] = i;
+				}
+				else
+				{
+					Assert::AreEqual(exists, slotMap.Erase(key));
+					reference.erase(key);
+				}
+			}
+
+			Assert::AreEqual((uint32_t)reference.size(), slotMap.GetCount());
+
+			for (auto& kv : reference)
+			{
+				Assert::AreEqual(kv.second, *slotMap.Find(kv.first));
+			}
+
+			slotMap.Clear();
+			Assert::AreEqual(0U, slotMap.GetCount());
+		}
+	};
+}
@@ -0,0 +1,150 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/TextMotionPredictor.h"
+#include "../d2dx/Utils.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTextMotionPredictor)
+	{
+	public:
+		TEST_METHOD(TextIdIsStableForSameString)
+		{
+			TextMotionPredictor tmp;
+			wchar_t label[] = L"Grand Charm";
+
+			const uint64_t id1 = tmp.GetTextId(0x6FA12345, label, (uint32_t)wcslen(label));
+			const uint64_t id2 = tmp.GetTextId(0x6FA12345, label, (uint32_t)wcslen(label));
+			Assert::AreEqual(id1, id2);
+
+			/* Same buffer, different call site. */
+			const uint64_t id3 = tmp.GetTextId(0x6FA12399, label, (uint32_t)wcslen(label));
+			Assert::AreNotEqual(id1, id3);
+		}
+
+		TEST_METHOD(TextIdChangesWhenBufferIsReused)
+		{
+			TextMotionPredictor tmp;
+			wchar_t label[] = L"Grand Charm";
+
+			const uint64_t id1 = tmp.GetTextId(0x6FA12345, label, (uint32_t)wcslen(label));
+
+			/* Same pointer and length, different contents. */
+			wcscpy_s(label, L"Small Charm");
+			const uint64_t id2 = tmp.GetTextId(0x6FA12345, label, (uint32_t)wcslen(label));
+			Assert::AreNotEqual(id1, id2);
+		}
+
+		TEST_METHOD(OffsetFollowsMovingText)
+		{
+			TextMotionPredictor tmp;
+
+			Assert::AreEqual(0, tmp.GetOffset(1234, { 100, 100 }).x);
+
+			/* The text jumped a few pixels. The predictor should hold it back and let it catch up smoothly. */
+			const Offset offset = tmp.GetOffset(1234, { 110, 100 });
+			Assert::AreEqual(-10, offset.x);
+			Assert::AreEqual(0, offset.y);
+
+			/* A large jump resets it. */
+			Assert::AreEqual(0, tmp.GetOffset(1234, { 400, 100 }).x);
+		}
+
+		TEST_METHOD(OffsetIsResetUnderOpenPanel)
+		{
+			TextMotionPredictor tmp;
+
+			GameStateSnapshot gameState;
+			gameState.screenOpenMode = 2;
+			gameState.changes = (uint32_t)GameStateChange::ScreenOpenMode;
+			tmp.OnGameStateChanged(gameState);
+
+			/* With the left panel open, text on the left half doesn't move smoothly. The game size is not known
+			   until Update has been called, so the left half is x <= 0 here. */
+			tmp.GetOffset(1234, { -100, 100 });
+			Assert::AreEqual(0, tmp.GetOffset(1234, { -90, 100 }).x);
+
+			gameState.screenOpenMode = 0;
+			tmp.OnGameStateChanged(gameState);
+
+			Assert::AreEqual(-10, tmp.GetOffset(1234, { -80, 100 }).x);
+		}
+
+		TEST_METHOD(BenchmarkScreenFullOfItemLabels)
+		{
+			const int32_t labelCount = 300;
+			const int32_t frameCount = 1000;
+			const uint32_t returnAddress = 0x6FA12345;
+
+			TextMotionPredictor tmp;
+			Buffer<wchar_t> labels{ labelCount * 64, true };
+
+			for (int32_t i = 0; i < labelCount; ++i)
+			{
+				swprintf_s(&labels.items[i * 64], 64, L"\xFF" L"c3Superior Ancient Armor of the Whale %i", i);
+			}
+
+			/* Reference: hash every label on every draw, as done before text ids were cached. */
+			uint64_t referenceChecksum = 0;
+			int64_t start = TimeStart();
+
+			for (int32_t frame = 0; frame < frameCount; ++frame)
+			{
+				for (int32_t i = 0; i < labelCount; ++i)
+				{
+					const wchar_t* str = &labels.items[i * 64];
+					const uint32_t length = (uint32_t)wcslen(str);
+					const uint32_t hash = fnv_32a_buf((void*)str, length * sizeof(wchar_t), FNV1_32A_INIT);
+					referenceChecksum += (((uint64_t)(returnAddress & 0xFFFFFF) << 40ULL) |
+						((uint64_t)((uintptr_t)str & 0xFFFFFF) << 16ULL)) ^ (uint64_t)hash;
+				}
+			}
+
+			const float referenceMs = TimeEndMs(start);
+
+			uint64_t checksum = 0;
+			start = TimeStart();
+
+			for (int32_t frame = 0; frame < frameCount; ++frame)
+			{
+				for (int32_t i = 0; i < labelCount; ++i)
+				{
+					const wchar_t* str = &labels.items[i * 64];
+					const uint64_t textId = tmp.GetTextId(returnAddress, str, (uint32_t)wcslen(str));
+					checksum += textId;
+					tmp.GetOffset(textId, { (i % 10) * 70, (i / 10) * 16 + (frame & 1) });
+				}
+			}
+
+			const float cachedMs = TimeEndMs(start);
+
+			char message[256];
+			sprintf_s(message, "%i labels x %i frames: hashing %f ms, cached ids + predictor %f ms",
+				labelCount, frameCount, referenceMs, cachedMs);
+			Logger::WriteMessage(message);
+
+			Assert::AreEqual(referenceChecksum, checksum);
+		}
+	};
+}
@@ -30,6 +30,42 @@ using namespace d2dx;
 
 namespace d2dxtests
 {
+	class FakeTextureCacheDevice final : public ITextureCacheDevice
+	{
+	public:
+		virtual uint32_t GetMaxTextureArraySize() override
+		{
+			return 2048;
+		}
+
+		virtual void CreateTextureArray(
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_ uint32_t arraySize,
+			_Outptr_ ID3D11Texture2D** texture,
+			_Outptr_ ID3D11ShaderResourceView** srv) override
+		{
+			*texture = nullptr;
+			*srv = nullptr;
+			++createdCount;
+			lastArraySize = arraySize;
+		}
+
+		virtual void UpdateTextureArraySlice(
+			_In_ ID3D11Texture2D* texture,
+			_In_ uint32_t slice,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint8_t* data) override
+		{
+			++updatedCount;
+		}
+
+		uint32_t createdCount = 0;
+		uint32_t lastArraySize = 0;
+		uint32_t updatedCount = 0;
+	};
+
 	TEST_CLASS(TestTextureCache)
 	{
 	public:
@@ -41,7 +77,7 @@ namespace d2dxtests
 				for (int32_t w = 3; w <= 8; ++w)
 				{
 					auto textureCache = std::make_unique<TextureCache>(
-						1 << w, 1 << h, 1024, 512, (ID3D11Device*)nullptr, simd);
+						1 << w, 1 << h, 1024, 512, std::make_shared<FakeTextureCacheDevice>(), simd);
 				}
 			}
 		}
@@ -49,7 +85,7 @@ namespace d2dxtests
 		TEST_METHOD(FindNonExistentTexture)
 		{
 			auto simd = std::make_shared<SimdSse2>();
-			auto textureCache = std::make_unique<TextureCache>(256, 128, 2048, 512, (ID3D11Device*)nullptr, simd);
+			auto textureCache = std::make_unique<TextureCache>(256, 128, 2048, 512, std::make_shared<FakeTextureCacheDevice>(), simd);
 			auto tcl = textureCache->FindTexture(0x12345678, -1);
 			Assert::AreEqual((int16_t)-1, tcl._textureAtlas);
 			Assert::AreEqual((int16_t)-1, tcl._textureIndex);
@@ -64,7 +100,7 @@ namespace d2dxtests
 			batch.SetTextureStartAddress(0);
 			batch.SetTextureSize(256, 128);
 
-			auto textureCache = std::make_unique<TextureCache>(256, 128, 64, 512, (ID3D11Device*)nullptr, simd);
+			auto textureCache = std::make_unique<TextureCache>(256, 128, 64, 512, std::make_shared<FakeTextureCacheDevice>(), simd);
 
 			for (uint32_t i = 0; i < 64; ++i)
 			{
@@ -90,7 +126,7 @@ namespace d2dxtests
 			batch.SetTextureStartAddress(0);
 			batch.SetTextureSize(256, 128);
 
-			auto textureCache = std::make_unique<TextureCache>(256, 128, 64, 512, (ID3D11Device*)nullptr, simd);
+			auto textureCache = std::make_unique<TextureCache>(256, 128, 64, 512, std::make_shared<FakeTextureCacheDevice>(), simd);
 
 			for (uint32_t i = 0; i < 65; ++i)
 			{
@@ -141,7 +177,7 @@ namespace d2dxtests
 			batch.SetTextureStartAddress(0);
 			batch.SetTextureSize(256, 128);
 
-			auto textureCache = std::make_unique<TextureCache>(256, 128, 64, 512, (ID3D11Device*)nullptr, simd);
+			auto textureCache = std::make_unique<TextureCache>(256, 128, 64, 512, std::make_shared<FakeTextureCacheDevice>(), simd);
 
 			for (uint32_t i = 0; i < 65; ++i)
 			{
@@ -192,5 +228,209 @@ namespace d2dxtests
 				Assert::AreEqual(expectedTextureIndex, tcl._textureIndex);
 			}
 		}
+
+		TEST_METHOD(AtlasIsCreatedOnFirstInsert)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto device = std::make_shared<FakeTextureCacheDevice>();
+			std::array<uint8_t, 16 * 16> tmuData{ };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(16, 16);
+
+			auto textureCache = std::make_unique<TextureCache>(16, 16, 2048, 512, device, simd);
+
+			Assert::AreEqual(0U, device->createdCount);
+			Assert::AreEqual(0U, textureCache->GetCommittedMemoryFootprint());
+			Assert::AreEqual(16U * 16U * 2048U, textureCache->GetMemoryFootprint());
+
+			auto tcl = textureCache->InsertTexture(1, batch, tmuData.data(), (uint32_t)tmuData.size());
+
+			Assert::AreEqual(1U, device->createdCount);
+			Assert::AreEqual(512U, device->lastArraySize);
+			Assert::AreEqual(1U, device->updatedCount);
+			Assert::AreEqual(16U * 16U * 512U, textureCache->GetCommittedMemoryFootprint());
+
+			auto tcl2 = textureCache->FindTexture(1, -1);
+			Assert::AreEqual(tcl._textureAtlas, tcl2._textureAtlas);
+			Assert::AreEqual(tcl._textureIndex, tcl2._textureIndex);
+		}
+
+		TEST_METHOD(EachAtlasIsCreatedOnce)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto device = std::make_shared<FakeTextureCacheDevice>();
+			std::array<uint8_t, 8 * 8> tmuData{ };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(8, 8);
+
+			auto textureCache = std::make_unique<TextureCache>(8, 8, 1024, 512, device, simd);
+
+			for (uint32_t i = 0; i < 1024 + 16; ++i)
+			{
+				textureCache->InsertTexture(i + 1, batch, tmuData.data(), (uint32_t)tmuData.size());
+			}
+
+			Assert::AreEqual(2U, device->createdCount);
+			Assert::AreEqual(1024U + 16U, device->updatedCount);
+			Assert::AreEqual(textureCache->GetMemoryFootprint(), textureCache->GetCommittedMemoryFootprint());
+		}
+
+		TEST_METHOD(AtlasIsNotLargerThanCapacity)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto device = std::make_shared<FakeTextureCacheDevice>();
+			std::array<uint8_t, 8 * 8> tmuData{ };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(8, 8);
+
+			auto textureCache = std::make_unique<TextureCache>(8, 8, 64, 2048, device, simd);
+
+			Assert::AreEqual(8U * 8U * 64U, textureCache->GetMemoryFootprint());
+
+			textureCache->InsertTexture(1, batch, tmuData.data(), (uint32_t)tmuData.size());
+
+			Assert::AreEqual(64U, device->lastArraySize);
+			Assert::AreEqual(textureCache->GetMemoryFootprint(), textureCache->GetCommittedMemoryFootprint());
+		}
+
+		TEST_METHOD(MemoryLimitReleasesAtlases)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto device = std::make_shared<FakeTextureCacheDevice>();
+			std::array<uint8_t, 8 * 8> tmuData{ };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(8, 8);
+
+			auto textureCache = std::make_unique<TextureCache>(8, 8, 1024, 512, device, simd);
+
+			/* A quarter of the textures per frame, so that one atlas is enough for a frame. */
+			for (uint32_t i = 0; i < 1024; ++i)
+			{
+				textureCache->InsertTexture(i + 1, batch, tmuData.data(), (uint32_t)tmuData.size());
+
+				if ((i & 255) == 255)
+				{
+					textureCache->OnNewFrame();
+				}
+			}
+
+			Assert::AreEqual(textureCache->GetMemoryFootprint(), textureCache->GetMemoryDemand());
+
+			for (uint32_t i = 0; i < TextureCache::AtlasIdleFrameCount; ++i)
+			{
+				textureCache->OnNewFrame();
+			}
+
+			textureCache->SetMemoryLimit(textureCache->GetAtlasMemoryFootprint());
+
+			Assert::AreEqual(textureCache->GetAtlasMemoryFootprint(), textureCache->GetCommittedMemoryFootprint());
+			Assert::AreEqual(512U, textureCache->GetUsedCount());
+
+			/* Textures in the released atlas are gone, and new ones only go in the remaining atlas. */
+			Assert::AreEqual((int16_t)-1, textureCache->FindTexture(1024, -1)._textureAtlas);
+
+			for (uint32_t i = 0; i < 600; ++i)
+			{
+				auto tcl = textureCache->InsertTexture(2000 + i, batch, tmuData.data(), (uint32_t)tmuData.size());
+				Assert::AreEqual((int16_t)0, tcl._textureAtlas);
+			}
+
+			Assert::AreEqual(2U, device->createdCount);
+		}
+
+		TEST_METHOD(MemoryLimitKeepsAtlasesUsedInRecentFrames)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto device = std::make_shared<FakeTextureCacheDevice>();
+			std::array<uint8_t, 8 * 8> tmuData{ };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(8, 8);
+
+			auto textureCache = std::make_unique<TextureCache>(8, 8, 1024, 512, device, simd);
+
+			for (uint32_t i = 0; i < 1024; ++i)
+			{
+				textureCache->InsertTexture(i + 1, batch, tmuData.data(), (uint32_t)tmuData.size());
+
+				if ((i & 255) == 255)
+				{
+					textureCache->OnNewFrame();
+				}
+			}
+
+			/* A texture in the second atlas is drawn every few frames. */
+			for (uint32_t i = 0; i < TextureCache::AtlasIdleFrameCount; ++i)
+			{
+				if (!(i & 15))
+				{
+					Assert::AreEqual((int16_t)1, textureCache->FindTexture(1024, -1)._textureAtlas);
+				}
+
+				textureCache->OnNewFrame();
+			}
+
+			textureCache->SetMemoryLimit(textureCache->GetAtlasMemoryFootprint());
+
+			Assert::AreEqual(textureCache->GetMemoryFootprint(), textureCache->GetCommittedMemoryFootprint());
+			Assert::AreEqual((int16_t)1, textureCache->FindTexture(1024, -1)._textureAtlas);
+		}
+
+		TEST_METHOD(MemoryLimitIsAtLeastTheUsageOfOneFrame)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto device = std::make_shared<FakeTextureCacheDevice>();
+			std::array<uint8_t, 8 * 8> tmuData{ };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(8, 8);
+
+			auto textureCache = std::make_unique<TextureCache>(8, 8, 1024, 512, device, simd);
+
+			/* One frame uses more textures than fit in an atlas. */
+			for (uint32_t i = 0; i < 600; ++i)
+			{
+				textureCache->InsertTexture(i + 1, batch, tmuData.data(), (uint32_t)tmuData.size());
+			}
+
+			for (uint32_t i = 0; i < TextureCache::AtlasIdleFrameCount + 1; ++i)
+			{
+				textureCache->OnNewFrame();
+			}
+
+			textureCache->SetMemoryLimit(textureCache->GetAtlasMemoryFootprint());
+
+			Assert::AreEqual(textureCache->GetMemoryFootprint(), textureCache->GetCommittedMemoryFootprint());
+			Assert::AreEqual(600U, textureCache->GetUsedCount());
+		}
+
+		TEST_METHOD(MemoryLimitIsAtLeastOneAtlas)
+		{
+			auto simd = std::make_shared<SimdSse2>();
+			auto device = std::make_shared<FakeTextureCacheDevice>();
+			std::array<uint8_t, 8 * 8> tmuData{ };
+
+			Batch batch;
+			batch.SetTextureStartAddress(0);
+			batch.SetTextureSize(8, 8);
+
+			auto textureCache = std::make_unique<TextureCache>(8, 8, 1024, 512, device, simd);
+			textureCache->SetMemoryLimit(0);
+
+			auto tcl = textureCache->InsertTexture(1, batch, tmuData.data(), (uint32_t)tmuData.size());
+
+			Assert::AreEqual((int16_t)0, tcl._textureAtlas);
+			Assert::AreEqual(textureCache->GetAtlasMemoryFootprint(), textureCache->GetCommittedMemoryFootprint());
+		}
 	};
 }
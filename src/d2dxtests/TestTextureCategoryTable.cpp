@@ -0,0 +1,75 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/TextureCategoryTable.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	static constexpr uint32_t testUiHashes[] = { 0x2ff1fd61, 0x54cc8b72, 0xfc253c88, 0x00000001 };
+	static constexpr uint32_t testMouseHashes[] = { 0xfe34f8b7, 0x5cac0e94, 0xfffffffe };
+	static constexpr uint32_t duplicateHashes[] = { 0x2ff1fd61, 0x12345678 };
+
+	static constexpr TextureHashList testHashLists[] =
+	{
+		{ TextureCategory::UserInterface, testUiHashes, ARRAYSIZE(testUiHashes) },
+		{ TextureCategory::MousePointer, testMouseHashes, ARRAYSIZE(testMouseHashes) },
+	};
+
+	static constexpr TextureHashList testHashListsWithDuplicate[] =
+	{
+		{ TextureCategory::UserInterface, testUiHashes, ARRAYSIZE(testUiHashes) },
+		{ TextureCategory::TitleScreen, duplicateHashes, ARRAYSIZE(duplicateHashes) },
+	};
+
+	static constexpr TextureCategoryTable<8> testTable{ testHashLists };
+	static_assert(testTable.GetCount() == 7, "");
+	static_assert(!testTable.HasDuplicates(), "");
+	static_assert(!testTable.HasOverflowed(), "");
+	static_assert(TextureCategoryTable<8>{ testHashListsWithDuplicate }.HasDuplicates(), "");
+	static_assert(TextureCategoryTable<4>{ testHashLists }.HasOverflowed(), "");
+
+	TEST_CLASS(TestTextureCategoryTable)
+	{
+	public:
+		TEST_METHOD(FindsAllHashes)
+		{
+			for (uint32_t i = 0; i < ARRAYSIZE(testUiHashes); ++i)
+			{
+				Assert::IsTrue(TextureCategory::UserInterface == testTable.Find(testUiHashes[i]));
+			}
+
+			for (uint32_t i = 0; i < ARRAYSIZE(testMouseHashes); ++i)
+			{
+				Assert::IsTrue(TextureCategory::MousePointer == testTable.Find(testMouseHashes[i]));
+			}
+		}
+
+		TEST_METHOD(UnknownHashes)
+		{
+			Assert::IsTrue(TextureCategory::Unknown == testTable.Find(0));
+			Assert::IsTrue(TextureCategory::Unknown == testTable.Find(0x2ff1fd60));
+			Assert::IsTrue(TextureCategory::Unknown == testTable.Find(0x2ff1fd62));
+			Assert::IsTrue(TextureCategory::Unknown == testTable.Find(0xffffffff));
+		}
+	};
+}
@@ -0,0 +1,160 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/TextureDumper.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	class FakeTextureDumpSink final : public ITextureDumpSink
+	{
+	public:
+		virtual void Write(
+			_In_ uint32_t hash,
+			_In_ uint32_t textureCategory,
+			_In_ int32_t width,
+			_In_ int32_t height,
+			_In_reads_(width * height) const uint32_t* pixels) override
+		{
+			std::unique_lock<std::mutex> lock{ mutex };
+			isReleased.wait(lock, [&]() { return !isBlocking; });
+
+			hashes.push_back(hash);
+			lastTextureCategory = textureCategory;
+			lastPixels.assign(pixels, pixels + width * height);
+		}
+
+		void SetBlocking(
+			_In_ bool blocking)
+		{
+			{
+				std::lock_guard<std::mutex> lock{ mutex };
+				isBlocking = blocking;
+			}
+			isReleased.notify_all();
+		}
+
+		std::mutex mutex;
+		std::condition_variable isReleased;
+		bool isBlocking = false;
+		std::vector<uint32_t> hashes;
+		uint32_t lastTextureCategory = 0;
+		std::vector<uint32_t> lastPixels;
+	};
+
+	TEST_CLASS(TestTextureDumper)
+	{
+	public:
+		TEST_METHOD(ExpandsThePaletteToRgba)
+		{
+			auto sink = std::make_shared<FakeTextureDumpSink>();
+			TextureDumper textureDumper{ 4, sink };
+
+			const uint8_t pixels[] = { 0, 1, 2, 1 };
+			uint32_t palette[256] = { };
+			palette[0] = 0x00112233;
+			palette[1] = 0xFFAABBCC;
+			palette[2] = 0x80000001;
+
+			Assert::IsTrue(textureDumper.TryDump(0x1234, 2, 2, pixels, 4, palette));
+			textureDumper.Flush();
+
+			Assert::AreEqual((size_t)1, sink->hashes.size());
+			Assert::AreEqual(0x1234U, sink->hashes[0]);
+			Assert::AreEqual(4U, sink->lastTextureCategory);
+			Assert::AreEqual((size_t)4, sink->lastPixels.size());
+			Assert::AreEqual(0xFF332211U, sink->lastPixels[0]);
+			Assert::AreEqual(0xFFCCBBAAU, sink->lastPixels[1]);
+			Assert::AreEqual(0xFF010000U, sink->lastPixels[2]);
+			Assert::AreEqual(0xFFCCBBAAU, sink->lastPixels[3]);
+		}
+
+		TEST_METHOD(DumpsEachTextureOnce)
+		{
+			auto sink = std::make_shared<FakeTextureDumpSink>();
+			TextureDumper textureDumper{ 4, sink };
+
+			const uint8_t pixels[16] = { };
+			const uint32_t palette[256] = { };
+
+			for (int32_t i = 0; i < 10; ++i)
+			{
+				Assert::IsTrue(textureDumper.TryDump(1, 4, 4, pixels, 0, palette));
+				Assert::IsTrue(textureDumper.TryDump(2, 4, 4, pixels, 0, palette));
+			}
+
+			/* The same hash in another category is a different texture. */
+			Assert::IsTrue(textureDumper.TryDump(1, 4, 4, pixels, 6, palette));
+
+			textureDumper.Flush();
+
+			Assert::AreEqual((size_t)3, sink->hashes.size());
+			Assert::AreEqual((uint64_t)3, textureDumper.GetWrittenCount());
+			Assert::AreEqual((uint64_t)0, textureDumper.GetDroppedCount());
+		}
+
+		TEST_METHOD(DropsWhenTheQueueIsFullAndRetriesLater)
+		{
+			auto sink = std::make_shared<FakeTextureDumpSink>();
+			TextureDumper textureDumper{ 2, sink };
+
+			const uint8_t pixels[16] = { };
+			const uint32_t palette[256] = { };
+
+			/* A queued texture keeps its place until it has been written, so this fills the queue. */
+			sink->SetBlocking(true);
+			Assert::IsTrue(textureDumper.TryDump(1, 4, 4, pixels, 0, palette));
+			Assert::IsTrue(textureDumper.TryDump(2, 4, 4, pixels, 0, palette));
+			Assert::IsFalse(textureDumper.TryDump(3, 4, 4, pixels, 0, palette));
+			Assert::AreEqual((uint64_t)1, textureDumper.GetDroppedCount());
+
+			sink->SetBlocking(false);
+			textureDumper.Flush();
+
+			Assert::IsTrue(textureDumper.TryDump(3, 4, 4, pixels, 0, palette));
+			textureDumper.Flush();
+
+			Assert::AreEqual((size_t)3, sink->hashes.size());
+			Assert::AreEqual(3U, sink->hashes[2]);
+			Assert::AreEqual((uint64_t)3, textureDumper.GetWrittenCount());
+		}
+
+		TEST_METHOD(WritesQueuedTexturesWhenDestroyed)
+		{
+			auto sink = std::make_shared<FakeTextureDumpSink>();
+
+			{
+				TextureDumper textureDumper{ 16, sink };
+
+				const uint8_t pixels[256 * 256] = { };
+				const uint32_t palette[256] = { };
+
+				for (uint32_t i = 0; i < 16; ++i)
+				{
+					Assert::IsTrue(textureDumper.TryDump(i, 256, 256, pixels, 0, palette));
+				}
+			}
+
+			Assert::AreEqual((size_t)16, sink->hashes.size());
+		}
+	};
+}
@@ -0,0 +1,87 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/TextureHasher.h"
+#include "../d2dx/Types.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTextureHasher)
+	{
+	public:
+		TEST_METHOD(HashesAreCachedUntilInvalidated)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+			TextureHasher hasher;
+			std::vector<uint8_t> data(64 * 64, 3);
+
+			hasher.Invalidate(memory, 4096, 64 * 64);
+			memory.Write(4096, data.data(), 64 * 64);
+
+			const uint32_t hash = hasher.GetHash(memory, 4096, memory.GetReadable(4096, 64 * 64), 64 * 64);
+			Assert::AreEqual(fnv_32a_buf(data.data(), 64 * 64, FNV1_32A_INIT), hash);
+			Assert::AreEqual(hash, hasher.GetHash(memory, 4096, memory.GetReadable(4096, 64 * 64), 64 * 64));
+			Assert::AreEqual(1U, hasher.GetCacheHits());
+
+			data[0] = 4;
+			hasher.Invalidate(memory, 4096, 64 * 64);
+			memory.Write(4096, data.data(), 64 * 64);
+
+			Assert::AreEqual(fnv_32a_buf(data.data(), 64 * 64, FNV1_32A_INIT), hasher.GetHash(memory, 4096, memory.GetReadable(4096, 64 * 64), 64 * 64));
+			Assert::AreEqual(2U, hasher.GetCacheMisses());
+		}
+
+		TEST_METHOD(UnwrittenTexturesAreHashedAsZeros)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+			TextureHasher hasher;
+			std::vector<uint8_t> zeros(32 * 32, 0);
+			const uint32_t zerosHash = fnv_32a_buf(zeros.data(), 32 * 32, FNV1_32A_INIT);
+
+			Assert::AreEqual(zerosHash, hasher.GetHash(memory, 0, memory.GetReadable(0, 32 * 32), 32 * 32));
+			Assert::AreEqual(zerosHash, hasher.GetHash(memory, 65536, memory.GetReadable(65536, 32 * 32), 32 * 32));
+			Assert::AreEqual(1U, hasher.GetCacheHits());
+
+			/* Once written, the texture is hashed from its contents. */
+			std::vector<uint8_t> data(32 * 32, 9);
+			hasher.Invalidate(memory, 65536, 32 * 32);
+			memory.Write(65536, data.data(), 32 * 32);
+
+			Assert::AreEqual(fnv_32a_buf(data.data(), 32 * 32, FNV1_32A_INIT), hasher.GetHash(memory, 65536, memory.GetReadable(65536, 32 * 32), 32 * 32));
+		}
+
+		TEST_METHOD(TexturesPartlyInWrittenMemoryAreHashedFromTheirContents)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+			TextureHasher hasher;
+			std::vector<uint8_t> data(256, 1);
+
+			memory.Write(8192 + 256, data.data(), 256);
+
+			std::vector<uint8_t> expected(1024, 0);
+			memset(expected.data() + 256, 1, 256);
+
+			Assert::AreEqual(fnv_32a_buf(expected.data(), 1024, FNV1_32A_INIT), hasher.GetHash(memory, 8192, memory.GetReadable(8192, 1024), 1024));
+		}
+	};
+}
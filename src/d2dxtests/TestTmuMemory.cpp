@@ -0,0 +1,108 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/TmuMemory.h"
+#include "../d2dx/Types.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	TEST_CLASS(TestTmuMemory)
+	{
+	public:
+		TEST_METHOD(NothingIsCommittedInitially)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+
+			Assert::AreEqual((uint64_t)0, memory.GetCommittedBytes());
+			Assert::IsFalse(memory.IsWritten(0));
+			Assert::IsFalse(memory.IsWritten(D2DX_TMU_MEMORY_SIZE - 1));
+		}
+
+		TEST_METHOD(WriteCommitsOnlyTheTouchedPages)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+			std::vector<uint8_t> data(64 * 64, 0x5A);
+
+			memory.Write(1024 * 1024, data.data(), (uint32_t)data.size());
+
+			Assert::IsTrue(memory.GetCommittedBytes() >= data.size());
+			Assert::IsTrue(memory.GetCommittedBytes() <= data.size() + 2 * 65536);
+			Assert::AreEqual((uint8_t)0x5A, memory.GetReadable(1024 * 1024, 4096)[4095]);
+		}
+
+		TEST_METHOD(WritingTwiceDoesNotCommitAgain)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+			std::vector<uint8_t> data(256, 1);
+
+			memory.Write(0, data.data(), 256);
+			const uint64_t committedBytes = memory.GetCommittedBytes();
+			memory.Write(256, data.data(), 256);
+
+			Assert::AreEqual(committedBytes, memory.GetCommittedBytes());
+		}
+
+		TEST_METHOD(UnwrittenMemoryReadsAsZero)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+			const uint8_t* pixels = memory.GetReadable(8 * 1024 * 1024, 256 * 256);
+
+			for (uint32_t i = 0; i < 256 * 256; ++i)
+			{
+				Assert::AreEqual((uint8_t)0, pixels[i]);
+			}
+
+			Assert::IsFalse(memory.IsWritten(8 * 1024 * 1024));
+		}
+
+		TEST_METHOD(TracksWrittenPages)
+		{
+			TmuMemory memory{ D2DX_TMU_MEMORY_SIZE };
+			std::vector<uint8_t> data(300, 7);
+
+			memory.Write(512, data.data(), (uint32_t)data.size());
+
+			Assert::IsFalse(memory.IsWritten(0));
+			Assert::IsFalse(memory.IsWritten(256));
+			Assert::IsTrue(memory.IsWritten(512));
+			Assert::IsTrue(memory.IsWritten(768));
+			Assert::IsFalse(memory.IsWritten(1024));
+
+			Assert::IsFalse(memory.IsAnyWritten(0, 512));
+			Assert::IsTrue(memory.IsAnyWritten(0, 513));
+			Assert::IsTrue(memory.IsAnyWritten(1000, 4096));
+			Assert::IsFalse(memory.IsAnyWritten(1024, 4096));
+		}
+
+		TEST_METHOD(WritableMemoryIsWritten)
+		{
+			TmuMemory memory{ D2DX_SIDE_TMU_MEMORY_SIZE };
+
+			uint8_t* pixels = memory.GetWritable(128 * 128, 8 * 8);
+			memset(pixels, 1, 8 * 8);
+
+			Assert::IsTrue(memory.IsWritten(128 * 128));
+			Assert::AreEqual((uint8_t)1, memory.GetData()[128 * 128 + 63]);
+		}
+	};
+}
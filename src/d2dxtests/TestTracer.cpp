@@ -0,0 +1,422 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "FakeClock.h"
+
+/* Compile in the markers, to test them too. */
+#define D2DX_TRACE
+#include "../d2dx/Tracer.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	/* Minimal recursive-descent JSON syntax check. */
+	class JsonValidator final
+	{
+	public:
+		static bool IsValid(
+			_In_ const std::string& text)
+		{
+			JsonValidator validator{ text };
+			return validator.ParseValue() && validator.SkipWhitespace() == text.size();
+		}
+
+	private:
+		JsonValidator(
+			_In_ const std::string& text) :
+			_text{ text }
+		{
+		}
+
+		size_t SkipWhitespace()
+		{
+			while (_pos < _text.size() && strchr(" \t\r\n", _text[_pos]))
+			{
+				++_pos;
+			}
+			return _pos;
+		}
+
+		bool Consume(
+			_In_ char c)
+		{
+			SkipWhitespace();
+			if (_pos < _text.size() && _text[_pos] == c)
+			{
+				++_pos;
+				return true;
+			}
+			return false;
+		}
+
+		bool ParseValue()
+		{
+			SkipWhitespace();
+
+			if (_pos >= _text.size())
+			{
+				return false;
+			}
+
+			const char c = _text[_pos];
+
+			if (c == '{')
+			{
+				++_pos;
+				if (Consume('}'))
+				{
+					return true;
+				}
+				do
+				{
+					if (!ParseString() || !Consume(':') || !ParseValue())
+					{
+						return false;
+					}
+				} while (Consume(','));
+				return Consume('}');
+			}
+			else if (c == '[')
+			{
+				++_pos;
+				if (Consume(']'))
+				{
+					return true;
+				}
+				do
+				{
+					if (!ParseValue())
+					{
+						return false;
+					}
+				} while (Consume(','));
+				return Consume(']');
+			}
+			else if (c == '"')
+			{
+				return ParseString();
+			}
+			else if (c == '-' || (c >= '0' && c <= '9'))
+			{
+				size_t start = _pos++;
+				while (_pos < _text.size() && strchr("0123456789.eE+-", _text[_pos]))
+				{
+					++_pos;
+				}
+				return _pos > start + (c == '-' ? 1 : 0);
+			}
+			else
+			{
+				for (const char* literal : { "true", "false", "null" })
+				{
+					if (!_text.compare(_pos, strlen(literal), literal))
+					{
+						_pos += strlen(literal);
+						return true;
+					}
+				}
+				return false;
+			}
+		}
+
+		bool ParseString()
+		{
+			if (!Consume('"'))
+			{
+				return false;
+			}
+
+			while (_pos < _text.size())
+			{
+				const char c = _text[_pos++];
+
+				if (c == '"')
+				{
+					return true;
+				}
+				else if (c == '\\')
+				{
+					if (_pos >= _text.size() || !strchr("\"\\/bfnrtu", _text[_pos]))
+					{
+						return false;
+					}
+					++_pos;
+				}
+				else if ((unsigned char)c < 0x20)
+				{
+					return false;
+				}
+			}
+
+			return false;
+		}
+
+		const std::string& _text;
+		size_t _pos = 0;
+	};
+
+	struct TraceEvent final
+	{
+		std::string name;
+		char phase;
+		int64_t timeUs;
+		uint32_t threadId;
+	};
+
+	static std::string WriteToString(
+		_In_ const Tracer& tracer)
+	{
+		FILE* file = nullptr;
+		Assert::AreEqual(0, (int32_t)tmpfile_s(&file));
+
+		tracer.Write(file);
+
+		std::string text;
+		char buffer[1024];
+		rewind(file);
+
+		for (size_t count; (count = fread(buffer, 1, sizeof(buffer), file)) > 0; )
+		{
+			text.append(buffer, count);
+		}
+
+		fclose(file);
+		return text;
+	}
+
+	/* Checks that the trace is valid JSON with properly nested begin/end pairs, and returns the events. */
+	static std::vector<TraceEvent> ParseAndValidate(
+		_In_ const std::string& json)
+	{
+		Assert::IsTrue(JsonValidator::IsValid(json));
+
+		std::vector<TraceEvent> events;
+		std::vector<std::vector<std::string>> stacks;
+		size_t pos = 0;
+
+		while ((pos = json.find("{\"name\":\"", pos)) != std::string::npos)
+		{
+			pos += 9;
+			TraceEvent event;
+
+			while (json[pos] != '"')
+			{
+				if (json[pos] == '\\')
+				{
+					++pos;
+				}
+				event.name += json[pos++];
+			}
+
+			Assert::AreEqual(0, json.compare(pos, 8, "\",\"ph\":\""));
+			event.phase = json[pos + 8];
+
+			long long timeUs = 0;
+			Assert::AreEqual(2, sscanf_s(json.c_str() + pos + 9, "\",\"ts\":%lld,\"pid\":1,\"tid\":%u}", &timeUs, &event.threadId));
+			event.timeUs = timeUs;
+
+			if (stacks.size() <= event.threadId)
+			{
+				stacks.resize(event.threadId + 1);
+			}
+
+			auto& stack = stacks[event.threadId];
+
+			if (event.phase == 'B')
+			{
+				stack.push_back(event.name);
+			}
+			else
+			{
+				Assert::AreEqual('E', event.phase);
+				Assert::IsFalse(stack.empty());
+				Assert::AreEqual(stack.back(), event.name);
+				stack.pop_back();
+			}
+
+			events.push_back(event);
+		}
+
+		for (const auto& stack : stacks)
+		{
+			Assert::IsTrue(stack.empty());
+		}
+
+		return events;
+	}
+
+	TEST_CLASS(TestTracer)
+	{
+	public:
+		TEST_METHOD(NothingIsRecordedWithoutATracer)
+		{
+			Tracer::SetInstance(nullptr);
+			D2DX_TRACE_SCOPE("NotRecorded");
+		}
+
+		TEST_METHOD(NestedScopesAreWrittenAsMatchedPairs)
+		{
+			Tracer tracer{ std::make_shared<FakeClock>(0, 10), 1024 };
+			Tracer::SetInstance(&tracer);
+			tracer.SetFrameRange(0, 0);
+			tracer.OnNewFrame(0);
+
+			{
+				D2DX_TRACE_SCOPE("Frame");
+				{
+					D2DX_TRACE_SCOPE("Draw");
+				}
+				{
+					D2DX_TRACE_SCOPE("Present");
+					D2DX_TRACE_SCOPE("Wait");
+				}
+			}
+
+			Assert::IsTrue(tracer.OnNewFrame(1));
+
+			const auto events = ParseAndValidate(WriteToString(tracer));
+
+			Assert::AreEqual((size_t)8, events.size());
+			Assert::AreEqual(std::string{ "Frame" }, events[0].name);
+			Assert::AreEqual(std::string{ "Wait" }, events[5].name);
+			Assert::AreEqual(std::string{ "Frame" }, events[7].name);
+
+			for (size_t i = 1; i < events.size(); ++i)
+			{
+				Assert::IsTrue(events[i].timeUs >= events[i - 1].timeUs);
+			}
+
+			Tracer::SetInstance(nullptr);
+		}
+
+		TEST_METHOD(OnlyTheFrameRangeIsRecorded)
+		{
+			Tracer tracer{ std::make_shared<FakeClock>(0, 10), 1024 };
+			Tracer::SetInstance(&tracer);
+			tracer.SetFrameRange(2, 3);
+
+			for (uint64_t frame = 0; frame < 6; ++frame)
+			{
+				const bool isDone = tracer.OnNewFrame(frame);
+				Assert::AreEqual(frame == 4, isDone);
+				Assert::AreEqual(frame == 2 || frame == 3, tracer.IsRecording());
+
+				D2DX_TRACE_SCOPE("Frame");
+			}
+
+			const auto events = ParseAndValidate(WriteToString(tracer));
+			Assert::AreEqual((size_t)4, events.size());
+
+			Tracer::SetInstance(nullptr);
+		}
+
+		TEST_METHOD(ScopesCrossingTheRangeEdgesStayBalanced)
+		{
+			Tracer tracer{ std::make_shared<FakeClock>(0, 10), 1024 };
+			Tracer::SetInstance(&tracer);
+			tracer.SetFrameRange(1, 1);
+
+			/* Begun before recording starts, ended during it. */
+			{
+				D2DX_TRACE_SCOPE("BufferSwap");
+				tracer.OnNewFrame(1);
+			}
+
+			D2DX_TRACE_SCOPE("Frame");
+			D2DX_TRACE_SCOPE("BufferSwap");
+
+			/* Still open when recording stops. */
+			Assert::IsTrue(tracer.OnNewFrame(2));
+
+			const auto events = ParseAndValidate(WriteToString(tracer));
+			Assert::AreEqual((size_t)4, events.size());
+			Assert::AreEqual('B', events[0].phase);
+			Assert::AreEqual(std::string{ "Frame" }, events[0].name);
+
+			Tracer::SetInstance(nullptr);
+		}
+
+		TEST_METHOD(FullBufferStaysWellFormed)
+		{
+			Tracer tracer{ std::make_shared<FakeClock>(0, 10), 16 };
+			Tracer::SetInstance(&tracer);
+			tracer.SetFrameRange(0, 0);
+			tracer.OnNewFrame(0);
+
+			{
+				D2DX_TRACE_SCOPE("Outer");
+
+				for (int32_t i = 0; i < 20; ++i)
+				{
+					D2DX_TRACE_SCOPE("A");
+					D2DX_TRACE_SCOPE("B");
+					D2DX_TRACE_SCOPE("C");
+				}
+			}
+
+			const auto events = ParseAndValidate(WriteToString(tracer));
+			/* The begin events that fit, each with an end event. */
+			Assert::AreEqual((size_t)18, events.size());
+			Assert::AreEqual(std::string{ "Outer" }, events.front().name);
+			Assert::AreEqual(std::string{ "Outer" }, events.back().name);
+
+			Tracer::SetInstance(nullptr);
+		}
+
+		TEST_METHOD(EachThreadHasItsOwnTrack)
+		{
+			Tracer tracer{ std::make_shared<FakeClock>(0, 10), 1024 };
+			Tracer::SetInstance(&tracer);
+			tracer.SetFrameRange(0, 0);
+			tracer.OnNewFrame(0);
+
+			D2DX_TRACE_SCOPE("Main");
+
+			std::thread worker{ []() {
+				D2DX_TRACE_SCOPE("Worker");
+				D2DX_TRACE_SCOPE("Inner");
+			} };
+			worker.join();
+
+			tracer.OnNewFrame(1);
+
+			const auto events = ParseAndValidate(WriteToString(tracer));
+			Assert::AreEqual((size_t)6, events.size());
+			Assert::AreNotEqual(events[0].threadId, events[2].threadId);
+
+			Tracer::SetInstance(nullptr);
+		}
+
+		TEST_METHOD(NamesAreEscaped)
+		{
+			Tracer tracer{ std::make_shared<FakeClock>(0, 10), 1024 };
+			tracer.SetFrameRange(0, 0);
+			tracer.OnNewFrame(0);
+
+			Assert::IsTrue(tracer.Begin("quote\" and \\backslash"));
+			tracer.End("quote\" and \\backslash");
+
+			const auto events = ParseAndValidate(WriteToString(tracer));
+			Assert::AreEqual(std::string{ "quote\" and \\backslash" }, events[0].name);
+		}
+	};
+}
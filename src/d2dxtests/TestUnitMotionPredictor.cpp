@@ -0,0 +1,258 @@
+/*
+	This file is part of D2DX.
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "../d2dx/UnitMotionPredictor.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+using namespace d2dx;
+
+namespace d2dxtests
+{
+	struct RecordedSample final
+	{
+		int32_t timeMs;
+		int32_t x;
+		int32_t y;
+	};
+
+	/* Server-side positions of a player walking, running diagonally, stopping, running and stopping again,
+	   as observed once per game tick (with the usual tick jitter). Positions are 16.16 fixed point. */
+	static const RecordedSample recordedWalkAndRun[] =
+	{
+		{ 0, 0x13880000, 0x13880000 }, { 40, 0x138828F6, 0x13880000 }, { 79, 0x138851EC, 0x13880000 },
+		{ 119, 0x13887AE1, 0x13880000 }, { 160, 0x1388A3D7, 0x13880000 }, { 198, 0x1388CCCD, 0x13880000 },
+		{ 236, 0x1388F5C3, 0x13880000 }, { 278, 0x13891EB8, 0x13880000 }, { 318, 0x138947AE, 0x13880000 },
+		{ 356, 0x138970A4, 0x13880000 }, { 396, 0x1389999A, 0x13880000 }, { 436, 0x1389C28F, 0x13880000 },
+		{ 474, 0x1389EB85, 0x13880000 }, { 514, 0x138A147B, 0x13880000 }, { 553, 0x138A3D71, 0x13880000 },
+		{ 591, 0x138A6666, 0x13880000 }, { 629, 0x138A8F5C, 0x13880000 }, { 669, 0x138AB852, 0x13880000 },
+		{ 709, 0x138AE148, 0x13880000 }, { 747, 0x138B0A3D, 0x13880000 }, { 786, 0x138B3333, 0x13880000 },
+		{ 824, 0x138B5C29, 0x13880000 }, { 864, 0x138B851F, 0x13880000 }, { 904, 0x138BAE14, 0x13880000 },
+		{ 942, 0x138BD70A, 0x13880000 }, { 984, 0x138C0000, 0x13880000 }, { 1024, 0x138C28F6, 0x13880000 },
+		{ 1062, 0x138C51EC, 0x13880000 }, { 1101, 0x138C7AE1, 0x13880000 }, { 1142, 0x138CA3D7, 0x13880000 },
+		{ 1183, 0x138CCCCD, 0x13880000 }, { 1223, 0x138CF852, 0x13882B85 }, { 1261, 0x138D23D7, 0x1388570A },
+		{ 1301, 0x138D4F5C, 0x1388828F }, { 1341, 0x138D7AE1, 0x1388AE14 }, { 1381, 0x138DA666, 0x1388D99A },
+		{ 1419, 0x138DD1EC, 0x1389051F }, { 1458, 0x138DFD71, 0x138930A4 }, { 1496, 0x138E28F6, 0x13895C29 },
+		{ 1536, 0x138E547B, 0x138987AE }, { 1578, 0x138E8000, 0x1389B333 }, { 1617, 0x138EAB85, 0x1389DEB8 },
+		{ 1657, 0x138ED70A, 0x138A0A3D }, { 1697, 0x138F028F, 0x138A35C3 }, { 1736, 0x138F2E14, 0x138A6148 },
+		{ 1776, 0x138F599A, 0x138A8CCD }, { 1814, 0x138F851F, 0x138AB852 }, { 1854, 0x138FB0A4, 0x138AE3D7 },
+		{ 1894, 0x138FDC29, 0x138B0F5C }, { 1934, 0x139007AE, 0x138B3AE1 }, { 1976, 0x13903333, 0x138B6666 },
+		{ 2017, 0x13905EB8, 0x138B91EC }, { 2056, 0x13908A3D, 0x138BBD71 }, { 2094, 0x1390B5C3, 0x138BE8F6 },
+		{ 2134, 0x1390E148, 0x138C147B }, { 2174, 0x13910CCD, 0x138C4000 }, { 2215, 0x13913852, 0x138C6B85 },
+		{ 2254, 0x139163D7, 0x138C970A }, { 2294, 0x13918F5C, 0x138CC28F }, { 2332, 0x1391BAE1, 0x138CEE14 },
+		{ 2372, 0x1391E666, 0x138D199A }, { 2413, 0x1391E666, 0x138D199A }, { 2451, 0x1391E666, 0x138D199A },
+		{ 2491, 0x1391E666, 0x138D199A }, { 2529, 0x1391E666, 0x138D199A }, { 2569, 0x1391E666, 0x138D199A },
+		{ 2608, 0x1391E666, 0x138D199A }, { 2648, 0x1391E666, 0x138D199A }, { 2689, 0x1391E666, 0x138D199A },
+		{ 2729, 0x1391E666, 0x138D199A }, { 2769, 0x1391E666, 0x138D199A }, { 2811, 0x1391E666, 0x138D199A },
+		{ 2851, 0x1391E666, 0x138D199A }, { 2891, 0x1391E666, 0x138D199A }, { 2931, 0x1391E666, 0x138D199A },
+		{ 2971, 0x1391E666, 0x138D199A }, { 3011, 0x1391E666, 0x138D199A }, { 3051, 0x1391E666, 0x138D199A },
+		{ 3090, 0x1391E666, 0x138D199A }, { 3132, 0x1391E666, 0x138CDC29 }, { 3171, 0x1391E666, 0x138C9EB8 },
+		{ 3212, 0x1391E666, 0x138C6148 }, { 3254, 0x1391E666, 0x138C23D7 }, { 3293, 0x1391E666, 0x138BE666 },
+		{ 3331, 0x1391E666, 0x138BA8F6 }, { 3371, 0x1391E666, 0x138B6B85 }, { 3411, 0x1391E666, 0x138B2E14 },
+		{ 3451, 0x1391E666, 0x138AF0A4 }, { 3491, 0x1391E666, 0x138AB333 }, { 3531, 0x1391E666, 0x138A75C3 },
+		{ 3572, 0x1391E666, 0x138A3852 }, { 3612, 0x1391E666, 0x1389FAE1 }, { 3652, 0x1391E666, 0x1389BD71 },
+		{ 3692, 0x1391E666, 0x13898000 }, { 3730, 0x1391E666, 0x1389428F }, { 3768, 0x1391E666, 0x1389051F },
+		{ 3808, 0x1391E666, 0x1388C7AE }, { 3848, 0x1391E666, 0x13888A3D }, { 3887, 0x1391E666, 0x13884CCD },
+		{ 3929, 0x1391E666, 0x13880F5C }, { 3969, 0x1391E666, 0x1387D1EC }, { 4008, 0x1391E666, 0x1387947B },
+		{ 4048, 0x1391E666, 0x1387570A }, { 4088, 0x1391E666, 0x1387199A }, { 4126, 0x1392199A, 0x13870000 },
+		{ 4167, 0x13924CCD, 0x1386E666 }, { 4205, 0x13928000, 0x1386CCCD }, { 4247, 0x1392B333, 0x1386B333 },
+		{ 4287, 0x1392E666, 0x1386999A }, { 4327, 0x1393199A, 0x13868000 }, { 4369, 0x1393199A, 0x13868000 },
+		{ 4411, 0x1393199A, 0x13868000 }, { 4451, 0x1393199A, 0x13868000 }, { 4491, 0x1393199A, 0x13868000 },
+		{ 4532, 0x1393199A, 0x13868000 }, { 4572, 0x1393199A, 0x13868000 }, { 4612, 0x1393199A, 0x13868000 },
+		{ 4652, 0x1393199A, 0x13868000 }, { 4692, 0x1393199A, 0x13868000 }, { 4734, 0x1393199A, 0x13868000 },
+		{ 4774, 0x1393199A, 0x13868000 }, { 4812, 0x1393199A, 0x13868000 }, { 4854, 0x1393199A, 0x13868000 },
+		{ 4892, 0x1393199A, 0x13868000 }, { 4932, 0x1393199A, 0x13868000 }, { 4972, 0x1393199A, 0x13868000 },
+		{ 5013, 0x1393199A, 0x13868000 }, { 5054, 0x1393199A, 0x13868000 }, { 5092, 0x1393199A, 0x13868000 },
+		{ 5130, 0x1393199A, 0x13868000 },
+	};
+
+	struct PredictionQuality final
+	{
+		float rmsError = 0.0f;
+		float maxError = 0.0f;
+	};
+
+	TEST_CLASS(TestUnitMotionPredictor)
+	{
+	public:
+		TEST_METHOD(AlphaBetaGammaHasLowerErrorThanBlendAt60Hz)
+		{
+			AssertAlphaBetaGammaIsBetter(60);
+		}
+
+		TEST_METHOD(AlphaBetaGammaHasLowerErrorThanBlendAt144Hz)
+		{
+			AssertAlphaBetaGammaIsBetter(144);
+		}
+
+		TEST_METHOD(AlphaBetaGammaHasLowerErrorThanBlendAt240Hz)
+		{
+			AssertAlphaBetaGammaIsBetter(240);
+		}
+
+		TEST_METHOD(AlphaBetaGammaOvershootIsBounded)
+		{
+			MotionPredictionSettings settings;
+			settings.mode = MotionPredictionMode::AlphaBetaGamma;
+
+			const int32_t sampleCount = ARRAYSIZE(recordedWalkAndRun);
+			const RecordedSample& stop = recordedWalkAndRun[sampleCount - 1];
+			const RecordedSample& beforeStop = recordedWalkAndRun[sampleCount - 21];
+			const RecordedSample& twoBeforeStop = recordedWalkAndRun[sampleCount - 22];
+			const float stepX = (beforeStop.x - twoBeforeStop.x) / 65536.0f;
+			const float stepY = (beforeStop.y - twoBeforeStop.y) / 65536.0f;
+			const float stepLength = sqrtf(stepX * stepX + stepY * stepY);
+
+			float maxOvershoot = 0.0f;
+			Offset finalPos{ 0, 0 };
+
+			Simulate(settings, 144, [&](int32_t timeMs, const UnitMotionPredictor::UnitMotion& um, OffsetF)
+			{
+				if (timeMs >= beforeStop.timeMs)
+				{
+					/* Distance travelled past the stop point, along the direction of travel. */
+					const float ox = (um.predictedPos.x - beforeStop.x) / 65536.0f;
+					const float oy = (um.predictedPos.y - beforeStop.y) / 65536.0f;
+					maxOvershoot = max(maxOvershoot, (ox * stepX + oy * stepY) / stepLength);
+				}
+				finalPos = um.predictedPos;
+			});
+
+			Assert::IsTrue(maxOvershoot <= stepLength * (1.0f + settings.maxOvershoot) * 1.1f);
+			Assert::IsTrue(abs(finalPos.x - stop.x) < 256);
+			Assert::IsTrue(abs(finalPos.y - stop.y) < 256);
+		}
+
+		TEST_METHOD(AlphaBetaGammaEstimatesTickPeriod)
+		{
+			MotionPredictionSettings settings;
+			settings.mode = MotionPredictionMode::AlphaBetaGamma;
+
+			UnitMotionPredictor::UnitMotion um;
+			const int32_t dt = 65536 / 144;
+			Offset pos{ 5000 << 16, 5000 << 16 };
+			int32_t timeSinceTick = 0;
+
+			/* A game running at 20 ticks per second. */
+			for (int32_t frame = 0; frame < 144 * 4; ++frame)
+			{
+				timeSinceTick += dt;
+				if (timeSinceTick >= 65536 / 20)
+				{
+					timeSinceTick -= 65536 / 20;
+					pos.x += 10000;
+				}
+				um.Update(pos, dt, settings);
+			}
+
+			Assert::IsTrue(abs(um.tickPeriod - 65536 / 20) < (65536 / 20) / 20);
+		}
+
+	private:
+		template<typename TCallback>
+		void Simulate(
+			const MotionPredictionSettings& settings,
+			int32_t frameRate,
+			TCallback callback)
+		{
+			const int32_t sampleCount = ARRAYSIZE(recordedWalkAndRun);
+			const int32_t dt = 65536 / frameRate;
+			const int32_t endTimeMs = recordedWalkAndRun[sampleCount - 1].timeMs;
+
+			UnitMotionPredictor::UnitMotion um;
+			int32_t sampleIndex = 0;
+
+			for (int32_t frame = 0; ; ++frame)
+			{
+				const int32_t timeMs = (int32_t)(((int64_t)frame * dt * 1000) >> 16);
+
+				if (timeMs > endTimeMs)
+				{
+					break;
+				}
+
+				while (sampleIndex < (sampleCount - 1) && recordedWalkAndRun[sampleIndex + 1].timeMs <= timeMs)
+				{
+					++sampleIndex;
+				}
+
+				const RecordedSample& s0 = recordedWalkAndRun[sampleIndex];
+				const RecordedSample& s1 = recordedWalkAndRun[min(sampleIndex + 1, sampleCount - 1)];
+
+				um.Update({ s0.x, s0.y }, dt, settings);
+
+				/* The true position moves continuously between the server ticks. */
+				const float f = s1.timeMs > s0.timeMs ? (float)(timeMs - s0.timeMs) / (s1.timeMs - s0.timeMs) : 0.0f;
+				const OffsetF truePos{
+					(s0.x + f * (s1.x - s0.x)) / 65536.0f,
+					(s0.y + f * (s1.y - s0.y)) / 65536.0f };
+
+				callback(timeMs, um, truePos);
+			}
+		}
+
+		PredictionQuality MeasureQuality(
+			const MotionPredictionSettings& settings,
+			int32_t frameRate)
+		{
+			PredictionQuality quality;
+			double sumSquaredError = 0.0;
+			int32_t count = 0;
+
+			Simulate(settings, frameRate, [&](int32_t timeMs, const UnitMotionPredictor::UnitMotion& um, OffsetF truePos)
+			{
+				if (timeMs < 200)
+				{
+					return;
+				}
+
+				const float ex = um.predictedPos.x / 65536.0f - truePos.x;
+				const float ey = um.predictedPos.y / 65536.0f - truePos.y;
+				const float error = sqrtf(ex * ex + ey * ey);
+				sumSquaredError += error * error;
+				quality.maxError = max(quality.maxError, error);
+				++count;
+			});
+
+			quality.rmsError = (float)sqrt(sumSquaredError / count);
+			return quality;
+		}
+
+		void AssertAlphaBetaGammaIsBetter(
+			int32_t frameRate)
+		{
+			MotionPredictionSettings blendSettings;
+			blendSettings.mode = MotionPredictionMode::Blend;
+
+			MotionPredictionSettings abgSettings;
+			abgSettings.mode = MotionPredictionMode::AlphaBetaGamma;
+
+			const PredictionQuality blend = MeasureQuality(blendSettings, frameRate);
+			const PredictionQuality abg = MeasureQuality(abgSettings, frameRate);
+
+			char message[256];
+			sprintf_s(message, "%i Hz: blend rms %f max %f, abg rms %f max %f",
+				frameRate, blend.rmsError, blend.maxError, abg.rmsError, abg.maxError);
+			Logger::WriteMessage(message);
+
+			Assert::IsTrue(abg.rmsError < blend.rmsError);
+			Assert::IsTrue(abg.maxError <= blend.maxError);
+		}
+	};
+}